@@ -0,0 +1,550 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "AHIBSModelPack.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const char kMagic[8] = {'A', 'H', 'I', 'B', 'S', 'P', 'A', 'K'};
+    const uint32_t kByteOrder = 0x01020304;
+
+    std::size_t elementSize(uint32_t type) {
+        switch ((AHIBSModelPackType) type) {
+            case AHIBSModelPackType::Int32:
+            case AHIBSModelPackType::Float32:
+                return 4;
+            case AHIBSModelPackType::Float16:
+                return 2;
+            case AHIBSModelPackType::Float64:
+                return 8;
+        }
+        return 0;
+    }
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Stores count values of From as storage.
+    template<typename From>
+    std::vector<uint8_t> encode(const From *values, std::size_t count, AHIBSModelPackType storage) {
+        std::vector<uint8_t> bytes(count * elementSize((uint32_t) storage));
+        for (std::size_t i = 0; i < count; i++) {
+            if (storage == AHIBSModelPackType::Float32) {
+                float value = (float) values[i];
+                std::memcpy(bytes.data() + i * 4, &value, 4);
+            } else if (storage == AHIBSModelPackType::Float16) {
+                uint16_t value = ahiFloatToHalf((float) values[i]);
+                std::memcpy(bytes.data() + i * 2, &value, 2);
+            } else {
+                double value = (double) values[i];
+                std::memcpy(bytes.data() + i * 8, &value, 8);
+            }
+        }
+        return bytes;
+    }
+
+    // The floating point blob as To, whatever its storage.
+    template<typename To>
+    bool decode(const AHIBSModelPack &pack, const std::string &name, std::vector<To> &out) {
+        const AHIBSModelPackEntry *entry = pack.find(name);
+        if (entry == nullptr) {
+            return false;
+        }
+        const uint8_t *bytes = static_cast<const uint8_t *>(pack.blob(*entry));
+        std::size_t count = (std::size_t) entry->rows * entry->cols;
+        out.resize(count);
+        for (std::size_t i = 0; i < count; i++) {
+            if (entry->type == (uint32_t) AHIBSModelPackType::Float32) {
+                float value;
+                std::memcpy(&value, bytes + i * 4, 4);
+                out[i] = (To) value;
+            } else if (entry->type == (uint32_t) AHIBSModelPackType::Float16) {
+                uint16_t value;
+                std::memcpy(&value, bytes + i * 2, 2);
+                out[i] = (To) ahiHalfToFloat(value);
+            } else if (entry->type == (uint32_t) AHIBSModelPackType::Float64) {
+                double value;
+                std::memcpy(&value, bytes + i * 8, 8);
+                out[i] = (To) value;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename T>
+    bool decodeRows(const AHIBSModelPack &pack, const std::string &name, std::vector<std::vector<T>> &out) {
+        const AHIBSModelPackEntry *entry = pack.find(name);
+        std::vector<T> values;
+        if (entry == nullptr || !decode(pack, name, values)) {
+            return false;
+        }
+        out.assign(entry->rows, std::vector<T>());
+        for (uint32_t r = 0; r < entry->rows; r++) {
+            out[r].assign(values.begin() + (std::size_t) r * entry->cols,
+                          values.begin() + (std::size_t) (r + 1) * entry->cols);
+        }
+        return true;
+    }
+
+    // The rows of a matrix model laid out one after the other, false if they differ in length.
+    template<typename T>
+    bool flatten(const std::vector<std::vector<T>> &rows, std::vector<T> &out, uint32_t &cols) {
+        cols = rows.empty() ? 0 : (uint32_t) rows[0].size();
+        out.clear();
+        out.reserve(rows.size() * cols);
+        for (const std::vector<T> &row: rows) {
+            if (row.size() != cols) {
+                return false;
+            }
+            out.insert(out.end(), row.begin(), row.end());
+        }
+        return true;
+    }
+}
+
+const uint32_t AHIBSModelPack::VERSION;
+const uint32_t AHIBSModelPack::ALIGNMENT;
+
+uint32_t ahiModelPackCrc32(const void *data, std::size_t size) {
+    static const std::vector<uint32_t> table = []() {
+        std::vector<uint32_t> crcs(256);
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t crc = n;
+            for (int k = 0; k < 8; k++) {
+                crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+            }
+            crcs[n] = crc;
+        }
+        return crcs;
+    }();
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    uint32_t crc = 0xFFFFFFFFu;
+    for (std::size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Round to nearest even, overflow to infinity, NaN kept quiet.
+uint16_t ahiFloatToHalf(float value) {
+    uint32_t f;
+    std::memcpy(&f, &value, 4);
+    uint32_t sign = (f >> 16) & 0x8000;
+    uint32_t exponent = (f >> 23) & 0xFF;
+    uint32_t mantissa = f & 0x7FFFFF;
+    if (exponent == 0xFF) {
+        return (uint16_t) (sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+    }
+    int e = (int) exponent - 127 + 15;
+    if (e >= 0x1F) {
+        return (uint16_t) (sign | 0x7C00);
+    }
+    if (e <= 0) { // subnormal half
+        if (e < -10) {
+            return (uint16_t) sign;
+        }
+        mantissa |= 0x800000;
+        int shift = 14 - e;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) {
+            half++;
+        }
+        return (uint16_t) (sign | half);
+    }
+    uint32_t half = ((uint32_t) e << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+        half++; // a carry into the exponent rounds up to the next binade, or to infinity
+    }
+    return (uint16_t) (sign | half);
+}
+
+float ahiHalfToFloat(uint16_t value) {
+    uint32_t sign = (uint32_t) (value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    uint32_t f;
+    if (exponent == 0x1F) {
+        f = sign | 0x7F800000 | (mantissa << 13);
+    } else if (exponent == 0) {
+        if (mantissa == 0) {
+            f = sign;
+        } else { // subnormal half, normalized
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400) == 0) {
+                mantissa <<= 1;
+                exponent--;
+            }
+            f = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+        }
+    } else {
+        f = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    float result;
+    std::memcpy(&result, &f, 4);
+    return result;
+}
+
+std::unique_ptr<AHIBSModelPack> AHIBSModelPack::open(const std::string &path, bool verify, std::string &error) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return nullptr;
+    }
+    struct stat info;
+    std::unique_ptr<AHIBSModelPack> pack;
+    if (fstat(fd, &info) != 0) {
+        error = "cannot stat " + path;
+    } else {
+        pack = open(fd, 0, (uint64_t) info.st_size, verify, error);
+    }
+    ::close(fd);
+    return pack;
+}
+
+std::unique_ptr<AHIBSModelPack>
+AHIBSModelPack::open(int fd, uint64_t offset, uint64_t length, bool verify, std::string &error) {
+    if (length < sizeof(AHIBSModelPackHeader)) {
+        error = "model pack too short";
+        return nullptr;
+    }
+    uint64_t page = (uint64_t) sysconf(_SC_PAGESIZE);
+    uint64_t mapOffset = offset - offset % page;
+    std::size_t mapSize = (std::size_t) (length + (offset - mapOffset));
+    void *mapping = mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE, fd, (off_t) mapOffset);
+    if (mapping == MAP_FAILED) {
+        error = "cannot map the model pack";
+        return nullptr;
+    }
+    std::unique_ptr<AHIBSModelPack> pack(new AHIBSModelPack());
+    pack->mMapping = mapping;
+    pack->mMappingSize = mapSize;
+    pack->mBase = static_cast<const uint8_t *>(mapping) + (offset - mapOffset);
+    pack->mSize = length;
+    if (!pack->load(verify, error)) {
+        return nullptr;
+    }
+    return pack;
+}
+
+AHIBSModelPack::~AHIBSModelPack() {
+    if (mMapping != nullptr) {
+        munmap(mMapping, mMappingSize);
+    }
+}
+
+bool AHIBSModelPack::load(bool verifyBlobs, std::string &error) {
+    // the views point into the mapping, so their alignment is that of the pack start
+    if (reinterpret_cast<uintptr_t>(mBase) % sizeof(double) != 0) {
+        error = "model pack not 8 byte aligned";
+        return false;
+    }
+    const AHIBSModelPackHeader *header = reinterpret_cast<const AHIBSModelPackHeader *>(mBase);
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) {
+        error = "not a model pack";
+        return false;
+    }
+    if (header->version != VERSION || header->byteOrder != kByteOrder) {
+        error = "unsupported model pack version or byte order";
+        return false;
+    }
+    uint64_t tocSize = (uint64_t) header->numEntries * sizeof(AHIBSModelPackEntry);
+    if (header->size > mSize || header->tocOffset % sizeof(uint64_t) != 0 || header->tocOffset > header->size ||
+        tocSize > header->size - header->tocOffset) {
+        error = "truncated model pack";
+        return false;
+    }
+    if (ahiModelPackCrc32(mBase + header->tocOffset, (std::size_t) tocSize) != header->tocChecksum) {
+        error = "model pack table of contents checksum mismatch";
+        return false;
+    }
+    const AHIBSModelPackEntry *toc = reinterpret_cast<const AHIBSModelPackEntry *>(mBase + header->tocOffset);
+    mEntries.clear();
+    for (uint32_t i = 0; i < header->numEntries; i++) {
+        const AHIBSModelPackEntry &entry = toc[i];
+        std::size_t element = elementSize(entry.type);
+        if (std::memchr(entry.name, 0, sizeof(entry.name)) == nullptr || element == 0 ||
+            entry.offset % ALIGNMENT != 0 || entry.offset > header->size || entry.size > header->size - entry.offset ||
+            (entry.cols != 0 && entry.rows > entry.size / element / entry.cols) ||
+            (uint64_t) entry.rows * entry.cols * element != entry.size) {
+            error = "invalid model pack entry " + std::to_string(i);
+            return false;
+        }
+        if (verifyBlobs && !verify(entry)) {
+            error = std::string("model pack checksum mismatch for ") + entry.name;
+            return false;
+        }
+        mEntries.push_back(&entry);
+    }
+    std::sort(mEntries.begin(), mEntries.end(), [](const AHIBSModelPackEntry *a, const AHIBSModelPackEntry *b) {
+        return std::strcmp(a->name, b->name) < 0;
+    });
+    return true;
+}
+
+const AHIBSModelPackEntry *AHIBSModelPack::find(const std::string &name) const {
+    auto iter = std::lower_bound(mEntries.begin(), mEntries.end(), name,
+                                 [](const AHIBSModelPackEntry *entry, const std::string &key) {
+                                     return std::strcmp(entry->name, key.c_str()) < 0;
+                                 });
+    if (iter == mEntries.end() || name != (*iter)->name) {
+        return nullptr;
+    }
+    return *iter;
+}
+
+bool AHIBSModelPack::verify(const AHIBSModelPackEntry &entry) const {
+    return ahiModelPackCrc32(mBase + entry.offset, (std::size_t) entry.size) == entry.checksum;
+}
+
+template<typename T>
+AHIBSModelPackView<T> AHIBSModelPack::view(const std::string &name, AHIBSModelPackType type) const {
+    AHIBSModelPackView<T> result;
+    const AHIBSModelPackEntry *entry = find(name);
+    if (entry != nullptr && entry->type == (uint32_t) type) {
+        result.data = reinterpret_cast<const T *>(mBase + entry->offset);
+        result.rows = entry->rows;
+        result.cols = entry->cols;
+    }
+    return result;
+}
+
+AHIBSModelPackView<int32_t> AHIBSModelPack::ints(const std::string &name) const {
+    return view<int32_t>(name, AHIBSModelPackType::Int32);
+}
+
+AHIBSModelPackView<float> AHIBSModelPack::floats(const std::string &name) const {
+    return view<float>(name, AHIBSModelPackType::Float32);
+}
+
+AHIBSModelPackView<double> AHIBSModelPack::doubles(const std::string &name) const {
+    return view<double>(name, AHIBSModelPackType::Float64);
+}
+
+bool AHIBSModelPack::copyFloats(const std::string &name, std::vector<float> &out) const {
+    return decode(*this, name, out);
+}
+
+bool AHIBSModelPack::copyDoubles(const std::string &name, std::vector<double> &out) const {
+    return decode(*this, name, out);
+}
+
+void AHIBSModelPackWriter::add(Blob blob) {
+    mBlobs.erase(std::remove_if(mBlobs.begin(), mBlobs.end(), [&blob](const Blob &other) {
+        return other.name == blob.name;
+    }), mBlobs.end());
+    mBlobs.push_back(std::move(blob));
+}
+
+void AHIBSModelPackWriter::addInts(const std::string &name, const std::vector<int> &values, uint32_t model) {
+    Blob blob{name, AHIBSModelPackType::Int32, model, (uint32_t) values.size(), 1, {}};
+    blob.bytes.resize(values.size() * 4);
+    for (std::size_t i = 0; i < values.size(); i++) {
+        int32_t value = values[i];
+        std::memcpy(blob.bytes.data() + i * 4, &value, 4);
+    }
+    add(std::move(blob));
+}
+
+void AHIBSModelPackWriter::addFloats(const std::string &name, const float *values, uint32_t rows, uint32_t cols,
+                                     AHIBSModelPackType storage, uint32_t model) {
+    add(Blob{name, storage, model, rows, cols, encode(values, (std::size_t) rows * cols, storage)});
+}
+
+void AHIBSModelPackWriter::addDoubles(const std::string &name, const double *values, uint32_t rows, uint32_t cols,
+                                      AHIBSModelPackType storage, uint32_t model) {
+    add(Blob{name, storage, model, rows, cols, encode(values, (std::size_t) rows * cols, storage)});
+}
+
+void AHIBSModelPackWriter::write(std::vector<char> &out) const {
+    AHIBSModelPackHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = AHIBSModelPack::VERSION;
+    header.byteOrder = kByteOrder;
+    header.numEntries = (uint32_t) mBlobs.size();
+    header.tocOffset = sizeof(AHIBSModelPackHeader);
+    std::vector<AHIBSModelPackEntry> toc(mBlobs.size());
+    uint64_t offset = alignUp(header.tocOffset + toc.size() * sizeof(AHIBSModelPackEntry), AHIBSModelPack::ALIGNMENT);
+    for (std::size_t i = 0; i < mBlobs.size(); i++) {
+        const Blob &blob = mBlobs[i];
+        AHIBSModelPackEntry &entry = toc[i];
+        std::memset(&entry, 0, sizeof(entry));
+        std::strncpy(entry.name, blob.name.c_str(), sizeof(entry.name) - 1);
+        entry.type = (uint32_t) blob.type;
+        entry.model = blob.model;
+        entry.rows = blob.rows;
+        entry.cols = blob.cols;
+        entry.offset = offset;
+        entry.size = blob.bytes.size();
+        entry.checksum = ahiModelPackCrc32(blob.bytes.data(), blob.bytes.size());
+        offset = alignUp(offset + entry.size, AHIBSModelPack::ALIGNMENT);
+    }
+    header.size = offset;
+    header.tocChecksum = ahiModelPackCrc32(toc.data(), toc.size() * sizeof(AHIBSModelPackEntry));
+    out.assign((std::size_t) header.size, 0);
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + header.tocOffset, toc.data(), toc.size() * sizeof(AHIBSModelPackEntry));
+    for (std::size_t i = 0; i < mBlobs.size(); i++) {
+        std::memcpy(out.data() + toc[i].offset, mBlobs[i].bytes.data(), mBlobs[i].bytes.size());
+    }
+}
+
+bool AHIBSModelPackWriter::write(const std::string &path, std::string &error) const {
+    for (const Blob &blob: mBlobs) {
+        if (blob.name.size() >= sizeof(AHIBSModelPackEntry::name)) {
+            error = "model name too long: " + blob.name;
+            return false;
+        }
+    }
+    std::vector<char> bytes;
+    write(bytes);
+    std::ofstream file(path, std::ios::binary);
+    file.write(bytes.data(), (std::streamsize) bytes.size());
+    if (!file) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool ahiModelPackAddCv(AHIBSModelPackWriter &writer, const std::string &name, const AHIModelCV &cv,
+                       AHIBSModelPackType floatStorage, std::string &error) {
+    AHIBSModelPackType doubleStorage =
+            floatStorage == AHIBSModelPackType::Float16 ? AHIBSModelPackType::Float16 : AHIBSModelPackType::Float64;
+    uint32_t cols = 1;
+    switch (cv.type) {
+        case 1:
+            writer.addInts(name, cv.vi, 1);
+            return true;
+        case 2:
+            writer.addDoubles(name, cv.vd.data(), (uint32_t) cv.vd.size(), 1, doubleStorage, 2);
+            return true;
+        case 3: {
+            std::vector<double> values;
+            if (!flatten(cv.vvd, values, cols)) {
+                break;
+            }
+            writer.addDoubles(name, values.data(), (uint32_t) cv.vvd.size(), cols, doubleStorage, 3);
+            return true;
+        }
+        case 4:
+            writer.addFloats(name, cv.vf.data(), (uint32_t) cv.vf.size(), 1, floatStorage, 4);
+            return true;
+        case 5: {
+            std::vector<float> values;
+            if (!flatten(cv.vvf, values, cols)) {
+                break;
+            }
+            writer.addFloats(name, values.data(), (uint32_t) cv.vvf.size(), cols, floatStorage, 5);
+            return true;
+        }
+        default:
+            error = "unknown CV model type of " + name;
+            return false;
+    }
+    error = "CV model " + name + " has rows of different lengths";
+    return false;
+}
+
+bool ahiModelPackAddSvr(AHIBSModelPackWriter &writer, const std::string &name, const AHIModelSVR &svr,
+                        AHIBSModelPackType storage, std::string &error) {
+    std::vector<double> vectors;
+    uint32_t cols = 0;
+    if (!flatten(svr.vectors, vectors, cols)) {
+        error = "SVR model " + name + " has support vectors of different lengths";
+        return false;
+    }
+    writer.addDoubles(name + ".vectors", vectors.data(), (uint32_t) svr.vectors.size(), cols, storage);
+    writer.addDoubles(name + ".coefficients", svr.coefficients.data(), (uint32_t) svr.coefficients.size(), 1, storage);
+    writer.addDoubles(name + ".intercepts", svr.intercepts.data(), (uint32_t) svr.intercepts.size(), 1, storage);
+    return true;
+}
+
+bool ahiModelPackDecodeCv(const AHIBSModelPack &pack, const std::string &name, AHIModelCV &cv) {
+    const AHIBSModelPackEntry *entry = pack.find(name);
+    if (entry == nullptr) {
+        return false;
+    }
+    cv = AHIModelCV();
+    cv.name = name;
+    cv.type = (int) entry->model;
+    switch (entry->model) {
+        case 1: {
+            AHIBSModelPackView<int32_t> values = pack.ints(name);
+            if (values.empty()) {
+                return false;
+            }
+            cv.vi.assign(values.data, values.data + values.size());
+            return true;
+        }
+        case 2:
+            return pack.copyDoubles(name, cv.vd);
+        case 3:
+            return decodeRows(pack, name, cv.vvd);
+        case 4:
+            return pack.copyFloats(name, cv.vf);
+        case 5:
+            return decodeRows(pack, name, cv.vvf);
+        default:
+            return false;
+    }
+}
+
+bool ahiModelPackDecodeSvr(const AHIBSModelPack &pack, const std::string &name, AHIModelSVR &svr) {
+    svr = AHIModelSVR();
+    svr.name = name;
+    return decodeRows(pack, name + ".vectors", svr.vectors) &&
+           pack.copyDoubles(name + ".coefficients", svr.coefficients) &&
+           pack.copyDoubles(name + ".intercepts", svr.intercepts);
+}
+
+bool ahiModelPackLayoutCv(const AHIModelCV &cv, std::vector<int32_t> &ints, std::vector<float> &floats, uint32_t &rows,
+                          uint32_t &cols) {
+    ints.clear();
+    floats.clear();
+    cols = 1;
+    switch (cv.type) {
+        case 1:
+            ints.assign(cv.vi.begin(), cv.vi.end());
+            rows = (uint32_t) ints.size();
+            return true;
+        case 2:
+            floats.assign(cv.vd.begin(), cv.vd.end());
+            rows = (uint32_t) floats.size();
+            return true;
+        case 3: {
+            std::vector<double> values;
+            if (!flatten(cv.vvd, values, cols)) {
+                return false;
+            }
+            floats.assign(values.begin(), values.end());
+            rows = (uint32_t) cv.vvd.size();
+            return true;
+        }
+        case 4:
+            floats = cv.vf;
+            rows = (uint32_t) floats.size();
+            return true;
+        case 5:
+            rows = (uint32_t) cv.vvf.size();
+            return flatten(cv.vvf, floats, cols);
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,186 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef ahi_model_pack_hpp
+#define ahi_model_pack_hpp
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AHIBSCereal.hpp"
+
+// Binary model pack: the CV and SVR models of the SDK in one file that is mapped read-only and read in place, instead
+// of one cereal resource per model decoded into vectors.
+//
+// Layout, little endian, every offset from the start of the pack:
+//   AHIBSModelPackHeader   (64 bytes)
+//   AHIBSModelPackEntry[n] table of contents, at header.tocOffset
+//   blobs                  each at a multiple of AHIBSModelPack::ALIGNMENT, rows x cols elements in row order
+// The table of contents and every blob carry a CRC-32, checked when the pack is opened with verify.
+
+enum class AHIBSModelPackType : uint32_t {
+    Int32 = 1,
+    Float32 = 2,
+    Float16 = 3,
+    Float64 = 4
+};
+
+struct AHIBSModelPackHeader {
+    char magic[8];         // "AHIBSPAK"
+    uint32_t version;
+    uint32_t byteOrder;    // 0x01020304 as written by the packing host
+    uint32_t numEntries;
+    uint32_t tocChecksum;  // CRC-32 of the table of contents
+    uint64_t tocOffset;
+    uint64_t size;         // of the whole pack
+    uint8_t reserved[24];
+};
+
+struct AHIBSModelPackEntry {
+    char name[64];         // NUL terminated
+    uint32_t type;         // AHIBSModelPackType of the stored elements
+    uint32_t model;        // AHIModelCV::type the blob decodes to, 0 for the parts of other models
+    uint32_t rows;
+    uint32_t cols;         // 1 for a vector
+    uint64_t offset;
+    uint64_t size;         // bytes
+    uint32_t checksum;     // CRC-32 of the blob
+    uint32_t reserved[3];
+};
+
+// Zero-copy view of a blob stored as T. Empty when the blob is missing or stored as another type.
+template<typename T>
+struct AHIBSModelPackView {
+    const T *data = nullptr;
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+
+    bool empty() const { return data == nullptr; }
+
+    std::size_t size() const { return (std::size_t) rows * cols; }
+
+    const T *row(uint32_t r) const { return data + (std::size_t) r * cols; }
+
+    const T &operator[](std::size_t i) const { return data[i]; }
+
+    const T *begin() const { return data; }
+
+    const T *end() const { return data + size(); }
+};
+
+class AHIBSModelPack {
+public:
+    static const uint32_t VERSION = 1;
+    static const uint32_t ALIGNMENT = 64;
+
+    // Maps the pack file. nullptr with error set if it cannot be mapped, is not a pack of this version, or (verify) a
+    // checksum does not match.
+    static std::unique_ptr<AHIBSModelPack> open(const std::string &path, bool verify, std::string &error);
+
+    // Maps length bytes at offset of fd, as an uncompressed asset is handed out by AAsset_openFileDescriptor64. The
+    // descriptor may be closed once the pack is open.
+    static std::unique_ptr<AHIBSModelPack>
+    open(int fd, uint64_t offset, uint64_t length, bool verify, std::string &error);
+
+    ~AHIBSModelPack();
+
+    AHIBSModelPack(const AHIBSModelPack &) = delete;
+
+    AHIBSModelPack &operator=(const AHIBSModelPack &) = delete;
+
+    const AHIBSModelPackEntry *find(const std::string &name) const;
+
+    const std::vector<const AHIBSModelPackEntry *> &entries() const { return mEntries; }
+
+    const void *blob(const AHIBSModelPackEntry &entry) const { return mBase + entry.offset; }
+
+    AHIBSModelPackView<int32_t> ints(const std::string &name) const;
+
+    AHIBSModelPackView<float> floats(const std::string &name) const;
+
+    AHIBSModelPackView<double> doubles(const std::string &name) const;
+
+    // The blob as floats whatever its floating point storage, converted from float16 / float64. False if missing.
+    bool copyFloats(const std::string &name, std::vector<float> &out) const;
+
+    bool copyDoubles(const std::string &name, std::vector<double> &out) const;
+
+    bool verify(const AHIBSModelPackEntry &entry) const;
+
+private:
+    AHIBSModelPack() = default;
+
+    bool load(bool verifyBlobs, std::string &error);
+
+    template<typename T>
+    AHIBSModelPackView<T> view(const std::string &name, AHIBSModelPackType type) const;
+
+    void *mMapping = nullptr;
+    std::size_t mMappingSize = 0;
+    const uint8_t *mBase = nullptr;
+    uint64_t mSize = 0;
+    std::vector<const AHIBSModelPackEntry *> mEntries; // sorted by name
+};
+
+// Collects blobs and writes them out as a pack.
+class AHIBSModelPackWriter {
+public:
+    void addInts(const std::string &name, const std::vector<int> &values, uint32_t model = 0);
+
+    // rows x cols floats, stored as storage (Float32, Float16 or Float64).
+    void addFloats(const std::string &name, const float *values, uint32_t rows, uint32_t cols,
+                   AHIBSModelPackType storage, uint32_t model = 0);
+
+    void addDoubles(const std::string &name, const double *values, uint32_t rows, uint32_t cols,
+                    AHIBSModelPackType storage, uint32_t model = 0);
+
+    bool write(const std::string &path, std::string &error) const;
+
+    void write(std::vector<char> &out) const;
+
+private:
+    struct Blob {
+        std::string name;
+        AHIBSModelPackType type;
+        uint32_t model;
+        uint32_t rows;
+        uint32_t cols;
+        std::vector<uint8_t> bytes;
+    };
+
+    void add(Blob blob);
+
+    std::vector<Blob> mBlobs;
+};
+
+uint32_t ahiModelPackCrc32(const void *data, std::size_t size);
+
+uint16_t ahiFloatToHalf(float value);
+
+float ahiHalfToFloat(uint16_t value);
+
+// A CV model as the blob name. The float models (vf, vvf) are stored as floatStorage, the double ones (vd, vvd) as
+// Float64 unless floatStorage is Float16. False if a matrix has rows of different lengths.
+bool ahiModelPackAddCv(AHIBSModelPackWriter &writer, const std::string &name, const AHIModelCV &cv,
+                       AHIBSModelPackType floatStorage, std::string &error);
+
+// An SVR model as the blobs name.vectors, name.coefficients and name.intercepts.
+bool ahiModelPackAddSvr(AHIBSModelPackWriter &writer, const std::string &name, const AHIModelSVR &svr,
+                        AHIBSModelPackType storage, std::string &error);
+
+// The CV model the blob name decodes to, as ahiDecodeCvFromBytes returns it. False if it is not a CV model blob.
+bool ahiModelPackDecodeCv(const AHIBSModelPack &pack, const std::string &name, AHIModelCV &cv);
+
+bool ahiModelPackDecodeSvr(const AHIBSModelPack &pack, const std::string &name, AHIModelSVR &svr);
+
+// A decoded CV model laid out as its blob: ints for vi, floats for the others (the doubles of vd / vvd converted),
+// rows x cols in row order. False if a matrix has rows of different lengths.
+bool ahiModelPackLayoutCv(const AHIModelCV &cv, std::vector<int32_t> &ints, std::vector<float> &floats, uint32_t &rows,
+                          uint32_t &cols);
+
+#endif /* ahi_model_pack_hpp */
@@ -6,6 +6,8 @@
 
 #include "Common.hpp"
 
+#if defined(ANDROID) || defined(__ANDROID__)
+
 void BodyScanCommon::throwJavaException(JNIEnv *env, const char *msg) {
     jclass je = env->FindClass("java/lang/Exception");
     env->ThrowNew(je, msg);
@@ -107,4 +109,6 @@ cv::Mat BodyScanCommon::bitmapToMat(JNIEnv *env, jobject bitmap) {
         throwJavaException(env, msg);
     }
     return cv::Mat();
-}
\ No newline at end of file
+}
+
+#endif
@@ -10,9 +10,11 @@
 #define LOGE(LOG_TAG, ...) ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
 #define LOGD(LOG_TAG, ...) ((void)__android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__))
 
+#if defined(ANDROID) || defined(__ANDROID__)
 #include <jni.h>
-#include <opencv2/core/mat.hpp>
 #include <android/bitmap.h>
+#endif
+#include <opencv2/core/mat.hpp>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <android/log.h>
@@ -59,6 +61,7 @@ namespace BodyScanCommon {
         female,
     } SexType;
 
+#if defined(ANDROID) || defined(__ANDROID__)
     void throwJavaException(JNIEnv *env, const char *msg);
 
     void matToBitmap(JNIEnv *env, const cv::Mat &src, jobject bitmap, jboolean needPremultiplyAlpha);
@@ -68,6 +71,7 @@ namespace BodyScanCommon {
     void matToBitmap(JNIEnv *env, const cv::Mat &src, jobject bitmap, jboolean needPremultiplyAlpha);
 
     cv::Mat bitmapToMat(JNIEnv *env, jobject bitmap);
+#endif
 }
 
 #endif //BODYSCAN_COMMON_HPP
@@ -5,6 +5,7 @@
 //
 
 #include <jni.h>
+#include <algorithm>
 #include <string>
 #include <Common.hpp>
 #include "JNIHelper.hpp"
@@ -126,51 +127,113 @@ std::vector<cv::Point2f> JNIHelper::getNativeContour(JNIEnv *env, jobjectArray c
     return nativeContour;
 }
 
-std::map<std::string, std::pair<char *, std::size_t>> JNIHelper::javaModelsMapToCpp(JNIEnv *env, jobject hashMap) {
-    std::map<std::string, std::pair<char *, std::size_t>> modelsMap;
-    try {
-        // Get the Map's entry Set.
+JNIModelSet::~JNIModelSet() {
+    // The native code only read the bytes, nothing to copy back.
+    for (auto &pinned: mPinned) {
+        mEnv->ReleaseByteArrayElements(pinned.first, pinned.second, JNI_ABORT);
+    }
+}
+
+void JNIModelSet::add(const std::string &name, jbyteArray bytes, jint size) {
+    std::size_t length = std::min((std::size_t) std::max(size, 0), (std::size_t) mEnv->GetArrayLength(bytes));
+    char *buffer;
+    if (mCopy) {
+        mCopies.emplace_back(new char[length]);
+        buffer = mCopies.back().get();
+        mEnv->GetByteArrayRegion(bytes, 0, (jsize) length, reinterpret_cast<jbyte *>(buffer));
+    } else {
+        jbyte *elements = mEnv->GetByteArrayElements(bytes, nullptr);
+        if (elements == nullptr) {
+            return;
+        }
+        mPinned.emplace_back(bytes, elements);
+        buffer = reinterpret_cast<char *>(elements);
+    }
+    models[name] = std::make_pair(buffer, length);
+}
+
+namespace {
+    // Members of the Map<String, Pair<ByteArray, Int>> the models are handed in. Method and field IDs stay valid while
+    // their class is loaded, the Pair class is held by a global reference for that.
+    struct ModelsMapIds {
+        jmethodID mapEntrySet;
+        jmethodID setIterator;
+        jmethodID iteratorHasNext;
+        jmethodID iteratorNext;
+        jmethodID entryGetKey;
+        jmethodID entryGetValue;
+        jclass pairClass;
+        jfieldID pairFirst;
+        jfieldID pairSecond;
+        jmethodID integerIntValue;
+    };
+
+    ModelsMapIds lookUpModelsMapIds(JNIEnv *env) {
+        ModelsMapIds ids;
         jclass mapClass = env->FindClass("java/util/Map");
-        jmethodID entrySet =
-                env->GetMethodID(mapClass, "entrySet", "()Ljava/util/Set;");
-        jobject set = env->CallObjectMethod(hashMap, entrySet);
-        // Obtain an iterator over the Set
+        ids.mapEntrySet = env->GetMethodID(mapClass, "entrySet", "()Ljava/util/Set;");
         jclass setClass = env->FindClass("java/util/Set");
-        jmethodID iterator =
-                env->GetMethodID(setClass, "iterator", "()Ljava/util/Iterator;");
-        jobject iter = env->CallObjectMethod(set, iterator);
-        // Get the Iterator method IDs
+        ids.setIterator = env->GetMethodID(setClass, "iterator", "()Ljava/util/Iterator;");
         jclass iteratorClass = env->FindClass("java/util/Iterator");
-        jmethodID hasNext = env->GetMethodID(iteratorClass, "hasNext", "()Z");
-        jmethodID next =
-                env->GetMethodID(iteratorClass, "next", "()Ljava/lang/Object;");
-        // Get the Entry class method IDs
+        ids.iteratorHasNext = env->GetMethodID(iteratorClass, "hasNext", "()Z");
+        ids.iteratorNext = env->GetMethodID(iteratorClass, "next", "()Ljava/lang/Object;");
         jclass entryClass = env->FindClass("java/util/Map$Entry");
-        jmethodID getKey =
-                env->GetMethodID(entryClass, "getKey", "()Ljava/lang/Object;");
-        jmethodID getValue =
-                env->GetMethodID(entryClass, "getValue", "()Ljava/lang/Object;");
+        ids.entryGetKey = env->GetMethodID(entryClass, "getKey", "()Ljava/lang/Object;");
+        ids.entryGetValue = env->GetMethodID(entryClass, "getValue", "()Ljava/lang/Object;");
         jclass pairClass = env->FindClass("kotlin/Pair");
-        jfieldID first = env->GetFieldID(pairClass, "first", "Ljava/lang/Object;");
-        jfieldID second = env->GetFieldID(pairClass, "second", "Ljava/lang/Object;");
-        // Iterate over the entry Set
-        while (env->CallBooleanMethod(iter, hasNext)) {
-            jobject entry = env->CallObjectMethod(iter, next);
-            auto key = (jstring) env->CallObjectMethod(entry, getKey);
-            std::string keyStr = env->GetStringUTFChars(key, nullptr);
-            auto value = env->CallObjectMethod(entry, getValue);
-            auto jBuffer = env->GetObjectField(value, first);
-            auto jBufferSize = env->GetObjectField(value, second);
-            auto *buffer = reinterpret_cast< char *>(env->GetByteArrayElements(reinterpret_cast<jbyteArray>(jBuffer), nullptr));
-            auto bufferSize = env->CallIntMethod(jBufferSize, env->GetMethodID(env->FindClass("java/lang/Integer"), "intValue", "()I"));;
-            std::pair<char *, std::size_t> valuePair = std::make_pair(buffer, bufferSize);
-            modelsMap.insert(std::make_pair(keyStr, valuePair));
-            env->DeleteLocalRef(entry);
-            env->DeleteLocalRef(key);
-            env->DeleteLocalRef(value);
+        ids.pairClass = (jclass) env->NewGlobalRef(pairClass);
+        ids.pairFirst = env->GetFieldID(pairClass, "first", "Ljava/lang/Object;");
+        ids.pairSecond = env->GetFieldID(pairClass, "second", "Ljava/lang/Object;");
+        jclass integerClass = env->FindClass("java/lang/Integer");
+        ids.integerIntValue = env->GetMethodID(integerClass, "intValue", "()I");
+        env->DeleteLocalRef(mapClass);
+        env->DeleteLocalRef(setClass);
+        env->DeleteLocalRef(iteratorClass);
+        env->DeleteLocalRef(entryClass);
+        env->DeleteLocalRef(pairClass);
+        env->DeleteLocalRef(integerClass);
+        return ids;
+    }
+
+    const ModelsMapIds &modelsMapIds(JNIEnv *env) {
+        static const ModelsMapIds ids = lookUpModelsMapIds(env);
+        return ids;
+    }
+}
+
+void JNIHelper::onLoad(JNIEnv *env) {
+    modelsMapIds(env);
+}
+
+std::unique_ptr<JNIModelSet> JNIHelper::javaModelsMapToCpp(JNIEnv *env, jobject hashMap, bool copy) {
+    std::unique_ptr<JNIModelSet> modelSet(new JNIModelSet(env, copy));
+    const ModelsMapIds &ids = modelsMapIds(env);
+    jobject set = env->CallObjectMethod(hashMap, ids.mapEntrySet);
+    jobject iter = env->CallObjectMethod(set, ids.setIterator);
+    while (env->CallBooleanMethod(iter, ids.iteratorHasNext)) {
+        jobject entry = env->CallObjectMethod(iter, ids.iteratorNext);
+        auto key = (jstring) env->CallObjectMethod(entry, ids.entryGetKey);
+        jobject value = env->CallObjectMethod(entry, ids.entryGetValue);
+        auto jBuffer = (jbyteArray) env->GetObjectField(value, ids.pairFirst);
+        jobject jBufferSize = env->GetObjectField(value, ids.pairSecond);
+        const char *keyChars = env->GetStringUTFChars(key, nullptr);
+        std::string keyStr = keyChars;
+        env->ReleaseStringUTFChars(key, keyChars);
+        if (jBuffer != nullptr) {
+            modelSet->add(keyStr, jBuffer, env->CallIntMethod(jBufferSize, ids.integerIntValue));
         }
-    } catch (std::exception &e) {}
-    return modelsMap;
+        // a pinned array keeps its local reference until the set releases it
+        if (copy) {
+            env->DeleteLocalRef(jBuffer);
+        }
+        env->DeleteLocalRef(jBufferSize);
+        env->DeleteLocalRef(entry);
+        env->DeleteLocalRef(key);
+        env->DeleteLocalRef(value);
+    }
+    env->DeleteLocalRef(iter);
+    env->DeleteLocalRef(set);
+    return modelSet;
 }
 
 std::vector<cv::Mat> JNIHelper::javaBitmapArrayToCpp(JNIEnv *env, jobjectArray silhouettes) {
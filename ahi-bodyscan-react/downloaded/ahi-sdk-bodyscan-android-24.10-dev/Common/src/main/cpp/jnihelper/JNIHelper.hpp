@@ -8,12 +8,41 @@
 #define BODYSCAN_JNIHELPER_HPP
 
 #include <map>
+#include <memory>
 #include <opencv2/core/types.hpp>
 #include <opencv2/core/types_c.h>
 #include "Common.hpp"
 
+// The model bytes of a Kotlin Map<String, Pair<ByteArray, Int>>, as the native code takes them in models. Pinned, the
+// Java arrays are held only until the set is destroyed, which must happen within the native call that made it;
+// copied, the set owns its bytes and may outlive the call.
+class JNIModelSet {
+public:
+    JNIModelSet(JNIEnv *env, bool copy) : mEnv(env), mCopy(copy) {}
+
+    ~JNIModelSet();
+
+    JNIModelSet(const JNIModelSet &) = delete;
+
+    JNIModelSet &operator=(const JNIModelSet &) = delete;
+
+    void add(const std::string &name, jbyteArray bytes, jint size);
+
+    std::map<std::string, std::pair<char *, std::size_t>> models;
+
+private:
+    JNIEnv *mEnv;
+    bool mCopy;
+    std::vector<std::pair<jbyteArray, jbyte *>> mPinned;
+    std::vector<std::unique_ptr<char[]>> mCopies;
+};
+
 class JNIHelper {
 public:
+    // Looks up the classes and member IDs the helpers use, once per process. Called from JNI_OnLoad of the modules,
+    // otherwise on first use.
+    static void onLoad(JNIEnv *env);
+
     static BodyScanCommon::Profile getNativeProfile(JNIEnv *env, jobject profile);
 
     static BodyScanCommon::SexType getNativeSexType(JNIEnv *env, jobject sex);
@@ -26,7 +55,7 @@ public:
 
     static jobjectArray getJContour(JNIEnv *env, std::vector<cv::Point2f> nativeContour);
 
-    static std::map<std::string, std::pair<char *, std::size_t>> javaModelsMapToCpp(JNIEnv *env, jobject hashMap);
+    static std::unique_ptr<JNIModelSet> javaModelsMapToCpp(JNIEnv *env, jobject hashMap, bool copy = false);
 
     static std::vector<std::map<std::string, cv::Point2f>> javaJointsArrayToCpp(JNIEnv *env, jobjectArray joints);
 
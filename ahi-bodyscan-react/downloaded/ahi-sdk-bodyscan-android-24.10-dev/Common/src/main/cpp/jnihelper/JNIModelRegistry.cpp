@@ -0,0 +1,31 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include <jni.h>
+#include "JNIModelRegistry.hpp"
+
+std::mutex JNIModelRegistry::mMutex;
+jlong JNIModelRegistry::mNextHandle = 1;
+std::map<jlong, std::shared_ptr<JNIModelSet>> JNIModelRegistry::mSets;
+
+jlong JNIModelRegistry::add(JNIEnv *env, jobject hashMap) {
+    std::shared_ptr<JNIModelSet> modelSet(JNIHelper::javaModelsMapToCpp(env, hashMap, true));
+    std::lock_guard<std::mutex> lock(mMutex);
+    jlong handle = mNextHandle++;
+    mSets[handle] = modelSet;
+    return handle;
+}
+
+std::shared_ptr<JNIModelSet> JNIModelRegistry::get(jlong handle) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto iter = mSets.find(handle);
+    return iter == mSets.end() ? nullptr : iter->second;
+}
+
+bool JNIModelRegistry::remove(jlong handle) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mSets.erase(handle) > 0;
+}
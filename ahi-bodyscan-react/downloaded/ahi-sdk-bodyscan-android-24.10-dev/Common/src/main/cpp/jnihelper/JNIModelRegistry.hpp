@@ -0,0 +1,33 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef BODYSCAN_JNIMODELREGISTRY_HPP
+#define BODYSCAN_JNIMODELREGISTRY_HPP
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include "JNIHelper.hpp"
+
+// Model sets copied out of the Java heap once and then referred to by handle, so a scan does not hand the models over
+// again. A set stays alive while a call that got it is running, even if it is removed meanwhile.
+class JNIModelRegistry {
+public:
+    // Copies the models of a Map<String, Pair<ByteArray, Int>>. Returns the handle of the set, never 0.
+    static jlong add(JNIEnv *env, jobject hashMap);
+
+    // nullptr for an unknown or removed handle.
+    static std::shared_ptr<JNIModelSet> get(jlong handle);
+
+    static bool remove(jlong handle);
+
+private:
+    static std::mutex mMutex;
+    static jlong mNextHandle;
+    static std::map<jlong, std::shared_ptr<JNIModelSet>> mSets;
+};
+
+#endif //BODYSCAN_JNIMODELREGISTRY_HPP
@@ -0,0 +1,46 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+package com.advancedhumanimaging.sdk.bodyscan.common
+
+import android.content.Context
+import com.advancedhumanimaging.sdk.common.models.AHIFile
+import java.io.File
+import java.io.IOException
+
+/**
+ * The binary model pack (written by bodyscan_pack): the CV and SVR models in one file the native parts map and read in
+ * place, instead of being handed every model as a resource to decode.
+ */
+object AHIBSModelPack {
+    /**
+     * File name of the pack, downloaded to local storage or shipped in the assets under Encoded.
+     */
+    const val NAME = "ahi_models.ahibspak"
+
+    /**
+     * Opens the pack with openPath when it is in local storage, otherwise with openFd over the asset, which must be
+     * stored uncompressed (noCompress "ahibspak"). The descriptor is closed once openFd returns.
+     * @return False if there is no pack or it failed to open, the models then come from the resources.
+     */
+    fun open(
+        context: Context,
+        openPath: (String) -> Boolean,
+        openFd: (Int, Long, Long) -> Boolean
+    ): Boolean {
+        val localFile = AHIFile.getLocalPath(context, NAME)?.let { File(it) } ?: File(context.filesDir, NAME)
+        if (localFile.exists()) {
+            return openPath(localFile.absolutePath)
+        }
+        return try {
+            context.assets.openFd("Encoded/$NAME").use { asset ->
+                openFd(asset.parcelFileDescriptor.fd, asset.startOffset, asset.length)
+            }
+        } catch (e: IOException) {
+            false
+        }
+    }
+}
@@ -6,6 +6,7 @@
 #include <map>
 #include "AHIAvatarGenClassificationHelper.hpp"
 #include "AHILogging.hpp"
+#include "ahiSvrEngine.hpp"
 
 namespace ahi_avatar_gen {
 
@@ -13,6 +14,54 @@ namespace ahi_avatar_gen {
         // nothing to construct
     }
 
+    cv::Mat classification_helper::silhouette_integral(cv::Mat const &silhouette) {
+        cv::Mat channel = silhouette;
+        if (silhouette.channels() > 1) {
+            cv::extractChannel(silhouette, channel, 0);
+        }
+        cv::Mat integral;
+        cv::integral(channel, integral, CV_64F);
+        return integral;
+    }
+
+    std::vector<int> classification_helper::filled_circle_half_widths(int radius) {
+        // the midpoint recurrence of cv::circle for 8-connected filled circles: the row dy off the center gets dx,
+        // the row dx gets dy
+        std::vector<int> half_widths(radius + 1, -1);
+        int err = 0, dx = radius, dy = 0, plus = 1, minus = (radius << 1) - 1;
+        while (dx >= dy) {
+            half_widths[dy] = std::max(half_widths[dy], dx);
+            half_widths[dx] = std::max(half_widths[dx], dy);
+            dy++;
+            err += plus;
+            plus += 2;
+            int mask = (err <= 0) - 1;
+            err -= minus & mask;
+            dx += mask;
+            minus -= mask & 2;
+        }
+        return half_widths;
+    }
+
+    double classification_helper::disc_sum(cv::Mat const &integral, cv::Point center, int radius) {
+        std::vector<int> half_widths = filled_circle_half_widths(radius);
+        int rows = integral.rows - 1;
+        int cols = integral.cols - 1;
+        double total = 0;
+        for (int y = std::max(0, center.y - radius); y <= std::min(rows - 1, center.y + radius); y++) {
+            int half_width = half_widths[std::abs(y - center.y)];
+            int x0 = std::max(0, center.x - half_width);
+            int x1 = std::min(cols - 1, center.x + half_width);
+            if (half_width < 0 || x0 > x1) {
+                continue;
+            }
+            const double *top = integral.ptr<double>(y);
+            const double *bottom = integral.ptr<double>(y + 1);
+            total += (bottom[x1 + 1] - bottom[x0]) - (top[x1 + 1] - top[x0]);
+        }
+        return total;
+    }
+
     std::vector<double> classification_helper::extract_image_features_v1(
             double height,
             double weight,
@@ -175,6 +224,7 @@ namespace ahi_avatar_gen {
                 int N_levels = 10;
                 int level_depth = cropped_image.rows / N_levels;
                 int level_radius = cropped_image.cols / 20;
+                cv::Mat cropped_integral = silhouette_integral(cropped_image);
 
                 for (int n = 0; n < N_levels; n++) {
                     /*cv::Rect rect;
@@ -194,13 +244,7 @@ namespace ahi_avatar_gen {
 
                     for (int m = 1; m <= 10; m++) {
                         int d = m * level_radius;
-                        cv::Mat mask = cv::Mat::zeros(cropped_image.size(), cropped_image.type());
-                        circle(mask, slice_center, d, 255, -1);
-                        cv::Mat slice;
-                        cv::bitwise_and(cropped_image, mask, slice);
-                        //imshow("slice", slice);
-                        //waitKey(0);
-                        features.push_back(sum(slice).val[0] / (Sum_Total + 1.0e-6));
+                        features.push_back(disc_sum(cropped_integral, slice_center, d) / (Sum_Total + 1.0e-6));
                     }
 
                 }
@@ -419,6 +463,7 @@ namespace ahi_avatar_gen {
                 int N_levels = 10;//20;
                 int level_depth = cropped_image.rows / N_levels;
                 int level_radius = cropped_image.cols / 20;
+                cv::Mat cropped_integral = silhouette_integral(cropped_image);
 
                 for (int n = 0; n < N_levels; n++) {
 
@@ -433,16 +478,7 @@ namespace ahi_avatar_gen {
 
                     for (int m = 1; m <= 10; m++) {
                         int d = m * level_radius;
-                        cv::Mat mask = cv::Mat::zeros(cropped_image.size(), cropped_image.type());
-                        circle(mask, slice_center, d, 255, -1);
-                        cv::Mat slice;
-                        cv::bitwise_and(cropped_image, mask, slice);
-                        //imshow("slice", slice);
-                        // waitKey(0);
-                        features.push_back(sum(slice).val[0] / (Sum_Total + 1.0e-6));
-                        //features.push_back(sum(slice).val[0]);
-
-                        //features.push_back(countNonZero(slice));
+                        features.push_back(disc_sum(cropped_integral, slice_center, d) / (Sum_Total + 1.0e-6));
                     }
 
                 }
@@ -631,988 +667,6 @@ namespace ahi_avatar_gen {
         return Mean;
     }
 
-//
-///#################################################################################
-    double
-    classification_helper::svr_image_features_predictor_predict(std::map<std::string, AHIModelSVR> &svrModels, double features[], std::string param) {
-        // Get ref to SVR
-        AHIModelSVR svr;
-        if (param == "chest") {
-            svr = svrModels.at("chest_svr_image_features");
-        } else if (param == "waist") {
-            svr = svrModels.at("waist_svr_image_features");
-        } else if (param == "hip") {
-            svr = svrModels.at("hip_svr_image_features");
-        } else if (param == "inseam") {
-            svr = svrModels.at("inseam_svr_image_features");
-        } else if (param == "thigh_UWA_all") {
-            svr = svrModels.at("thigh_svr_image_features_UWA_all");
-        } else if (param == "weight") {
-            svr = svrModels.at("weight_svr_image_features");
-        } else if (param == "weight_UWA_all") {
-            svr = svrModels.at("weight_svr_image_features_UWA_all");
-        } else if (param == "fat") {
-            svr = svrModels.at("fat_svr_image_features");
-        } else if (param == "fat_UWA_all") {
-            svr = svrModels.at("fat_svr_image_features_UWA_all");
-        } else if (param == "gynoid_UWA_all") {
-            svr = svrModels.at("gynoid_svr_image_features_UWA_all");
-        } else if (param == "andriod_UWA_all") {
-            svr = svrModels.at("andriod_svr_image_features_UWA_all");
-        } else if (param == "visceral_UWA_all") {
-            svr = svrModels.at("visceral_svr_image_features_UWA_all");
-        } else if (param == "ffm_UWA_all") {
-            svr = svrModels.at("FFM_svr_image_features_UWA_all");
-        }
-
-        size_t num_vectors = svr.vectors.size();
-
-        //compute the mapped vectors wrt support vectors
-        double kernels[num_vectors];
-        double kernel;
-        switch (KERNEL_TYPE) {
-            case 'l':
-                // <x,x'>
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = kernel;
-                }
-                break;
-            case 'p':
-                // (y<x,x'>+r)^d
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = pow((KERNEL_GAMMA * kernel) + KERNEL_COEF, KERNEL_DEGREE);// (1.0 + kernel) * (1.0 + kernel); //
-                }
-                break;
-            case 'r':
-                // exp(-y|x-x'|^2)
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += pow(svr.vectors[i][j] - features[j], 2);
-                    }
-                    kernels[i] = exp(-KERNEL_GAMMA * kernel);
-                }
-                break;
-            case 's':
-                // tanh(y<x,x'>+r)
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = tanh((KERNEL_GAMMA * kernel) + KERNEL_COEF);
-                }
-                break;
-        }
-
-        //compute the product of kernel and coeff
-        double predicted = 0.0;
-        for (int i = 0; i < num_vectors; i++) {
-            predicted = predicted + kernels[i] * svr.coefficients[i];
-            if (i == num_vectors - 1) {
-                predicted = predicted + svr.intercepts[0];
-            }
-        }
-
-        return predicted;
-    }
-
-
-///
-    double classification_helper::male_svr_image_features_predictor_predict(std::map<std::string, AHIModelSVR> &svrModels,
-                                                                            double features[],
-                                                                            std::string param) {
-        if (features == NULL) {
-            AHILog(ANDROID_LOG_ERROR, "FEATURES for %s is null", param.c_str());
-        }
-
-        // Get ref to SVR
-        AHIModelSVR svr;
-        if (param == "chest") {
-            svr = svrModels.at("male_chest_svr_image_features");
-        } else if (param == "waist") {
-            svr = svrModels.at("male_waist_svr_image_features");
-        } else if (param == "hip") {
-            svr = svrModels.at("male_hip_svr_image_features");
-        } else if (param == "inseam") {
-            svr = svrModels.at("male_inseam_svr_image_features");
-        }
-
-        // Get boundaries
-        size_t num_vectors = svr.vectors.size();
-
-        //compute the mapped vectors wrt support vectors
-        double kernels[num_vectors];
-        double kernel;
-        switch (KERNEL_TYPE) {
-            case 'l':
-                // <x,x'>
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = kernel;
-                }
-                break;
-            case 'p':
-                // (y<x,x'>+r)^d
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        double featureJ = 0;
-                        if (features != NULL) {
-                            featureJ = features[j];
-                        }
-                        kernel += svr.vectors[i][j] * featureJ;
-                    }
-                    kernels[i] = pow((KERNEL_GAMMA * kernel) + KERNEL_COEF, KERNEL_DEGREE); //(1.0 + kernel) * (1.0 + kernel);//
-                }
-                break;
-            case 'r':
-                // exp(-y|x-x'|^2)
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += pow(svr.vectors[i][j] - features[j], 2);
-                    }
-                    kernels[i] = exp(-KERNEL_GAMMA * kernel);
-                }
-                break;
-            case 's':
-                // tanh(y<x,x'>+r)
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = tanh((KERNEL_GAMMA * kernel) + KERNEL_COEF);
-                }
-                break;
-        }
-
-        //compute the product of kernel and coeff
-        double predicted = 0.0;
-        for (int i = 0; i < num_vectors; i++) {
-            predicted = predicted + kernels[i] * svr.coefficients[i];
-            if (i == num_vectors - 1) {
-                predicted = predicted + svr.intercepts[0];
-            }
-        }
-
-        return predicted;
-    }
-
-
-//female predict function definition
-    double classification_helper::female_svr_image_features_predictor_predict(std::map<std::string, AHIModelSVR> &svrModels, double features[],
-                                                                              const std::string &param) {
-
-        // Get ref to SVR
-        AHIModelSVR svr;
-        if (param == "chest") {
-            svr = svrModels.at("female_chest_svr_image_features");
-        } else if (param == "waist") {
-            svr = svrModels.at("female_waist_svr_image_features");
-        } else if (param == "hip") {
-            svr = svrModels.at("female_hip_svr_image_features");
-        } else if (param == "inseam") {
-            svr = svrModels.at("female_inseam_svr_image_features");
-        }
-
-        size_t num_vectors = svr.vectors.size();
-
-        //compute the mapped vectors wrt support vectors
-        double kernels[num_vectors];
-        double kernel;
-        switch (KERNEL_TYPE) {
-            case 'l':
-                // <x,x'>
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = kernel;
-                }
-                break;
-            case 'p':
-                // (y<x,x'>+r)^d
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = pow((KERNEL_GAMMA * kernel) + KERNEL_COEF, KERNEL_DEGREE);//(1.0 + kernel) * (1.0 + kernel);//
-                }
-                break;
-            case 'r':
-                // exp(-y|x-x'|^2)
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += pow(svr.vectors[i][j] - features[j], 2);
-                    }
-                    kernels[i] = exp(-KERNEL_GAMMA * kernel);
-                }
-                break;
-            case 's':
-                // tanh(y<x,x'>+r)
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = tanh((KERNEL_GAMMA * kernel) + KERNEL_COEF);
-                }
-                break;
-        }
-
-        //compute the product of kernel and coeff
-        double predicted = 0.0;
-        for (int i = 0; i < num_vectors; i++) {
-            if (param == "waist") {
-                predicted = predicted + kernels[i] * svr.coefficients[i];
-
-                if (i == num_vectors - 1) {
-                    predicted = predicted + svr.intercepts[0];
-                }
-            }
-
-            if (param == "chest") {
-                predicted = predicted + kernels[i] * svr.coefficients[i];
-
-                if (i == num_vectors - 1) {
-                    predicted = predicted + svr.intercepts[0];
-                }
-            }
-
-            if (param == "hip") {
-                predicted = predicted + kernels[i] * svr.coefficients[i];
-
-                if (i == num_vectors - 1) {
-                    predicted = predicted + svr.intercepts[0];
-                }
-            }
-
-
-            if (param == "inseam") {
-                predicted = predicted + kernels[i] * svr.coefficients[i];
-
-                if (i == num_vectors - 1) {
-                    predicted = predicted + svr.intercepts[0];
-                }
-            }
-
-
-        }
-
-        return predicted;
-    }
-
-
-#if 0 /// this for a model for both male and female
-
-    double classification_helper::svr_image_features_predictor_v2_predict(double features[], std::string param)
-    {
-
-        int num_vectors;
-
-        if (param == "chest")
-        {
-            num_vectors = sizeof(chest_svr_image_features_v2::vectors) / (N_FEATURES_svr_image_features * 8);
-            //std::cout <<"\n chest num_vectors = " << num_vectors;
-        }
-        if (param == "waist")
-        {
-            num_vectors = sizeof(waist_svr_image_features_v2::vectors) / (N_FEATURES_svr_image_features * 8);
-            //std::cout <<"\n num_vectors = " << num_vectors;
-        }
-        if (param == "hip")
-        {
-            num_vectors = sizeof(hip_svr_image_features_v2::vectors) / (N_FEATURES_svr_image_features * 8);
-            //std::cout <<"\n num_vectors = " << num_vectors;
-        }
-        if (param == "inseam")
-        {
-            num_vectors = sizeof(inseam_svr_image_features_v2::vectors) / (N_FEATURES_svr_image_features * 8);
-            //std::cout <<"\n num_vectors = " << num_vectors;
-        }
-
-        if (param == "weight")
-        {
-            num_vectors = sizeof(weight_svr_image_features_v2::vectors) / (N_FEATURES_svr_image_features * 8);
-            //std::cout <<"\n num_vectors = " << num_vectors;
-        }
-
-        if (param == "fat")
-        {
-            num_vectors = sizeof(fat_svr_image_features_v2::vectors) / (N_FEATURES_svr_image_features * 8);
-            //std::cout <<"\n num_vectors = " << num_vectors;
-        }
-
-        //compute the mapped vectors wrt support vectors
-        double kernels[num_vectors];
-        double kernel;
-        switch (KERNEL_TYPE)
-        {
-            case 'l':
-                // <x,x'>
-                for (int i = 0; i < num_vectors; i++)
-                {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++)
-                    {
-                        if (param == "waist")
-                            kernel += waist_svr_image_features_v2::vectors[i][j] * features[j];
-                        if (param == "chest")
-                            kernel += chest_svr_image_features_v2::vectors[i][j] * features[j];
-                        if (param == "hip")
-                            kernel += hip_svr_image_features_v2::vectors[i][j] * features[j];
-                        if (param == "inseam")
-                            kernel += inseam_svr_image_features_v2::vectors[i][j] * features[j];
-                        if (param == "inseam")
-                            kernel += inseam_svr_image_features_v2::vectors[i][j] * features[j];
-                    }
-                    kernels[i] = kernel;
-
-                }
-                break;
-            case 'p':
-                // (y<x,x'>+r)^d
-                for (int i = 0; i < num_vectors; i++)
-                {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++)
-                    {
-                        if (param == "waist")
-                            kernel += waist_svr_image_features_v2::vectors[i][j] * features[j];
-                        if (param == "chest")
-                            kernel += chest_svr_image_features_v2::vectors[i][j] * features[j];
-                        if (param == "hip")
-                            kernel += hip_svr_image_features_v2::vectors[i][j] * features[j];
-                        if (param == "inseam")
-                            kernel += inseam_svr_image_features_v2::vectors[i][j] * features[j];
-                        if (param == "weight")
-                            kernel += weight_svr_image_features_v2::vectors[i][j] * features[j];
-                        if (param == "fat")
-                            kernel += fat_svr_image_features_v2::vectors[i][j] * features[j];
-
-                    }
-                    kernels[i] = pow((KERNEL_GAMMA * kernel) + KERNEL_COEF, KERNEL_DEGREE);// (1.0 + kernel) * (1.0 + kernel); //
-                }
-                break;
-            case 'r':
-                // exp(-y|x-x'|^2)
-                for (int i = 0; i < num_vectors; i++)
-                {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++)
-                    {
-                        kernel += pow(waist_svr_image_features_v2::vectors[i][j] - features[j], 2);
-                    }
-                    kernels[i] = exp(-KERNEL_GAMMA * kernel);
-                }
-                break;
-            case 's':
-                // tanh(y<x,x'>+r)
-                for (int i = 0; i < num_vectors; i++)
-                {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++)
-                    {
-                        kernel += waist_svr_image_features_v2::vectors[i][j] * features[j];
-                    }
-                    kernels[i] = tanh((KERNEL_GAMMA * kernel) + KERNEL_COEF);
-                }
-                break;
-        }
-
-        //compute the product of kernel and coeff
-        double predicted = 0.0;
-        for (int i = 0; i < num_vectors; i++)
-        {
-            if (param == "waist")
-            {
-                predicted = predicted + kernels[i] * waist_svr_image_features_v2::coefficients[i];
-
-                if (i == num_vectors - 1)
-                {
-                    predicted = predicted + waist_svr_image_features_v2::intercepts[0];
-                }
-            }
-
-            if (param == "chest")
-            {
-                predicted = predicted + kernels[i] * chest_svr_image_features_v2::coefficients[i];
-
-                if (i == num_vectors - 1)
-                {
-                    predicted = predicted + chest_svr_image_features_v2::intercepts[0];
-                }
-            }
-
-            if (param == "hip")
-            {
-                predicted = predicted + kernels[i] * hip_svr_image_features_v2::coefficients[i];
-
-                if (i == num_vectors - 1)
-                {
-                    predicted = predicted + hip_svr_image_features_v2::intercepts[0];
-                }
-            }
-
-            if (param == "inseam")
-            {
-                predicted = predicted + kernels[i] * inseam_svr_image_features_v2::coefficients[i];
-
-                if (i == num_vectors - 1)
-                {
-                    predicted = predicted + inseam_svr_image_features_v2::intercepts[0];
-                }
-            }
-
-            if (param == "weight")
-            {
-                predicted = predicted + kernels[i] * weight_svr_image_features_v2::coefficients[i];
-
-                if (i == num_vectors - 1)
-                {
-                    predicted = predicted + weight_svr_image_features_v2::intercepts[0];
-                }
-            }
-
-            if (param == "fat")
-            {
-                predicted = predicted + kernels[i] * fat_svr_image_features_v2::coefficients[i];
-
-                if (i == num_vectors - 1)
-                {
-                    predicted = predicted + fat_svr_image_features_v2::intercepts[0];
-                }
-            }
-        }
-
-        return predicted;
-
-    }
-
-#endif
-
-    double classification_helper::male_svr_image_features_predictor_v2_predict(std::map<std::string, AHIModelSVR> &svrModels, double features[],
-                                                                               std::string param) {
-        // Get ref to SVR
-        AHIModelSVR svr;
-        if (param == "chest") {
-            svr = svrModels.at("male_chest_svr_image_features_v2");
-        } else if (param == "waist") {
-            svr = svrModels.at("male_waist_svr_image_features_v2");
-        } else if (param == "hip") {
-            svr = svrModels.at("male_hip_svr_image_features_v2");
-        } else if (param == "inseam") {
-            svr = svrModels.at("male_inseam_svr_image_features_v2");
-        } else if (param == "chest_UWA_all") {
-            svr = svrModels.at("male_chest_svr_image_features_v2_UWA_all");
-        } else if (param == "waist_UWA_all") {
-            svr = svrModels.at("male_waist_svr_image_features_v2_UWA_all");
-        } else if (param == "hip_UWA_all") {
-            svr = svrModels.at("male_hip_svr_image_features_v2_UWA_all");
-        } else if (param == "inseam_UWA_all") {
-            svr = svrModels.at("male_inseam_svr_image_features_v2_UWA_all");
-        }
-
-        size_t num_vectors = svr.vectors.size();
-
-        //compute the mapped vectors wrt support vectors
-        double kernels[num_vectors];
-        double kernel;
-        switch (KERNEL_TYPE) {
-            case 'l':
-                // <x,x'>
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = kernel;
-                }
-                break;
-            case 'p':
-                // (y<x,x'>+r)^d
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = pow((KERNEL_GAMMA * kernel) + KERNEL_COEF, KERNEL_DEGREE); //(1.0 + kernel) * (1.0 + kernel);//
-                }
-                break;
-            case 'r':
-                // exp(-y|x-x'|^2)
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += pow(svr.vectors[i][j] - features[j], 2);
-                    }
-                    kernels[i] = exp(-KERNEL_GAMMA * kernel);
-                }
-                break;
-            case 's':
-                // tanh(y<x,x'>+r)
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = tanh((KERNEL_GAMMA * kernel) + KERNEL_COEF);
-                }
-                break;
-        }
-
-        //compute the product of kernel and coeff
-        double predicted = 0.0;
-        for (int i = 0; i < num_vectors; i++) {
-            predicted = predicted + kernels[i] * svr.coefficients[i];
-            if (i == num_vectors - 1) {
-                predicted = predicted + svr.intercepts[0];
-            }
-        }
-
-        return predicted;
-    }
-
-
-//female predict function definition
-    double classification_helper::female_svr_image_features_predictor_v2_predict(std::map<std::string, AHIModelSVR> &svrModels,
-                                                                                 double features[],
-                                                                                 std::string param) {
-        // Get ref to SVR
-        AHIModelSVR svr;
-        if (param == "chest") {
-            svr = svrModels.at("female_chest_svr_image_features_v2");
-        } else if (param == "waist") {
-            svr = svrModels.at("female_waist_svr_image_features_v2");
-        } else if (param == "hip") {
-            svr = svrModels.at("female_hip_svr_image_features_v2");
-        } else if (param == "inseam") {
-            svr = svrModels.at("female_inseam_svr_image_features_v2");
-        } else if (param == "chest_UWA_all") {
-            svr = svrModels.at("female_chest_svr_image_features_v2_UWA_all");
-        } else if (param == "waist_UWA_all") {
-            svr = svrModels.at("female_waist_svr_image_features_v2_UWA_all");
-        } else if (param == "hip_UWA_all") {
-            svr = svrModels.at("female_hip_svr_image_features_v2_UWA_all");
-        } else if (param == "inseam_UWA_all") {
-            svr = svrModels.at("female_inseam_svr_image_features_v2_UWA_all");
-        }
-
-        size_t num_vectors = svr.vectors.size();
-
-        //compute the mapped vectors wrt support vectors
-        double kernels[num_vectors];
-        double kernel;
-        switch (KERNEL_TYPE) {
-            case 'l':
-                // <x,x'>
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = kernel;
-                }
-                break;
-            case 'p':
-                // (y<x,x'>+r)^d
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = pow((KERNEL_GAMMA * kernel) + KERNEL_COEF, KERNEL_DEGREE);//(1.0 + kernel) * (1.0 + kernel);//
-                }
-                break;
-            case 'r':
-                // exp(-y|x-x'|^2)
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += pow(svr.vectors[i][j] - features[j], 2);
-                    }
-                    kernels[i] = exp(-KERNEL_GAMMA * kernel);
-                }
-                break;
-            case 's':
-                // tanh(y<x,x'>+r)
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = tanh((KERNEL_GAMMA * kernel) + KERNEL_COEF);
-                }
-                break;
-        }
-
-        //compute the product of kernel and coeff
-        double predicted = 0.0;
-        for (int i = 0; i < num_vectors; i++) {
-            predicted = predicted + kernels[i] * svr.coefficients[i];
-            if (i == num_vectors - 1) {
-                predicted = predicted + svr.intercepts[0];
-            }
-        }
-
-        return predicted;
-    }
-
-
-#if 0 // this for a model for both male and female
-
-    double classification_helper::svr_image_features_predictor_v3_predict(double features[], std::string param)
-    {
-
-        int num_vectors;
-
-        if (param == "chest")
-        {
-            num_vectors = sizeof(chest_svr_image_features_v3::vectors) / (N_FEATURES_svr_image_features * 8);
-            //std::cout <<"\n chest num_vectors = " << num_vectors;
-        }
-        if (param == "waist")
-        {
-            num_vectors = sizeof(waist_svr_image_features_v3::vectors) / (N_FEATURES_svr_image_features * 8);
-            //std::cout <<"\n num_vectors = " << num_vectors;
-        }
-        if (param == "hip")
-        {
-            num_vectors = sizeof(hip_svr_image_features_v3::vectors) / (N_FEATURES_svr_image_features * 8);
-            //std::cout <<"\n num_vectors = " << num_vectors;
-        }
-        if (param == "inseam")
-        {
-            num_vectors = sizeof(inseam_svr_image_features_v3::vectors) / (N_FEATURES_svr_image_features * 8);
-            //std::cout <<"\n num_vectors = " << num_vectors;
-        }
-
-        if (param == "weight")
-        {
-            num_vectors = sizeof(weight_svr_image_features_v3::vectors) / (N_FEATURES_svr_image_features * 8);
-            //std::cout <<"\n num_vectors = " << num_vectors;
-        }
-
-        if (param == "fat")
-        {
-            num_vectors = sizeof(fat_svr_image_features_v3::vectors) / (N_FEATURES_svr_image_features * 8);
-            //std::cout <<"\n num_vectors = " << num_vectors;
-        }
-
-        //compute the mapped vectors wrt support vectors
-        double kernels[num_vectors];
-        double kernel;
-        switch (KERNEL_TYPE)
-        {
-            case 'l':
-                // <x,x'>
-                for (int i = 0; i < num_vectors; i++)
-                {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++)
-                    {
-                        if (param == "waist")
-                            kernel += waist_svr_image_features_v3::vectors[i][j] * features[j];
-                        if (param == "chest")
-                            kernel += chest_svr_image_features_v3::vectors[i][j] * features[j];
-                        if (param == "hip")
-                            kernel += hip_svr_image_features_v3::vectors[i][j] * features[j];
-                        if (param == "inseam")
-                            kernel += inseam_svr_image_features_v3::vectors[i][j] * features[j];
-                        if (param == "inseam")
-                            kernel += inseam_svr_image_features_v3::vectors[i][j] * features[j];
-                    }
-                    kernels[i] = kernel;
-
-                }
-                break;
-            case 'p':
-                // (y<x,x'>+r)^d
-                for (int i = 0; i < num_vectors; i++)
-                {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++)
-                    {
-                        if (param == "waist")
-                            kernel += waist_svr_image_features_v3::vectors[i][j] * features[j];
-                        if (param == "chest")
-                            kernel += chest_svr_image_features_v3::vectors[i][j] * features[j];
-                        if (param == "hip")
-                            kernel += hip_svr_image_features_v3::vectors[i][j] * features[j];
-                        if (param == "inseam")
-                            kernel += inseam_svr_image_features_v3::vectors[i][j] * features[j];
-                        if (param == "weight")
-                            kernel += weight_svr_image_features_v3::vectors[i][j] * features[j];
-                        if (param == "fat")
-                            kernel += fat_svr_image_features_v3::vectors[i][j] * features[j];
-
-                    }
-                    kernels[i] = pow((KERNEL_GAMMA * kernel) + KERNEL_COEF, KERNEL_DEGREE);// (1.0 + kernel) * (1.0 + kernel); //
-                }
-                break;
-            case 'r':
-                // exp(-y|x-x'|^2)
-                for (int i = 0; i < num_vectors; i++)
-                {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++)
-                    {
-                        kernel += pow(waist_svr_image_features_v3::vectors[i][j] - features[j], 2);
-                    }
-                    kernels[i] = exp(-KERNEL_GAMMA * kernel);
-                }
-                break;
-            case 's':
-                // tanh(y<x,x'>+r)
-                for (int i = 0; i < num_vectors; i++)
-                {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++)
-                    {
-                        kernel += waist_svr_image_features_v3::vectors[i][j] * features[j];
-                    }
-                    kernels[i] = tanh((KERNEL_GAMMA * kernel) + KERNEL_COEF);
-                }
-                break;
-        }
-
-        //compute the product of kernel and coeff
-        double predicted = 0.0;
-        for (int i = 0; i < num_vectors; i++)
-        {
-            if (param == "waist")
-            {
-                predicted = predicted + kernels[i] * waist_svr_image_features_v3::coefficients[i];
-
-                if (i == num_vectors - 1)
-                {
-                    predicted = predicted + waist_svr_image_features_v3::intercepts[0];
-                }
-            }
-
-            if (param == "chest")
-            {
-                predicted = predicted + kernels[i] * chest_svr_image_features_v3::coefficients[i];
-
-                if (i == num_vectors - 1)
-                {
-                    predicted = predicted + chest_svr_image_features_v3::intercepts[0];
-                }
-            }
-
-            if (param == "hip")
-            {
-                predicted = predicted + kernels[i] * hip_svr_image_features_v3::coefficients[i];
-
-                if (i == num_vectors - 1)
-                {
-                    predicted = predicted + hip_svr_image_features_v3::intercepts[0];
-                }
-            }
-
-            if (param == "inseam")
-            {
-                predicted = predicted + kernels[i] * inseam_svr_image_features_v3::coefficients[i];
-
-                if (i == num_vectors - 1)
-                {
-                    predicted = predicted + inseam_svr_image_features_v3::intercepts[0];
-                }
-            }
-
-            if (param == "weight")
-            {
-                predicted = predicted + kernels[i] * weight_svr_image_features_v3::coefficients[i];
-
-                if (i == num_vectors - 1)
-                {
-                    predicted = predicted + weight_svr_image_features_v3::intercepts[0];
-                }
-            }
-
-            if (param == "fat")
-            {
-                predicted = predicted + kernels[i] * fat_svr_image_features_v3::coefficients[i];
-
-                if (i == num_vectors - 1)
-                {
-                    predicted = predicted + fat_svr_image_features_v3::intercepts[0];
-                }
-            }
-        }
-
-        return predicted;
-
-    }
-
-#endif
-
-    double classification_helper::male_svr_image_features_predictor_v3_predict(std::map<std::string, AHIModelSVR> &svrModels, double features[],
-                                                                               std::string param) {
-        // Get ref to SVR
-        AHIModelSVR svr;
-        if (param == "chest") {
-            svr = svrModels.at("male_chest_svr_image_features_v3");
-        } else if (param == "waist") {
-            svr = svrModels.at("male_waist_svr_image_features_v3");
-        } else if (param == "hip") {
-            svr = svrModels.at("male_hip_svr_image_features_v3");
-        } else if (param == "inseam") {
-            svr = svrModels.at("male_inseam_svr_image_features_v3");
-        }
-
-        size_t num_vectors = svr.vectors.size();
-
-        //compute the mapped vectors wrt support vectors
-        double kernels[num_vectors];
-        double kernel;
-        switch (KERNEL_TYPE) {
-            case 'l':
-                // <x,x'>
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = kernel;
-                }
-                break;
-            case 'p':
-                // (y<x,x'>+r)^d
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = pow((KERNEL_GAMMA * kernel) + KERNEL_COEF, KERNEL_DEGREE); //(1.0 + kernel) * (1.0 + kernel);//
-                }
-                break;
-            case 'r':
-                // exp(-y|x-x'|^2)
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += pow(svr.vectors[i][j] - features[j], 2);
-                    }
-                    kernels[i] = exp(-KERNEL_GAMMA * kernel);
-                }
-                break;
-            case 's':
-                // tanh(y<x,x'>+r)
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = tanh((KERNEL_GAMMA * kernel) + KERNEL_COEF);
-                }
-                break;
-        }
-
-        //compute the product of kernel and coeff
-        double predicted = 0.0;
-        for (int i = 0; i < num_vectors; i++) {
-            predicted = predicted + kernels[i] * svr.coefficients[i];
-            if (i == num_vectors - 1) {
-                predicted = predicted + svr.intercepts[0];
-            }
-        }
-
-        return predicted;
-    }
-
-
-//female predict function definition
-    double classification_helper::female_svr_image_features_predictor_v3_predict(std::map<std::string, AHIModelSVR> &svrModels, double features[],
-                                                                                 std::string param) {
-        // Get ref to SVR
-        AHIModelSVR svr;
-        if (param == "chest") {
-            svr = svrModels.at("female_chest_svr_image_features_v3");
-        } else if (param == "waist") {
-            svr = svrModels.at("female_waist_svr_image_features_v3");
-        } else if (param == "hip") {
-            svr = svrModels.at("female_hip_svr_image_features_v3");
-        } else if (param == "inseam") {
-            svr = svrModels.at("female_inseam_svr_image_features_v3");
-        }
-
-        size_t num_vectors = svr.vectors.size();
-
-        //compute the mapped vectors wrt support vectors
-        double kernels[num_vectors];
-        double kernel;
-        switch (KERNEL_TYPE) {
-            case 'l':
-                // <x,x'>
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = kernel;
-                }
-                break;
-            case 'p':
-                // (y<x,x'>+r)^d
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = pow((KERNEL_GAMMA * kernel) + KERNEL_COEF, KERNEL_DEGREE);//(1.0 + kernel) * (1.0 + kernel);//
-                }
-                break;
-            case 'r':
-                // exp(-y|x-x'|^2)
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += pow(svr.vectors[i][j] - features[j], 2);
-                    }
-                    kernels[i] = exp(-KERNEL_GAMMA * kernel);
-                }
-                break;
-            case 's':
-                // tanh(y<x,x'>+r)
-                for (int i = 0; i < num_vectors; i++) {
-                    kernel = 0.;
-                    for (int j = 0; j < N_FEATURES_svr_image_features; j++) {
-                        kernel += svr.vectors[i][j] * features[j];
-                    }
-                    kernels[i] = tanh((KERNEL_GAMMA * kernel) + KERNEL_COEF);
-                }
-                break;
-        }
-
-        //compute the product of kernel and coeff
-        double predicted = 0.0;
-        for (int i = 0; i < num_vectors; i++) {
-            predicted = predicted + kernels[i] * svr.coefficients[i];
-            if (i == num_vectors - 1) {
-                predicted = predicted + svr.intercepts[0];
-            }
-        }
-
-        return predicted;
-    }
-
     std::vector<double> classification_helper::classify(double height,
                                                         double weight,
                                                         const std::string &gender,
@@ -1624,12 +678,6 @@ namespace ahi_avatar_gen {
                                                         std::map<std::string, std::pair<char *, std::size_t>> &svrModels,
                                                         std::vector<std::pair<std::string, std::vector<float>>> &svr_class_resultsRawPairs) {
 
-        std::map<std::string, AHIModelSVR> decodedSVRs;
-        for (auto &model: svrModels) {
-            auto svr = ahiDecodeSvrFromBytes(model.second.first, model.second.second);
-            decodedSVRs[model.first] = svr;
-        }
-
         std::vector<double> svr_results;
         std::vector<double> dummy(126, 0);
         sil_features_for_DL = dummy;
@@ -1661,14 +709,11 @@ namespace ahi_avatar_gen {
             std::vector<double> sil_features_v1;
             sil_features_v1 = extract_image_features_v1(height, weight, gender, front_silhoutte, side_silhoutte, front_joints_vector,
                                                         side_joints_vector);
-            double *image_features_v1 = &sil_features_v1[0];
-
 
             // This is for SVR v2 and v3
             std::vector<double> sil_features;
 
             sil_features = extract_image_features(height, weight, gender, front_silhoutte, side_silhoutte, front_joints_vector, side_joints_vector);
-            double *image_features = &sil_features[0];
 
             sil_features_for_DL = sil_features;
 
@@ -1677,50 +722,51 @@ namespace ahi_avatar_gen {
             float hip_svr_v1, hip_svr_v2, hip_svr_v3, hip_svr_v2_UWA_all;
             float inseam_svr_v1, inseam_svr_v2, inseam_svr_v3, inseam_svr_v2_UWA_all, thigh_svr_v2_UWA_all;
 
-            if ((int(gender.find("F")) > 0) || (int(gender.find("f")) > 0)) // female
-            {
-                chest_svr_v1 = female_svr_image_features_predictor_predict(decodedSVRs, image_features_v1, "chest");
-                waist_svr_v1 = female_svr_image_features_predictor_predict(decodedSVRs, image_features_v1, "waist");
-                hip_svr_v1 = female_svr_image_features_predictor_predict(decodedSVRs, image_features_v1, "hip");
-                inseam_svr_v1 = female_svr_image_features_predictor_predict(decodedSVRs, image_features_v1, "inseam");
-                if (image_features != NULL) {
-                    chest_svr_v2 = female_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "chest");
-                    waist_svr_v2 = female_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "waist");
-                    hip_svr_v2 = female_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "hip");
-                    inseam_svr_v2 = female_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "inseam");
-
-                    chest_svr_v3 = female_svr_image_features_predictor_v3_predict(decodedSVRs, image_features, "chest");
-                    waist_svr_v3 = female_svr_image_features_predictor_v3_predict(decodedSVRs, image_features, "waist");
-                    hip_svr_v3 = female_svr_image_features_predictor_v3_predict(decodedSVRs, image_features, "hip");
-                    inseam_svr_v3 = female_svr_image_features_predictor_v3_predict(decodedSVRs, image_features, "inseam");
-
-                    chest_svr_v2_UWA_all = female_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "chest_UWA_all");
-                    waist_svr_v2_UWA_all = female_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "waist_UWA_all");
-                    hip_svr_v2_UWA_all = female_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "hip_UWA_all");
-                    inseam_svr_v2_UWA_all = female_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "inseam_UWA_all");
-                }
-            } else { // male
-                chest_svr_v1 = male_svr_image_features_predictor_predict(decodedSVRs, image_features_v1, "chest");
-                waist_svr_v1 = male_svr_image_features_predictor_predict(decodedSVRs, image_features_v1, "waist");
-                hip_svr_v1 = male_svr_image_features_predictor_predict(decodedSVRs, image_features_v1, "hip");
-                inseam_svr_v1 = male_svr_image_features_predictor_predict(decodedSVRs, image_features_v1, "inseam");
-                if (image_features != NULL) {
-                    chest_svr_v2 = male_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "chest");
-                    waist_svr_v2 = male_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "waist");
-                    hip_svr_v2 = male_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "hip");
-                    inseam_svr_v2 = male_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "inseam");
-
-                    chest_svr_v3 = male_svr_image_features_predictor_v3_predict(decodedSVRs, image_features, "chest");
-                    waist_svr_v3 = male_svr_image_features_predictor_v3_predict(decodedSVRs, image_features, "waist");
-                    hip_svr_v3 = male_svr_image_features_predictor_v3_predict(decodedSVRs, image_features, "hip");
-                    inseam_svr_v3 = male_svr_image_features_predictor_v3_predict(decodedSVRs, image_features, "inseam");
-
-                    chest_svr_v2_UWA_all = male_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "chest_UWA_all");
-                    waist_svr_v2_UWA_all = male_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "waist_UWA_all");
-                    hip_svr_v2_UWA_all = male_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "hip_UWA_all");
-                    inseam_svr_v2_UWA_all = male_svr_image_features_predictor_v2_predict(decodedSVRs, image_features, "inseam_UWA_all");
-                }
-            }
+            // The SVRs come compiled from the engine (decoded once per process), one bank per feature vector.
+            bool female = (int(gender.find("F")) > 0) || (int(gender.find("f")) > 0);
+            std::string prefix = female ? "female_" : "male_";
+            ahiSvrKernel kernel;
+            kernel.type = KERNEL_TYPE;
+            kernel.gamma = KERNEL_GAMMA;
+            kernel.coef = KERNEL_COEF;
+            kernel.degree = KERNEL_DEGREE;
+            ahiSvrEngine *svrEngine = ahiSvrEngine::getInstance();
+
+            std::vector<std::string> v1Names = {prefix + "chest_svr_image_features", prefix + "waist_svr_image_features",
+                                                prefix + "hip_svr_image_features", prefix + "inseam_svr_image_features"};
+            std::vector<std::string> imageNames;
+            for (const char *suffix: {"_v2", "_v3", "_v2_UWA_all"}) {
+                for (const char *param: {"chest", "waist", "hip", "inseam"}) {
+                    imageNames.push_back(prefix + param + "_svr_image_features" + suffix);
+                }
+            }
+            imageNames.insert(imageNames.end(), {"thigh_svr_image_features_UWA_all", "FFM_svr_image_features_UWA_all", "fat_svr_image_features",
+                                                 "fat_svr_image_features_UWA_all", "gynoid_svr_image_features_UWA_all",
+                                                 "andriod_svr_image_features_UWA_all", "visceral_svr_image_features_UWA_all"});
+
+            auto v1Bank = svrEngine->bank(v1Names, svrModels, N_FEATURES_svr_image_features, kernel);
+            auto imageBank = svrEngine->bank(imageNames, svrModels, N_FEATURES_svr_image_features, kernel);
+            std::vector<double> v1Predicted = v1Bank->predict(sil_features_v1);
+            std::vector<double> imagePredicted = imageBank->predict(sil_features);
+
+            chest_svr_v1 = v1Bank->result(v1Predicted, prefix + "chest_svr_image_features");
+            waist_svr_v1 = v1Bank->result(v1Predicted, prefix + "waist_svr_image_features");
+            hip_svr_v1 = v1Bank->result(v1Predicted, prefix + "hip_svr_image_features");
+            inseam_svr_v1 = v1Bank->result(v1Predicted, prefix + "inseam_svr_image_features");
+            chest_svr_v2 = imageBank->result(imagePredicted, prefix + "chest_svr_image_features_v2");
+            waist_svr_v2 = imageBank->result(imagePredicted, prefix + "waist_svr_image_features_v2");
+            hip_svr_v2 = imageBank->result(imagePredicted, prefix + "hip_svr_image_features_v2");
+            inseam_svr_v2 = imageBank->result(imagePredicted, prefix + "inseam_svr_image_features_v2");
+
+            chest_svr_v3 = imageBank->result(imagePredicted, prefix + "chest_svr_image_features_v3");
+            waist_svr_v3 = imageBank->result(imagePredicted, prefix + "waist_svr_image_features_v3");
+            hip_svr_v3 = imageBank->result(imagePredicted, prefix + "hip_svr_image_features_v3");
+            inseam_svr_v3 = imageBank->result(imagePredicted, prefix + "inseam_svr_image_features_v3");
+
+            chest_svr_v2_UWA_all = imageBank->result(imagePredicted, prefix + "chest_svr_image_features_v2_UWA_all");
+            waist_svr_v2_UWA_all = imageBank->result(imagePredicted, prefix + "waist_svr_image_features_v2_UWA_all");
+            hip_svr_v2_UWA_all = imageBank->result(imagePredicted, prefix + "hip_svr_image_features_v2_UWA_all");
+            inseam_svr_v2_UWA_all = imageBank->result(imagePredicted, prefix + "inseam_svr_image_features_v2_UWA_all");
 
             // below push backs can be better but lets POC first
             chest.push_back(chest_svr_v1);
@@ -1754,9 +800,7 @@ namespace ahi_avatar_gen {
             svr_results.push_back(mean(inseam));
             svr_class_resultsRawPairs.push_back({"InseamSVRCurrent", inseam});
 
-            if (image_features != NULL) {
-                thigh_svr_v2_UWA_all = svr_image_features_predictor_predict(decodedSVRs, image_features, "thigh_UWA_all");
-            }
+            thigh_svr_v2_UWA_all = imageBank->result(imagePredicted, "thigh_svr_image_features_UWA_all");
 
             thigh.push_back(thigh_svr_v2_UWA_all);
 
@@ -1768,13 +812,14 @@ namespace ahi_avatar_gen {
             if (sil_features_for_weight_pred.size() > 1) {
                 // remove the weight as we are predicting
                 sil_features_for_weight_pred[1] = 0.0;
-                double *image_features_for_weight_pred = &sil_features_for_weight_pred[0];
-                double weight_predic_both_poly2 = svr_image_features_predictor_predict(decodedSVRs, image_features_for_weight_pred, "weight");
+                auto weightBank = svrEngine->bank({"weight_svr_image_features", "weight_svr_image_features_UWA_all"}, svrModels,
+                                                  N_FEATURES_svr_image_features, kernel);
+                std::vector<double> weightPredicted = weightBank->predict(sil_features_for_weight_pred);
+                double weight_predic_both_poly2 = weightBank->result(weightPredicted, "weight_svr_image_features");
                 weight_predic_both_poly2 = std::max(25.0,
                                                     std::min(weight_predic_both_poly2,
                                                              180.0)); // making sure weight isn't beyond human phyisical values
-                double weight_predic_both_poly2_UWA_all = svr_image_features_predictor_predict(decodedSVRs, image_features_for_weight_pred,
-                                                                                               "weight_UWA_all");
+                double weight_predic_both_poly2_UWA_all = weightBank->result(weightPredicted, "weight_svr_image_features_UWA_all");
                 weight_predic_both_poly2_UWA_all = std::max(25.0, std::min(weight_predic_both_poly2_UWA_all,
                                                                            180.0)); // making sure weight isn't beyond human phyisical values
                 weight_predic_both_poly2_UWA_all = std::max(25.0, std::min(weight_predic_both_poly2_UWA_all,
@@ -1786,54 +831,44 @@ namespace ahi_avatar_gen {
             svr_results.push_back(mean(weight_predic));
             svr_class_resultsRawPairs.push_back({"WeightPredSVRCurrent", weight_predic});
             //Fat Free mass
-            if (image_features != NULL) {
-                double FFM_predic_both_poly2_UWA_all = svr_image_features_predictor_predict(decodedSVRs, image_features, "ffm_UWA_all");
-                FFM_predic_both_poly2_UWA_all = std::max(FFM_predic_both_poly2_UWA_all, 0.55 * weight); // make sure
-                ffm.push_back(FFM_predic_both_poly2_UWA_all);
-            }
+            double FFM_predic_both_poly2_UWA_all = imageBank->result(imagePredicted, "FFM_svr_image_features_UWA_all");
+            FFM_predic_both_poly2_UWA_all = std::max(FFM_predic_both_poly2_UWA_all, 0.55 * weight); // make sure
+            ffm.push_back(FFM_predic_both_poly2_UWA_all);
 
             svr_results.push_back(mean(ffm));
             svr_class_resultsRawPairs.push_back({"FFMkgSVRCurrent", ffm});
             //Fat
-            if (image_features != NULL) {
-                double fat_predic_both_poly2 = svr_image_features_predictor_predict(decodedSVRs, image_features, "fat");
-                fat_predic_both_poly2 = std::max(3.0, std::min(fat_predic_both_poly2,
-                                                               weight / 2.0 * 1.01)); //, making sure Fat isn't beyond human phyisical values
-                double fat_predic_both_poly2_UWA_all = svr_image_features_predictor_predict(decodedSVRs, image_features, "fat_UWA_all");
-                fat_predic_both_poly2_UWA_all = std::max(3.0, std::min(fat_predic_both_poly2_UWA_all,
-                                                                       weight / 2.0 * 1.01)); //, making sure Fat isn't beyond human phyisical values
-                fat.push_back(fat_predic_both_poly2);
-                fat.push_back(fat_predic_both_poly2_UWA_all);
-            }
+            double fat_predic_both_poly2 = imageBank->result(imagePredicted, "fat_svr_image_features");
+            fat_predic_both_poly2 = std::max(3.0, std::min(fat_predic_both_poly2,
+                                                           weight / 2.0 * 1.01)); //, making sure Fat isn't beyond human phyisical values
+            double fat_predic_both_poly2_UWA_all = imageBank->result(imagePredicted, "fat_svr_image_features_UWA_all");
+            fat_predic_both_poly2_UWA_all = std::max(3.0, std::min(fat_predic_both_poly2_UWA_all,
+                                                                   weight / 2.0 * 1.01)); //, making sure Fat isn't beyond human phyisical values
+            fat.push_back(fat_predic_both_poly2);
+            fat.push_back(fat_predic_both_poly2_UWA_all);
             svr_results.push_back(mean(fat));
             svr_class_resultsRawPairs.push_back({"FatkgSVRCurrent", fat});
             //gynoid
-            if (image_features != NULL) {
-                double gynoid_predic_both_poly2_UWA_all = svr_image_features_predictor_predict(decodedSVRs, image_features, "gynoid_UWA_all");
-                gynoid_predic_both_poly2_UWA_all = std::max(gynoid_predic_both_poly2_UWA_all, 0.6 / 100.0 * weight); // make sure
-                gynoid_predic_both_poly2_UWA_all = std::min(gynoid_predic_both_poly2_UWA_all, 11. / 100. * weight); // make sure
-                gynoid.push_back(gynoid_predic_both_poly2_UWA_all);
-            }
+            double gynoid_predic_both_poly2_UWA_all = imageBank->result(imagePredicted, "gynoid_svr_image_features_UWA_all");
+            gynoid_predic_both_poly2_UWA_all = std::max(gynoid_predic_both_poly2_UWA_all, 0.6 / 100.0 * weight); // make sure
+            gynoid_predic_both_poly2_UWA_all = std::min(gynoid_predic_both_poly2_UWA_all, 11. / 100. * weight); // make sure
+            gynoid.push_back(gynoid_predic_both_poly2_UWA_all);
 
             svr_results.push_back(mean(gynoid));
             svr_class_resultsRawPairs.push_back({"GynoidkgSVRCurrent", gynoid});
             //andriod
-            if (image_features != NULL) {
-                double andriod_predic_both_poly2_UWA_all = svr_image_features_predictor_predict(decodedSVRs, image_features, "andriod_UWA_all");
-                andriod_predic_both_poly2_UWA_all = std::max(andriod_predic_both_poly2_UWA_all, 0.27 / 100.0 * weight); // make sure
-                andriod_predic_both_poly2_UWA_all = std::min(andriod_predic_both_poly2_UWA_all, 6. / 100.0 * weight); // make sure
-                andriod.push_back(andriod_predic_both_poly2_UWA_all);
-            }
+            double andriod_predic_both_poly2_UWA_all = imageBank->result(imagePredicted, "andriod_svr_image_features_UWA_all");
+            andriod_predic_both_poly2_UWA_all = std::max(andriod_predic_both_poly2_UWA_all, 0.27 / 100.0 * weight); // make sure
+            andriod_predic_both_poly2_UWA_all = std::min(andriod_predic_both_poly2_UWA_all, 6. / 100.0 * weight); // make sure
+            andriod.push_back(andriod_predic_both_poly2_UWA_all);
 
             svr_results.push_back(mean(andriod));
             svr_class_resultsRawPairs.push_back({"AndroidkgSVRCurrent", andriod});
             //vat
-            if (image_features != NULL) {
-                double visceral_predic_both_poly2_UWA_all = svr_image_features_predictor_predict(decodedSVRs, image_features, "visceral_UWA_all");
-                visceral_predic_both_poly2_UWA_all = std::max(visceral_predic_both_poly2_UWA_all, 0.1 / 100.0 * weight); // make sure
-                visceral_predic_both_poly2_UWA_all = std::min(visceral_predic_both_poly2_UWA_all, 3.9 / 100.0 * weight); // make sure
-                vat.push_back(visceral_predic_both_poly2_UWA_all);
-            }
+            double visceral_predic_both_poly2_UWA_all = imageBank->result(imagePredicted, "visceral_svr_image_features_UWA_all");
+            visceral_predic_both_poly2_UWA_all = std::max(visceral_predic_both_poly2_UWA_all, 0.1 / 100.0 * weight); // make sure
+            visceral_predic_both_poly2_UWA_all = std::min(visceral_predic_both_poly2_UWA_all, 3.9 / 100.0 * weight); // make sure
+            vat.push_back(visceral_predic_both_poly2_UWA_all);
 
             svr_results.push_back(mean(vat));
             svr_class_resultsRawPairs.push_back({"VATkgSVRCurrent", vat});
@@ -60,6 +60,15 @@ Classification::classifyMultiple(double height,
     );
 }
 
+int Classification::warmUp(std::map<std::string, std::pair<char *, std::size_t>> &tfModels) {
+    return ahiInterpreterPool::getInstance()->warmUp(tfModels);
+}
+
+bool Classification::setDelegateCacheFile(const std::string &path, bool benchmarkCpu) {
+    ahiDelegateCache::getInstance()->setBenchmarkMode(benchmarkCpu);
+    return ahiDelegateCache::getInstance()->setCacheFile(path);
+}
+
 vector<std::string> Classification::getTfLiteModelNames() {
     ahiModelsZoo modelsZoo;
     auto modelsMap = modelsZoo.ahiShapeModelGenderMap;
@@ -76,3 +85,7 @@ vector<std::string> Classification::getSvrModelNames() {
     ahiModelsZoo modelsZoo;
     return modelsZoo.getSvrModelList("shape_and_composition");
 }
+
+vector<std::string> Classification::getResultKeys() {
+    return ahiFactoryClassify().getResultKeys();
+}
@@ -4,9 +4,12 @@
 //
 
 #include <jni.h>
+#include <limits>
 #include "Common.hpp"
 #include "jnihelper/JNIHelper.hpp"
+#include "jnihelper/JNIModelRegistry.hpp"
 #include "Classification.hpp"
+#include "ahiSvrEngine.hpp"
 
 jobject cppResultsMapToJava(JNIEnv *env, const std::map<std::string, float> &results) {
     jclass hashMapClass = env->FindClass("java/util/HashMap");
@@ -23,6 +26,17 @@ jobject cppResultsMapToJava(JNIEnv *env, const std::map<std::string, float> &res
     return hashMapObj;
 }
 
+extern "C"
+JNIEXPORT jint JNICALL
+JNI_OnLoad(JavaVM *vm, void *reserved) {
+    JNIEnv *env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        return JNI_ERR;
+    }
+    JNIHelper::onLoad(env);
+    return JNI_VERSION_1_6;
+}
+
 extern "C"
 JNIEXPORT jobject
 Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_classify(
@@ -55,8 +69,8 @@ Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_
                 nativeFrontMap,
                 nativeSideMap,
                 "shape_and_comp",
-                tfModelsMap,
-                svrModelsMap,
+                tfModelsMap->models,
+                svrModelsMap->models,
                 useAverage
         );
         return cppResultsMapToJava(env, result.classificationResultsCurrent);
@@ -65,29 +79,17 @@ Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_
     }
 }
 
-extern "C"
-JNIEXPORT jobject JNICALL
-Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_classifyMultiple(JNIEnv *env,
-                                                                                                 jobject thiz,
-                                                                                                 jdouble height,
-                                                                                                 jdouble weight,
-                                                                                                 jobject sex,
-                                                                                                 jobjectArray frontSilhouettes,
-                                                                                                 jobjectArray sideSilhouettes,
-                                                                                                 jobjectArray frontJoints,
-                                                                                                 jobjectArray sideJoints,
-                                                                                                 jobject tfModels,
-                                                                                                 jobject svrModels,
-                                                                                                 jboolean useAverage) {
+ahiClassifyInfo classifyMultiple(JNIEnv *env, jdouble height, jdouble weight, jobject sex, jobjectArray frontSilhouettes,
+                                 jobjectArray sideSilhouettes, jobjectArray frontJoints, jobjectArray sideJoints,
+                                 std::map<std::string, std::pair<char *, std::size_t>> &tfModels,
+                                 std::map<std::string, std::pair<char *, std::size_t>> &svrModels, jboolean useAverage) {
     auto nativeFrontJoints = JNIHelper::javaJointsArrayToCpp(env, frontJoints);
     auto nativeSideJoints = JNIHelper::javaJointsArrayToCpp(env, sideJoints);
     auto nativeFrontSilhouettes = JNIHelper::javaBitmapArrayToCpp(env, frontSilhouettes);
     auto nativeSideSilhouettes = JNIHelper::javaBitmapArrayToCpp(env, sideSilhouettes);
-    auto tfModelsMap = JNIHelper::javaModelsMapToCpp(env, tfModels);
-    auto svrModelsMap = JNIHelper::javaModelsMapToCpp(env, svrModels);
     BodyScanCommon::SexType sexType = JNIHelper::getNativeSexType(env, sex);
     std::string sexStr = sexType == BodyScanCommon::male ? "M" : "F";
-    auto result = Classification::classifyMultiple(
+    return Classification::classifyMultiple(
             height,
             weight,
             sexStr,
@@ -96,13 +98,145 @@ Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_
             nativeFrontJoints,
             nativeSideJoints,
             "shape_and_comp",
-            tfModelsMap,
-            svrModelsMap,
+            tfModels,
+            svrModels,
             useAverage
     );
+}
+
+// The models of registerModels handles, false if one is unknown. The native code takes the maps by reference, copies
+// of the pointers keep the registered sets untouched.
+bool registeredModels(jlong tfModelsHandle, jlong svrModelsHandle, std::shared_ptr<JNIModelSet> &tfModelSet,
+                      std::shared_ptr<JNIModelSet> &svrModelSet,
+                      std::map<std::string, std::pair<char *, std::size_t>> &tfModels,
+                      std::map<std::string, std::pair<char *, std::size_t>> &svrModels) {
+    tfModelSet = JNIModelRegistry::get(tfModelsHandle);
+    svrModelSet = JNIModelRegistry::get(svrModelsHandle);
+    if (tfModelSet == nullptr || svrModelSet == nullptr) {
+        return false;
+    }
+    tfModels = tfModelSet->models;
+    svrModels = svrModelSet->models;
+    return true;
+}
+
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_classifyMultiple(JNIEnv *env,
+                                                                                                 jobject thiz,
+                                                                                                 jdouble height,
+                                                                                                 jdouble weight,
+                                                                                                 jobject sex,
+                                                                                                 jobjectArray frontSilhouettes,
+                                                                                                 jobjectArray sideSilhouettes,
+                                                                                                 jobjectArray frontJoints,
+                                                                                                 jobjectArray sideJoints,
+                                                                                                 jobject tfModels,
+                                                                                                 jobject svrModels,
+                                                                                                 jboolean useAverage) {
+    auto tfModelsMap = JNIHelper::javaModelsMapToCpp(env, tfModels);
+    auto svrModelsMap = JNIHelper::javaModelsMapToCpp(env, svrModels);
+    auto result = classifyMultiple(env, height, weight, sex, frontSilhouettes, sideSilhouettes, frontJoints, sideJoints,
+                                   tfModelsMap->models, svrModelsMap->models, useAverage);
+    return cppResultsMapToJava(env, result.classificationResultsCurrent);
+}
+
+// As classifyMultiple, with the models of registerModels handles.
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_classifyMultipleRegistered(
+        JNIEnv *env,
+        jobject thiz,
+        jdouble height,
+        jdouble weight,
+        jobject sex,
+        jobjectArray frontSilhouettes,
+        jobjectArray sideSilhouettes,
+        jobjectArray frontJoints,
+        jobjectArray sideJoints,
+        jlong tfModelsHandle,
+        jlong svrModelsHandle,
+        jboolean useAverage) {
+    std::shared_ptr<JNIModelSet> tfModelSet, svrModelSet;
+    std::map<std::string, std::pair<char *, std::size_t>> tfModelsMap, svrModelsMap;
+    if (!registeredModels(tfModelsHandle, svrModelsHandle, tfModelSet, svrModelSet, tfModelsMap, svrModelsMap)) {
+        return nullptr;
+    }
+    auto result = classifyMultiple(env, height, weight, sex, frontSilhouettes, sideSilhouettes, frontJoints, sideJoints,
+                                   tfModelsMap, svrModelsMap, useAverage);
     return cppResultsMapToJava(env, result.classificationResultsCurrent);
 }
 
+// As classifyMultipleRegistered, with the results written into results in the order of getResultKeys (NaN for a key
+// without result) instead of boxed into a map. False if the classification failed.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_classifyMultipleInto(
+        JNIEnv *env,
+        jobject thiz,
+        jdouble height,
+        jdouble weight,
+        jobject sex,
+        jobjectArray frontSilhouettes,
+        jobjectArray sideSilhouettes,
+        jobjectArray frontJoints,
+        jobjectArray sideJoints,
+        jlong tfModelsHandle,
+        jlong svrModelsHandle,
+        jboolean useAverage,
+        jfloatArray results) {
+    static const std::vector<std::string> resultKeys = Classification::getResultKeys();
+    std::shared_ptr<JNIModelSet> tfModelSet, svrModelSet;
+    std::map<std::string, std::pair<char *, std::size_t>> tfModelsMap, svrModelsMap;
+    if (env->GetArrayLength(results) < (jsize) resultKeys.size() ||
+        !registeredModels(tfModelsHandle, svrModelsHandle, tfModelSet, svrModelSet, tfModelsMap, svrModelsMap)) {
+        return JNI_FALSE;
+    }
+    auto result = classifyMultiple(env, height, weight, sex, frontSilhouettes, sideSilhouettes, frontJoints, sideJoints,
+                                   tfModelsMap, svrModelsMap, useAverage);
+    if (result.classificationResultsCurrent.empty()) {
+        return JNI_FALSE;
+    }
+    std::vector<jfloat> values(resultKeys.size(), std::numeric_limits<float>::quiet_NaN());
+    for (std::size_t index = 0; index < resultKeys.size(); ++index) {
+        auto iter = result.classificationResultsCurrent.find(resultKeys[index]);
+        if (iter != result.classificationResultsCurrent.end()) {
+            values[index] = iter->second;
+        }
+    }
+    env->SetFloatArrayRegion(results, 0, (jsize) values.size(), values.data());
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_registerModels(JNIEnv *env, jobject thiz, jobject models) {
+    return JNIModelRegistry::add(env, models);
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_releaseModels(JNIEnv *env, jobject thiz, jlong handle) {
+    return JNIModelRegistry::remove(handle) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_warmUp(JNIEnv *env, jobject thiz, jobject tfModels) {
+    auto tfModelsMap = JNIHelper::javaModelsMapToCpp(env, tfModels);
+    return Classification::warmUp(tfModelsMap->models);
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_setDelegateCacheFile(JNIEnv *env, jobject thiz, jstring path,
+                                                                                                     jboolean benchmarkCpu) {
+    const char *nativePath = env->GetStringUTFChars(path, nullptr);
+    bool result = Classification::setDelegateCacheFile(nativePath, benchmarkCpu);
+    env->ReleaseStringUTFChars(path, nativePath);
+    return result;
+}
+
 extern "C"
 JNIEXPORT jobjectArray JNICALL
 Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_getTfLiteModelNames(JNIEnv *env, jobject thiz) {
@@ -128,3 +262,49 @@ Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_
     }
     return jModelNames;
 }
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_getResultKeys(JNIEnv *env, jobject thiz) {
+    auto resultKeys = Classification::getResultKeys();
+    jclass jStringClass = env->FindClass("java/lang/String");
+    jobjectArray jResultKeys = env->NewObjectArray((jsize) resultKeys.size(), jStringClass, nullptr);
+    for (int index = 0; index < resultKeys.size(); ++index) {
+        jobject resultKey = env->NewStringUTF(resultKeys[index].c_str());
+        env->SetObjectArrayElement(jResultKeys, index, resultKey);
+    }
+    return jResultKeys;
+}
+
+// The SVR models are read from the pack from then on, the svrModels classify is handed are only used for the models
+// missing from it.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_openModelPack(JNIEnv *env, jobject thiz, jstring path) {
+    const char *nativePath = env->GetStringUTFChars(path, nullptr);
+    std::string error;
+    std::shared_ptr<const AHIBSModelPack> pack = AHIBSModelPack::open(nativePath, true, error);
+    env->ReleaseStringUTFChars(path, nativePath);
+    if (pack == nullptr) {
+        return JNI_FALSE;
+    }
+    ahiSvrEngine::getInstance()->usePack(std::move(pack));
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partclassification_ClassificationJNI_openModelPackFd(JNIEnv *env, jobject thiz, jint fd,
+                                                                                                jlong offset, jlong length) {
+    if (fd < 0 || offset < 0 || length <= 0) {
+        return JNI_FALSE;
+    }
+    std::string error;
+    std::shared_ptr<const AHIBSModelPack> pack =
+            AHIBSModelPack::open(fd, (uint64_t) offset, (uint64_t) length, true, error);
+    if (pack == nullptr) {
+        return JNI_FALSE;
+    }
+    ahiSvrEngine::getInstance()->usePack(std::move(pack));
+    return JNI_TRUE;
+}
@@ -0,0 +1,96 @@
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "ahiClassifyGraph.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <set>
+
+std::size_t ahiClassifyGraph::addNode(int modelId, const std::vector<int> &dependsOn) {
+    std::size_t node = mNodes.size();
+    Node added;
+    added.modelId = modelId;
+    for (std::size_t other = 0; other < node; other++) {
+        if (std::find(dependsOn.begin(), dependsOn.end(), mNodes[other].modelId) != dependsOn.end()) {
+            mNodes[other].dependents.push_back(node);
+            added.numDependencies++;
+        }
+    }
+    mNodes.push_back(added);
+    return node;
+}
+
+std::size_t ahiClassifyGraph::size() const {
+    return mNodes.size();
+}
+
+int ahiClassifyGraph::modelId(std::size_t node) const {
+    return mNodes[node].modelId;
+}
+
+void ahiClassifyGraph::run(std::size_t numWorkers, const std::function<void(std::size_t, std::size_t)> &run) {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::size_t> pending(mNodes.size());
+    // ordered, the lowest ready node goes out first
+    std::set<std::size_t> ready;
+    std::size_t numRunning = 0;
+    std::exception_ptr failure;
+    for (std::size_t node = 0; node < mNodes.size(); node++) {
+        pending[node] = mNodes[node].numDependencies;
+        if (pending[node] == 0) {
+            ready.insert(node);
+        }
+    }
+
+    auto worker = [&](std::size_t workerIndex) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            // a node still running may make others ready
+            changed.wait(lock, [&]() { return failure || !ready.empty() || numRunning == 0; });
+            if (failure || ready.empty()) {
+                return;
+            }
+            std::size_t node = *ready.begin();
+            ready.erase(ready.begin());
+            numRunning++;
+            lock.unlock();
+            std::exception_ptr nodeFailure;
+            try {
+                run(node, workerIndex);
+            } catch (...) {
+                nodeFailure = std::current_exception();
+            }
+            lock.lock();
+            numRunning--;
+            if (nodeFailure && !failure) {
+                failure = nodeFailure;
+            }
+            for (std::size_t dependent: mNodes[node].dependents) {
+                if (--pending[dependent] == 0) {
+                    ready.insert(dependent);
+                }
+            }
+            changed.notify_all();
+        }
+    };
+
+    numWorkers = std::max<std::size_t>(1, std::min(numWorkers, mNodes.size()));
+    std::vector<std::future<void>> workers;
+    for (std::size_t w = 1; w < numWorkers; w++) {
+        workers.push_back(std::async(std::launch::async, worker, w));
+    }
+    worker(0);
+    for (auto &pendingWorker: workers) {
+        pendingWorker.get();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
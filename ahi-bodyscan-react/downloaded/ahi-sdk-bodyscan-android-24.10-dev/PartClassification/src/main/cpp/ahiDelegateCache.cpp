@@ -0,0 +1,165 @@
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "ahiDelegateCache.hpp"
+#include <fstream>
+#include <thread>
+#include <sys/utsname.h>
+
+#if defined(ANDROID) || defined(__ANDROID__)
+
+#include <sys/system_properties.h>
+
+#endif
+
+Mutex gDelegateCacheInstanceMutex_;
+ahiDelegateCache *ahiDelegateCache::mThis = nullptr;
+
+ahiDelegateCache *ahiDelegateCache::getInstance() {
+    AutoLock lock(gDelegateCacheInstanceMutex_);
+
+    if (nullptr == mThis) {
+        mThis = new ahiDelegateCache();
+    }
+
+    return mThis;
+}
+
+ahiDelegateCache::ahiDelegateCache() : mDeviceKey(deviceKey()) {
+#if defined(ANDROID) || defined(__ANDROID__)
+    mBenchmarkMode = false;
+#else
+    // No GPU/NNAPI on the host, so the only choice left (XNNPack vs builtin kernels) is made by measurement.
+    mBenchmarkMode = true;
+#endif
+}
+
+std::string ahiDelegateCache::deviceKey() {
+    std::stringstream ss;
+#if defined(ANDROID) || defined(__ANDROID__)
+    char value[PROP_VALUE_MAX] = {0};
+    __system_property_get("ro.product.manufacturer", value);
+    ss << value << "/";
+    __system_property_get("ro.product.model", value);
+    ss << value << "/";
+    __system_property_get("ro.build.version.sdk", value);
+    ss << value << "/";
+#endif
+    struct utsname name;
+    if (uname(&name) == 0) {
+        ss << name.sysname << "/" << name.machine << "/";
+    }
+    ss << std::thread::hardware_concurrency();
+    // the key is written as one tab separated field
+    std::string key = ss.str();
+    std::replace(key.begin(), key.end(), '\t', ' ');
+    std::replace(key.begin(), key.end(), '\n', ' ');
+    return key;
+}
+
+bool ahiDelegateCache::lookup(const std::string &modelKey, ahiDelegateDecision &decision) {
+    AutoLock lock(mMutex);
+    auto iter = mDecisions.find(std::make_pair(mDeviceKey, modelKey));
+    if (iter == mDecisions.end()) {
+        return false;
+    }
+    decision = iter->second;
+    return true;
+}
+
+void ahiDelegateCache::record(const std::string &modelKey, const ahiDelegateDecision &decision) {
+    AutoLock lock(mMutex);
+    mDecisions[std::make_pair(mDeviceKey, modelKey)] = decision;
+    saveLocked();
+}
+
+void ahiDelegateCache::forget(const std::string &modelKey) {
+    AutoLock lock(mMutex);
+    if (mDecisions.erase(std::make_pair(mDeviceKey, modelKey)) > 0) {
+        saveLocked();
+    }
+}
+
+bool ahiDelegateCache::setCacheFile(const std::string &path) {
+    AutoLock lock(mMutex);
+    mCacheFile = path;
+    if (mCacheFile.empty()) {
+        return true;
+    }
+    return loadLocked();
+}
+
+void ahiDelegateCache::setBenchmarkMode(bool benchmark) {
+    AutoLock lock(mMutex);
+    mBenchmarkMode = benchmark;
+}
+
+bool ahiDelegateCache::isBenchmarkMode() {
+    AutoLock lock(mMutex);
+    return mBenchmarkMode;
+}
+
+void ahiDelegateCache::clear() {
+    AutoLock lock(mMutex);
+    mDecisions.clear();
+    saveLocked();
+}
+
+bool ahiDelegateCache::loadLocked() {
+    std::ifstream in(mCacheFile);
+    if (!in.is_open()) {
+        // the first run on this device: the cache starts empty, as long as the file can be created for the decisions
+        std::ofstream created(mCacheFile, std::ios::app);
+        return created.is_open();
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, '\t')) {
+            fields.push_back(field);
+        }
+        if (fields.size() != 6) {
+            continue;
+        }
+        ahiDelegateDecision decision;
+        decision.delegate = fields[2];
+        decision.numThreads = atoi(fields[3].c_str());
+        decision.firstInvokeMs = atof(fields[4].c_str());
+        decision.invokeMs = atof(fields[5].c_str());
+        if (decision.delegate.empty() || decision.numThreads < 1) {
+            continue;
+        }
+        mDecisions[std::make_pair(fields[0], fields[1])] = decision;
+    }
+    return true;
+}
+
+bool ahiDelegateCache::saveLocked() {
+    if (mCacheFile.empty()) {
+        return false;
+    }
+    // write aside and rename, a crash mid write must not leave a truncated cache behind
+    std::string tmpFile = mCacheFile + ".tmp";
+    {
+        std::ofstream out(tmpFile, std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out << "# ahi delegate cache v1: device\tmodel\tdelegate\tthreads\tfirst_invoke_ms\tinvoke_ms\n";
+        for (auto &decision: mDecisions) {
+            out << decision.first.first << "\t" << decision.first.second << "\t" << decision.second.delegate << "\t"
+                << decision.second.numThreads << "\t" << decision.second.firstInvokeMs << "\t" << decision.second.invokeMs << "\n";
+        }
+        if (!out.good()) {
+            return false;
+        }
+    }
+    return rename(tmpFile.c_str(), mCacheFile.c_str()) == 0;
+}
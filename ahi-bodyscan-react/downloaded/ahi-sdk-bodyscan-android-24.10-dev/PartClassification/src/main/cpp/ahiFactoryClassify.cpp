@@ -5,6 +5,10 @@
 //
 
 #include "ahiFactoryClassify.hpp"
+#include "ahiClassifyGraph.hpp"
+#include "ahiModelNoise.hpp"
+#include "ahiPreprocessContext.hpp"
+#include "ahiResultCache.hpp"
 
 std::string ahiFactoryClassify::to_lowerStr(std::string str) {
     std::for_each(str.begin(), str.end(), [](char &c) {
@@ -24,19 +28,11 @@ void ahiFactoryClassify::initClassify() {
     getFactorTensorInstant();
 }
 
-std::map<std::string, std::unique_ptr<tflite::Interpreter>>
-ahiFactoryClassify::loadAllTfModels(std::map<std::string, std::pair<char *, std::size_t>> &tfModels) {
-    std::map<std::string, std::unique_ptr<tflite::Interpreter>> loadedModels;
+void ahiFactoryClassify::hashTfModels(std::map<std::string, std::pair<char *, std::size_t>> &tfModels) {
+    mTfModelHashes.clear();
     for (auto &model: tfModels) {
-        char *buffer = model.second.first;
-        std::size_t bufferSize = model.second.second;
-        auto loadedModel = tflite::FlatBufferModel::BuildFromBuffer(buffer, bufferSize);
-        if (loadedModel != nullptr) {
-            auto interpreter = classifyFT.buildOptimalInterpreter(std::move(loadedModel));
-            loadedModels[model.first] = std::move(interpreter);
-        }
+        mTfModelHashes[model.first] = ahiInterpreterPool::contentHash(model.second.first, model.second.second);
     }
-    return loadedModels;
 }
 
 bool
@@ -237,15 +233,6 @@ void handleFeatureBasedExtraMeas(std::vector<float> tf_result,
     refineExtraMeasFeatBased(extraMeas, site, allMeasurementsDict);
 }
 
-std::vector<double> gen_randnorm_vector(double mu, double sigma, int vect_size) {
-    cv::RNG rng(cv::getCPUTickCount()); //random seed
-    std::vector<double> rnd_norm_vec(vect_size);
-    for (int n = 0; n < vect_size; n++) {
-        rnd_norm_vec[n] = rng.gaussian(sigma) + mu;
-    }
-    return rnd_norm_vec;
-}
-
 void handleImageBasedExtraMeas(std::vector<float> tf_result,
                                std::string outNodeName,
                                std::map<std::string, float> &allMeasurementsDict) {
@@ -324,6 +311,246 @@ bool ahiFactoryClassify::ahiSVRClassification(double height, double weight, std:
     return true;
 }
 
+// runs one DL model on the worker's tensor
+void ahiFactoryClassify::runClassModel(ahiFactoryTensor &tensor,
+                                       ahiPreprocessContext &views,
+                                       int classModelId,
+                                       const std::string &currModelFileName,
+                                       const std::pair<char *, std::size_t> &tfModel,
+                                       uint64_t tfModelHash,
+                                       double height,
+                                       double weight,
+                                       const std::string &gender,
+                                       std::vector<double> &imageFeatureVector,
+                                       ahiClassModelRun &run) {
+    bool isFemale = to_lowerStr(gender).find("f") != std::string::npos;
+
+    //get ready for the current model
+    tensor.mInterpreter = nullptr;
+    tensor.mInputs.clear();
+    tensor.modelFileName = currModelFileName;
+
+    // Borrow the interpreter from the pool, it is handed back once this model's outputs are read
+    std::unique_ptr<ahiPooledInterpreter> pooledModel = ahiInterpreterPool::getInstance()->acquire(currModelFileName, tfModel.first,
+                                                                                                   tfModel.second, tfModelHash);
+    if (pooledModel == nullptr || pooledModel->builder.mInterpreter == nullptr) {
+        return;
+    }
+    // the names and signature were read when the interpreter was built, they move over with it
+    tensor.mInterpreter = std::move(pooledModel->builder.mInterpreter);
+    tensor.mInputNames = std::move(pooledModel->inputNames);
+    tensor.mOutputNames = std::move(pooledModel->outputNames);
+    tensor.mSignature = std::move(pooledModel->signature);
+    // the pooled factory owns the model and delegate, so the interpreter must go back to it on every exit path
+    auto handBackPooledModel = [&]() {
+        pooledModel->builder.mInterpreter = std::move(tensor.mInterpreter);
+        pooledModel->inputNames = std::move(tensor.mInputNames);
+        pooledModel->outputNames = std::move(tensor.mOutputNames);
+        pooledModel->signature = std::move(tensor.mSignature);
+        ahiInterpreterPool::getInstance()->release(std::move(pooledModel));
+        tensor.mInputs.clear();
+    };
+
+    const std::vector<std::string> &InputNames = tensor.mInputNames;
+
+    switch (classModelId) {
+        default:
+        case ModelClassV1:
+        case ModelClassV2male:
+        case ModelClassV2female:
+        case ModelClassV2p5:
+        case ModelClassV3male:
+        case ModelClassV3female: {
+            run.isShape = true;
+            cv::Mat image_featuresMat = cv::Mat(126, 1, CV_64F, imageFeatureVector.data());
+            image_featuresMat.convertTo(image_featuresMat, CV_32F);
+            tensor.addInput(InputNames[0], ahiTensorInput(image_featuresMat,
+                                                          false)); //InputNames[0] is "silhouettes" (actually the features)
+        }
+            break;
+        case ModelClassV3p1: {
+            run.isShape = true;
+            std::vector<double> additional_data(2);
+            additional_data[0] = (height / 255.0f - 0.5149143288800009) / 0.1858516016514072;
+            additional_data[1] = (weight / 255.0f - 0.5149143288800009) / 0.1858516016514072;
+            cv::Mat addInputMat = cv::Mat(2, 1, CV_64F, additional_data.data());
+            addInputMat.convertTo(addInputMat, CV_32F);
+            tensor.addInput("additional_data", ahiTensorInput(addInputMat, false));
+            cv::Size target_size = cv::Size(256, 256);
+            cv::Mat front_side_mats_merged = views.frontSide(target_size, 2.0, 1.5);
+            if (front_side_mats_merged.empty()) {
+                run.isFailed = true;
+                handBackPooledModel();
+                return;
+            }
+            tensor.addInput("silhouettes", ahiTensorInput(front_side_mats_merged / 255.0f, true, false, target_size,
+                                                          {255.0f}, {0.}));
+        }
+            break;
+
+        case ModelClassTBFIM1: {
+            run.isShape = false;
+            std::vector<double> additional_data(2);
+            additional_data[0] = height;
+            additional_data[1] = weight;
+            cv::Mat addInputMat = cv::Mat(2, 1, CV_64F, additional_data.data());//cv::Mat(2, 1, CV_32F,additional_data.data());
+            addInputMat.convertTo(addInputMat, CV_32F);
+            tensor.addInput("additional_data", ahiTensorInput(addInputMat));
+            cv::Size target_size = cv::Size(256, 256);
+            cv::Mat front_side_mats_merged = views.frontSide(target_size, 2.0, 1.5);
+            if (front_side_mats_merged.empty()) {
+                run.isFailed = true;
+                handBackPooledModel();
+                return;
+            }
+            tensor.addInput("silhouettes",
+                            ahiTensorInput(front_side_mats_merged, true, false, target_size,
+                                           {1.0f}, {0.}));
+        }
+            break;
+
+            // note this uses the same data as the above TBFIM1
+        case ModelClassTBFIM2: {
+            run.isShape = false;
+            std::vector<double> additional_data(2);
+            additional_data[0] = height;
+            additional_data[1] = weight;
+            cv::Mat addInputMat = cv::Mat(2, 1, CV_64F, additional_data.data());
+            addInputMat.convertTo(addInputMat, CV_32F);
+            tensor.addInput("additional_data", ahiTensorInput(addInputMat, false));
+            cv::Size target_size = cv::Size(256, 256);
+            cv::Mat front_side_mats_merged = views.frontSide(target_size, 2.0, 1.5);
+            if (front_side_mats_merged.empty()) {
+                run.isFailed = true;
+                handBackPooledModel();
+                return;
+            }
+            tensor.addInput("silhouettes",
+                            ahiTensorInput(front_side_mats_merged, true, false, target_size,
+                                           {1.0f}, {0.}));
+        }
+            break;
+
+        case ModelClassExmeasImageBased: {
+            run.isShape = true;
+            cv::Mat inputImageFeat;
+            cv::Mat inputHWGFeat;
+            cv::Mat inputNormalDist;
+
+            bool isPrepOkay = tensor.prepareInputsForImageBasedExtraMeas(views, height, weight, gender,
+                                                                         inputImageFeat,
+                                                                         inputHWGFeat, inputNormalDist);
+            cv::Size target_size = cv::Size(256, 256);
+            tensor.addInput("input_1",
+                            ahiTensorInput(inputImageFeat, true, false, target_size,
+                                           {1.0f}, {0.}));
+            tensor.addInput("input_2", ahiTensorInput(inputHWGFeat, false));
+            tensor.addInput("input_3", ahiTensorInput(inputNormalDist, false));
+        }
+            break;
+
+        case ModelClassExmeasFeatBasedM23: {
+            run.extraModelSite = "M1";
+            run.isShape = true;
+            std::vector<double> extarMeasFeat23(127, 0);
+            for (int n = 0; n < 126; n++) // the 126 can be dynamic length
+            {
+                extarMeasFeat23[n + 1] = imageFeatureVector[n];
+            }
+            extarMeasFeat23[0] = 1.0; // default male
+            extarMeasFeat23[1] = extarMeasFeat23[1] / 200.0;
+            extarMeasFeat23[2] = extarMeasFeat23[2] / 184.0;
+            if (isFemale) {
+                extarMeasFeat23[0] = 0;
+            }
+            cv::Mat image_featuresMat = cv::Mat(127, 1, CV_64F, extarMeasFeat23.data());
+            image_featuresMat.convertTo(image_featuresMat, CV_32F);
+            tensor.addInput("image_features", ahiTensorInput(image_featuresMat)); //
+
+            // the model's fixed noise, so the same scan gives the same measurements
+            cv::Mat input_randnormMat = ahiModelNoise::getInstance()->samples(currModelFileName, 64);
+            tensor.addInput("input_randnorm", ahiTensorInput(input_randnormMat));
+        }
+            break;
+
+        case ModelClassExmeasFeatBasedM60A:
+        case ModelClassExmeasFeatBasedM60B: {
+            run.isShape = true;
+            std::vector<double> extarMeasFeat60Plus(127, 0);
+            for (int n = 0; n < 126; n++) // the 126 can be dynamic length
+            {
+                extarMeasFeat60Plus[n + 1] = imageFeatureVector[n];
+            }
+            extarMeasFeat60Plus[0] = 1.0; // default male
+            extarMeasFeat60Plus[1] = extarMeasFeat60Plus[1] / 210.0;
+            extarMeasFeat60Plus[2] = extarMeasFeat60Plus[2] / 170.0;
+            if (isFemale) {
+                extarMeasFeat60Plus[0] = 0;
+            }
+            cv::Mat image_featuresMat = cv::Mat(127, 1, CV_64F, extarMeasFeat60Plus.data());
+            image_featuresMat.convertTo(image_featuresMat, CV_32F);
+            tensor.addInput("image_features", ahiTensorInput(image_featuresMat)); //
+
+            // the model's fixed noise, so the same scan gives the same measurements
+            cv::Mat input_randnormMat = ahiModelNoise::getInstance()->samples(currModelFileName, 96);
+            tensor.addInput("input_randnorm", ahiTensorInput(input_randnormMat));
+
+            if (classModelId == ModelClassExmeasFeatBasedM60A) {
+                run.extraModelSite = "M1";
+            }
+            if (classModelId == ModelClassExmeasFeatBasedM60B) {
+                run.extraModelSite = "M2";
+            }
+        }
+            break;
+
+        case ModelClassHeighWeightFeatBased: {
+            run.isShape = false;
+            std::vector<double> image_features(127, 0);
+            for (int n = 0; n < 126; n++) // the 126 can be dynamic length
+            {
+                image_features[n + 1] = imageFeatureVector[n];
+            }
+            image_features[0] = 1.0; // default male
+            if (isFemale) {
+                image_features[0] = 0.;
+            }
+
+            cv::Mat image_featuresMat = cv::Mat(127, 1, CV_64F, image_features.data());
+            image_featuresMat.convertTo(image_featuresMat, CV_32F);
+            tensor.addInput("image_features", ahiTensorInput(image_featuresMat)); //
+        }
+            break;
+    }
+    //Invoking (inference) starts here, unless the model already ran on the same inputs
+    ahiTensorOutputMap classOutputs;
+    ahiResultCache *resultCache = ahiResultCache::getInstance();
+    std::vector<char> inputsKey = ahiResultCache::inputsKey(tensor.mInputs);
+    run.isInvoked = resultCache->find(tfModelHash, inputsKey, classOutputs);
+    if (!run.isInvoked) {
+        run.isInvoked = tensor.invokeMIMO(tensor.mInputs, classOutputs);
+        if (run.isInvoked) {
+            resultCache->insert(tfModelHash, std::move(inputsKey), classOutputs);
+        }
+    }
+    if (run.isInvoked) {
+        run.numOutputs = (int) classOutputs.size();
+        for (auto iter = classOutputs.begin(); iter != classOutputs.end(); iter++) {
+            cv::Mat currOutResult = iter->second._mat;
+            // we don't calc beyon extra measurment size of about 70
+            if (currOutResult.total() > 80) {
+                continue;
+            }
+            std::vector<float> tf_result;
+            tf_result.assign(currOutResult.begin<float>(), currOutResult.end<float>());
+            run.outputs.push_back({iter->first, tf_result});
+        }
+    }
+
+    // Hand the interpreter back to the pool
+    handBackPooledModel();
+}
+
 // iterate over DL model
 bool ahiFactoryClassify::ahiDLClassification(double height,
                                              double weight,
@@ -332,7 +559,7 @@ bool ahiFactoryClassify::ahiDLClassification(double height,
                                              cv::Mat const &sideSilhouette,
                                              std::vector<double> imageFeatureVector,
                                              const std::string &modelScanType,
-                                             std::map<std::string, std::unique_ptr<tflite::Interpreter>> &loadedTfModels,
+                                             std::map<std::string, std::pair<char *, std::size_t>> &tfModels,
                                              std::vector<std::pair<std::string, std::vector<float>>> &classResultsRawPairs) {
 
     if (!isClassifyInit) {
@@ -344,7 +571,6 @@ bool ahiFactoryClassify::ahiDLClassification(double height,
     std::vector<float> PredHeightGivenWeightGivenFeatDL, PredWeightGivenHeightGivenFeatDL, PredHeightGivenFeatDL, PredWeightGivenFeatDL;
 
     std::map<std::string, float> allMeasurementsDict;
-    std::string extraModelSite;
     bool isFemale = to_lowerStr(gender).find("f") != std::string::npos;
 
     auto modelGenderMaps = modelsZoo.ahiShapeModelGenderMap; // default
@@ -361,345 +587,143 @@ bool ahiFactoryClassify::ahiDLClassification(double height,
         modelGenderMaps.insert(modelsZoo.ahiCompositionModelGenderMap.begin(), modelsZoo.ahiCompositionModelGenderMap.end());
     }
 
-
+    // the models of this scan, in the order of the model maps
+    ahiClassifyGraph graph;
+    std::vector<std::string> graphModelFileNames;
+    std::vector<std::map<std::string, std::pair<char *, std::size_t>>::iterator> graphTfModels;
+    std::vector<uint64_t> graphTfModelHashes;
     for (auto iter = modelGenderMaps.begin(); iter != modelGenderMaps.end(); iter++) {
-        //get ready for the current model
-        classifyFT.mInterpreter = nullptr;
-        classifyFT.mInputs.clear();
-
-        std::string currModelFileName = iter->first.second;;
-        int classModelId = iter->first.first;
-        classifyFT.modelFileName = currModelFileName;
+        std::string currModelFileName = iter->first.second;
+        ahiModelsZooModelId classModelId = iter->first.first;
 
         ahiModelGender currModelGender = iter->second;
         if ((currModelGender == ahiModelGender::Male && isFemale) || (currModelGender == ahiModelGender::Female && !isFemale)) {
             continue;
         }
 
-        if (classifyFT.mInterpreter == nullptr) // not loaded from elsewhere, e.g. java/kotlin. Here we need either the model buffer or its full path
-        {
-            // Move loaded tf model from map
-            bool loadModelSuccess = prepareTensorFlowClassifyModel(std::move(loadedTfModels[currModelFileName]), (string &) "");
-            // unable to load currModelFileName
-            if (!loadModelSuccess)
-                continue;
+        auto tfModel = tfModels.find(currModelFileName);
+        if (tfModel == tfModels.end()) {
+            continue;
+        }
+        auto tfModelHash = mTfModelHashes.find(currModelFileName);
+        if (tfModelHash == mTfModelHashes.end()) {
+            tfModelHash = mTfModelHashes.insert(std::make_pair(currModelFileName,
+                                                               ahiInterpreterPool::contentHash(tfModel->second.first,
+                                                                                               tfModel->second.second))).first;
+        }
+        std::vector<int> dependsOn;
+        auto dependencies = modelsZoo.ahiClassModelDependencies.find(classModelId);
+        if (dependencies != modelsZoo.ahiClassModelDependencies.end()) {
+            dependsOn.assign(dependencies->second.begin(), dependencies->second.end());
+        }
+        graph.addNode(classModelId, dependsOn);
+        graphModelFileNames.push_back(currModelFileName);
+        graphTfModels.push_back(tfModel);
+        graphTfModelHashes.push_back(tfModelHash->second);
+    }
+
+    // silhouettes preprocessed once per scan, shared by the image based models
+    ahiPreprocessContext views(classifyFT, frontSilhouette, sideSilhouette);
+
+    // every worker runs its models on its own tensor, worker 0 on classifyFT
+    std::size_t numWorkers = classifyWorkers > 0 ? (std::size_t) classifyWorkers
+                                                 : std::max(1u, std::thread::hardware_concurrency() / 2);
+    std::vector<std::unique_ptr<ahiFactoryTensor>> workerTensors(numWorkers);
+    std::vector<ahiClassModelRun> runs(graph.size());
+    graph.run(numWorkers, [&](std::size_t node, std::size_t worker) {
+        if (worker > 0 && workerTensors[worker] == nullptr) {
+            workerTensors[worker].reset(new ahiFactoryTensor());
         }
+        ahiFactoryTensor &tensor = worker > 0 ? *workerTensors[worker] : classifyFT;
+        runClassModel(tensor, views, graph.modelId(node), graphModelFileNames[node], graphTfModels[node]->second,
+                      graphTfModelHashes[node], height, weight, gender, imageFeatureVector, runs[node]);
+    });
 
-        std::vector<std::string> InputNames = classifyFT.mInputNames;
-        std::vector<std::string> outputNames = classifyFT.mOutputNames;
-
-        // we need to automate the below to iterate through multiple inputs, but we dont need this here maybe future
-        int pWidth = classifyFT.getInputDim(0, 1);
-        int pHeight = classifyFT.getInputDim(0, 2);
-        cv::Size targetSize(pWidth, pHeight);
-
-        switch (classModelId) {
-            default:
-            case ModelClassV1:
-            case ModelClassV2male:
-            case ModelClassV2female:
-            case ModelClassV2p5:
-            case ModelClassV3male:
-            case ModelClassV3female: {
-                isShape = true;
-                isComposition = false;
-                cv::Mat image_featuresMat = cv::Mat(126, 1, CV_64F, imageFeatureVector.data());
-                image_featuresMat.convertTo(image_featuresMat, CV_32F);
-                classifyFT.addInput(InputNames[0], ahiTensorInput(image_featuresMat,
-                                                                  false)); //InputNames[0] is "silhouettes" (actually the features)
-            }
-                break;
-            case ModelClassV3p1: {
-                isShape = true;
-                isComposition = false;
-                std::vector<double> additional_data(2);
-                additional_data[0] = (height / 255.0f - 0.5149143288800009) / 0.1858516016514072;
-                additional_data[1] = (weight / 255.0f - 0.5149143288800009) / 0.1858516016514072;
-                cv::Mat addInputMat = cv::Mat(2, 1, CV_64F, additional_data.data());
-                addInputMat.convertTo(addInputMat, CV_32F);
-                classifyFT.addInput("additional_data", ahiTensorInput(addInputMat, false));
-                cv::Size target_size = cv::Size(256, 256);
-                int top_, bottom_, left_, right_;
-                cv::Mat prep_front = classifyFT.preprocess_image_std_or_robust(frontSilhouette,
-                                                                               target_size, top_,
-                                                                               bottom_, left_, right_, true, 2.0,
-                                                                               2.0);
-                cv::Mat prep_side = classifyFT.preprocess_image_std_or_robust(sideSilhouette, target_size,
-                                                                              top_, bottom_, left_, right_, true,
-                                                                              1.5, 1.5);
-
-                if (prep_front.rows != prep_side.rows || prep_front.cols != prep_side.cols) {
-                    return false;
-                }
-                std::vector<cv::Mat> front_side_mats(2);
-                front_side_mats[0] = prep_front;
-                front_side_mats[1] = prep_side;
-                cv::Mat front_side_mats_merged;
-                cv::merge(front_side_mats, front_side_mats_merged);
-                front_side_mats_merged.convertTo(front_side_mats_merged, CV_32F);
-                classifyFT.addInput("silhouettes", ahiTensorInput(front_side_mats_merged / 255.0f, true, false, target_size,
-                                                                  {255.0f}, {0.}));
-            }
-                break;
-
-            case ModelClassTBFIM1: {
-                isComposition = true;
-                isShape = false;
-                std::vector<double> additional_data(2);
-                additional_data[0] = height;
-                additional_data[1] = weight;
-                cv::Mat addInputMat = cv::Mat(2, 1, CV_64F, additional_data.data());//cv::Mat(2, 1, CV_32F,additional_data.data());
-                addInputMat.convertTo(addInputMat, CV_32F);
-                classifyFT.addInput("additional_data", ahiTensorInput(addInputMat));
-                cv::Size target_size = cv::Size(256, 256);
-                int top_, bottom_, left_, right_;
-                cv::Mat prep_front = classifyFT.preprocess_image_std_or_robust(frontSilhouette,
-                                                                               target_size, top_,
-                                                                               bottom_, left_, right_, true, 2.0,
-                                                                               2.0);
-                cv::Mat prep_side = classifyFT.preprocess_image_std_or_robust(sideSilhouette, target_size,
-                                                                              top_, bottom_, left_, right_, true,
-                                                                              1.5, 1.5);
-                if (prep_front.rows != prep_side.rows || prep_front.cols != prep_side.cols) {
-                    return false;
-                }
-                std::vector<cv::Mat> front_side_mats(2);
-                front_side_mats[0] = prep_front;
-                front_side_mats[1] = prep_side;
-                cv::Mat front_side_mats_merged;
-                cv::merge(front_side_mats, front_side_mats_merged);
-                front_side_mats_merged.convertTo(front_side_mats_merged, CV_32F);
-                classifyFT.addInput("silhouettes",
-                                    ahiTensorInput(front_side_mats_merged, true, false, target_size,
-                                                   {1.0f}, {0.}));
-            }
-                break;
-
-                // note this uses the same data as the above TBFIM1
-            case ModelClassTBFIM2: {
-                isComposition = true;
-                isShape = false;
-                std::vector<double> additional_data(2);
-                additional_data[0] = height;
-                additional_data[1] = weight;
-                cv::Mat addInputMat = cv::Mat(2, 1, CV_64F, additional_data.data());
-                addInputMat.convertTo(addInputMat, CV_32F);
-                classifyFT.addInput("additional_data", ahiTensorInput(addInputMat, false));
-                cv::Size target_size = cv::Size(256, 256);
-                int top_, bottom_, left_, right_;
-                cv::Mat prep_front = classifyFT.preprocess_image_std_or_robust(frontSilhouette,
-                                                                               target_size, top_,
-                                                                               bottom_, left_, right_, true, 2.0,
-                                                                               2.0);
-                cv::Mat prep_side = classifyFT.preprocess_image_std_or_robust(sideSilhouette, target_size,
-                                                                              top_, bottom_, left_, right_, true,
-                                                                              1.5, 1.5);
-
-                if (prep_front.rows != prep_side.rows || prep_front.cols != prep_side.cols) {
-                    return false;
-                }
-                std::vector<cv::Mat> front_side_mats(2);
-                front_side_mats[0] = prep_front;
-                front_side_mats[1] = prep_side;
-                cv::Mat front_side_mats_merged;
-                cv::merge(front_side_mats, front_side_mats_merged);
-                front_side_mats_merged.convertTo(front_side_mats_merged, CV_32F);
-                classifyFT.addInput("silhouettes",
-                                    ahiTensorInput(front_side_mats_merged, true, false, target_size,
-                                                   {1.0f}, {0.}));
-            }
-                break;
-
-            case ModelClassExmeasImageBased: {
-                isShape = true;
-                isComposition = false;
-                cv::Mat inputImageFeat;
-                cv::Mat inputHWGFeat;
-                cv::Mat inputNormalDist;
-
-                bool isPrepOkay = classifyFT.prepareInputsForImageBasedExtraMeas(frontSilhouette, sideSilhouette, height, weight, gender,
-                                                                                 inputImageFeat,
-                                                                                 inputHWGFeat, inputNormalDist);
-                cv::Size target_size = cv::Size(256, 256);
-                classifyFT.addInput("input_1",
-                                    ahiTensorInput(inputImageFeat, true, false, target_size,
-                                                   {1.0f}, {0.}));
-                classifyFT.addInput("input_2", ahiTensorInput(inputHWGFeat, false));
-                classifyFT.addInput("input_3", ahiTensorInput(inputNormalDist, false));
-            }
-                break;
-
-            case ModelClassExmeasFeatBasedM23: {
-                extraModelSite = "M1";
-                isShape = true;
-                isComposition = false;
-                std::vector<double> extarMeasFeat23(127, 0);
-                for (int n = 0; n < 126; n++) // the 126 can be dynamic length
-                {
-                    extarMeasFeat23[n + 1] = imageFeatureVector[n];
-                }
-                extarMeasFeat23[0] = 1.0; // default male
-                extarMeasFeat23[1] = extarMeasFeat23[1] / 200.0;
-                extarMeasFeat23[2] = extarMeasFeat23[2] / 184.0;
-                if (isFemale) {
-                    extarMeasFeat23[0] = 0;
-                }
-                cv::Mat image_featuresMat = cv::Mat(127, 1, CV_64F, extarMeasFeat23.data());
-                image_featuresMat.convertTo(image_featuresMat, CV_32F);
-                classifyFT.addInput("image_features", ahiTensorInput(image_featuresMat)); //
-
-                std::vector<double> randNormMH = gen_randnorm_vector(0.0, 1.0, 64);
-                cv::Mat input_randnormMat = cv::Mat(64, 1, CV_64F, randNormMH.data());
-                input_randnormMat.convertTo(input_randnormMat, CV_32F);
-                classifyFT.addInput("input_randnorm", ahiTensorInput(input_randnormMat));
-            }
-                break;
-
-            case ModelClassExmeasFeatBasedM60A:
-            case ModelClassExmeasFeatBasedM60B: {
-                isShape = true;
-                isComposition = false;
-                std::vector<double> extarMeasFeat60Plus(127, 0);
-                for (int n = 0; n < 126; n++) // the 126 can be dynamic length
-                {
-                    extarMeasFeat60Plus[n + 1] = imageFeatureVector[n];
-                }
-                extarMeasFeat60Plus[0] = 1.0; // default male
-                extarMeasFeat60Plus[1] = extarMeasFeat60Plus[1] / 210.0;
-                extarMeasFeat60Plus[2] = extarMeasFeat60Plus[2] / 170.0;
-                if (isFemale) {
-                    extarMeasFeat60Plus[0] = 0;
-                }
-                cv::Mat image_featuresMat = cv::Mat(127, 1, CV_64F, extarMeasFeat60Plus.data());
-                image_featuresMat.convertTo(image_featuresMat, CV_32F);
-                classifyFT.addInput("image_features", ahiTensorInput(image_featuresMat)); //
+    //handle the outputs in the order of the model maps, whichever order the models ran in
+    for (auto &run: runs) {
+        if (run.isFailed) {
+            return false;
+        }
+        if (!run.isInvoked) {
+            continue;
+        }
+        // use named measurments as I have done it for iOS via Pairs, them
+        int numOfOutputForTheCurrModel = run.numOutputs;
+        for (auto iter = run.outputs.begin(); iter != run.outputs.end(); iter++) {
 
-                std::vector<double> randNormMH = gen_randnorm_vector(0.0, 1.0, 96);
-                cv::Mat input_randnormMat = cv::Mat(96, 1, CV_64F, randNormMH.data());
-                input_randnormMat.convertTo(input_randnormMat, CV_32F);
-                classifyFT.addInput("input_randnorm", ahiTensorInput(input_randnormMat));
+            std::string currModelOutNodeName = iter->first;
+            const std::vector<float> &tf_result = iter->second;
 
-                if (classModelId == ModelClassExmeasFeatBasedM60A) {
-                    extraModelSite = "M1";
-                }
-                if (classModelId == ModelClassExmeasFeatBasedM60B) {
-                    extraModelSite = "M2";
-                }
-            }
-                break;
+            bool isExMeasFeatBased = currModelOutNodeName.find("decoder/eval/measfc") != string::npos;
+            bool isExMeasImgBased = currModelOutNodeName.find("Identity") != string::npos;
 
-            case ModelClassHeighWeightFeatBased: {
-                isComposition = true;
-                isShape = false;
-                std::vector<double> image_features(127, 0);
-                for (int n = 0; n < 126; n++) // the 126 can be dynamic length
-                {
-                    image_features[n + 1] = imageFeatureVector[n];
-                }
-                image_features[0] = 1.0; // default male
-                if (isFemale) {
-                    image_features[0] = 0.;
-                }
+            bool isHeightWeightPred = currModelOutNodeName.find("pred_height_weight/BiasAdd") != string::npos;
+            bool isHeightPred = currModelOutNodeName.find("pred_height/BiasAdd") != string::npos;
+            bool isWeightPred = currModelOutNodeName.find("pred_weight/BiasAdd") != string::npos;
 
-                cv::Mat image_featuresMat = cv::Mat(127, 1, CV_64F, image_features.data());
-                image_featuresMat.convertTo(image_featuresMat, CV_32F);
-                classifyFT.addInput("image_features", ahiTensorInput(image_featuresMat)); //
-            }
-                break;
-        }
-        //Invoking (inference) starts here
-        ahiTensorOutputMap classOutputs;
-        bool invokeSucessCurrent = classifyFT.invokeMIMO(classifyFT.mInputs, classOutputs);
-        //handle classOutputs
-        if (invokeSucessCurrent) {
-            // use named measurments as I have done it for iOS via Pairs, them
-            int numOfOutputForTheCurrModel = (int) classOutputs.size();
-            for (auto iter = classOutputs.begin(); iter != classOutputs.end(); iter++) {
-
-                std::string currModelOutNodeName = iter->first;
-                cv::Mat currOutResult = iter->second._mat;
-
-                bool isExMeasFeatBased = currModelOutNodeName.find("decoder/eval/measfc") != string::npos;
-                bool isExMeasImgBased = currModelOutNodeName.find("Identity") != string::npos;
-
-                bool isHeightWeightPred = currModelOutNodeName.find("pred_height_weight/BiasAdd") != string::npos;
-                bool isHeightPred = currModelOutNodeName.find("pred_height/BiasAdd") != string::npos;
-                bool isWeightPred = currModelOutNodeName.find("pred_weight/BiasAdd") != string::npos;
-
-                bool isAnyHW = isHeightWeightPred || isHeightPred || isWeightPred;
-                std::vector<float> tf_result;
-                tf_result.assign(currOutResult.begin<float>(), currOutResult.end<float>());
-
-                //Chest, Waist, Hips etc.
-                // Extra meas or handling of MIMO here
-                size_t count = tf_result.size();
-                if (count > 80) // we don't calc beyon extra measurment size of about 70
-                {
-                    continue;
-                }
+            bool isAnyHW = isHeightWeightPred || isHeightPred || isWeightPred;
 
-                bool bValid = true;
-                for (size_t i = 0; i < count; i++) {
-                    if (isnan(tf_result[i])) {
-                        bValid = false;
-                        break;
-                    }
+            //Chest, Waist, Hips etc.
+            // Extra meas or handling of MIMO here
+            size_t count = tf_result.size();
 
-                    if (isinf(tf_result[i])) {
-                        bValid = false;
-                        break;
-                    }
+            bool bValid = true;
+            for (size_t i = 0; i < count; i++) {
+                if (isnan(tf_result[i])) {
+                    bValid = false;
+                    break;
+                }
 
-                    if (tf_result[i] < 0) { // unless one of our predictions is expected to be  < 0
-                        bValid = false;
-                        break;
-                    }
+                if (isinf(tf_result[i])) {
+                    bValid = false;
+                    break;
+                }
+
+                if (tf_result[i] < 0) { // unless one of our predictions is expected to be  < 0
+                    bValid = false;
+                    break;
                 }
+            }
 
-                if (bValid) {
+            if (bValid) {
 
-                    if (isShape) {
-                        // before adding extra measurement. We can change this further in the future
-                        if (numOfOutputForTheCurrModel == 1) {
+                if (run.isShape) {
+                    // before adding extra measurement. We can change this further in the future
+                    if (numOfOutputForTheCurrModel == 1) {
 
-                            if (count == 3) //chest waist and hips
-                            {
-                                ChestDL.push_back(tf_result[0]);
-                                WaistDL.push_back(tf_result[1]);
-                                HipsDL.push_back(tf_result[2]);
-                            }
+                        if (count == 3) //chest waist and hips
+                        {
+                            ChestDL.push_back(tf_result[0]);
+                            WaistDL.push_back(tf_result[1]);
+                            HipsDL.push_back(tf_result[2]);
                         }
+                    }
 
-                        // new models e.g. extra measurements models
-                        if (isExMeasFeatBased) {
-                            handleFeatureBasedExtraMeas(tf_result, currModelOutNodeName, extraModelSite, allMeasurementsDict);
-                        } else if (isExMeasImgBased) {
-                            handleImageBasedExtraMeas(tf_result, currModelOutNodeName, allMeasurementsDict);
-                        }
+                    // new models e.g. extra measurements models
+                    if (isExMeasFeatBased) {
+                        handleFeatureBasedExtraMeas(tf_result, currModelOutNodeName, run.extraModelSite, allMeasurementsDict);
+                    } else if (isExMeasImgBased) {
+                        handleImageBasedExtraMeas(tf_result, currModelOutNodeName, allMeasurementsDict);
+                    }
 
-                    } else {
-                        if (isAnyHW) {
-                            if (isHeightPred) {
-                                PredHeightGivenWeightGivenFeatDL.push_back(tf_result[0]);
-                            } else if (isWeightPred) {
-                                PredWeightGivenHeightGivenFeatDL.push_back(tf_result[0]);
-                            } else if (isHeightWeightPred) {
-                                PredHeightGivenFeatDL.push_back(tf_result[0]);
-                                PredWeightGivenFeatDL.push_back(tf_result[1]);
-                            }
-                        } else if (count == 1) {
-                            FatDL.push_back(tf_result[0]);
+                } else {
+                    if (isAnyHW) {
+                        if (isHeightPred) {
+                            PredHeightGivenWeightGivenFeatDL.push_back(tf_result[0]);
+                        } else if (isWeightPred) {
+                            PredWeightGivenHeightGivenFeatDL.push_back(tf_result[0]);
+                        } else if (isHeightWeightPred) {
+                            PredHeightGivenFeatDL.push_back(tf_result[0]);
+                            PredWeightGivenFeatDL.push_back(tf_result[1]);
                         }
-
+                    } else if (count == 1) {
+                        FatDL.push_back(tf_result[0]);
                     }
 
                 }
+
             }
         }
-
-        // Move loaded tf model back into map
-        loadedTfModels[currModelFileName] = std::move(classifyFT.mInterpreter);
-        classifyFT.mInputs.clear();
     }
 
 
@@ -1012,17 +1036,12 @@ ahiClassifyInfo ahiFactoryClassify::getClassifyOutInfo(double height,
         return classInfo;
     }
 
-    // Load all TF models into memory
-    auto loadedTfModels = ahiFactoryClassify::loadAllTfModels(tfModels);
+    // Interpreters are borrowed from the process wide pool, only the buffers need hashing here
+    hashTfModels(tfModels);
 
-    bool isDLSucess = ahiDLClassification(height, weight, gender, frontSilhouette, sideSilhouette, sil_features_for_DL, modelScanType, loadedTfModels,
+    bool isDLSucess = ahiDLClassification(height, weight, gender, frontSilhouette, sideSilhouette, sil_features_for_DL, modelScanType, tfModels,
                                           classResultsRawPairs);
 
-    // Release all loaded TF models from memory
-    for (auto &model: loadedTfModels) {
-        model.second.release();
-    }
-
     if (!isDLSucess || classResultsRawPairs.empty()) {
         return classInfo;
     }
@@ -1083,8 +1102,8 @@ ahiFactoryClassify::getClassifyOutInfoMultipleImages(double height,
     // I would use this outside this function and iterate over  all 4 images then average later but in this example I'm only averaging over the results of 1 front and 1 side
     std::vector<std::pair<std::string, std::vector<float>>> classResultsRawPairs;
 
-    // Load all TF models into memory
-    auto loadedTfModels = ahiFactoryClassify::loadAllTfModels(tfModels);
+    // Interpreters are borrowed from the process wide pool, only the buffers need hashing here
+    hashTfModels(tfModels);
 
     for (int idx = 0; idx < frontSilhouettes.size(); idx++) {
         cv::Mat frontSilhouette = frontSilhouettes[idx];
@@ -1106,18 +1125,13 @@ ahiFactoryClassify::getClassifyOutInfoMultipleImages(double height,
 
         bool isDLSucess = ahiDLClassification(height, weight, gender, frontSilhouette,
                                               sideSilhouette, sil_features_for_DL, modelScanType,
-                                              loadedTfModels, classResultsRawPairs);
+                                              tfModels, classResultsRawPairs);
 
         if (!isDLSucess || classResultsRawPairs.empty()) {
             return classInfo;
         }
     }
 
-    // Release all loaded TF models from memory
-    for (auto &model: loadedTfModels) {
-        model.second.release();
-    }
-
     // here we take mean and stdDev and clean results
     // it is highly preferred to do these over all 4 front and 4 side images  but here we do it for a single front and a single side image
     std::string addKey = "Current";
@@ -4,16 +4,20 @@
 //
 
 #include "ahiFactoryTensor.hpp"
+#include "ahiModelNoise.hpp"
+#include "ahiPreprocessContext.hpp"
+#include <thread>
 
 #if defined(ANDROID) || defined(__ANDROID__)
 
 #include <jni.h>
 #include <android/bitmap.h>
 #include "ndk/sources/android/cpufeatures/cpu-features.h"
-#include "AHILogging.hpp"
 
 #endif
 
+#include "AHILogging.hpp"
+
 
 // make it large
 int openCV_TfLiteTypes[32] = {-100};
@@ -88,6 +92,7 @@ void ahiFactoryTensor::PrintModelInfo(const tflite::Interpreter *interpreter) {
 }
 
 void ahiFactoryTensor::GetModelInpOutNames() {
+    mSignature = ahiTensorSignature();
     // Below can be added to PrintModelInfo above
     const auto inputs = mInterpreter->inputs();
     mInputNames.clear();
@@ -121,7 +126,7 @@ void ahiFactoryTensor::resetInterpreter() {
 }
 
 bool ahiFactoryTensor::buildInterpreter() {
-    RETURN_FALSE_IF_TF_FAIL(tflite::InterpreterBuilder(*mModel, mResolver)(&mInterpreter))
+    RETURN_FALSE_IF_TF_FAIL(tflite::InterpreterBuilder(mSharedModel ? *mSharedModel : *mModel, mResolver)(&mInterpreter))
     mInterpreter->SetNumThreads(num_thread_);
 
     if (build_type_ == kNNAPI) {
@@ -229,59 +234,185 @@ std::unique_ptr<tflite::Interpreter> ahiFactoryTensor::buildOptimalInterpreter(s
 }
 
 
-bool ahiFactoryTensor::buildOptimalInterpreter() {
-    RETURN_FALSE_IF_TF_FAIL(tflite::InterpreterBuilder(*mModel, mResolver)(&mInterpreter))
-    mInterpreter->SetNumThreads(num_thread_);
-    InferenceMethod = "";
-    TfLiteStatus Status;
-    // GPU
-    try {
-        InferenceMethod = "gpu_delegate";
-        gpu_delegate_.reset(TfLiteGpuDelegateV2Create(&gpu_options_));
-        Status = mInterpreter->ModifyGraphWithDelegate(gpu_delegate_.get());
-        if (Status == kTfLiteOk)
-            return true;
+std::string ahiFactoryTensor::buildTypeName(BUILD_TYPE type) {
+    switch (type) {
+        case kGPU:
+            return "gpu_delegate";
+        case kNNAPI:
+            return "nnapi_delegate";
+        case kXNNPack:
+            return "xnn_delegate";
+        case kCPU:
+        default:
+            return "cpu";
     }
-    catch (std::exception e) {
-        Status = kTfLiteError;
-        LOG_GUARD(std::cout << "Could not use the GPU: " << e.what() << std::endl)
+}
+
+bool ahiFactoryTensor::buildTypeFromName(const std::string &name, BUILD_TYPE &type) {
+    for (BUILD_TYPE candidate: {kCPU, kGPU, kNNAPI, kXNNPack}) {
+        if (buildTypeName(candidate) == name) {
+            type = candidate;
+            return true;
+        }
     }
-    // NNAPI
-    if (Status != kTfLiteOk)
-        try {
-            InferenceMethod = "nnapi_delegate";
+    return false;
+}
+
+// Builds mInterpreter from mModel with exactly the given delegate (none for kCPU) and allocates its tensors.
+bool ahiFactoryTensor::buildInterpreterWith(BUILD_TYPE type, int numThreads) {
+    // the delegate must outlive the interpreter, so drop the old interpreter before its delegate is replaced
+    mInterpreter.reset();
+    try {
+        if (tflite::InterpreterBuilder(mSharedModel ? *mSharedModel : *mModel, mResolver)(&mInterpreter) != kTfLiteOk || mInterpreter == nullptr) {
+            mInterpreter.reset();
+            return false;
+        }
+        mInterpreter->SetNumThreads(numThreads);
+        TfLiteStatus Status = kTfLiteOk;
+        if (type == kGPU) {
+            gpu_delegate_.reset(TfLiteGpuDelegateV2Create(&gpu_options_));
+            Status = mInterpreter->ModifyGraphWithDelegate(gpu_delegate_.get());
+        } else if (type == kNNAPI) {
             nnapi_delegate_ = std::make_unique<tflite::StatefulNnApiDelegate>();
             Status = mInterpreter->ModifyGraphWithDelegate(nnapi_delegate_.get());
-            if (Status == kTfLiteOk)
-                return true;
-        }
-        catch (std::exception e) {
-            Status = kTfLiteError;
-            LOG_GUARD(std::cout << "Could not use NNAPI: " << e.what() << std::endl)
-        }
-
-    // XNNPACK
-    if (Status != kTfLiteOk)
-        try {
-            InferenceMethod = "xnn_delegate";
+        } else if (type == kXNNPack) {
+            xnn_options_.num_threads = numThreads;
             xnn_delegate_.reset(TfLiteXNNPackDelegateCreate(&xnn_options_));
             Status = mInterpreter->ModifyGraphWithDelegate(xnn_delegate_.get());
-            if (Status == kTfLiteOk)
-                return true;
         }
-        catch (std::exception e) {
-            Status = kTfLiteError;
-            LOG_GUARD(std::cout << "Could not use XNNAPACK: " << e.what() << std::endl)
+        if (Status == kTfLiteOk) {
+            Status = mInterpreter->AllocateTensors();
+        }
+        if (Status != kTfLiteOk) {
+            mInterpreter.reset();
+            return false;
         }
+    }
+    catch (std::exception &e) {
+        LOG_GUARD(std::cout << "Could not use " << buildTypeName(type) << ": " << e.what() << std::endl)
+        mInterpreter.reset();
+        return false;
+    }
+    InferenceMethod = buildTypeName(type);
+    return true;
+}
 
-    // Still fails, then go to the default (CPU)
+// Invokes mInterpreter once on zeroed inputs, returns the wall time in ms or -1 on failure.
+double ahiFactoryTensor::timeInvokeMs() {
+    for (std::size_t index = 0; index < mInterpreter->inputs().size(); index++) {
+        TfLiteTensor *tensor = mInterpreter->input_tensor(index);
+        if (tensor != nullptr && tensor->data.raw != nullptr) {
+            std::memset(tensor->data.raw, 0, tensor->bytes);
+        }
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    TfLiteStatus Status = mInterpreter->Invoke();
+    const auto t2 = std::chrono::steady_clock::now();
     if (Status != kTfLiteOk) {
-        mInterpreter.release();
-        InferenceMethod = "cpu";
-        buildInterpreter();
+        return -1;
     }
+    return std::chrono::duration<double, std::milli>(t2 - t1).count();
+}
 
-    RETURN_FALSE_IF_TF_FAIL(mInterpreter->AllocateTensors())
+// Times XNNPack and the builtin kernels at 1, 2 and 4 threads and returns the fastest steady state configuration.
+bool ahiFactoryTensor::benchmarkCpuConfigs(ahiDelegateDecision &best) {
+    const int nTimedRuns = 3;
+    int maxThreads = std::max(1, (int) std::thread::hardware_concurrency());
+    bool isFound = false;
+    for (BUILD_TYPE type: {kXNNPack, kCPU}) {
+        for (int numThreads: {1, 2, 4}) {
+            if (numThreads > maxThreads) {
+                continue;
+            }
+            if (!buildInterpreterWith(type, numThreads)) {
+                continue;
+            }
+            double firstInvokeMs = timeInvokeMs();
+            double invokeMs = -1;
+            for (int run = 0; run < nTimedRuns && firstInvokeMs >= 0; run++) {
+                double runMs = timeInvokeMs();
+                if (runMs >= 0 && (invokeMs < 0 || runMs < invokeMs)) {
+                    invokeMs = runMs;
+                }
+            }
+            LOG_GUARD(std::cout << "[buildOptimalInterpreter] " << modelFileName << " " << buildTypeName(type) << " x" << numThreads
+                                << ": first " << firstInvokeMs << " ms, steady " << invokeMs << " ms" << std::endl)
+            if (invokeMs < 0) {
+                continue;
+            }
+            if (!isFound || invokeMs < best.invokeMs) {
+                best.delegate = buildTypeName(type);
+                best.numThreads = numThreads;
+                best.firstInvokeMs = firstInvokeMs;
+                best.invokeMs = invokeMs;
+                isFound = true;
+            }
+        }
+    }
+    return isFound;
+}
+
+bool ahiFactoryTensor::buildOptimalInterpreter() {
+    if (mModel == nullptr && mSharedModel == nullptr) {
+        return false;
+    }
+    ahiDelegateCache *delegateCache = ahiDelegateCache::getInstance();
+    std::string cacheKey = mDelegateCacheKey.empty() ? modelFileName : mDelegateCacheKey;
+    ahiDelegateDecision decision;
+    BUILD_TYPE type = kCPU;
+
+    // A decision made earlier on this device (this process or, with a cache file, a previous one) skips the probing
+    if (!cacheKey.empty() && delegateCache->lookup(cacheKey, decision)) {
+        if (buildTypeFromName(decision.delegate, type) && buildInterpreterWith(type, decision.numThreads)) {
+            PrintModelInfo(mInterpreter.get());
+            return true;
+        }
+        delegateCache->forget(cacheKey);
+    }
+    decision = ahiDelegateDecision();
+
+    bool isBuilt = false;
+#if defined(ANDROID) || defined(__ANDROID__)
+    // GPU, then NNAPI
+    for (BUILD_TYPE accelerator: {kGPU, kNNAPI}) {
+        if (buildInterpreterWith(accelerator, num_thread_)) {
+            decision.delegate = buildTypeName(accelerator);
+            decision.numThreads = num_thread_;
+            isBuilt = true;
+            break;
+        }
+    }
+#endif
+
+    // CPU only: measure XNNPack vs the builtin kernels rather than trusting the fallback order
+    if (!isBuilt && delegateCache->isBenchmarkMode() && benchmarkCpuConfigs(decision)) {
+        isBuilt = buildTypeFromName(decision.delegate, type) && buildInterpreterWith(type, decision.numThreads);
+    }
+
+    // XNNPACK, then the default (CPU)
+    if (!isBuilt) {
+        decision = ahiDelegateDecision();
+        for (BUILD_TYPE fallback: {kXNNPack, kCPU}) {
+            if (buildInterpreterWith(fallback, num_thread_)) {
+                decision.delegate = buildTypeName(fallback);
+                decision.numThreads = num_thread_;
+                isBuilt = true;
+                break;
+            }
+        }
+    }
+
+    if (!isBuilt) {
+        InferenceMethod = "";
+        return false;
+    }
+
+    if (decision.firstInvokeMs < 0) {
+        decision.firstInvokeMs = timeInvokeMs();
+    }
+    if (!cacheKey.empty()) {
+        delegateCache->record(cacheKey, decision);
+    }
 
     PrintModelInfo(mInterpreter.get());
 
@@ -854,7 +985,7 @@ std::vector<double> ahiFactoryTensor::generateUniformMLSamples(int numSamples) {
     return outputSamples;
 }
 
-bool ahiFactoryTensor::prepareInputsForImageBasedExtraMeas(cv::Mat front_silhoutte, cv::Mat side_silhoutte, double height, double weight,
+bool ahiFactoryTensor::prepareInputsForImageBasedExtraMeas(ahiPreprocessContext &views, double height, double weight,
                                                            std::string gender,
                                                            cv::Mat &inputImageFeat,
                                                            cv::Mat &inputHWGFeat,
@@ -863,27 +994,7 @@ bool ahiFactoryTensor::prepareInputsForImageBasedExtraMeas(cv::Mat front_silhout
     try {
 
         //preprate the input for the model to correctly
-        cv::Size target_size(256, 256);
-        int top;
-        int bottom;
-        int left;
-        int right;
-        cv::Mat prep_front = preprocess_image_for_exmeas(front_silhoutte, target_size, top, bottom,
-                                                         left, right);
-        cv::Mat prep_side = preprocess_image_for_exmeas(side_silhoutte, target_size, top, bottom,
-                                                        left, right);
-        cv::Mat prep_fside;
-        //1 correcponds to mirror image
-        cv::flip(prep_side, prep_fside, 1);
-
-        cv::Mat tempimg[3];
-        tempimg[0] = prep_front;
-        tempimg[1] = prep_side;
-        tempimg[2] = prep_fside;
-        cv::Mat silhouttes;
-        cv::merge(tempimg, 3, silhouttes);
-        silhouttes.convertTo(inputImageFeat, CV_32F);
-        silhouttes.release();
+        inputImageFeat = views.extraMeasSilhouettes(cv::Size(256, 256));
 
         std::vector<double> heightWeightGender(3);
         //Male
@@ -898,8 +1009,10 @@ bool ahiFactoryTensor::prepareInputsForImageBasedExtraMeas(cv::Mat front_silhout
         inputHWGFeat = cv::Mat(3, 1, CV_64F, heightWeightGender.data());
         inputHWGFeat.convertTo(inputHWGFeat, CV_32F);
 
-        inputNormalDist = cv::Mat(256, 1, CV_64F, (generateUniformMLSamples(256)).data());
-        inputNormalDist.convertTo(inputNormalDist, CV_32F);
+        // drawn once per model: the model was trained against this draw
+        inputNormalDist = ahiModelNoise::getInstance()->samples(modelFileName, 256, [this](int numSamples) {
+            return generateUniformMLSamples(numSamples);
+        });
 
         return true;
     }
@@ -909,80 +1022,110 @@ bool ahiFactoryTensor::prepareInputsForImageBasedExtraMeas(cv::Mat front_silhout
 }
 
 ////////////////////////////////////////////////////////
-bool ahiFactoryTensor::invokeMIMO(ahiTensorInputMap &inputs, ahiTensorOutputMap &outputs) {
-    match_CV_TF_types();
-    {
-        LOG_GUARD(std::cout << "[TensorModel::invoke]: Now invoking model " << mModelName << std::endl);
-        auto inputCount = inputs.size();
-        auto iter = inputs.begin();
-
-        while (iter != inputs.end()) {
-            // Get the iterator to the first named input - allows for unnamed input.
-            auto name = mInputNames.begin();
-            if (inputCount > 1) {
-                // If there's more than one input supplied -> search for input by name.
-                name = std::find(mInputNames.begin(), mInputNames.end(), iter->first);
-            }
-            if (name != mInputNames.end()) {
-
-                auto nameIx = std::distance(mInputNames.begin(), name);
-                const int inputIx = mInterpreter->inputs()[nameIx];
-                TfLiteTensor *tensor = mInterpreter->tensor(inputIx);
-                cv::Mat inputMat = iter->second._mat;
-                auto type = mInterpreter->input_tensor(nameIx)->type;
-
-                if (inputMat.rows > 1 && inputMat.cols > 1) {
-                    int CV_type = openCV_TfLiteTypes[type];
-                    if (CV_type < 0) {
-                        LOG_GUARD(std::cout << "TF input has unsupported CV type" << std::endl);
-                        return false;
-                    }
+bool ahiFactoryTensor::prepareSignature() {
+    if (mInterpreter == nullptr) {
+        return false;
+    }
+    if (mSignature.interpreter == mInterpreter.get()) {
+        return true;
+    }
+    static const bool typesMatched = (match_CV_TF_types(), true);
+    (void) typesMatched;
+    ahiTensorSignature signature;
+    signature.interpreter = mInterpreter.get();
+    for (int position = 0; position < (int) mInterpreter->inputs().size(); position++) {
+        signature.inputPositions[mInterpreter->GetInputName(position)] = position;
+        signature.inputDepths.push_back(openCV_TfLiteTypes[mInterpreter->input_tensor(position)->type]);
+    }
+    for (int position = 0; position < (int) mInterpreter->outputs().size(); position++) {
+        signature.outputDepths.push_back(openCV_TfLiteTypes[mInterpreter->output_tensor(position)->type]);
+    }
+    mSignature = signature;
+    return true;
+}
 
-                    inputMat.convertTo(inputMat, CV_type);
-                }
+cv::Mat ahiFactoryTensor::inputView(int position) {
+    if (!prepareSignature() || position < 0 || position >= (int) mSignature.inputDepths.size() ||
+        mSignature.inputDepths[position] < 0) {
+        return cv::Mat();
+    }
+    TfLiteTensor *tensor = mInterpreter->input_tensor(position);
+    int depth = mSignature.inputDepths[position];
+    if (tensor->dims->size == 4 && tensor->dims->data[0] == 1) {
+        return cv::Mat(tensor->dims->data[1], tensor->dims->data[2], CV_MAKETYPE(depth, tensor->dims->data[3]),
+                       tensor->data.raw);
+    }
+    if (tensor->dims->size == 0) {
+        return cv::Mat(1, 1, depth, tensor->data.raw);
+    }
+    return cv::Mat(tensor->dims->size, tensor->dims->data, depth, tensor->data.raw);
+}
 
-                size_t cvSizeInBytes = inputMat.total() * inputMat.elemSize();
-                if (cvSizeInBytes <= tensor->bytes) {
-                    std::memcpy(mInterpreter->input_tensor(nameIx)->data.data, inputMat.data, cvSizeInBytes);
-                } else {
-                    LOG_GUARD(
-                            std::cout << "[TensorModel::invoke]:" << mModelName << " error (" << mInputNames[nameIx] << ") - invalid input mat size "
-                                      << cvSizeInBytes << " vs " << tensor->bytes << std::endl)
-                    return false;
-                }
+bool ahiFactoryTensor::invokeMIMO(ahiTensorInputMap &inputs, ahiTensorOutputMap &outputs) {
+    if (!prepareSignature()) {
+        return false;
+    }
+    for (auto iter = inputs.begin(); iter != inputs.end(); iter++) {
+        // a single input feeds the first tensor whatever its name, several are matched by name
+        int position = 0;
+        if (inputs.size() > 1) {
+            auto named = mSignature.inputPositions.find(iter->first);
+            if (named == mSignature.inputPositions.end()) {
+                continue;
             }
-            iter++;
+            position = named->second;
         }
-
-        //TODO: check if all inputs succeeded.
-        {
-            const TfLiteStatus status = mInterpreter->Invoke();
-
-            if (status != kTfLiteOk) {
+        TfLiteTensor *tensor = mInterpreter->input_tensor(position);
+        cv::Mat inputMat = iter->second._mat;
+        if (inputMat.data == reinterpret_cast<const uchar *>(tensor->data.raw)) {
+            continue; // preprocessed into inputView
+        }
+        if (!inputMat.isContinuous()) {
+            inputMat = inputMat.clone();
+        }
+        int depth = inputMat.depth();
+        if (inputMat.rows > 1 && inputMat.cols > 1 && depth != mSignature.inputDepths[position]) {
+            depth = mSignature.inputDepths[position];
+            if (depth < 0) {
+                LOG_GUARD(std::cout << "TF input has unsupported CV type" << std::endl);
                 return false;
             }
+        }
+        int type = CV_MAKETYPE(depth, inputMat.channels());
+        size_t cvSizeInBytes = inputMat.total() * CV_ELEM_SIZE(type);
+        if (cvSizeInBytes > tensor->bytes) {
+            LOG_GUARD(std::cout << "[TensorModel::invoke]:" << mModelName << " error (" << iter->first
+                                << ") - invalid input mat size " << cvSizeInBytes << " vs " << tensor->bytes << std::endl)
+            return false;
+        }
+        if (type != inputMat.type()) {
+            // converted straight into the tensor
+            cv::Mat tensorMat(inputMat.dims, inputMat.size.p, type, tensor->data.raw);
+            inputMat.convertTo(tensorMat, type);
+        } else {
+            std::memcpy(tensor->data.raw, inputMat.data, cvSizeInBytes);
+        }
+    }
 
-            auto ix = 0;
-            size_t nOutputs = mInterpreter->outputs().size();
-
-            while (ix < nOutputs) {
-                auto outputName = mOutputNames[ix];
-                const int outputIx = mInterpreter->outputs()[ix];
-                TfLiteTensor *tensor = mInterpreter->tensor(outputIx);
-                cv::Mat output(tensor->dims->size, tensor->dims->data, CV_32F);
-                size_t cvSizeInBytes = output.total() * output.elemSize();
-                memcpy(output.data, mInterpreter->typed_output_tensor<float>(ix), cvSizeInBytes);
-                ahiTensorOutput outputStruct;
-                outputStruct._mat = output;
-                outputs[outputName] = outputStruct;
-                ix++;
-            }
+    if (mInterpreter->Invoke() != kTfLiteOk) {
+        return false;
+    }
 
-            return true;
+    for (int position = 0; position < (int) mInterpreter->outputs().size(); position++) {
+        const TfLiteTensor *tensor = mInterpreter->output_tensor(position);
+        int depth = mSignature.outputDepths[position];
+        if (depth < 0) {
+            return false;
+        }
+        ahiTensorOutput outputStruct;
+        if (tensor->dims->size > 0) {
+            outputStruct._mat = cv::Mat(tensor->dims->size, tensor->dims->data, depth, tensor->data.raw);
+        } else {
+            outputStruct._mat = cv::Mat(1, 1, depth, tensor->data.raw);
         }
+        outputs[mInterpreter->GetOutputName(position)] = outputStruct;
     }
-
-    return false;
+    return true;
 }
 
 #if 0
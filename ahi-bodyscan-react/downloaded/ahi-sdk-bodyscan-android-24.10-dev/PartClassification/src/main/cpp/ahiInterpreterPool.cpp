@@ -0,0 +1,257 @@
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "ahiInterpreterPool.hpp"
+
+Mutex gPoolInstanceMutex_;
+ahiInterpreterPool *ahiInterpreterPool::mThis = nullptr;
+
+ahiInterpreterPool *ahiInterpreterPool::getInstance() {
+    AutoLock lock(gPoolInstanceMutex_);
+
+    if (nullptr == mThis) {
+        mThis = new ahiInterpreterPool();
+    }
+
+    return mThis;
+}
+
+namespace {
+    const uint64_t kPrime1 = 0x9e3779b185ebca87ULL;
+    const uint64_t kPrime2 = 0xc2b2ae3d27d4eb4fULL;
+    const uint64_t kPrime3 = 0x165667b19e3779f9ULL;
+    const uint64_t kPrime4 = 0x85ebca77c2b2ae63ULL;
+    const uint64_t kPrime5 = 0x27d4eb2f165667c5ULL;
+
+    inline uint64_t rotl(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline uint64_t readWord(const char *p) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(uint64_t));
+        return word;
+    }
+
+    inline uint64_t mixRound(uint64_t acc, uint64_t word) {
+        return rotl(acc + word * kPrime2, 31) * kPrime1;
+    }
+
+    inline uint64_t mergeRound(uint64_t hash, uint64_t acc) {
+        return (hash ^ mixRound(0, acc)) * kPrime1 + kPrime4;
+    }
+}
+
+// XXH64 (seed 0): every word is mixed on its own before it is folded in and the result is avalanched, so unlike a
+// word-wise FNV, flipping the same bits in two words does not cancel out. Four lanes keep it at memory speed over
+// tens of MB of models per scan.
+uint64_t ahiInterpreterPool::contentHash(const char *buffer, std::size_t bufferSize) {
+    const char *p = buffer;
+    const char *end = buffer + (buffer == nullptr ? 0 : bufferSize);
+    uint64_t hash;
+    if (end - p >= 32) {
+        uint64_t v1 = kPrime1 + kPrime2;
+        uint64_t v2 = kPrime2;
+        uint64_t v3 = 0;
+        uint64_t v4 = 0 - kPrime1;
+        for (; end - p >= 32; p += 32) {
+            v1 = mixRound(v1, readWord(p));
+            v2 = mixRound(v2, readWord(p + 8));
+            v3 = mixRound(v3, readWord(p + 16));
+            v4 = mixRound(v4, readWord(p + 24));
+        }
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    } else {
+        hash = kPrime5;
+    }
+    hash += (uint64_t) bufferSize;
+    for (; end - p >= 8; p += 8) {
+        hash = rotl(hash ^ mixRound(0, readWord(p)), 27) * kPrime1 + kPrime4;
+    }
+    if (end - p >= 4) {
+        uint32_t half;
+        std::memcpy(&half, p, sizeof(uint32_t));
+        hash = rotl(hash ^ ((uint64_t) half * kPrime1), 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        hash = rotl(hash ^ ((uint8_t) *p * kPrime5), 11) * kPrime1;
+    }
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+std::shared_ptr<const tflite::FlatBufferModel>
+ahiInterpreterPool::sharedModel(const ahiInterpreterPoolKey &key, const char *buffer, std::size_t bufferSize) {
+    {
+        AutoLock lock(mMutex);
+        auto iter = mModels.find(key);
+        if (iter != mModels.end()) {
+            std::shared_ptr<const tflite::FlatBufferModel> model = iter->second.lock();
+            if (model != nullptr) {
+                return model;
+            }
+        }
+    }
+    // Own the bytes: the FlatBufferModel does not copy them and the caller's buffer only lives for one classify call.
+    std::shared_ptr<ahiPooledModel> loaded = std::make_shared<ahiPooledModel>();
+    loaded->bytes.assign(buffer, buffer + bufferSize);
+    loaded->model = tflite::FlatBufferModel::BuildFromBuffer(loaded->bytes.data(), loaded->bytes.size());
+    if (loaded->model == nullptr) {
+        return nullptr;
+    }
+    // the handed out pointer keeps the bytes alive with the model
+    std::shared_ptr<const tflite::FlatBufferModel> model(loaded, loaded->model.get());
+    AutoLock lock(mMutex);
+    std::weak_ptr<const tflite::FlatBufferModel> &slot = mModels[key];
+    std::shared_ptr<const tflite::FlatBufferModel> raced = slot.lock();
+    if (raced != nullptr) {
+        return raced;
+    }
+    slot = model;
+    return model;
+}
+
+std::unique_ptr<ahiPooledInterpreter>
+ahiInterpreterPool::build(const std::string &modelId, const char *buffer, std::size_t bufferSize, uint64_t hash) {
+    if (buffer == nullptr || bufferSize < 10) {
+        return nullptr;
+    }
+    std::unique_ptr<ahiPooledInterpreter> pooled(new ahiPooledInterpreter());
+    pooled->modelId = modelId;
+    pooled->contentHash = hash;
+    pooled->builder.modelFileName = modelId;
+    std::stringstream cacheKey;
+    cacheKey << modelId << "#" << std::hex << hash;
+    pooled->builder.mDelegateCacheKey = cacheKey.str();
+    pooled->builder.mSharedModel = sharedModel(std::make_pair(modelId, hash), buffer, bufferSize);
+    if (pooled->builder.mSharedModel == nullptr) {
+        return nullptr;
+    }
+    if (!pooled->builder.buildOptimalInterpreter() || pooled->builder.mInterpreter == nullptr) {
+        return nullptr;
+    }
+    pooled->builder.GetModelInpOutNames();
+    pooled->builder.prepareSignature();
+    pooled->inputNames = std::move(pooled->builder.mInputNames);
+    pooled->outputNames = std::move(pooled->builder.mOutputNames);
+    pooled->signature = std::move(pooled->builder.mSignature);
+    return pooled;
+}
+
+std::unique_ptr<ahiPooledInterpreter>
+ahiInterpreterPool::acquire(const std::string &modelId, const char *buffer, std::size_t bufferSize, uint64_t hash) {
+    {
+        AutoLock lock(mMutex);
+        evictIdleLocked(std::chrono::steady_clock::now());
+        auto iter = mIdle.find(std::make_pair(modelId, hash));
+        if (iter != mIdle.end() && !iter->second.empty()) {
+            std::unique_ptr<ahiPooledInterpreter> pooled = std::move(iter->second.back());
+            iter->second.pop_back();
+            if (iter->second.empty()) {
+                mIdle.erase(iter);
+            }
+            return pooled;
+        }
+    }
+    // Build outside the lock, other models can still be borrowed meanwhile.
+    return build(modelId, buffer, bufferSize, hash);
+}
+
+std::unique_ptr<ahiPooledInterpreter> ahiInterpreterPool::acquire(const std::string &modelId, const char *buffer, std::size_t bufferSize) {
+    return acquire(modelId, buffer, bufferSize, contentHash(buffer, bufferSize));
+}
+
+void ahiInterpreterPool::release(std::unique_ptr<ahiPooledInterpreter> pooled) {
+    if (pooled == nullptr || pooled->builder.mInterpreter == nullptr) {
+        return;
+    }
+    AutoLock lock(mMutex);
+    auto now = std::chrono::steady_clock::now();
+    pooled->lastUsed = now;
+    // A new buffer under the same model id means the model was updated, drop the idle instances of the old one.
+    for (auto iter = mIdle.begin(); iter != mIdle.end();) {
+        if (iter->first.first == pooled->modelId && iter->first.second != pooled->contentHash) {
+            iter = mIdle.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+    mIdle[std::make_pair(pooled->modelId, pooled->contentHash)].push_back(std::move(pooled));
+    evictIdleLocked(now);
+}
+
+int ahiInterpreterPool::warmUp(std::map<std::string, std::pair<char *, std::size_t>> &tfModels) {
+    int nReady = 0;
+    for (auto &model: tfModels) {
+        auto pooled = acquire(model.first, model.second.first, model.second.second);
+        if (pooled == nullptr) {
+            LOG_GUARD(std::cout << "[ahiInterpreterPool::warmUp] unable to build " << model.first << std::endl)
+            continue;
+        }
+        // The first invoke does the lazy delegate/kernel preparation, pay it here rather than on the first scan.
+        if (pooled->builder.mInterpreter->Invoke() != kTfLiteOk) {
+            LOG_GUARD(std::cout << "[ahiInterpreterPool::warmUp] warm up invoke failed for " << model.first << std::endl)
+        }
+        release(std::move(pooled));
+        nReady++;
+    }
+    return nReady;
+}
+
+void ahiInterpreterPool::evictIdleLocked(std::chrono::steady_clock::time_point now) {
+    for (auto iter = mIdle.begin(); iter != mIdle.end();) {
+        auto &instances = iter->second;
+        instances.erase(std::remove_if(instances.begin(), instances.end(),
+                                       [&](const std::unique_ptr<ahiPooledInterpreter> &pooled) {
+                                           return now - pooled->lastUsed > mIdleTimeout;
+                                       }), instances.end());
+        if (instances.empty()) {
+            iter = mIdle.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+    for (auto iter = mModels.begin(); iter != mModels.end();) {
+        if (iter->second.expired()) {
+            iter = mModels.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+}
+
+void ahiInterpreterPool::evictIdle() {
+    AutoLock lock(mMutex);
+    evictIdleLocked(std::chrono::steady_clock::now());
+}
+
+void ahiInterpreterPool::clear() {
+    AutoLock lock(mMutex);
+    mIdle.clear();
+    mModels.clear();
+}
+
+void ahiInterpreterPool::setIdleTimeout(std::chrono::milliseconds timeout) {
+    AutoLock lock(mMutex);
+    mIdleTimeout = timeout;
+}
+
+std::size_t ahiInterpreterPool::idleCount() {
+    AutoLock lock(mMutex);
+    std::size_t count = 0;
+    for (auto &idle: mIdle) {
+        count += idle.second.size();
+    }
+    return count;
+}
@@ -0,0 +1,63 @@
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "ahiModelNoise.hpp"
+#include "ahiInterpreterPool.hpp"
+#include <opencv2/core.hpp>
+
+Mutex gModelNoiseInstanceMutex_;
+ahiModelNoise *ahiModelNoise::mThis = nullptr;
+
+ahiModelNoise *ahiModelNoise::getInstance() {
+    AutoLock lock(gModelNoiseInstanceMutex_);
+
+    if (nullptr == mThis) {
+        mThis = new ahiModelNoise();
+    }
+
+    return mThis;
+}
+
+cv::Mat ahiModelNoise::samples(const std::string &modelName, int numSamples) {
+    uint64_t seed = getSeed() ^ ahiInterpreterPool::contentHash(modelName.data(), modelName.size());
+    return samples(modelName, numSamples, [seed](int n) {
+        cv::RNG rng(seed);
+        std::vector<double> drawn(n);
+        for (int i = 0; i < n; i++) {
+            drawn[i] = rng.gaussian(1.0);
+        }
+        return drawn;
+    });
+}
+
+cv::Mat ahiModelNoise::samples(const std::string &modelName, int numSamples, const std::function<std::vector<double>(int)> &draw) {
+    auto key = std::make_pair(modelName, numSamples);
+    {
+        AutoLock lock(mMutex);
+        auto iter = mSamples.find(key);
+        if (iter != mSamples.end()) {
+            return iter->second;
+        }
+    }
+
+    std::vector<double> drawn = draw(numSamples);
+    cv::Mat drawnMat;
+    cv::Mat(numSamples, 1, CV_64F, drawn.data()).convertTo(drawnMat, CV_32F);
+
+    AutoLock lock(mMutex);
+    // another thread may have drawn the same samples meanwhile, keep the first so every caller feeds the same tensor
+    return mSamples.insert(std::make_pair(key, drawnMat)).first->second;
+}
+
+void ahiModelNoise::setSeed(uint64_t seed) {
+    AutoLock lock(mMutex);
+    mSeed = seed;
+    mSamples.clear();
+}
+
+uint64_t ahiModelNoise::getSeed() {
+    AutoLock lock(mMutex);
+    return mSeed;
+}
@@ -0,0 +1,82 @@
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "ahiPreprocessContext.hpp"
+#include "ahiFactoryTensor.hpp"
+
+ahiPreprocessContext::ahiPreprocessContext(ahiFactoryTensor &tensor, const cv::Mat &frontSilhouette, const cv::Mat &sideSilhouette)
+        : mTensor(tensor) {
+    mSilhouettes[Front] = frontSilhouette;
+    mSilhouettes[Side] = sideSilhouette;
+}
+
+const cv::Mat &ahiPreprocessContext::gray(View view) {
+    cv::Mat &gray = mGray[view];
+    if (gray.empty() && !mSilhouettes[view].empty()) {
+        if (mSilhouettes[view].channels() > 1) {
+            cv::cvtColor(mSilhouettes[view], gray, cv::COLOR_BGR2GRAY);
+        } else {
+            gray = mSilhouettes[view];
+        }
+    }
+    return gray;
+}
+
+cv::Mat ahiPreprocessContext::stdOrRobust(View view, cv::Size targetSize, bool robust, float topPaddingScale, float bottomPaddingScale) {
+    AutoLock lock(mMutex);
+    ViewKey key(view, targetSize.width, targetSize.height, robust, topPaddingScale, bottomPaddingScale);
+    auto cached = mViews.find(key);
+    if (cached != mViews.end()) {
+        return cached->second;
+    }
+    int top, bottom, left, right;
+    // the robust preprocessing works on the gray silhouette, converting it once here spares every variant the conversion
+    cv::Mat prep = mTensor.preprocess_image_std_or_robust(robust ? gray(view) : mSilhouettes[view], targetSize, top, bottom,
+                                                          left, right, robust, topPaddingScale, bottomPaddingScale);
+    mViews[key] = prep;
+    return prep;
+}
+
+cv::Mat ahiPreprocessContext::frontSide(cv::Size targetSize, float frontPaddingScale, float sidePaddingScale) {
+    AutoLock lock(mMutex);
+    FrontSideKey key(targetSize.width, targetSize.height, frontPaddingScale, sidePaddingScale);
+    auto cached = mFrontSides.find(key);
+    if (cached != mFrontSides.end()) {
+        return cached->second;
+    }
+    cv::Mat prepFront = stdOrRobust(Front, targetSize, true, frontPaddingScale, frontPaddingScale);
+    cv::Mat prepSide = stdOrRobust(Side, targetSize, true, sidePaddingScale, sidePaddingScale);
+    cv::Mat merged;
+    if (prepFront.rows == prepSide.rows && prepFront.cols == prepSide.cols) {
+        std::vector<cv::Mat> frontSideMats = {prepFront, prepSide};
+        cv::merge(frontSideMats, merged);
+        merged.convertTo(merged, CV_32F);
+    }
+    mFrontSides[key] = merged;
+    return merged;
+}
+
+cv::Mat ahiPreprocessContext::extraMeasSilhouettes(cv::Size targetSize) {
+    AutoLock lock(mMutex);
+    std::pair<int, int> key(targetSize.width, targetSize.height);
+    auto cached = mExtraMeasSilhouettes.find(key);
+    if (cached != mExtraMeasSilhouettes.end()) {
+        return cached->second;
+    }
+    int top, bottom, left, right;
+    // preprocess_image_for_exmeas thresholds its input in place, so it gets copies of the scan's silhouettes
+    cv::Mat prepFront = mTensor.preprocess_image_for_exmeas(mSilhouettes[Front].clone(), targetSize, top, bottom, left, right);
+    cv::Mat prepSide = mTensor.preprocess_image_for_exmeas(mSilhouettes[Side].clone(), targetSize, top, bottom, left, right);
+    cv::Mat prepFlippedSide;
+    //1 corresponds to mirror image
+    cv::flip(prepSide, prepFlippedSide, 1);
+
+    cv::Mat silhouettes[3] = {prepFront, prepSide, prepFlippedSide};
+    cv::Mat merged;
+    cv::merge(silhouettes, 3, merged);
+    merged.convertTo(merged, CV_32F);
+    mExtraMeasSilhouettes[key] = merged;
+    return merged;
+}
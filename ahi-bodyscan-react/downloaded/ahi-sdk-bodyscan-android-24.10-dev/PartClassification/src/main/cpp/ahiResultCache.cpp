@@ -0,0 +1,104 @@
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "ahiResultCache.hpp"
+#include "ahiInterpreterPool.hpp"
+
+Mutex gResultCacheInstanceMutex_;
+ahiResultCache *ahiResultCache::mThis = nullptr;
+
+ahiResultCache *ahiResultCache::getInstance() {
+    AutoLock lock(gResultCacheInstanceMutex_);
+
+    if (nullptr == mThis) {
+        mThis = new ahiResultCache();
+    }
+
+    return mThis;
+}
+
+static void appendBytes(std::vector<char> &key, const void *data, std::size_t size) {
+    const char *bytes = static_cast<const char *>(data);
+    key.insert(key.end(), bytes, bytes + size);
+}
+
+std::vector<char> ahiResultCache::inputsKey(const ahiTensorInputMap &inputs) {
+    // the map is unordered, so the inputs are laid out in name order
+    std::vector<std::string> names;
+    std::size_t size = 0;
+    for (auto &input: inputs) {
+        names.push_back(input.first);
+        size += input.first.size() + 64 + input.second._mat.total() * input.second._mat.elemSize();
+    }
+    std::sort(names.begin(), names.end());
+
+    std::vector<char> key;
+    key.reserve(size);
+    for (auto &name: names) {
+        const cv::Mat &mat = inputs.at(name)._mat;
+        uint64_t nameSize = name.size();
+        int32_t type = mat.type();
+        int32_t dims = mat.dims;
+        appendBytes(key, &nameSize, sizeof(nameSize));
+        appendBytes(key, name.data(), name.size());
+        appendBytes(key, &type, sizeof(type));
+        appendBytes(key, &dims, sizeof(dims));
+        for (int d = 0; d < mat.dims; d++) {
+            int32_t extent = mat.size[d];
+            appendBytes(key, &extent, sizeof(extent));
+        }
+        if (mat.isContinuous()) {
+            appendBytes(key, mat.data, mat.total() * mat.elemSize());
+        } else {
+            appendBytes(key, mat.clone().data, mat.total() * mat.elemSize());
+        }
+    }
+    return key;
+}
+
+bool ahiResultCache::find(uint64_t modelHash, const std::vector<char> &inputsKey, ahiTensorOutputMap &outputs) {
+    uint64_t inputsHash = ahiInterpreterPool::contentHash(inputsKey.data(), inputsKey.size());
+    AutoLock lock(mMutex);
+    auto iter = mResults.find(std::make_pair(modelHash, inputsHash));
+    // the hash only picks the entry, the inputs it was stored for must match too
+    if (iter == mResults.end() || iter->second.inputs != inputsKey) {
+        return false;
+    }
+    // hand out copies, the callers own their outputs
+    outputs.clear();
+    for (auto &output: iter->second.outputs) {
+        outputs[output.first]._mat = output.second._mat.clone();
+    }
+    return true;
+}
+
+void ahiResultCache::insert(uint64_t modelHash, std::vector<char> inputsKey, const ahiTensorOutputMap &outputs) {
+    uint64_t inputsHash = ahiInterpreterPool::contentHash(inputsKey.data(), inputsKey.size());
+    ahiCachedResult result;
+    result.inputs = std::move(inputsKey);
+    for (auto &output: outputs) {
+        result.outputs[output.first]._mat = output.second._mat.clone();
+    }
+
+    AutoLock lock(mMutex);
+    auto key = std::make_pair(modelHash, inputsHash);
+    auto iter = mResults.find(key);
+    if (iter != mResults.end()) {
+        mBytes -= iter->second.inputs.size();
+        mResults.erase(iter);
+    }
+    if (mResults.size() >= kMaxResults || mBytes + result.inputs.size() > kMaxBytes) {
+        mResults.clear();
+        mBytes = 0;
+    }
+    mBytes += result.inputs.size();
+    mResults[key] = std::move(result);
+}
+
+void ahiResultCache::clear() {
+    AutoLock lock(mMutex);
+    mResults.clear();
+    mBytes = 0;
+}
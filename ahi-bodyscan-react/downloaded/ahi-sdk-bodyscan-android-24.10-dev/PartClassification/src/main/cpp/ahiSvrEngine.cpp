@@ -0,0 +1,308 @@
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "ahiSvrEngine.hpp"
+#include "ahiInterpreterPool.hpp"
+#include <stdexcept>
+#include <limits>
+
+namespace {
+    std::map<std::string, ahiSvrModelView> viewAll(const std::map<std::string, AHIModelSVR> &svrs) {
+        std::map<std::string, ahiSvrModelView> views;
+        for (auto &svr: svrs) {
+            views[svr.first] = ahiSvrBank::view(svr.second);
+        }
+        return views;
+    }
+
+    // The SVR name of the pack viewed in place, false if it is missing or not stored as doubles.
+    bool viewPacked(const AHIBSModelPack &pack, const std::string &name, ahiSvrModelView &view) {
+        AHIBSModelPackView<double> vectors = pack.doubles(name + ".vectors");
+        AHIBSModelPackView<double> coefficients = pack.doubles(name + ".coefficients");
+        AHIBSModelPackView<double> intercepts = pack.doubles(name + ".intercepts");
+        if (vectors.empty() || coefficients.empty() || intercepts.empty()) {
+            return false;
+        }
+        view = ahiSvrModelView();
+        for (uint32_t i = 0; i < vectors.rows; i++) {
+            view.vectors.push_back(vectors.row(i));
+            view.vectorSizes.push_back(vectors.cols);
+        }
+        view.coefficients = coefficients.data;
+        view.numCoefficients = coefficients.size();
+        view.intercepts = intercepts.data;
+        view.numIntercepts = intercepts.size();
+        return true;
+    }
+}
+
+ahiSvrModelView ahiSvrBank::view(const AHIModelSVR &svr) {
+    ahiSvrModelView view;
+    for (auto &vector: svr.vectors) {
+        view.vectors.push_back(vector.data());
+        view.vectorSizes.push_back(vector.size());
+    }
+    view.coefficients = svr.coefficients.data();
+    view.numCoefficients = svr.coefficients.size();
+    view.intercepts = svr.intercepts.data();
+    view.numIntercepts = svr.intercepts.size();
+    return view;
+}
+
+ahiSvrBank::ahiSvrBank(const std::vector<std::string> &names, const std::map<std::string, AHIModelSVR> &svrs, std::size_t nFeatures,
+                       const ahiSvrKernel &kernel) : ahiSvrBank(names, viewAll(svrs), nFeatures, kernel) {
+}
+
+ahiSvrBank::ahiSvrBank(const std::vector<std::string> &names, const std::map<std::string, ahiSvrModelView> &svrs,
+                       std::size_t nFeatures, const ahiSvrKernel &kernel)
+        : mNames(names), mFeatures(nFeatures), mKernel(kernel) {
+    mPresent.assign(names.size(), false);
+    mIntercepts.assign(names.size(), 0.0);
+    mFirstRow.assign(names.size() + 1, 0);
+    const bool isLinear = mKernel.type == 'l';
+    for (std::size_t m = 0; m < names.size(); m++) {
+        mFirstRow[m] = mNumVectors;
+        auto iter = svrs.find(names[m]);
+        if (iter == svrs.end()) {
+            continue;
+        }
+        mPresent[m] = true;
+        if (isLinear) {
+            mNumVectors += iter->second.vectors.empty() ? 0 : 1;
+        } else {
+            mNumVectors += iter->second.vectors.size();
+        }
+        if (iter->second.numIntercepts > 0) {
+            mIntercepts[m] = iter->second.intercepts[0];
+        }
+    }
+    mFirstRow[names.size()] = mNumVectors;
+    mRows = (mNumVectors + kPanelRows - 1) / kPanelRows * kPanelRows;
+
+    std::size_t nValues = std::max<std::size_t>(mRows * mFeatures, 1);
+    void *panels = nullptr;
+    if (posix_memalign(&panels, 64, nValues * sizeof(double)) != 0) {
+        throw std::bad_alloc();
+    }
+    mPanels = (double *) panels;
+    std::fill(mPanels, mPanels + nValues, 0.0);
+    mCoefficients.assign(mRows, 0.0);
+
+    for (std::size_t m = 0; m < names.size(); m++) {
+        if (!mPresent[m]) {
+            continue;
+        }
+        const ahiSvrModelView &svr = svrs.at(names[m]);
+        for (std::size_t i = 0; i < svr.vectors.size(); i++) {
+            std::size_t row = isLinear ? mFirstRow[m] : mFirstRow[m] + i;
+            double *panel = mPanels + (row / kPanelRows) * kPanelRows * mFeatures;
+            std::size_t lane = row % kPanelRows;
+            std::size_t nCopy = std::min(svr.vectorSizes[i], mFeatures);
+            double coefficient = i < svr.numCoefficients ? svr.coefficients[i] : 0.0;
+            if (isLinear) {
+                // sum_i coef_i (v_i . x) = (sum_i coef_i v_i) . x
+                for (std::size_t j = 0; j < nCopy; j++) {
+                    panel[j * kPanelRows + lane] += coefficient * svr.vectors[i][j];
+                }
+                mCoefficients[row] = 1.0;
+            } else {
+                // the rbf kernel scales the squared distance by gamma, not the vectors
+                double scale = mKernel.type == 'r' ? 1.0 : mKernel.gamma;
+                for (std::size_t j = 0; j < nCopy; j++) {
+                    panel[j * kPanelRows + lane] = scale * svr.vectors[i][j];
+                }
+                mCoefficients[row] = coefficient;
+            }
+        }
+    }
+}
+
+ahiSvrBank::~ahiSvrBank() {
+    free(mPanels);
+}
+
+std::vector<double> ahiSvrBank::predict(const double *features, std::size_t size) const {
+    std::vector<double> x(mFeatures, 0.0);
+    if (features != nullptr) {
+        std::copy(features, features + std::min(size, mFeatures), x.begin());
+    }
+
+    // Blocked GEMV, one panel of kPanelRows support vectors at a time.
+    std::vector<double> kernels(mRows, 0.0);
+    for (std::size_t p = 0; p < mRows; p += kPanelRows) {
+        const double *panel = mPanels + p * mFeatures;
+        double acc[kPanelRows] = {0.0};
+        if (mKernel.type == 'r') {
+            for (std::size_t j = 0; j < mFeatures; j++) {
+                for (std::size_t r = 0; r < kPanelRows; r++) {
+                    double d = panel[j * kPanelRows + r] - x[j];
+                    acc[r] += d * d;
+                }
+            }
+        } else {
+            for (std::size_t j = 0; j < mFeatures; j++) {
+                double xj = x[j];
+                for (std::size_t r = 0; r < kPanelRows; r++) {
+                    acc[r] += panel[j * kPanelRows + r] * xj;
+                }
+            }
+        }
+        for (std::size_t r = 0; r < kPanelRows; r++) {
+            kernels[p + r] = acc[r];
+        }
+    }
+
+    switch (mKernel.type) {
+        case 'p':
+            if (mKernel.degree == 2.0) {
+                // pow(t, 2) is exactly t * t, without the libm call per support vector
+                for (std::size_t i = 0; i < mRows; i++) {
+                    double t = kernels[i] + mKernel.coef;
+                    kernels[i] = t * t;
+                }
+            } else {
+                for (std::size_t i = 0; i < mRows; i++) {
+                    kernels[i] = pow(kernels[i] + mKernel.coef, mKernel.degree);
+                }
+            }
+            break;
+        case 'r':
+            for (std::size_t i = 0; i < mRows; i++) {
+                kernels[i] = exp(-mKernel.gamma * kernels[i]);
+            }
+            break;
+        case 's':
+            for (std::size_t i = 0; i < mRows; i++) {
+                kernels[i] = tanh(kernels[i] + mKernel.coef);
+            }
+            break;
+        default:
+            break;
+    }
+
+    std::vector<double> predicted(mNames.size(), std::numeric_limits<double>::quiet_NaN());
+    for (std::size_t m = 0; m < mNames.size(); m++) {
+        if (!mPresent[m]) {
+            continue;
+        }
+        double sum = 0.0;
+        for (std::size_t i = mFirstRow[m]; i < mFirstRow[m + 1]; i++) {
+            sum = sum + kernels[i] * mCoefficients[i];
+        }
+        // a model without support vectors never got its intercept added
+        if (mFirstRow[m + 1] > mFirstRow[m]) {
+            sum = sum + mIntercepts[m];
+        }
+        predicted[m] = sum;
+    }
+    return predicted;
+}
+
+std::vector<double> ahiSvrBank::predict(const std::vector<double> &features) const {
+    return predict(features.data(), features.size());
+}
+
+double ahiSvrBank::result(const std::vector<double> &predicted, const std::string &name) const {
+    for (std::size_t m = 0; m < mNames.size(); m++) {
+        if (mNames[m] == name) {
+            if (!mPresent[m] || m >= predicted.size()) {
+                break;
+            }
+            return predicted[m];
+        }
+    }
+    throw std::out_of_range("svr model not loaded: " + name);
+}
+
+Mutex gSvrEngineInstanceMutex_;
+ahiSvrEngine *ahiSvrEngine::mThis = nullptr;
+
+ahiSvrEngine *ahiSvrEngine::getInstance() {
+    AutoLock lock(gSvrEngineInstanceMutex_);
+
+    if (nullptr == mThis) {
+        mThis = new ahiSvrEngine();
+    }
+
+    return mThis;
+}
+
+std::shared_ptr<const ahiSvrBank> ahiSvrEngine::bank(const std::vector<std::string> &names,
+                                                     std::map<std::string, std::pair<char *, std::size_t>> &svrModels,
+                                                     std::size_t nFeatures, const ahiSvrKernel &kernel) {
+    std::shared_ptr<const AHIBSModelPack> pack;
+    {
+        AutoLock lock(mMutex);
+        pack = mPack;
+    }
+    std::stringstream key;
+    key << kernel.type << "/" << kernel.gamma << "/" << kernel.coef << "/" << kernel.degree << "/" << nFeatures;
+    for (auto &name: names) {
+        key << ";" << name << "#";
+        const AHIBSModelPackEntry *vectors = pack != nullptr ? pack->find(name + ".vectors") : nullptr;
+        const AHIBSModelPackEntry *coefficients = pack != nullptr ? pack->find(name + ".coefficients") : nullptr;
+        const AHIBSModelPackEntry *intercepts = pack != nullptr ? pack->find(name + ".intercepts") : nullptr;
+        if (vectors != nullptr && coefficients != nullptr && intercepts != nullptr) {
+            key << "p" << std::hex << vectors->checksum << "." << coefficients->checksum << "." << intercepts->checksum
+                << std::dec;
+            continue;
+        }
+        auto iter = svrModels.find(name);
+        if (iter != svrModels.end()) {
+            key << std::hex << ahiInterpreterPool::contentHash(iter->second.first, iter->second.second) << std::dec;
+        }
+    }
+
+    {
+        AutoLock lock(mMutex);
+        auto iter = mBanks.find(key.str());
+        if (iter != mBanks.end()) {
+            return iter->second;
+        }
+    }
+
+    // Decode and pack outside the lock, the other banks can still be used meanwhile. The models of the pack are read in
+    // place, only the ones stored as float16 are converted.
+    std::map<std::string, AHIModelSVR> decodedSVRs;
+    std::map<std::string, ahiSvrModelView> views;
+    for (auto &name: names) {
+        if (pack != nullptr) {
+            if (viewPacked(*pack, name, views[name])) {
+                continue;
+            }
+            views.erase(name);
+            if (ahiModelPackDecodeSvr(*pack, name, decodedSVRs[name])) {
+                continue;
+            }
+            decodedSVRs.erase(name);
+        }
+        auto iter = svrModels.find(name);
+        if (iter == svrModels.end() || iter->second.first == nullptr) {
+            continue;
+        }
+        decodedSVRs[name] = ahiDecodeSvrFromBytes(iter->second.first, iter->second.second);
+    }
+    for (auto &svr: decodedSVRs) {
+        views[svr.first] = ahiSvrBank::view(svr.second);
+    }
+    std::shared_ptr<const ahiSvrBank> compiled = std::make_shared<ahiSvrBank>(names, views, nFeatures, kernel);
+
+    AutoLock lock(mMutex);
+    if (mBanks.size() >= kMaxBanks) {
+        mBanks.clear();
+    }
+    mBanks[key.str()] = compiled;
+    return compiled;
+}
+
+void ahiSvrEngine::usePack(std::shared_ptr<const AHIBSModelPack> pack) {
+    AutoLock lock(mMutex);
+    mPack = std::move(pack);
+}
+
+void ahiSvrEngine::clear() {
+    AutoLock lock(mMutex);
+    mBanks.clear();
+}
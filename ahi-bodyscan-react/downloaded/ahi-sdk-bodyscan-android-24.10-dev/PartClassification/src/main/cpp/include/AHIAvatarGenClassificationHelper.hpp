@@ -32,6 +32,20 @@ namespace ahi_avatar_gen {
                                                       std::map<std::string, cv::Point2f> const &front_joints_vector,
                                                       std::map<std::string, cv::Point2f> const &side_joints_vector);
 
+        // CV_64F integral image of the first channel, for the disc sums.
+        static cv::Mat silhouette_integral(cv::Mat const &silhouette);
+
+        // Half width of every row of the disc cv::circle fills for radius, indexed by the row's distance to the center.
+        static std::vector<int> filled_circle_half_widths(int radius);
+
+        // Sum of the silhouette under the disc cv::circle(center, radius, -1) would draw, as the sum of the silhouette
+        // ANDed with that disc's mask, read off the integral one disc row at a time. Exact, the sums are integers.
+        static double disc_sum(cv::Mat const &integral, cv::Point center, int radius);
+
+    public:
+        classification_helper(void);
+
+        // Features of the v2/v3 SVRs and of the DL models, out of gray silhouettes.
         std::vector<double>
         extract_image_features(double height,
                                double weight,
@@ -41,24 +55,6 @@ namespace ahi_avatar_gen {
                                std::map<std::string, cv::Point2f> const &front_joints_vector,
                                std::map<std::string, cv::Point2f> const &side_joints_vector);
 
-        double svr_image_features_predictor_predict(std::map<std::string, AHIModelSVR> &svrModels, double features[], std::string param);
-
-        double male_svr_image_features_predictor_predict(std::map<std::string, AHIModelSVR> &svrModels, double features[], std::string param);
-
-        double
-        female_svr_image_features_predictor_predict(std::map<std::string, AHIModelSVR> &svrModels, double features[], const std::string &param);
-
-        double male_svr_image_features_predictor_v2_predict(std::map<std::string, AHIModelSVR> &svrModels, double features[], std::string param);
-
-        double female_svr_image_features_predictor_v2_predict(std::map<std::string, AHIModelSVR> &svrModels, double features[], std::string param);
-
-        double male_svr_image_features_predictor_v3_predict(std::map<std::string, AHIModelSVR> &svrModels, double features[], std::string param);
-
-        double female_svr_image_features_predictor_v3_predict(std::map<std::string, AHIModelSVR> &svrModels, double features[], std::string param);
-
-    public:
-        classification_helper(void);
-
         std::vector<double> classify(double height,
                                      double weight,
                                      const std::string &gender,
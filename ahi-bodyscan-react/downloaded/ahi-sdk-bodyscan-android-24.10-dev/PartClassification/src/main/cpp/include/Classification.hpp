@@ -37,9 +37,16 @@ public:
                                        std::map<std::string, std::pair<char *, std::size_t>> &svrModels,
                                        bool useAverage);
 
+    static int warmUp(std::map<std::string, std::pair<char *, std::size_t>> &tfModels);
+
+    static bool setDelegateCacheFile(const std::string &path, bool benchmarkCpu);
+
     static vector<std::string> getTfLiteModelNames();
 
     static vector<std::string> getSvrModelNames();
+
+    // The keys of the classification results, in the stable order the results are handed out as an array.
+    static vector<std::string> getResultKeys();
 };
 
 #endif //BODYSCAN_CLASSIFICATION_HPP
@@ -0,0 +1,41 @@
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef ahiClassifyGraph_H_
+#define ahiClassifyGraph_H_
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/**
+ * Dependency graph of the classification models of one scan. A node is handed to a worker once every node it depends
+ * on has run; ready nodes go out in the order they were added, so with a single worker the models run in the order of
+ * the model maps, as they did before the graph.
+ */
+class ahiClassifyGraph {
+public:
+    // Adds the node of modelId, run after the nodes already added for the model ids of dependsOn. Returns its index.
+    std::size_t addNode(int modelId, const std::vector<int> &dependsOn);
+
+    std::size_t size() const;
+
+    int modelId(std::size_t node) const;
+
+    // Calls run(node, worker) once per node, on numWorkers workers (the calling thread is worker 0). The first exception
+    // thrown by a node stops the hand out of new nodes and is rethrown once every worker is done.
+    void run(std::size_t numWorkers, const std::function<void(std::size_t, std::size_t)> &run);
+
+private:
+    struct Node {
+        int modelId;
+        std::vector<std::size_t> dependents;
+        std::size_t numDependencies = 0;
+    };
+
+    std::vector<Node> mNodes;
+};
+
+#endif
@@ -0,0 +1,66 @@
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef ahiDelegateCache_H_
+#define ahiDelegateCache_H_
+
+#include "Types.hpp"
+#include "Mutex.hpp"
+#include "AutoLock.hpp"
+
+// Which way of running a model won on this device. delegate is one of the ahiFactoryTensor::InferenceMethod names
+// ("gpu_delegate", "nnapi_delegate", "xnn_delegate", "cpu").
+typedef struct ahiDelegateDecision {
+    std::string delegate;
+    int numThreads = 2;
+    double firstInvokeMs = -1;  // first invoke after the build, includes the lazy delegate preparation
+    double invokeMs = -1;       // steady state invoke, only measured in benchmark mode
+} ahiDelegateDecision;
+
+/**
+ * Per model, per device record of the delegate/thread configuration buildOptimalInterpreter settled on, so later
+ * builds (and later process starts, once a cache file is set) skip the probes that failed or lost.
+ * File format is one tab separated line per decision: device, model, delegate, threads, first invoke ms, invoke ms.
+ */
+class ahiDelegateCache {
+public:
+    static ahiDelegateCache *getInstance();
+
+    static std::string deviceKey();
+
+    bool lookup(const std::string &modelKey, ahiDelegateDecision &decision);
+
+    void record(const std::string &modelKey, const ahiDelegateDecision &decision);
+
+    void forget(const std::string &modelKey);
+
+    // Loads the decisions already in the file (if any) and persists every new decision to it. Empty path keeps it in memory only.
+    // False only if the file can neither be read nor created.
+    bool setCacheFile(const std::string &path);
+
+    // When on, the CPU configuration (XNNPack or builtin kernels, 1/2/4 threads) is picked by timing each one.
+    void setBenchmarkMode(bool benchmark);
+
+    bool isBenchmarkMode();
+
+    void clear();
+
+private:
+    ahiDelegateCache();
+
+    static ahiDelegateCache *mThis;
+
+    bool loadLocked();
+
+    bool saveLocked();
+
+    Mutex mMutex;
+    std::string mDeviceKey;
+    std::string mCacheFile;
+    bool mBenchmarkMode;
+    std::map<std::pair<std::string, std::string>, ahiDelegateDecision> mDecisions;
+};
+
+#endif
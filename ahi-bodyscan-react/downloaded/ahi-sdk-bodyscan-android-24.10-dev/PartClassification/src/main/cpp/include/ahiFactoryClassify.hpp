@@ -14,9 +14,28 @@
 #include "AssetManager.hpp"
 #include "ahiModelsZoo.hpp"
 #include "ahiFactoryTensor.hpp"
+#include "ahiInterpreterPool.hpp"
+#include "ahiPreprocessContext.hpp"
 #include "AHIAvatarGenClassificationHelper.hpp"
 #include "log2022.h"
 
+// Workers running the classification models of a scan, 0 for one per two cores (an interpreter runs on two threads).
+#ifndef AHI_CLASSIFY_WORKERS
+#define AHI_CLASSIFY_WORKERS 0
+#endif
+
+// Outputs of one classification model, read off its interpreter before the interpreter goes back to the pool.
+typedef struct ahiClassModelRun {
+    bool isInvoked = false;
+    // the model's silhouettes could not be prepared, which fails the classification
+    bool isFailed = false;
+    bool isShape = true;
+    std::string extraModelSite;
+    int numOutputs = 0;
+    // the outputs of up to 80 values, the longer ones are not measurements
+    std::vector<std::pair<std::string, std::vector<float>>> outputs;
+} ahiClassModelRun;
+
 typedef struct {
     std::string classErrMsg;
     std::map<std::string, float> classificationResultsCurrent;
@@ -44,6 +63,12 @@ public:
     const std::string AHI_GEN_ANDROID = "ml_gen_android";
     const std::string AHI_GEN_VAT = "ml_gen_vat";
 
+    // The keys above in a fixed order, the one of the results array handed to the Kotlin layer.
+    std::vector<std::string> getResultKeys() const {
+        return {AHI_RAW_CHEST, AHI_RAW_WAIST, AHI_RAW_HIPS, AHI_RAW_THIGH, AHI_RAW_INSEAM, AHI_RAW_WEIGHTPRED,
+                AHI_RAW_BODYFAT, AHI_GEN_FITNESS, AHI_GEN_FFM, AHI_GEN_GYNOID, AHI_GEN_ANDROID, AHI_GEN_VAT};
+    }
+
     std::string modelFileName;
     ahiModelsZoo modelsZoo;
     uint8_t mKeydata[32];
@@ -61,7 +86,10 @@ public:
 
     std::string to_lowerStr(std::string str);
 
-    std::map<std::string, std::unique_ptr<tflite::Interpreter>> loadAllTfModels(std::map<std::string, std::pair<char *, std::size_t>> &tfModels);
+    // content hash of every tf model buffer of the current classify call, so the pool key is hashed once per call and not per image pair
+    std::map<std::string, uint64_t> mTfModelHashes;
+
+    void hashTfModels(std::map<std::string, std::pair<char *, std::size_t>> &tfModels);
 
     bool prepareTensorFlowClassifyModel(std::unique_ptr<tflite::Interpreter> loadedTfModel, std::string &classModelFileName);
 
@@ -69,6 +97,21 @@ public:
 
     ahi_avatar_gen::classification_helper classification_helper;
 
+    int classifyWorkers = AHI_CLASSIFY_WORKERS;
+
+    // Runs the model on tensor, with an interpreter borrowed from the pool. Thread safe for distinct tensors.
+    void runClassModel(ahiFactoryTensor &tensor,
+                       ahiPreprocessContext &views,
+                       int classModelId,
+                       const std::string &currModelFileName,
+                       const std::pair<char *, std::size_t> &tfModel,
+                       uint64_t tfModelHash,
+                       double height,
+                       double weight,
+                       const std::string &gender,
+                       std::vector<double> &imageFeatureVector,
+                       ahiClassModelRun &run);
+
     bool ahiSVRClassification(double height, double weight, std::string gender,
                               cv::Mat const frontSilhouette,
                               cv::Mat const sideSilhouette,
@@ -80,6 +123,7 @@ public:
                               std::map<std::string, std::pair<char *, std::size_t>> &svrModels,
                               std::vector<std::pair<std::string, std::vector<float>>> &classResultsRawPairs);
 
+    // The models run concurrently on classifyWorkers workers, their outputs are merged in the order of the model maps.
     bool ahiDLClassification(double height,
                              double weight,
                              const std::string &gender,
@@ -87,7 +131,7 @@ public:
                              cv::Mat const &sideSilhouette,
                              std::vector<double> imageFeatureVector,
                              const std::string &modelScanType,
-                             std::map<std::string, std::unique_ptr<tflite::Interpreter>> &loadedTfModels,
+                             std::map<std::string, std::pair<char *, std::size_t>> &tfModels,
                              std::vector<std::pair<std::string, std::vector<float>>> &classResultsRawPairs);
 
     ahiClassifyInfo getClassifyOutInfo(double height,
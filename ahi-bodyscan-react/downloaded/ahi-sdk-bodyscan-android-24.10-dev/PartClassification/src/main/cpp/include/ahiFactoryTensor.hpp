@@ -57,6 +57,7 @@
 #include <iostream>
 #include <inttypes.h>
 #include "chacha20.hpp"
+#include "ahiDelegateCache.hpp"
 #include <sys/ptrace.h>
 #include <random>
 
@@ -143,8 +144,19 @@ typedef struct ahiTensorOutput {
 typedef std::unordered_map<std::string, ahiTensorInput> ahiTensorInputMap;
 typedef std::unordered_map<std::string, ahiTensorOutput> ahiTensorOutputMap;
 
+// Tensors of an interpreter resolved once: the input positions by name and the CV depth of every input and output
+// (< 0 when OpenCV has none matching the TFLite type).
+typedef struct ahiTensorSignature {
+    const tflite::Interpreter *interpreter = nullptr;
+    std::unordered_map<std::string, int> inputPositions;
+    std::vector<int> inputDepths;
+    std::vector<int> outputDepths;
+} ahiTensorSignature;
+
 //typedef std::map<int, int> openCV_TfLiteTypes_EQ;
 
+class ahiPreprocessContext;
+
 class ahiFactoryTensor {
 public:
     static ahiFactoryTensor *mThis;
@@ -202,7 +214,8 @@ public:
 
     std::vector<double> generateUniformMLSamples(int numSamples);
 
-    bool prepareInputsForImageBasedExtraMeas(cv::Mat front_silhoutte, cv::Mat side_silhoutte, double height, double weight, std::string gender,
+    // The silhouettes input comes from the scan's preprocessed views.
+    bool prepareInputsForImageBasedExtraMeas(ahiPreprocessContext &views, double height, double weight, std::string gender,
                                              cv::Mat &inputImageFeat,
                                              cv::Mat &inputHWGFeat,
                                              cv::Mat &inputNormalDist);
@@ -220,6 +233,9 @@ public:
 
     bool buildOptimalInterpreter();
 
+    // key of this model in the delegate cache (model id plus content hash when built by the pool), modelFileName if empty
+    std::string mDelegateCacheKey;
+
     void resetInterpreter();
 
     void setNumThreads(int num);
@@ -254,6 +270,8 @@ public:
 
     TfLiteDelegate *mDelegate;
     std::unique_ptr<tflite::FlatBufferModel> mModel;
+    // Used instead of mModel when the interpreters of several tensors are built from one loaded model.
+    std::shared_ptr<const tflite::FlatBufferModel> mSharedModel;
     std::unique_ptr<tflite::Interpreter> mInterpreter;
     tflite::ops::builtin::BuiltinOpResolver mResolver;
 
@@ -272,8 +290,18 @@ public:
 
     std::vector<int> getOutputDim(int);
 
+    // The outputs are headers over the output tensors, valid until the next invoke of the interpreter.
     bool invokeMIMO(ahiTensorInputMap &inputs, ahiTensorOutputMap &outputs);
 
+    // Resolves the signature of mInterpreter, once per interpreter.
+    bool prepareSignature();
+
+    // Header over the memory of input tensor position, an H x W x C image input as an H x W mat of C channels. An
+    // input preprocessed into it is not copied again by invokeMIMO.
+    cv::Mat inputView(int position);
+
+    ahiTensorSignature mSignature;
+
 #if 0
 
     void releaseDelegate();
@@ -353,6 +381,16 @@ private:
     int num_thread_ = 2;
     BUILD_TYPE build_type_ = kCPU;
 
+    static std::string buildTypeName(BUILD_TYPE type);
+
+    static bool buildTypeFromName(const std::string &name, BUILD_TYPE &type);
+
+    bool buildInterpreterWith(BUILD_TYPE type, int numThreads);
+
+    double timeInvokeMs();
+
+    bool benchmarkCpuConfigs(ahiDelegateDecision &best);
+
     bool decode(unsigned char *, size_t);
 
     bool decodeSvr(unsigned char *, size_t);
@@ -0,0 +1,86 @@
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef ahiInterpreterPool_H_
+#define ahiInterpreterPool_H_
+
+#include "Types.hpp"
+#include "Mutex.hpp"
+#include "AutoLock.hpp"
+#include "ahiFactoryTensor.hpp"
+
+// The pool's own copy of a model's bytes and the FlatBufferModel over them, shared read only by every interpreter
+// built for the model.
+typedef struct ahiPooledModel {
+    std::vector<char> bytes;
+    std::unique_ptr<tflite::FlatBufferModel> model;
+} ahiPooledModel;
+
+// A built interpreter plus everything it depends on: the factory holds the shared model (builder.mSharedModel) and
+// owns the delegate the interpreter was built with, both must outlive it. The input/output names and the signature
+// are read once when the interpreter is built and travel with it, the borrower moves them in and back out.
+typedef struct ahiPooledInterpreter {
+    std::string modelId;
+    uint64_t contentHash = 0;
+    ahiFactoryTensor builder;
+    std::vector<std::string> inputNames;
+    std::vector<std::string> outputNames;
+    ahiTensorSignature signature;
+    std::chrono::steady_clock::time_point lastUsed;
+} ahiPooledInterpreter;
+
+typedef std::pair<std::string, uint64_t> ahiInterpreterPoolKey;
+
+/**
+ * Process wide, thread safe pool of TFLite interpreters keyed by model id and the content hash of the model buffer.
+ * An interpreter is borrowed with acquire() and handed back with release(); while borrowed it is owned exclusively by
+ * the caller, so concurrent callers asking for the same model get separate instances.
+ */
+class ahiInterpreterPool {
+public:
+    static ahiInterpreterPool *getInstance();
+
+    // Hash of all the bytes of the buffer. The pool, the result cache and the SVR banks key models on it, so a buffer
+    // rewritten in place gets a new key.
+    static uint64_t contentHash(const char *buffer, std::size_t bufferSize);
+
+    // Returns an idle interpreter for (modelId, hash), building one if none is idle. nullptr if the model fails to build.
+    std::unique_ptr<ahiPooledInterpreter> acquire(const std::string &modelId, const char *buffer, std::size_t bufferSize, uint64_t hash);
+
+    std::unique_ptr<ahiPooledInterpreter> acquire(const std::string &modelId, const char *buffer, std::size_t bufferSize);
+
+    void release(std::unique_ptr<ahiPooledInterpreter> pooled);
+
+    // Builds (and invokes once) an interpreter for every model so the first scan does not pay for it. Returns the number of ready models.
+    int warmUp(std::map<std::string, std::pair<char *, std::size_t>> &tfModels);
+
+    void evictIdle();
+
+    void clear();
+
+    void setIdleTimeout(std::chrono::milliseconds timeout);
+
+    std::size_t idleCount();
+
+private:
+    ahiInterpreterPool() = default;
+
+    static ahiInterpreterPool *mThis;
+
+    std::unique_ptr<ahiPooledInterpreter> build(const std::string &modelId, const char *buffer, std::size_t bufferSize, uint64_t hash);
+
+    // The loaded model of (modelId, hash), loaded from buffer if no interpreter holds it anymore.
+    std::shared_ptr<const tflite::FlatBufferModel> sharedModel(const ahiInterpreterPoolKey &key, const char *buffer, std::size_t bufferSize);
+
+    void evictIdleLocked(std::chrono::steady_clock::time_point now);
+
+    Mutex mMutex;
+    std::chrono::milliseconds mIdleTimeout{std::chrono::minutes(5)};
+    std::map<ahiInterpreterPoolKey, std::vector<std::unique_ptr<ahiPooledInterpreter>>> mIdle;
+    // alive as long as an idle or borrowed interpreter holds them
+    std::map<ahiInterpreterPoolKey, std::weak_ptr<const tflite::FlatBufferModel>> mModels;
+};
+
+#endif
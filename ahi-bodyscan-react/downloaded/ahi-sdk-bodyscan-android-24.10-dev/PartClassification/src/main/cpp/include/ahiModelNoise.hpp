@@ -0,0 +1,50 @@
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef ahiModelNoise_H_
+#define ahiModelNoise_H_
+
+#include "Types.hpp"
+#include "Mutex.hpp"
+#include "AutoLock.hpp"
+#include <functional>
+#include <opencv2/core/mat.hpp>
+
+// Seed of the noise inputs of the generative models (input_randnorm of the feature based extra measurement models).
+#ifndef AHI_ML_NOISE_SEED
+#define AHI_ML_NOISE_SEED 0x61686953ULL
+#endif
+
+/**
+ * Process wide store of the noise inputs of the models. A model's noise is drawn once, on first use, and then fed as a
+ * constant tensor, so a scan classifies the same way on every run and the results can be cached.
+ * The samples are shared: callers read them and must not write to them.
+ */
+class ahiModelNoise {
+public:
+    static ahiModelNoise *getInstance();
+
+    // numSamples x 1 CV_32F standard normal samples, drawn from the seed combined with the model name.
+    cv::Mat samples(const std::string &modelName, int numSamples);
+
+    // numSamples x 1 CV_32F samples produced by draw, for the models trained against a specific draw.
+    cv::Mat samples(const std::string &modelName, int numSamples, const std::function<std::vector<double>(int)> &draw);
+
+    // Drops the samples drawn so far, the next ones come from the new seed.
+    void setSeed(uint64_t seed);
+
+    uint64_t getSeed();
+
+private:
+    ahiModelNoise() = default;
+
+    static ahiModelNoise *mThis;
+
+    Mutex mMutex;
+    uint64_t mSeed = AHI_ML_NOISE_SEED;
+    std::map<std::pair<std::string, int>, cv::Mat> mSamples;
+};
+
+#endif
@@ -317,6 +317,11 @@ public:
             {std::make_pair(ModelClassTBFIM1, "classTBFIM1Model"), ahiModelGender::Either}
     };
 
+    // Classification models fed the outputs of other models, mapped to those models. The classification graph runs a
+    // model after the ones it is listed with and every other model concurrently. All the current models read only the
+    // silhouettes and the image features.
+    std::map<ahiModelsZooModelId, std::vector<ahiModelsZooModelId>> ahiClassModelDependencies = {};
+
 
     uint8_t mKeydata[32];
     uint8_t mNoncedata[12];
@@ -0,0 +1,57 @@
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef ahiPreprocessContext_H_
+#define ahiPreprocessContext_H_
+
+#include <map>
+#include <tuple>
+#include <opencv2/core/mat.hpp>
+#include "Mutex.hpp"
+#include "AutoLock.hpp"
+
+class ahiFactoryTensor;
+
+/**
+ * Preprocessed silhouettes of one scan, shared by the input builders of the classification models. Each variant
+ * (view, target size, robust or standard, padding scales) is computed on first use and then handed to every model
+ * asking for it, so the models fed the same preprocessing do not redo it.
+ * The returned mats are shared: callers read them and must not write to them. The models of a scan run concurrently,
+ * a variant is computed under the lock so the models asking for it together wait for the one preprocessing.
+ */
+class ahiPreprocessContext {
+public:
+    enum View {
+        Front = 0,
+        Side = 1
+    };
+
+    ahiPreprocessContext(ahiFactoryTensor &tensor, const cv::Mat &frontSilhouette, const cv::Mat &sideSilhouette);
+
+    // preprocess_image_std_or_robust of the view.
+    cv::Mat stdOrRobust(View view, cv::Size targetSize, bool robust, float topPaddingScale, float bottomPaddingScale);
+
+    // The robust front and side views merged into a 2 channel CV_32F, empty when they differ in size.
+    cv::Mat frontSide(cv::Size targetSize, float frontPaddingScale, float sidePaddingScale);
+
+    // preprocess_image_for_exmeas of the front, the side and the mirrored side merged into a 3 channel CV_32F.
+    cv::Mat extraMeasSilhouettes(cv::Size targetSize);
+
+private:
+    const cv::Mat &gray(View view);
+
+    typedef std::tuple<int, int, int, bool, float, float> ViewKey;
+    typedef std::tuple<int, int, float, float> FrontSideKey;
+
+    Mutex mMutex;
+    ahiFactoryTensor &mTensor;
+    cv::Mat mSilhouettes[2];
+    cv::Mat mGray[2];
+    std::map<ViewKey, cv::Mat> mViews;
+    std::map<FrontSideKey, cv::Mat> mFrontSides;
+    std::map<std::pair<int, int>, cv::Mat> mExtraMeasSilhouettes;
+};
+
+#endif
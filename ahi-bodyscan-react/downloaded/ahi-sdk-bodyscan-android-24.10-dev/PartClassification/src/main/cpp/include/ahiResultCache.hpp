@@ -0,0 +1,54 @@
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef ahiResultCache_H_
+#define ahiResultCache_H_
+
+#include "Types.hpp"
+#include "Mutex.hpp"
+#include "AutoLock.hpp"
+#include "ahiFactoryTensor.hpp"
+
+typedef struct ahiCachedResult {
+    std::vector<char> inputs; // inputsKey of the inputs the outputs were computed from
+    ahiTensorOutputMap outputs;
+} ahiCachedResult;
+
+/**
+ * Process wide cache of model outputs, keyed by the content hash of the model and a hash of the input tensors; a hit
+ * also compares the inputs themselves. With the noise inputs fixed (see ahiModelNoise) a model maps equal inputs to
+ * equal outputs, so a scan classified again, e.g. when the results are averaged or re-requested, is served without
+ * invoking the models.
+ */
+class ahiResultCache {
+public:
+    static ahiResultCache *getInstance();
+
+    // The names, types, shapes and data of the inputs as invokeMIMO feeds them, in name order: what find compares.
+    static std::vector<char> inputsKey(const ahiTensorInputMap &inputs);
+
+    bool find(uint64_t modelHash, const std::vector<char> &inputsKey, ahiTensorOutputMap &outputs);
+
+    // Keeps the inputs key and copies of the outputs.
+    void insert(uint64_t modelHash, std::vector<char> inputsKey, const ahiTensorOutputMap &outputs);
+
+    void clear();
+
+private:
+    ahiResultCache() = default;
+
+    static ahiResultCache *mThis;
+
+    // The cached outputs are a few floats per model, the stored inputs up to two 256 x 256 float silhouettes. The
+    // bounds only matter for long lived processes.
+    static const std::size_t kMaxResults = 256;
+    static const std::size_t kMaxBytes = 32 * 1024 * 1024;
+
+    Mutex mMutex;
+    std::map<std::pair<uint64_t, uint64_t>, ahiCachedResult> mResults;
+    std::size_t mBytes = 0; // of the stored inputs
+};
+
+#endif
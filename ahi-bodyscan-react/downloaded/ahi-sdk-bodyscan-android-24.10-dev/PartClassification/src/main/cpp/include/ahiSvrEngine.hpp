@@ -0,0 +1,120 @@
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef ahiSvrEngine_H_
+#define ahiSvrEngine_H_
+
+#include "Types.hpp"
+#include "Mutex.hpp"
+#include "AutoLock.hpp"
+#include <AHIBSCereal.hpp>
+#include <AHIBSModelPack.hpp>
+
+// Kernel the SVRs were trained with, same meaning as KERNEL_TYPE/GAMMA/COEF/DEGREE of classification_helper.
+typedef struct ahiSvrKernel {
+    char type = 'p'; // 'l' linear, 'p' polynomial, 'r' rbf, 's' sigmoid
+    double gamma = 1.0;
+    double coef = 1.0;
+    double degree = 2.0;
+} ahiSvrKernel;
+
+// One SVR as a bank reads it, wherever its values live: the support vectors (one pointer and length per vector), the
+// dual coefficients and the intercepts.
+typedef struct ahiSvrModelView {
+    std::vector<const double *> vectors;
+    std::vector<std::size_t> vectorSizes;
+    const double *coefficients = nullptr;
+    std::size_t numCoefficients = 0;
+    const double *intercepts = nullptr;
+    std::size_t numIntercepts = 0;
+} ahiSvrModelView;
+
+/**
+ * A set of SVRs decoded once and packed to be evaluated against one shared feature vector in a single pass.
+ * The support vectors of all models are stacked into one aligned matrix, stored in panels of kPanelRows rows with the
+ * panel's rows interleaved per feature, so the GEMV runs kPanelRows dot products in SIMD lanes while every dot product
+ * still accumulates its features in order (a plain row-major matrix only vectorizes by reordering each sum).
+ * The kernel's gamma is folded into the packed vectors. With the linear kernel the dual coefficients are too, and each
+ * model packs down to the one row of its weights; the other kernels apply the coefficients after their non-linearity,
+ * from one array aligned with the rows.
+ */
+class ahiSvrBank {
+public:
+    static const std::size_t kPanelRows = 4;
+
+    // Models missing from svrs are kept as absent, result() throws for them like the std::map lookup it replaces.
+    // The values are copied into the panels, svrs need not outlive the bank.
+    ahiSvrBank(const std::vector<std::string> &names, const std::map<std::string, ahiSvrModelView> &svrs,
+               std::size_t nFeatures, const ahiSvrKernel &kernel);
+
+    ahiSvrBank(const std::vector<std::string> &names, const std::map<std::string, AHIModelSVR> &svrs, std::size_t nFeatures,
+               const ahiSvrKernel &kernel);
+
+    static ahiSvrModelView view(const AHIModelSVR &svr);
+
+    ~ahiSvrBank();
+
+    ahiSvrBank(const ahiSvrBank &) = delete;
+
+    ahiSvrBank &operator=(const ahiSvrBank &) = delete;
+
+    // One prediction per model, in the order of the names. Features beyond size (or a nullptr) read as 0.
+    std::vector<double> predict(const double *features, std::size_t size) const;
+
+    std::vector<double> predict(const std::vector<double> &features) const;
+
+    // Prediction of the named model out of predict()'s output. Throws std::out_of_range if the model is not in the bank.
+    double result(const std::vector<double> &predicted, const std::string &name) const;
+
+    std::size_t numModels() const { return mNames.size(); }
+
+    std::size_t numVectors() const { return mNumVectors; }
+
+private:
+    std::vector<std::string> mNames;
+    std::vector<bool> mPresent;
+    std::vector<std::size_t> mFirstRow;   // first row of each model, numModels() + 1 entries
+    std::vector<double> mIntercepts;
+    std::vector<double> mCoefficients;    // one per row, 0 for the padding rows of the last panel, 1 for the linear kernel
+    std::size_t mNumVectors = 0;
+    std::size_t mRows = 0;                // mNumVectors rounded up to kPanelRows
+    std::size_t mFeatures = 0;
+    double *mPanels = nullptr;            // mRows x mFeatures
+    ahiSvrKernel mKernel;
+};
+
+/**
+ * Process wide cache of compiled SVR banks. A bank is keyed by its model names and the content hash of their bytes
+ * (the blob checksums for the models of a pack), so the SVRs are decoded and packed once per process rather than once
+ * per scan.
+ */
+class ahiSvrEngine {
+public:
+    static ahiSvrEngine *getInstance();
+
+    std::shared_ptr<const ahiSvrBank> bank(const std::vector<std::string> &names,
+                                           std::map<std::string, std::pair<char *, std::size_t>> &svrModels,
+                                           std::size_t nFeatures, const ahiSvrKernel &kernel);
+
+    // The models of the pack (name.vectors, name.coefficients, name.intercepts) are read from it in place by bank(),
+    // the cereal ones it is handed only for the models missing from the pack. nullptr drops the pack.
+    void usePack(std::shared_ptr<const AHIBSModelPack> pack);
+
+    void clear();
+
+private:
+    ahiSvrEngine() = default;
+
+    static ahiSvrEngine *mThis;
+
+    // Bounds the cache when model packs keep being swapped, a scan only needs a handful of banks.
+    static const std::size_t kMaxBanks = 16;
+
+    Mutex mMutex;
+    std::map<std::string, std::shared_ptr<const ahiSvrBank>> mBanks;
+    std::shared_ptr<const AHIBSModelPack> mPack;
+};
+
+#endif
@@ -10,6 +10,7 @@ import com.advancedhumanimaging.sdk.bodyscan.common.interfaces.IResources
 import com.advancedhumanimaging.sdk.common.models.AHILogLevel
 import com.advancedhumanimaging.sdk.common.models.AHILogging
 import com.advancedhumanimaging.sdk.common.models.AHIResult
+import java.io.File
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.withContext
 
@@ -68,29 +69,52 @@ class Classification : IClassification {
                         return@withContext AHIResult.failure(BodyScanError.BODY_SCAN_CLASSIFICATION_MISSING_JOINTS)
                     }
                 }
-                val tfModelsMap = mutableMapOf<String, Pair<ByteArray, Int>>()
-                val tfModelNames = ClassificationJNI.getTfLiteModelNames().asList()
-                tfModelNames.forEach { name ->
-                    val buffer = resources.getResource(name, AHIBSResourceType.AHIBSResourceTypeML, context).getOrNull()
-                    if (buffer != null) {
-                        tfModelsMap[name] = Pair(buffer, buffer.size)
-                    }
+                if (!delegateCacheSet) {
+                    ClassificationJNI.setDelegateCacheFile(File(context.cacheDir, DELEGATE_CACHE_FILE).absolutePath, false)
+                    delegateCacheSet = true
                 }
-                val svrModelsMap = mutableMapOf<String, Pair<ByteArray, Int>>()
-                val svrModelNames = ClassificationJNI.getSvrModelNames().asList()
-                svrModelNames.forEach { name ->
-                    val buffer = resources.getResource(name, AHIBSResourceType.AHIBSResourceTypeSVR, context).getOrNull()
-                    if (buffer != null) {
-                        svrModelsMap[name] = Pair(buffer, buffer.size)
+                // The models are handed to the native side once per resources, later scans only pass their handles.
+                val modelHandles = synchronized(modelsLock) {
+                    if (modelsResources !== resources) {
+                        val tfModelsMap = mutableMapOf<String, Pair<ByteArray, Int>>()
+                        val tfModelNames = ClassificationJNI.getTfLiteModelNames().asList()
+                        tfModelNames.forEach { name ->
+                            val buffer = resources.getResource(name, AHIBSResourceType.AHIBSResourceTypeML, context).getOrNull()
+                            if (buffer != null) {
+                                tfModelsMap[name] = Pair(buffer, buffer.size)
+                            }
+                        }
+                        if (!modelPackOpen) {
+                            modelPackOpen = AHIBSModelPack.open(
+                                context, ClassificationJNI::openModelPack, ClassificationJNI::openModelPackFd
+                            )
+                        }
+                        // the SVR models are read from the model pack when there is one
+                        val svrModelsMap = mutableMapOf<String, Pair<ByteArray, Int>>()
+                        val svrModelNames = if (modelPackOpen) listOf() else ClassificationJNI.getSvrModelNames().asList()
+                        svrModelNames.forEach { name ->
+                            val buffer = resources.getResource(name, AHIBSResourceType.AHIBSResourceTypeSVR, context).getOrNull()
+                            if (buffer != null) {
+                                svrModelsMap[name] = Pair(buffer, buffer.size)
+                            }
+                        }
+                        if (tfModelNames.size != tfModelsMap.size) {
+                            AHILogging.log(AHILogLevel.ERROR, "Classification failed due to some missing resources")
+                            return@withContext AHIResult.failure(BodyScanError.BODY_SCAN_CLASSIFICATION_MISSING_ML_MODELS)
+                        }
+                        if (svrModelNames.size != svrModelsMap.size) {
+                            AHILogging.log(AHILogLevel.ERROR, "Classification failed due to some missing resources")
+                            return@withContext AHIResult.failure(BodyScanError.BODY_SCAN_CLASSIFICATION_MISSING_SVR_MODELS)
+                        }
+                        val tfHandle = ClassificationJNI.registerModels(tfModelsMap)
+                        val svrHandle = ClassificationJNI.registerModels(svrModelsMap)
+                        ClassificationJNI.releaseModels(tfModelsHandle)
+                        ClassificationJNI.releaseModels(svrModelsHandle)
+                        tfModelsHandle = tfHandle
+                        svrModelsHandle = svrHandle
+                        modelsResources = resources
                     }
-                }
-                if (tfModelNames.size != tfModelsMap.size) {
-                    AHILogging.log(AHILogLevel.ERROR, "Classification failed due to some missing resources")
-                    return@withContext AHIResult.failure(BodyScanError.BODY_SCAN_CLASSIFICATION_MISSING_ML_MODELS)
-                }
-                if (svrModelNames.size != svrModelsMap.size) {
-                    AHILogging.log(AHILogLevel.ERROR, "Classification failed due to some missing resources")
-                    return@withContext AHIResult.failure(BodyScanError.BODY_SCAN_CLASSIFICATION_MISSING_SVR_MODELS)
+                    Pair(tfModelsHandle, svrModelsHandle)
                 }
                 val frontSilhouettes = mutableListOf<Bitmap>()
                 val sideSilhouettes = mutableListOf<Bitmap>()
@@ -102,7 +126,8 @@ class Classification : IClassification {
                     frontJoints.add(capture.front.joints)
                     sideJoints.add(capture.side.joints)
                 }
-                val result = ClassificationJNI.classifyMultiple(
+                val results = FloatArray(resultKeys.size)
+                val classified = ClassificationJNI.classifyMultipleInto(
                     heightCM,
                     weightKG,
                     sex,
@@ -110,10 +135,19 @@ class Classification : IClassification {
                     sideSilhouettes.toTypedArray(),
                     frontJoints.toTypedArray(),
                     sideJoints.toTypedArray(),
-                    tfModelsMap,
-                    svrModelsMap,
-                    useAverage
+                    modelHandles.first,
+                    modelHandles.second,
+                    useAverage,
+                    results
                 )
+                val result = mutableMapOf<String, Any>()
+                if (classified) {
+                    resultKeys.forEachIndexed { index, key ->
+                        if (!results[index].isNaN()) {
+                            result[key] = results[index]
+                        }
+                    }
+                }
                 AHIResult.success(result)
             } catch (e: Exception) {
                 AHILogging.log(AHILogLevel.ERROR, "Classification failed")
@@ -123,6 +157,15 @@ class Classification : IClassification {
     }
 
     companion object {
+        private const val DELEGATE_CACHE_FILE = "ahi_delegate_cache.tsv"
+        @Volatile
+        private var delegateCacheSet = false
+        private val modelsLock = Any()
+        private var modelsResources: IResources? = null
+        private var tfModelsHandle = 0L
+        private var svrModelsHandle = 0L
+        private var modelPackOpen = false
+        private val resultKeys: Array<String> by lazy { ClassificationJNI.getResultKeys() }
         private const val MIN_HEIGHT = 50
         private const val MAX_HEIGHT = 255
         private const val MIN_WEIGHT = 16
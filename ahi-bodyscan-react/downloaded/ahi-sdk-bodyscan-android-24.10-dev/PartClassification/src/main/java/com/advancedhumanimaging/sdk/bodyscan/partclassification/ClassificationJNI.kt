@@ -35,8 +35,53 @@ internal object ClassificationJNI {
         useAverage:Boolean
     ): Map<String, Any>?
 
+    external fun classifyMultipleRegistered(
+        height: Double,
+        weight: Double,
+        sex: SexType,
+        frontSilhouettes: Array<Bitmap>,
+        sideSilhouette: Array<Bitmap>,
+        frontJoints: Array<Map<String, PointF>>,
+        sideJoints: Array<Map<String, PointF>>,
+        tfModelsHandle: Long,
+        svrModelsHandle: Long,
+        useAverage:Boolean
+    ): Map<String, Any>?
+
+    /** Writes the results into results in the order of getResultKeys, NaN where a result is missing. */
+    external fun classifyMultipleInto(
+        height: Double,
+        weight: Double,
+        sex: SexType,
+        frontSilhouettes: Array<Bitmap>,
+        sideSilhouette: Array<Bitmap>,
+        frontJoints: Array<Map<String, PointF>>,
+        sideJoints: Array<Map<String, PointF>>,
+        tfModelsHandle: Long,
+        svrModelsHandle: Long,
+        useAverage:Boolean,
+        results: FloatArray
+    ): Boolean
+
+    /** Copies the models into native memory once, the handle stands for them until releaseModels. */
+    external fun registerModels(models: Map<String, Pair<ByteArray, Int>>): Long
+
+    external fun releaseModels(handle: Long): Boolean
+
+    external fun warmUp(tfModels: Map<String, Pair<ByteArray, Int>>): Int
+
+    external fun setDelegateCacheFile(path: String, benchmarkCpu: Boolean): Boolean
+
     external fun getTfLiteModelNames(): Array<String>
 
     external fun getSvrModelNames(): Array<String>
 
+    external fun getResultKeys(): Array<String>
+
+    /** Maps the model pack at path, the SVR models are read from it from then on. False if it could not be opened. */
+    external fun openModelPack(path: String): Boolean
+
+    /** Same over the length bytes at offset of fd (an uncompressed asset). The descriptor may be closed afterwards. */
+    external fun openModelPackFd(fd: Int, offset: Long, length: Long): Boolean
+
 }
\ No newline at end of file
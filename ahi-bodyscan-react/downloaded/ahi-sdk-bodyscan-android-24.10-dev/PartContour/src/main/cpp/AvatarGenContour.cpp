@@ -181,9 +181,10 @@ namespace avatar_gen {
 
             std::vector<float> thetas_feet(2, 0.0);
             std::vector<float> V(N_VERTS_3);
-            const std::vector<int> F = c->getFaces(gender);
+            const AHIBSModelPackView<int32_t> F = c->getFaces(gender);
             data[6] = 1.02;
-            error_id = pm.run(data, thetas_pose, thetas_feet, V);
+            // only the predicted measurements are needed from this first pass, not its mesh
+            error_id = pm.predict_data(data);
 
             if (error_id.size() > 0 && !(error_id == "Passed")) {
                 return cv::Mat::zeros(1, 1, 0);
@@ -259,81 +260,132 @@ namespace avatar_gen {
             if (Tz < 0) {
                 Tz = 3 * Ty;
             }
+            // Only fc changes while the avatar is fitted into the image, so the used vertices are projected once and
+            // the fit is searched on their extents: a vertex lands at (int) (fc / depth * (1000 * X + Tx) + ux), which
+            // moves monotonically with fc. The silhouette is rasterized once, for the fc found.
+            auto focal = [&](float alpha) -> float {
+                if (Ty == 0) {
+                    return 0.9 * ux / (Ty + 1.e-6) * Tz;
+                }
+                if (view == Profile::side) {
+                    return 0.85 * (alpha * ux + (1.0 - alpha) * uy) / Ty * Tz;
+                }
+                return 0.9 * (alpha * ux + (1.0 - alpha) * uy) / Ty * Tz;
+            };
+            std::vector<char> is_used(V.size() / 3, 0);
+            for (int idx: F) {
+                is_used[idx] = 1;
+            }
+            std::vector<cv::Vec3d> projected; // depth, x and y numerators
+            for (int v = 0; v < (int) is_used.size(); v++) {
+                if (!is_used[v]) {
+                    continue;
+                }
+                float Xo = V[3 * v];
+                float Yo = sh * (V[3 * v + 1] - mid_h) + mid_h;
+                float Zo = V[3 * v + 2];
+                if (view == Profile::side) {
+                    if (fabs(Zo) > 0.7 * max_z)
+                        continue;
+                }
+                float X, Y, Z;
+                X = cy * cz * Xo - cy * sz * Yo + sy * Zo;
+                Y = (cx * sz + cz * sx * sy) * Xo + (cx * cz - sx * sy * sz) * Yo - cy * sx * Zo;
+                Z = (sx * sz - cx * cz * sy) * Xo + (cz * sx + cx * sy * sz) * Yo + cx * cy * Zo;
+                if (std::abs(Tz + Z * 1000) > 0.001) {
+                    projected.emplace_back(Tz + Z * 1000., 1000. * X + Tx, 1000. * Y + Ty);
+                }
+            }
+            auto fits = [&](float fc_try) -> bool {
+                for (const cv::Vec3d &p: projected) {
+                    float Scale = fc_try / p[0];
+                    int ximage = (int) (Scale * p[1] + ux);
+                    int yimage = (int) (Scale * p[2] + uy);
+                    if (ximage <= 30 || ximage >= generated_silhoutte.cols - 30 ||
+                        yimage <= 30 || yimage >= generated_silhoutte.rows - 30) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            // the alpha steps of the original search, accumulated the same way
+            std::vector<float> alphas;
             float alpha = 0.4;
-            bool pass = false;
-            do {
-                fc = -1;
+            const int max_steps = 10000;
+            while ((int) alphas.size() < max_steps) {
                 alpha = alpha + 0.005;
-                if (fc < 0) {
-                    if (Ty == 0) {
-                        fc = 0.9 * ux / (Ty + 1.e-6) * Tz;
-                    } else {
-                        if (view == Profile::side) {
-                            fc = 0.85 * (alpha * ux + (1.0 - alpha) * uy) / Ty * Tz;
-                        } else {
-                            fc = 0.9 * (alpha * ux + (1.0 - alpha) * uy) / Ty * Tz;
-                        }
-                    }
+                if (focal(alpha) <= 0) {
+                    break;
                 }
-                generated_silhoutte = cv::Mat::zeros(generated_silhoutte.rows,
-                                                     generated_silhoutte.cols,
-                                                     generated_silhoutte.type());
-                int ximage, yimage, i, idx;
-                int ximage_prev = 0;
-                int yimage_prev = 0;
-                int idx_prev;
-                int xi_min = 2 * generated_silhoutte.cols;
-                int xi_max = -1;
-                int yi_min = 2 * generated_silhoutte.rows;
-                int yi_max = -1;
-                float (&Vxyz)[N_VERTS][3] = *reinterpret_cast<float (*)[N_VERTS][3]>(&(V[0]));
-                for (int n = 0; n < ((int) (F.size() / 3)); n++) {
-                    i = 3 * n;
-                    idx_prev = -100; // any -ve number
-                    for (int m = 0; m < 3; m++) {
-                        idx = i + m;
-                        float Xo = Vxyz[F[idx]][0];
-                        float Yo = Vxyz[F[idx]][1];
-                        Yo = sh * (Yo - mid_h) + mid_h;
-                        float Zo = Vxyz[F[idx]][2];
-                        if (view == Profile::side) {
-                            if (fabs(Zo) > 0.7 * max_z)
-                                continue;
-                        }
-                        float X, Y, Z;
-                        X = cy * cz * Xo - cy * sz * Yo + sy * Zo;
-                        Y = (cx * sz + cz * sx * sy) * Xo + (cx * cz - sx * sy * sz) * Yo -
-                            cy * sx * Zo;
-                        Z = (sx * sz - cx * cz * sy) * Xo + (cz * sx + cx * sy * sz) * Yo +
-                            cx * cy * Zo;
-                        if (std::abs(Tz + Z * 1000) > 0.001) {
-                            float Scale = fc / (Tz + Z * 1000.);
-                            ximage = (int) (Scale * (1000. * X + Tx) + ux);
-                            yimage = (int) (Scale * (1000. * Y + Ty) + uy);
-                            if (ximage >= 0 && yimage >= 0 && ximage_prev >= 0 &&
-                                yimage_prev >= 0 &&
-                                ximage < generated_silhoutte.cols &&
-                                yimage < generated_silhoutte.rows) {
-                                xi_min = std::min(xi_min, ximage);
-                                xi_max = std::max(xi_max, ximage);
-                                yi_min = std::min(yi_min, yimage);
-                                yi_max = std::max(yi_max, yimage);
-                                generated_silhoutte.at<uchar>(cv::Point(ximage, yimage)) = 255;
-                                if ((idx - idx_prev) == 1) {
-                                    line(generated_silhoutte, cv::Point(ximage, yimage),
-                                         cv::Point(ximage_prev, yimage_prev), 255, 1);
-                                }
-                                idx_prev = idx;
-                                ximage_prev = ximage;
-                                yimage_prev = yimage;
+                alphas.push_back(alpha);
+            }
+            if (alphas.empty() || !(fits(focal(alphas.front())) || fits(focal(alphas.back())))) {
+                error_id = "{\"GE\": \"1\"}";
+                return cv::Mat::zeros(1, 1, 0);
+            }
+            // first step that fits, by bisection over the steps
+            std::size_t lo = 0;
+            std::size_t hi = alphas.size() - 1;
+            if (fits(focal(alphas[lo]))) {
+                hi = lo;
+            }
+            while (lo + 1 < hi) {
+                std::size_t mid = lo + (hi - lo) / 2;
+                if (fits(focal(alphas[mid]))) {
+                    hi = mid;
+                } else {
+                    lo = mid;
+                }
+            }
+            fc = focal(alphas[hi]);
+            generated_silhoutte = cv::Mat::zeros(generated_silhoutte.rows,
+                                                 generated_silhoutte.cols,
+                                                 generated_silhoutte.type());
+            int ximage, yimage, i, idx;
+            int ximage_prev = 0;
+            int yimage_prev = 0;
+            int idx_prev;
+            float (&Vxyz)[N_VERTS][3] = *reinterpret_cast<float (*)[N_VERTS][3]>(&(V[0]));
+            for (int n = 0; n < ((int) (F.size() / 3)); n++) {
+                i = 3 * n;
+                idx_prev = -100; // any -ve number
+                for (int m = 0; m < 3; m++) {
+                    idx = i + m;
+                    float Xo = Vxyz[F[idx]][0];
+                    float Yo = Vxyz[F[idx]][1];
+                    Yo = sh * (Yo - mid_h) + mid_h;
+                    float Zo = Vxyz[F[idx]][2];
+                    if (view == Profile::side) {
+                        if (fabs(Zo) > 0.7 * max_z)
+                            continue;
+                    }
+                    float X, Y, Z;
+                    X = cy * cz * Xo - cy * sz * Yo + sy * Zo;
+                    Y = (cx * sz + cz * sx * sy) * Xo + (cx * cz - sx * sy * sz) * Yo -
+                        cy * sx * Zo;
+                    Z = (sx * sz - cx * cz * sy) * Xo + (cz * sx + cx * sy * sz) * Yo +
+                        cx * cy * Zo;
+                    if (std::abs(Tz + Z * 1000) > 0.001) {
+                        float Scale = fc / (Tz + Z * 1000.);
+                        ximage = (int) (Scale * (1000. * X + Tx) + ux);
+                        yimage = (int) (Scale * (1000. * Y + Ty) + uy);
+                        if (ximage >= 0 && yimage >= 0 && ximage_prev >= 0 &&
+                            yimage_prev >= 0 &&
+                            ximage < generated_silhoutte.cols &&
+                            yimage < generated_silhoutte.rows) {
+                            generated_silhoutte.at<uchar>(cv::Point(ximage, yimage)) = 255;
+                            if ((idx - idx_prev) == 1) {
+                                line(generated_silhoutte, cv::Point(ximage, yimage),
+                                     cv::Point(ximage_prev, yimage_prev), 255, 1);
                             }
+                            idx_prev = idx;
+                            ximage_prev = ximage;
+                            yimage_prev = yimage;
                         }
                     }
                 }
-                pass = (xi_min > 30) && (xi_max < (generated_silhoutte.cols - 30)) &&
-                       (yi_min > 30) &&
-                       (yi_max < (generated_silhoutte.rows - 30));
-            } while (!pass);
+            }
             generated_silhoutte = seg.fillHoles(generated_silhoutte, error_id);
             AHILog(ANDROID_LOG_DEBUG, "\n fc Tx Ty Tz %f \t %f \t %f \t %f \n", fc, Tx, Ty, Tz);
             return generated_silhoutte;
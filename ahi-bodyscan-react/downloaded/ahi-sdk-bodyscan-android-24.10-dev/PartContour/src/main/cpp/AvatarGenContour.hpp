@@ -41,11 +41,12 @@ namespace avatar_gen {
                 cv::Mat &ContourAsImage, float theta_phone, std::string &error_id,
                 int onColor, int offColor, int onLen, int offLen, int lineWidth);
 
-    private:
+        // Binary silhouette of the average avatar for height and weight, fitted in the image, that predict() outlines.
         static cv::Mat
         get_silhouttes_from_avatar(int image_Height, int image_Width, float Height, float Weight,
                                    BodyScanCommon::SexType gender, BodyScanCommon::Profile view, std::string &error_id);
 
+    private:
         cv::Mat match_with_template(const cv::Mat &templ, const cv::Mat &img, int match_method);
 
         void check_blob_size_new(const cv::Mat &part_bin_image, const cv::Mat &mask, float min_th,
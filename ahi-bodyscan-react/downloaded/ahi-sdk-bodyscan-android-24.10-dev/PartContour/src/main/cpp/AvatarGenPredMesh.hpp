@@ -8,21 +8,35 @@
 #define AvatarGenPredMesh_hpp
 
 #include "Common.hpp"
+#include "AHIBSModelPack.hpp"
 
 namespace avatar_gen {
     class pred_mesh {
     public:
+        // Conditioning of the shape MVN on the variables a scan observes, Sigma_22 being their covariance block and
+        // Sigma_12 the covariance of every variable with them. It only depends on the model and on which variables are
+        // observed, so it is computed once per gender and observation pattern (bit idx set when variable idx is observed).
+        struct mvn_condition {
+            bool valid = false;     // false if Sigma_22 is not positive definite
+            int n = 0;              // number of observed variables
+            int index[7] = {};      // observed variables, in increasing order
+            float gain[7][7] = {};  // Sigma_12 Sigma_22^-1, gain[a][j] weighs the offset of variable index[j]
+        };
+
+        static const mvn_condition &get_mvn_condition(BodyScanCommon::SexType gender, unsigned pattern);
+
         BodyScanCommon::SexType m_gender;
     private:
         std::string pred_mesh_error_id;
         std::vector<float> mvn_all_values;
-        std::vector<float> sigma_22_inverse_times_offsets;
-        std::vector<float> previous_sigma_22_inverse_times_offsets;
     public:
         pred_mesh(BodyScanCommon::SexType g);
 
         std::vector<float> initialize_parameters(const std::vector<float> &data);
 
+        // Predicts the unknown (-ve) entries of data_in like run() does, without building the mesh.
+        std::string predict_data(std::vector<float> &data_in);
+
         std::string run(std::vector<float> &data_in, const std::vector<float> &thetas_pose,
                         const std::vector<float> &thetas_feet, std::vector<float> &OutVertices);
 
@@ -30,34 +44,16 @@ namespace avatar_gen {
                            const std::vector<float> &thetas_feet, std::vector<float> &OutVertices);
 
     private:
-        std::vector<std::vector<float> > set_sigma_22(const std::vector<int> &index);
-
-        std::vector<float> set_conditioned_value_offsets(const std::vector<float> &current_data,
-                                                         const std::vector<int> &index);
+        // Fills in the entries of data outside the model ranges with their mean conditioned on the others.
+        bool condition_data(std::vector<float> &data);
 
-        std::vector<float> set_all_values(const std::vector<std::vector<float> > &sigma_22,
-                                          const std::vector<float> &conditioned_values_by_index,
-                                          const std::vector<float> &conditioned_value_offsets,
-                                          const std::vector<int> &index);
-
-        std::vector<float> update_all_values(const std::vector<std::vector<float> > &sigma_22,
-                                             const std::vector<float> &conditioned_values_by_index,
-                                             const std::vector<float> &conditioned_value_offsets,
-                                             const std::vector<int> &index);
-
-        std::vector<float>
-        deform(const std::vector<float> &thetas_pose, const std::vector<float> &thetas_feet);
+        // The mean mesh (the inversion one if inversion_mesh) skinned to the pose into OutVertices.
+        void deform(const std::vector<float> &thetas_pose, const std::vector<float> &thetas_feet, bool inversion_mesh,
+                    std::vector<float> &OutVertices);
 
         // MATRIX FUNCS
-        std::vector<std::vector<float> > MatrixInverse(const std::vector<std::vector<float> > &A);
-
-        float MatrixDeterminant(const std::vector<std::vector<float> > &D, int order);
-
-        std::vector<std::vector<float> >
-        MatrixTranspose(const std::vector<std::vector<float> > &A, int order);
-
         std::vector<float>
-        Matrix_times_vector(const std::vector<std::vector<float> > &A, const std::vector<float> &b);
+        Matrix_times_vector(const AHIBSModelPackView<float> &A, const std::vector<float> &b);
     };
 }
 #endif /* AvatarGenPredMesh_hpp */
@@ -0,0 +1,151 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "AvatarGenSkinning.hpp"
+#include "AvatarGenCommon.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace avatar_gen {
+    namespace {
+        void set_identity(skinning::bone_transform &t) {
+            const float identity[12] = {1, 0, 0, 0,
+                                        0, 1, 0, 0,
+                                        0, 0, 1, 0};
+            std::copy(identity, identity + 12, t.m);
+        }
+
+        // Rotation by theta about the y axis through joint: x' = x0 + cos (x - x0) + sin (z - z0),
+        // z' = z0 - sin (x - x0) + cos (z - z0).
+        void set_rotation_y(skinning::bone_transform &t, const float *joint, double theta) {
+            double c = cos(theta);
+            double s = sin(theta);
+            const float m[12] = {(float) c, 0, (float) s, (float) (joint[0] - c * joint[0] - s * joint[2]),
+                                 0, 1, 0, 0,
+                                 (float) -s, 0, (float) c, (float) (joint[2] + s * joint[0] - c * joint[2])};
+            std::copy(m, m + 12, t.m);
+        }
+
+        // Rotation by theta about the z axis through joint: x' = x0 + cos (x - x0) - sin (y - y0),
+        // y' = y0 + sin (x - x0) + cos (y - y0).
+        void set_rotation_z(skinning::bone_transform &t, const float *joint, double theta) {
+            double c = cos(theta);
+            double s = sin(theta);
+            const float m[12] = {(float) c, (float) -s, 0, (float) (joint[0] - c * joint[0] + s * joint[1]),
+                                 (float) s, (float) c, 0, (float) (joint[1] - s * joint[0] - c * joint[1]),
+                                 0, 0, 1, 0};
+            std::copy(m, m + 12, t.m);
+        }
+    }
+
+    bool skinning::make_pose(const AHIBSModelPackView<float> &skeleton, const std::vector<float> &thetas_pose,
+                             const std::vector<float> &thetas_feet, pose &out) {
+        if (skeleton.rows < 16 || skeleton.cols < 3 || thetas_pose.size() < 4 || thetas_feet.size() < 2) {
+            return false;
+        }
+        for (int b = 0; b < N_BONES; b++) {// 17 bones made of 18 SkV skel verts
+            if (b == 6) {// rf
+                set_rotation_y(out.feet[b], skeleton.row(6), thetas_feet[0]);
+            } else if (b == 10) {// lf
+                set_rotation_y(out.feet[b], skeleton.row(10), thetas_feet[1]);
+            } else {
+                set_identity(out.feet[b]);
+            }
+            if (b == 12 || b == 13) {// ra
+                set_rotation_z(out.limbs[b], skeleton.row(12), thetas_pose[0]);
+            } else if (b == 15 || b == 16) {// la
+                set_rotation_z(out.limbs[b], skeleton.row(15), thetas_pose[1]);
+            } else if (b == 4 || b == 5 || b == 6) {// rl
+                set_rotation_z(out.limbs[b], skeleton.row(4), thetas_pose[2]);
+            } else if (b == 8 || b == 9 || b == 10) {// ll
+                set_rotation_z(out.limbs[b], skeleton.row(8), thetas_pose[3]);
+            } else {
+                set_identity(out.limbs[b]);
+            }
+        }
+        return true;
+    }
+
+    skinning::skinning(SexType gender, bool inversion_mesh)
+            : m_gender(gender), m_inversion_mesh(inversion_mesh) {
+    }
+
+    skinning &skinning::get(SexType gender, bool inversion_mesh) {
+        static skinning male(SexType::male, false);
+        static skinning female(SexType::female, false);
+        static skinning male_inv(SexType::male, true);
+        static skinning female_inv(SexType::female, true);
+        if (gender == SexType::male) {
+            return inversion_mesh ? male_inv : male;
+        }
+        return inversion_mesh ? female_inv : female;
+    }
+
+    // Builds the sparse weights from the model data, if not done from that data yet. Called under the lock.
+    bool skinning::prepare() {
+        const common *c = common::getInstance();
+        AHIBSModelPackView<float> weights = m_inversion_mesh ? c->getBonWInv(m_gender) : c->getBonW(m_gender);
+        AHIBSModelPackView<float> mean = m_inversion_mesh ? c->getVertsInv(m_gender) : c->getAvgVerts(m_gender);
+        if ((std::size_t) weights.rows * 3 != mean.size() || weights.cols < N_BONES) {
+            return false;
+        }
+        m_mean = mean.data;
+        if (m_source == weights.data) {
+            return true;
+        }
+        m_source = nullptr;
+        m_num_verts = (int) weights.rows;
+        m_offsets.assign(1, 0);
+        m_bones.clear();
+        m_weights.clear();
+        for (int v = 0; v < m_num_verts; v++) {
+            const float *vertex_weights = weights.row(v);
+            for (int b = 0; b < N_BONES; b++) {
+                if (vertex_weights[b] != 0.0f) {
+                    m_bones.push_back((std::uint8_t) b);
+                    m_weights.push_back(vertex_weights[b]);
+                }
+            }
+            m_offsets.push_back((int) m_weights.size());
+        }
+        m_source = weights.data;
+        return true;
+    }
+
+    // Blending the bone transforms by the vertex weights and applying the blend is the weighted sum of the transformed
+    // vertex, so each vertex goes through both passes in one go.
+    bool skinning::deform(const pose &p, std::vector<float> &out) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!prepare()) {
+            return false;
+        }
+        out.resize((std::size_t) m_num_verts * 3);
+        for (int v = 0; v < m_num_verts; v++) {
+            float feet[12] = {};
+            float limbs[12] = {};
+            for (int k = m_offsets[v]; k < m_offsets[v + 1]; k++) {
+                const float w = m_weights[k];
+                const float *f = p.feet[m_bones[k]].m;
+                const float *l = p.limbs[m_bones[k]].m;
+                for (int j = 0; j < 12; j++) {
+                    feet[j] += w * f[j];
+                    limbs[j] += w * l[j];
+                }
+            }
+            const float *x = m_mean + 3 * v;
+            float y[3];
+            for (int r = 0; r < 3; r++) {
+                y[r] = feet[4 * r] * x[0] + feet[4 * r + 1] * x[1] + feet[4 * r + 2] * x[2] + feet[4 * r + 3];
+            }
+            float *z = out.data() + 3 * v;
+            for (int r = 0; r < 3; r++) {
+                z[r] = limbs[4 * r] * y[0] + limbs[4 * r + 1] * y[1] + limbs[4 * r + 2] * y[2] + limbs[4 * r + 3];
+            }
+        }
+        return true;
+    }
+}
@@ -7,6 +7,17 @@
 #include <jnihelper/JNIHelper.hpp>
 #include "ContourGenerator.hpp"
 
+extern "C"
+JNIEXPORT jint JNICALL
+JNI_OnLoad(JavaVM *vm, void *reserved) {
+    JNIEnv *env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        return JNI_ERR;
+    }
+    JNIHelper::onLoad(env);
+    return JNI_VERSION_1_6;
+}
+
 extern "C"
 JNIEXPORT jobjectArray JNICALL
 Java_com_advancedhumanimaging_sdk_bodyscan_partcontour_ContourGeneratorJNI_generateIdealContour(
@@ -37,7 +48,7 @@ Java_com_advancedhumanimaging_sdk_bodyscan_partcontour_ContourGeneratorJNI_gener
 
     auto result = ContourGenerator::generateIdealContour(sexType, height_cm, weight_kg, imageHeight,
                                                          imageWidth, alignment_zradians,
-                                                         profileType, cvModelsMapMale, cvModelsMapFemale);
+                                                         profileType, cvModelsMapMale->models, cvModelsMapFemale->models);
 
     jclass jPointFClass = env->FindClass("android/graphics/PointF");
     jobjectArray jResult = env->NewObjectArray(result.size(), jPointFClass, nullptr);
@@ -85,4 +96,42 @@ Java_com_advancedhumanimaging_sdk_bodyscan_partcontour_ContourGeneratorJNI_gener
     } catch (std::exception e) {
         return nullptr;
     }
+}
+
+// The avatar models are viewed in the pack from then on; the cereal maps generateIdealContour is handed may be left
+// empty.
+static jboolean useModelPack(std::shared_ptr<const AHIBSModelPack> pack) {
+    if (pack == nullptr) {
+        return JNI_FALSE;
+    }
+    avatar_gen::common::getInstance(BodyScanCommon::SexType::male, std::move(pack));
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partcontour_ContourGeneratorJNI_openModelPack(
+        JNIEnv *env,
+        jobject thiz,
+        jstring path) {
+    const char *nativePath = env->GetStringUTFChars(path, nullptr);
+    std::string error;
+    std::shared_ptr<const AHIBSModelPack> pack = AHIBSModelPack::open(nativePath, true, error);
+    env->ReleaseStringUTFChars(path, nativePath);
+    return useModelPack(std::move(pack));
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partcontour_ContourGeneratorJNI_openModelPackFd(
+        JNIEnv *env,
+        jobject thiz,
+        jint fd,
+        jlong offset,
+        jlong length) {
+    if (fd < 0 || offset < 0 || length <= 0) {
+        return JNI_FALSE;
+    }
+    std::string error;
+    return useModelPack(AHIBSModelPack::open(fd, (uint64_t) offset, (uint64_t) length, true, error));
 }
\ No newline at end of file
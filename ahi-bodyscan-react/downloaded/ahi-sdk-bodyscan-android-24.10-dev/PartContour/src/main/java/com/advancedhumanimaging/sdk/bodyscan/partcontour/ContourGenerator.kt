@@ -13,6 +13,7 @@ import android.graphics.RectF
 import androidx.core.graphics.contains
 import com.advancedhumanimaging.sdk.bodyscan.common.AHIBSImageCaptureHeight
 import com.advancedhumanimaging.sdk.bodyscan.common.AHIBSImageCaptureWidth
+import com.advancedhumanimaging.sdk.bodyscan.common.AHIBSModelPack
 import com.advancedhumanimaging.sdk.bodyscan.common.AHIBSOptimalContourZone
 import com.advancedhumanimaging.sdk.bodyscan.common.Profile
 import com.advancedhumanimaging.sdk.bodyscan.common.Resolution
@@ -56,6 +57,9 @@ class ContourGenerator : IContourGenerator {
     private val cvModelsMapMale = mutableMapOf<String, Pair<ByteArray, Int>>()
     private val cvModelsMapFemale = mutableMapOf<String, Pair<ByteArray, Int>>()
 
+    // Set once the native side reads the CV models from the model pack, the resources are not loaded then.
+    private var modelPackOpen = false
+
     private suspend fun getCvModelsMap(
         context: Context,
         resources: IResources,
@@ -104,6 +108,16 @@ class ContourGenerator : IContourGenerator {
     ): Array<PointF>? {
         return withContext(Dispatchers.IO) {
             try {
+                if (!modelPackOpen) {
+                    modelPackOpen = AHIBSModelPack.open(
+                        context, ContourGeneratorJNI::openModelPack, ContourGeneratorJNI::openModelPackFd
+                    )
+                }
+                if (modelPackOpen) {
+                    return@withContext ContourGeneratorJNI.generateIdealContour(
+                        sex, heightCM, weightKG, imageSize, alignmentZRadians, profile, mapOf(), mapOf()
+                    )
+                }
                 val cvModelsMapMale = getCvModelsMap(context, resources, SexType.male)
                 val cvModelsMapFemale = getCvModelsMap(context, resources, SexType.female)
                 when {
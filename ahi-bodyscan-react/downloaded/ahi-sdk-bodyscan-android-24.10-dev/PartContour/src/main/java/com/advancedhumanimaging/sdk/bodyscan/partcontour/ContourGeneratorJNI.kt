@@ -32,4 +32,10 @@ internal object ContourGeneratorJNI {
     ): Array<PointF>?
 
     external fun generateContourMask(contour: Array<PointF>, imageSize: Resolution): Bitmap?
+
+    // Maps the model pack at path; the CV models are read from it from then on. False if it could not be opened.
+    external fun openModelPack(path: String): Boolean
+
+    // Same over the length bytes at offset of fd (an uncompressed asset). The descriptor may be closed afterwards.
+    external fun openModelPackFd(fd: Int, offset: Long, length: Long): Boolean
 }
\ No newline at end of file
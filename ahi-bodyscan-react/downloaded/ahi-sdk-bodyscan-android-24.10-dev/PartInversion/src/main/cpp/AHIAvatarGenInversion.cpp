@@ -7,6 +7,7 @@
 #include "AHIAvatarGenInversion.hpp"
 #include "AHIAvatarGenPredMesh.hpp"
 #include "AvatarGenCommon.hpp"
+#include "AHIAvatarGenSparseLaplacian.hpp"
 
 namespace avatar_gen {
     inversion::inversion(void) : m_rnd(time(0)) {
@@ -19,10 +20,11 @@ namespace avatar_gen {
         }
     }
 
-    void inversion::wrap_faces(std::vector<AHIAvatarGenFace> &dest, std::vector<int> &src) {
+    // The faces only read the indices they wrap.
+    void inversion::wrap_faces(std::vector<AHIAvatarGenFace> &dest, const AHIBSModelPackView<int32_t> &src) {
         size_t nFaces = src.size();
         for (int i = 0; i < nFaces; i += 3) {
-            dest.push_back(AHIAvatarGenFace(&src.data()[i]));
+            dest.push_back(AHIAvatarGenFace(const_cast<int *>(&src.data[i])));
         }
     }
 
@@ -104,69 +106,32 @@ namespace avatar_gen {
         }
     }
 
-    std::vector<std::string>
-    inversion::invert(
-            BodyScanCommon::SexType Gender,
-            float H,
-            float W,
-            float Chest,
-            float Waist,
-            float Hip,
-            float Inseam,
-            float Fitness,
-            std::string &errorString,
-            std::map<std::string, std::pair<char *, std::size_t>> &cvModelsMale,
-            std::map<std::string, std::pair<char *, std::size_t>> &cvModelsFemale,
-            const char delim
-    ) {
+    bool
+    inversion::invert(BodyScanCommon::SexType Gender, float H, float W, float Chest, float Waist, float Hip,
+                      float Inseam, float Fitness, std::string &errorString,
+                      std::map<std::string, std::pair<char *, std::size_t>> &cvModelsMale,
+                      std::map<std::string, std::pair<char *, std::size_t>> &cvModelsFemale,
+                      mesh_writer::format format, bool with_normals, const mesh_writer::sink &out) {
         const common *c = common::getInstance(Gender, cvModelsMale, cvModelsFemale);
-        std::vector<std::string> mesh;
-        pred_mesh pm(Gender);
-        try {
-            std::vector<float> arcL(3, -100);
-            std::vector<float> Parameters(7, -100);
-            Parameters[0] = H;
-            Parameters[1] = W;
-            Parameters[2] = Chest;
-            Parameters[3] = Waist;
-            Parameters[4] = Hip;
-            Parameters[5] = Inseam;
-            Parameters[6] = Fitness;
-            std::vector<float> thetas_pose(4, 0.0); // arms and legs poses
-            std::vector<float> thetas_feet(2, 0.0);
-            std::vector<float> OutVertices;
-            std::string output_msg = pm.runInv(Parameters, thetas_pose, thetas_feet, OutVertices);
-            if (output_msg == "Passed") {
-                compute_part_laplacian_cot_weights(OutVertices, Gender,
-                                                   c->getLaplacianRingsAsVectors(Gender),
-                                                   c->getLaplacianRings(Gender), errorString);
-                if (errorString.size() > 0) {
-                    errorString = "11";
-                    return mesh;
-                }
-                for (int i = 0; i < (int) OutVertices.size(); i += 3) {
-                    std::ostringstream tmpV;
-                    tmpV << "v " << OutVertices[i] << " " << OutVertices[i + 1] << " "
-                         << OutVertices[i + 2] << delim;
-                    mesh.push_back(tmpV.str());
-                }
-                for (int i = 0; i < c->getFacesInv(Gender).size(); i += 3) {
-                    std::ostringstream tmpF;
-                    tmpF << "f " << c->getFacesInv(Gender)[i] + 1 << " "
-                         << c->getFacesInv(Gender)[i + 1] + 1 << " "
-                         << c->getFacesInv(Gender)[i + 2] + 1 << delim;
-                    mesh.push_back(tmpF.str());
-                }
-                errorString = "";
-                return mesh;
-            } else {
-                errorString = "11";
-                return mesh;
-            }
-        } catch (cv::Exception e) {
+        std::vector<float> OutVertices;
+        if (!invert(OutVertices, Gender, H, W, Chest, Waist, Hip, Inseam, Fitness, errorString)) {
             errorString = "11";
-            return mesh;
+            return false;
+        }
+        AHIBSModelPackView<int32_t> Faces = c->getFacesInv(Gender);
+        std::vector<float> Normals;
+        if (with_normals) {
+            std::vector<AHIAvatarGenVec3> vertices;
+            std::vector<AHIAvatarGenFace> faces;
+            wrap_vertices(vertices, OutVertices);
+            wrap_faces(faces, Faces);
+            create_normals(Normals, vertices, faces);
+        }
+        if (!mesh_writer::write(format, OutVertices, Normals, Faces, out)) {
+            errorString = "11";
+            return false;
         }
+        return true;
     }
 
     std::string inversion::average(BodyScanCommon::SexType Gender, float H, float W,
@@ -240,11 +205,11 @@ namespace avatar_gen {
 
             const common *c = common::getInstance();
 
-            idx_pca = c->getInvRightThigh();
+            idx_pca.assign(c->getInvRightThigh().begin(), c->getInvRightThigh().end());
             idx_pca.insert(idx_pca.end(), c->getInvRightCalf().begin(), c->getInvRightCalf().end());
 
             for (int i = 0; i < 3; i++) {
-                const std::vector<int> idx =
+                const AHIBSModelPackView<int32_t> idx =
                         i == 0 ? c->getInvRightCalf() : i == 1 ? c->getInvRightThigh()
                                                                : c->getInvRightUpperArm();
                 // 3D
@@ -339,215 +304,13 @@ namespace avatar_gen {
 
     void inversion::compute_part_laplacian_cot_weights(std::vector<float> &OutVertices,
                                                        BodyScanCommon::SexType gender,
-                                                       const std::vector<int> &rings_as_vector,
-                                                       const std::vector<int> &num_of_points_per_ring,
+                                                       const AHIBSModelPackView<int32_t> &rings_as_vector,
+                                                       const AHIBSModelPackView<int32_t> &num_of_points_per_ring,
                                                        std::string &error_id) {
-        const common *c = common::getInstance();
         try {
-            float (&verts)[BodyScanCommon::N_VERTS_INV][3] = *reinterpret_cast<float (*)[BodyScanCommon::N_VERTS_INV][3]>(&(c->getVertsInv(
-                    gender)[0]));
-            // first we find the valid number of vertices and rings for a given bound (bounds)
-            int L_ring_total = 0;
-            float bound, th;
-            if (gender == BodyScanCommon::SexType::male) {
-                bound = 1.57;
-                th = OutVertices[3 * 3552 + 1];// over ear point; needed at the end
-            } else {
-                bound = 1.48;
-                th = OutVertices[3 * 3552 + 1];// over ear point;
-            }
-            int N_rows = 0;
-            for (int i = 0; i < BodyScanCommon::N_VERTS_INV; i++) {
-                std::vector<int> ring;
-                ring.reserve(L_ring_total + num_of_points_per_ring[i]);
-                for (int r = L_ring_total; r < (L_ring_total + num_of_points_per_ring[i]); r++) {
-                    ring.push_back(rings_as_vector[r]);
-                }
-                L_ring_total = L_ring_total + num_of_points_per_ring[i];
-
-                int Lring = (int) ring.size() - 1;
-                bool N_rows_plus_one = false;
-                for (int ii = 0; ii < Lring; ii++) {
-                    int j = ring[ii] - 1;
-                    int k = ring[ii + 1] - 1;
-                    if (verts[i][1] < bound || verts[j][1] < bound || verts[k][1] < bound) {
-                        continue;
-                    }
-                    N_rows_plus_one = true; // true if at least i had one j and links
-                }
-                if (N_rows_plus_one) {
-                    N_rows = N_rows + 1;
-                }
-            }
-            // now we get W for the vertices defined as per the bound above
-            cv::Mat W = cv::Mat::zeros(N_rows, BodyScanCommon::N_VERTS_INV, CV_32F);
-            L_ring_total = 0;
-            int row_counter = 0;
-            for (int i = 0; i < BodyScanCommon::N_VERTS_INV; i++) {
-                std::vector<int> ring;// = rings_as_vector(L_ring_total: L_ring_total + num_of_points_per_ring(i)-1);
-                ring.reserve(L_ring_total + num_of_points_per_ring[i]);
-
-                for (int r = L_ring_total; r < (L_ring_total + num_of_points_per_ring[i]); r++) {
-                    ring.push_back(rings_as_vector[r]);
-                }
-
-                L_ring_total = L_ring_total + num_of_points_per_ring[i];
-
-                int Lring = (int) ring.size() - 1;
-
-                bool row_counter_plus_one = false;
-                for (int ii = 0; ii < Lring; ii++) {
-                    int j = ring[ii] - 1;
-                    int k = ring[ii + 1] - 1;
-
-                    if (verts[i][1] < bound || verts[j][1] < bound || verts[k][1] < bound) {
-                        continue;
-                    }
-                    row_counter_plus_one = true;
-
-                    float vi[3];
-                    vi[0] = verts[i][0];
-                    vi[1] = verts[i][1];
-                    vi[2] = verts[i][2];
-                    float vj[3];
-                    vj[0] = verts[j][0];
-                    vj[1] = verts[j][1];
-                    vj[2] = verts[j][2];
-                    float vk[3];
-                    vk[0] = verts[k][0];
-                    vk[1] = verts[k][1];
-                    vk[2] = verts[k][2];
-
-                    float u[3], v[3];
-                    // u = vk-vi; v = vk-vj;
-                    u[0] = vk[0] - vi[0];
-                    u[1] = vk[1] - vi[1];
-                    u[2] = vk[2] - vi[2];
-                    v[0] = vk[0] - vj[0];
-                    v[1] = vk[1] - vj[1];
-                    v[2] = vk[2] - vj[2];
-
-                    float cot1, dot, cross[3]; // = dot(u,v)/norm(cross(u,v));
-
-                    dot = u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
-
-                    cross[0] = u[1] * v[2] - u[2] * v[1];
-                    cross[1] = u[2] * v[0] - u[0] * v[2];
-                    cross[2] = u[0] * v[1] - u[1] * v[0];
-
-                    cot1 = dot /
-                           sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
-                    W.at<float>(row_counter, j) =
-                            W.at<float>(row_counter, j) + cot1;// W(i,j) = W(i,j) + cot1;
-                    // u = vj-vi; v = vj-vk;
-                    u[0] = vj[0] - vi[0];
-                    u[1] = vj[1] - vi[1];
-                    u[2] = vj[2] - vi[2];
-                    v[0] = vj[0] - vk[0];
-                    v[1] = vj[1] - vk[1];
-                    v[2] = vj[2] - vk[2];
-
-                    dot = u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
-
-                    cross[0] = u[1] * v[2] - u[2] * v[1];
-                    cross[1] = u[2] * v[0] - u[0] * v[2];
-                    cross[2] = u[0] * v[1] - u[1] * v[0];
-
-                    float cot2 =
-                            dot /
-                            sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
-
-                    W.at<float>(row_counter, k) =
-                            W.at<float>(row_counter, k) + cot2;// W(i,k) = W(i,k) + cot2;
-                }
-                if (row_counter_plus_one) {
-                    row_counter = row_counter + 1;
-                }
-            }
-            // now we keep non-zero values (cols) of W and the correspoinding vertices
-            cv::Mat W_rows_summed;
-            reduce(W, W_rows_summed, 0, cv::REDUCE_SUM, CV_32F);
-
-            int N_of_nonzero_cols = countNonZero(W_rows_summed);
-
-            cv::Mat W_part(N_rows, N_of_nonzero_cols, CV_32F);
-            cv::Mat V_part = cv::Mat(N_rows, 3, CV_32F);
-            std::vector<int> V_idx;
-
-            for (int row = 0; row < N_rows; row++) {
-                int col_counter = 0;
-                float tmp_sum = 0.0;
-                for (int col = 0; col < BodyScanCommon::N_VERTS_INV; col++) {
-                    if (W_rows_summed.at<float>(col) != 0) {
-                        if (row ==
-                            0) {// we need to do it just once (could be in  a seprate loop but thought of having it here)
-                            V_idx.push_back(
-                                    col);// don't confuse col here also refers to the row of the V matrix (W V  = delta)
-                            V_part.at<float>(col_counter, 0) = verts[col][0];
-                            V_part.at<float>(col_counter, 1) = verts[col][1];
-                            V_part.at<float>(col_counter, 2) = verts[col][2];
-                        }
-                        W_part.at<float>(row, col_counter) = W.at<float>(row, col);
-                        tmp_sum = tmp_sum + W_part.at<float>(row, col_counter);
-                        col_counter = col_counter + 1;
-                    }
-                }
-                tmp_sum = std::abs(tmp_sum);
-                if (tmp_sum > 10000) {
-                    for (int col = 0;
-                         col < N_rows; col++) {// no of cols = no of raws (must equal actually)
-                        W_part.at<float>(row, col) = W.at<float>(row, col) * 10000.0 / tmp_sum;
-                    }
-                }
-            }
-            cv::Mat W_part_col_summed;
-            reduce(W, W_part_col_summed, 1, cv::REDUCE_SUM, CV_32F);
-            for (int i = 0; i < N_rows; i++) {
-                W_part.at<float>(i, i) = W_part.at<float>(i, i) - W_part_col_summed.at<float>(i);
-            }
-            cv::Mat delta_part = W_part * V_part;
-            // if we use all vertex indices in V_part
-            std::vector<int> anchor_idx = V_idx;
-            // anchors
-            int N_rows_reflected = 0;
-            for (int idx = 0; idx < (int) V_idx.size(); idx++) {
-                int j = 3 * V_idx[idx];
-                if (OutVertices[j + 1] < th || OutVertices[j + 2] > 0) {
-                    N_rows_reflected = N_rows_reflected + 1;
-                }
-            }
-            cv::Mat WH = cv::Mat::zeros(N_rows_reflected, (int) V_idx.size(), CV_32F);
-            cv::Mat V_anchors = cv::Mat::zeros(N_rows_reflected, 3, CV_32F);
-            int reflected_counter = 0;
-            for (int idx = 0; idx < (int) V_idx.size(); idx++) {
-                int j = 3 * V_idx[idx];
-                if (OutVertices[j + 1] < th || OutVertices[j + 2] > 0) {
-                    WH.at<float>(reflected_counter, idx) = 1.0;
-                    V_anchors.at<float>(reflected_counter, 0) = float(OutVertices[j]);
-                    V_anchors.at<float>(reflected_counter, 1) = float(OutVertices[j + 1]);
-                    V_anchors.at<float>(reflected_counter, 2) = float(OutVertices[j + 2]);
-                    reflected_counter = reflected_counter + 1;
-                }
-            }
-            vconcat(W_part, WH, W_part);
-            WH.release();
-            vconcat(delta_part, V_anchors, delta_part);
-            V_anchors.release();
-            // slow here
-            cv::Mat t = W_part.t();
-            delta_part = t * delta_part;
-            W_part = (t * W_part);
-            // and slow(ish) here...
-            cv::Mat VL_part = W_part.inv() * delta_part;
-            W_part.release();
-            delta_part.release();
-            for (int idx = 0; idx < (int) V_idx.size(); idx++) {
-                int k = 3 * V_idx[idx];
-                OutVertices[k] = VL_part.at<float>(idx, 0);
-                OutVertices[k + 1] = VL_part.at<float>(idx, 1);
-                OutVertices[k + 2] = VL_part.at<float>(idx, 2);
-            }
-            error_id.clear();// if it reaches here it is then passed;
+            // the template only part (cot weights, L^T L and its factorization) is built once per gender
+            laplacian_template::get(gender).solve(OutVertices, gender, rings_as_vector,
+                                                  num_of_points_per_ring, error_id);
         } catch (cv::Exception e) {
             error_id = "Failed in Laplace: " + std::string(e.what());
         }
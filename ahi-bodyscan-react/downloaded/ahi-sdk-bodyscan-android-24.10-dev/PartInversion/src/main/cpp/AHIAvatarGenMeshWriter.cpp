@@ -0,0 +1,229 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "AHIAvatarGenMeshWriter.hpp"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+namespace avatar_gen {
+    namespace {
+        const std::size_t CHUNK_SIZE = 1 << 16;
+        // Longest OBJ line: "f a//a b//b c//c" or "vn x y z" with the longest numbers.
+        const std::size_t MAX_LINE_SIZE = 4 + 3 * (2 * 20 + 3) + 1;
+
+        // The chunk the mesh is formatted into, handed to the sink when the next line might not fit.
+        class chunk_output {
+        public:
+            explicit chunk_output(const mesh_writer::sink &out) : m_out(out), m_chunk(CHUNK_SIZE) {
+            }
+
+            // Room for size bytes (at most CHUNK_SIZE) at the returned pointer, to be committed once written.
+            char *reserve(std::size_t size) {
+                if (m_used + size > m_chunk.size()) {
+                    flush();
+                }
+                return m_chunk.data() + m_used;
+            }
+
+            void commit(const char *end) {
+                m_used = (std::size_t) (end - m_chunk.data());
+            }
+
+            void append(const void *data, std::size_t size) {
+                char *at = reserve(size);
+                std::memcpy(at, data, size);
+                commit(at + size);
+            }
+
+            bool flush() {
+                if (m_ok && m_used > 0) {
+                    m_ok = m_out(m_chunk.data(), m_used);
+                }
+                m_used = 0;
+                return m_ok;
+            }
+
+        private:
+            const mesh_writer::sink &m_out;
+            std::vector<char> m_chunk;
+            std::size_t m_used = 0;
+            bool m_ok = true;
+        };
+
+        char *format_uint(char *text, std::uint64_t value) {
+            char digits[20];
+            int n = 0;
+            do {
+                digits[n++] = (char) ('0' + value % 10);
+                value /= 10;
+            } while (value > 0);
+            while (n > 0) {
+                *text++ = digits[--n];
+            }
+            return text;
+        }
+
+        char *format_vector(char *text, const char *keyword, const float *v) {
+            while (*keyword) {
+                *text++ = *keyword++;
+            }
+            for (int k = 0; k < 3; k++) {
+                *text++ = ' ';
+                text = mesh_writer::format_float(text, v[k]);
+            }
+            *text++ = '\n';
+            return text;
+        }
+
+        void write_obj(chunk_output &out, const std::vector<float> &vertices, const std::vector<float> &normals,
+                       const AHIBSModelPackView<int32_t> &faces) {
+            for (std::size_t i = 0; i < vertices.size(); i += 3) {
+                out.commit(format_vector(out.reserve(MAX_LINE_SIZE), "v", vertices.data() + i));
+            }
+            for (std::size_t i = 0; i < normals.size(); i += 3) {
+                out.commit(format_vector(out.reserve(MAX_LINE_SIZE), "vn", normals.data() + i));
+            }
+            for (std::size_t i = 0; i < faces.size(); i += 3) {
+                char *text = out.reserve(MAX_LINE_SIZE);
+                *text++ = 'f';
+                for (int k = 0; k < 3; k++) {
+                    *text++ = ' ';
+                    text = format_uint(text, (std::uint64_t) faces[i + k] + 1);
+                    if (!normals.empty()) {
+                        *text++ = '/';
+                        *text++ = '/';
+                        text = format_uint(text, (std::uint64_t) faces[i + k] + 1);
+                    }
+                }
+                *text++ = '\n';
+                out.commit(text);
+            }
+        }
+
+        template<typename Index>
+        void write_ply_faces(chunk_output &out, const AHIBSModelPackView<int32_t> &faces) {
+            const std::size_t face_size = 1 + 3 * sizeof(Index);
+            for (std::size_t i = 0; i < faces.size(); i += 3) {
+                char *at = out.reserve(face_size);
+                at[0] = 3;
+                for (int k = 0; k < 3; k++) {
+                    Index index = (Index) faces[i + k];
+                    std::memcpy(at + 1 + k * sizeof(Index), &index, sizeof(Index));
+                }
+                out.commit(at + face_size);
+            }
+        }
+
+        // The floats and indices are copied in host order, which is little endian on every Android ABI.
+        void write_ply(chunk_output &out, const std::vector<float> &vertices, const std::vector<float> &normals,
+                       const AHIBSModelPackView<int32_t> &faces) {
+            const std::size_t num_vertices = vertices.size() / 3;
+            const bool short_indices = num_vertices <= 65536;
+            std::string header = "ply\nformat binary_little_endian 1.0\nelement vertex " +
+                                 std::to_string(num_vertices) +
+                                 "\nproperty float x\nproperty float y\nproperty float z\n";
+            if (!normals.empty()) {
+                header += "property float nx\nproperty float ny\nproperty float nz\n";
+            }
+            header += "element face " + std::to_string(faces.size() / 3) + "\nproperty list uchar " +
+                      (short_indices ? "ushort" : "uint") + " vertex_indices\nend_header\n";
+            out.append(header.data(), header.size());
+            if (normals.empty()) {
+                for (std::size_t i = 0; i < vertices.size(); i += 3) {
+                    out.append(vertices.data() + i, 3 * sizeof(float));
+                }
+            } else {
+                for (std::size_t i = 0; i < vertices.size(); i += 3) {
+                    char *at = out.reserve(6 * sizeof(float));
+                    std::memcpy(at, vertices.data() + i, 3 * sizeof(float));
+                    std::memcpy(at + 3 * sizeof(float), normals.data() + i, 3 * sizeof(float));
+                    out.commit(at + 6 * sizeof(float));
+                }
+            }
+            if (short_indices) {
+                write_ply_faces<std::uint16_t>(out, faces);
+            } else {
+                write_ply_faces<std::uint32_t>(out, faces);
+            }
+        }
+    }
+
+    char *mesh_writer::format_float(char *text, float value) {
+        double v = value;
+        if (!(std::fabs(v) < 1e12)) { // nan, inf and values past the fixed point range
+            return text + std::snprintf(text, MAX_FLOAT_CHARS, "%g", v);
+        }
+        std::uint64_t scaled = (std::uint64_t) std::llround(std::fabs(v) * 1e6);
+        if (scaled == 0) {
+            *text++ = '0';
+            return text;
+        }
+        if (v < 0) {
+            *text++ = '-';
+        }
+        text = format_uint(text, scaled / 1000000);
+        int fraction = (int) (scaled % 1000000);
+        if (fraction > 0) {
+            char digits[6];
+            for (int k = 5; k >= 0; k--) {
+                digits[k] = (char) ('0' + fraction % 10);
+                fraction /= 10;
+            }
+            int n = 6;
+            while (digits[n - 1] == '0') {
+                n--;
+            }
+            *text++ = '.';
+            std::memcpy(text, digits, n);
+            text += n;
+        }
+        return text;
+    }
+
+    bool mesh_writer::write(format f, const std::vector<float> &vertices, const std::vector<float> &normals,
+                            const AHIBSModelPackView<int32_t> &faces, const sink &out) {
+        if (vertices.size() % 3 != 0 || faces.size() % 3 != 0 ||
+            (!normals.empty() && normals.size() != vertices.size())) {
+            return false;
+        }
+        chunk_output chunk(out);
+        if (f == format::obj) {
+            write_obj(chunk, vertices, normals, faces);
+        } else {
+            write_ply(chunk, vertices, normals, faces);
+        }
+        return chunk.flush();
+    }
+
+    mesh_writer::sink mesh_writer::to_fd(int fd) {
+        return [fd](const char *data, std::size_t size) {
+            while (size > 0) {
+                ssize_t written = ::write(fd, data, size);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data += written;
+                size -= (std::size_t) written;
+            }
+            return true;
+        };
+    }
+
+    mesh_writer::sink mesh_writer::to_buffer(std::string &buffer) {
+        return [&buffer](const char *data, std::size_t size) {
+            buffer.append(data, size);
+            return true;
+        };
+    }
+}
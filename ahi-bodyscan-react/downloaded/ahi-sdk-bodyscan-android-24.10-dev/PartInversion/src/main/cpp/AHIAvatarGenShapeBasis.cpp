@@ -0,0 +1,135 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "AHIAvatarGenShapeBasis.hpp"
+#include "AvatarGenCommon.hpp"
+
+#include <algorithm>
+#include <future>
+#include <memory>
+
+namespace avatar_gen {
+    namespace {
+        // Panels of a batch block, 64 x 7 x 8 floats (14 KB) stay in L1 while every mesh of the batch reads them.
+        const int BATCH_BLOCK_PANELS = 64;
+    }
+
+    shape_basis::shape_basis(BodyScanCommon::SexType gender, bool inversion_mesh)
+            : m_gender(gender), m_inversion_mesh(inversion_mesh) {
+    }
+
+    shape_basis &shape_basis::get(BodyScanCommon::SexType gender, bool inversion_mesh) {
+        static shape_basis male(BodyScanCommon::SexType::male, false);
+        static shape_basis female(BodyScanCommon::SexType::female, false);
+        static shape_basis male_inv(BodyScanCommon::SexType::male, true);
+        static shape_basis female_inv(BodyScanCommon::SexType::female, true);
+        if (gender == BodyScanCommon::SexType::male) {
+            return inversion_mesh ? male_inv : male;
+        }
+        return inversion_mesh ? female_inv : female;
+    }
+
+    // Packs the basis rows of the model data into the panels, if not done from that data yet. Called under the lock.
+    bool shape_basis::prepare() {
+        const common *c = common::getInstance();
+        AHIBSModelPackView<float> basis = m_inversion_mesh ? c->getSvInv(m_gender) : c->getSv(m_gender);
+        AHIBSModelPackView<float> mean = m_inversion_mesh ? c->getVertsInv(m_gender) : c->getAvgVerts(m_gender);
+        if (basis.rows != mean.size() || basis.cols < N_COEFFS) {
+            return false;
+        }
+        m_mean = mean.data;
+        if (m_source == basis.data) {
+            return true;
+        }
+        m_source = nullptr;
+        m_size = (int) basis.rows;
+        m_num_panels = (m_size + PANEL - 1) / PANEL;
+        m_storage.assign((std::size_t) m_num_panels * N_COEFFS * PANEL + PANEL, 0.0f);
+        void *aligned = m_storage.data();
+        std::size_t space = m_storage.size() * sizeof(float);
+        m_panels = static_cast<float *>(std::align(PANEL * sizeof(float), (std::size_t) m_num_panels * N_COEFFS *
+                                                                          PANEL * sizeof(float), aligned, space));
+        for (int row = 0; row < m_size; row++) {
+            const float *coefficients = basis.row(row);
+            float *panel = m_panels + (std::size_t) (row / PANEL) * N_COEFFS * PANEL;
+            for (int k = 0; k < N_COEFFS; k++) {
+                panel[k * PANEL + row % PANEL] = coefficients[k];
+            }
+        }
+        m_source = basis.data;
+        return true;
+    }
+
+    // out[i] = base[i] + basis[i] . coefficients over the coordinates of the panels. The sums run over the
+    // coefficients in order from zero, as Matrix_times_vector did, and the inner loop is over the panel so it
+    // vectorizes without any horizontal reduction.
+    void shape_basis::panel_range(const float *coefficients, const float *base, float *out, int first_panel,
+                                  int last_panel) const {
+        for (int p = first_panel; p < last_panel; p++) {
+            const float *panel = m_panels + (std::size_t) p * N_COEFFS * PANEL;
+            float sum[PANEL] = {};
+            for (int k = 0; k < N_COEFFS; k++) {
+                const float coefficient = coefficients[k];
+                for (int j = 0; j < PANEL; j++) {
+                    sum[j] += panel[k * PANEL + j] * coefficient;
+                }
+            }
+            const int row = p * PANEL;
+            const int rows = std::min(PANEL, m_size - row);
+            for (int j = 0; j < rows; j++) {
+                out[row + j] = base[row + j] + sum[j];
+            }
+        }
+    }
+
+    void shape_basis::for_panels(int num_threads, const std::function<void(int, int)> &work) const {
+        num_threads = std::max(1, std::min(num_threads, m_num_panels));
+        int per_thread = (m_num_panels + num_threads - 1) / num_threads;
+        std::vector<std::future<void>> workers;
+        for (int t = 1; t < num_threads; t++) {
+            int first = std::min(m_num_panels, t * per_thread);
+            int last = std::min(m_num_panels, first + per_thread);
+            if (first < last) {
+                workers.push_back(std::async(std::launch::async, work, first, last));
+            }
+        }
+        work(0, std::min(m_num_panels, per_thread));
+        for (auto &worker: workers) {
+            worker.get();
+        }
+    }
+
+    bool shape_basis::add_to(const float (&coefficients)[N_COEFFS], std::vector<float> &out, int num_threads) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!prepare() || (int) out.size() != m_size) {
+            return false;
+        }
+        float *vertices = out.data();
+        for_panels(num_threads, [&](int first, int last) {
+            panel_range(coefficients, vertices, vertices, first, last);
+        });
+        return true;
+    }
+
+    bool shape_basis::reconstruct_batch(const std::vector<float> &coefficients, int num_meshes,
+                                        std::vector<float> &out, int num_threads) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (num_meshes < 0 || (int) coefficients.size() < num_meshes * N_COEFFS || !prepare()) {
+            return false;
+        }
+        out.resize((std::size_t) num_meshes * m_size);
+        for_panels(num_threads, [&](int first, int last) {
+            for (int block = first; block < last; block += BATCH_BLOCK_PANELS) {
+                int block_end = std::min(last, block + BATCH_BLOCK_PANELS);
+                for (int m = 0; m < num_meshes; m++) {
+                    panel_range(coefficients.data() + (std::size_t) m * N_COEFFS, m_mean,
+                                out.data() + (std::size_t) m * m_size, block, block_end);
+                }
+            }
+        });
+        return true;
+    }
+}
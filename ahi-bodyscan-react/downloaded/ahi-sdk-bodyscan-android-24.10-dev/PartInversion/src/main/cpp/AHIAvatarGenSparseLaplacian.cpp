@@ -0,0 +1,502 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "AHIAvatarGenSparseLaplacian.hpp"
+#include "AvatarGenCommon.hpp"
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace avatar_gen {
+
+    // Reverse Cuthill-McKee, keeps the fill of the factor of a mesh Laplacian close to its band.
+    void sparse_ldlt::rcm_ordering(const csr_matrix &A) {
+        int n = A.rows;
+        std::vector<int> degree(n);
+        for (int i = 0; i < n; i++) {
+            degree[i] = A.row_ptr[i + 1] - A.row_ptr[i];
+        }
+        std::vector<char> visited(n, 0);
+        std::vector<int> order;
+        order.reserve(n);
+        std::vector<int> neighbours;
+        while ((int) order.size() < n) {
+            // start every connected component from its lowest degree vertex
+            int start = -1;
+            for (int i = 0; i < n; i++) {
+                if (!visited[i] && (start < 0 || degree[i] < degree[start])) {
+                    start = i;
+                }
+            }
+            visited[start] = 1;
+            std::size_t head = order.size();
+            order.push_back(start);
+            while (head < order.size()) {
+                int v = order[head++];
+                neighbours.clear();
+                for (int p = A.row_ptr[v]; p < A.row_ptr[v + 1]; p++) {
+                    int w = A.col_idx[p];
+                    if (!visited[w]) {
+                        visited[w] = 1;
+                        neighbours.push_back(w);
+                    }
+                }
+                std::sort(neighbours.begin(), neighbours.end(), [&](int a, int b) {
+                    return degree[a] < degree[b] || (degree[a] == degree[b] && a < b);
+                });
+                order.insert(order.end(), neighbours.begin(), neighbours.end());
+            }
+        }
+        m_perm.assign(order.rbegin(), order.rend());
+        m_perm_inv.assign(n, 0);
+        for (int k = 0; k < n; k++) {
+            m_perm_inv[m_perm[k]] = k;
+        }
+    }
+
+    bool sparse_ldlt::analyze(const csr_matrix &A) {
+        m_n = 0;
+        m_factorized = false;
+        if (A.rows != A.cols || A.rows <= 0) {
+            return false;
+        }
+        int n = A.rows;
+        rcm_ordering(A);
+
+        // elimination tree and column counts of L (Liu's algorithm, on the upper triangle of P A P^T)
+        m_parent.assign(n, -1);
+        std::vector<int> flag(n, -1);
+        std::vector<int> Lnz(n, 0);
+        for (int k = 0; k < n; k++) {
+            flag[k] = k;
+            int kk = m_perm[k];
+            for (int p = A.row_ptr[kk]; p < A.row_ptr[kk + 1]; p++) {
+                int i = m_perm_inv[A.col_idx[p]];
+                if (i < k) {
+                    for (; flag[i] != k; i = m_parent[i]) {
+                        if (m_parent[i] == -1) {
+                            m_parent[i] = k;
+                        }
+                        Lnz[i]++;
+                        flag[i] = k;
+                    }
+                }
+            }
+        }
+        m_Lp.assign(n + 1, 0);
+        for (int k = 0; k < n; k++) {
+            m_Lp[k + 1] = m_Lp[k] + Lnz[k];
+        }
+        m_Li.assign(m_Lp[n], 0);
+        m_Lx.assign(m_Lp[n], 0.0);
+        m_D.assign(n, 0.0);
+        m_n = n;
+        return true;
+    }
+
+    bool sparse_ldlt::factorize(const csr_matrix &A, const std::vector<double> &diag_shift) {
+        m_factorized = false;
+        int n = m_n;
+        if (n == 0 || A.rows != n) {
+            return false;
+        }
+        std::vector<double> Y(n, 0.0);
+        std::vector<int> pattern(n);
+        std::vector<int> flag(n, -1);
+        std::vector<int> Lnz(n, 0);
+        for (int k = 0; k < n; k++) {
+            // nonzero pattern of row k of L, from the elimination tree
+            int top = n;
+            flag[k] = k;
+            int kk = m_perm[k];
+            for (int p = A.row_ptr[kk]; p < A.row_ptr[kk + 1]; p++) {
+                int i = m_perm_inv[A.col_idx[p]];
+                if (i <= k) {
+                    Y[i] += A.values[p];
+                    int len = 0;
+                    for (; flag[i] != k; i = m_parent[i]) {
+                        pattern[len++] = i;
+                        flag[i] = k;
+                    }
+                    while (len > 0) {
+                        pattern[--top] = pattern[--len];
+                    }
+                }
+            }
+            if (!diag_shift.empty()) {
+                Y[k] += diag_shift[kk];
+            }
+            // sparse triangular solve for row k
+            double a_kk = Y[k];
+            m_D[k] = Y[k];
+            Y[k] = 0.0;
+            for (; top < n; top++) {
+                int i = pattern[top];
+                double yi = Y[i];
+                Y[i] = 0.0;
+                int p2 = m_Lp[i] + Lnz[i];
+                for (int p = m_Lp[i]; p < p2; p++) {
+                    Y[m_Li[p]] -= m_Lx[p] * yi;
+                }
+                double l_ki = yi / m_D[i];
+                m_D[k] -= l_ki * yi;
+                m_Li[p2] = k;
+                m_Lx[p2] = l_ki;
+                Lnz[i]++;
+            }
+            // a pivot cancelled down to round off means a part of the mesh without anchors (singular)
+            if (!(m_D[k] > 1e-12 * a_kk)) {
+                return false;
+            }
+        }
+        m_factorized = true;
+        return true;
+    }
+
+    void sparse_ldlt::solve(std::vector<double> &x, int nrhs) const {
+        int n = m_n;
+        std::vector<double> b((std::size_t) n * nrhs);
+        for (int k = 0; k < n; k++) {
+            for (int c = 0; c < nrhs; c++) {
+                b[k * nrhs + c] = x[m_perm[k] * nrhs + c];
+            }
+        }
+        for (int j = 0; j < n; j++) {
+            for (int p = m_Lp[j]; p < m_Lp[j + 1]; p++) {
+                for (int c = 0; c < nrhs; c++) {
+                    b[m_Li[p] * nrhs + c] -= m_Lx[p] * b[j * nrhs + c];
+                }
+            }
+        }
+        for (int j = 0; j < n; j++) {
+            for (int c = 0; c < nrhs; c++) {
+                b[j * nrhs + c] /= m_D[j];
+            }
+        }
+        for (int j = n - 1; j >= 0; j--) {
+            for (int p = m_Lp[j]; p < m_Lp[j + 1]; p++) {
+                for (int c = 0; c < nrhs; c++) {
+                    b[j * nrhs + c] -= m_Lx[p] * b[m_Li[p] * nrhs + c];
+                }
+            }
+        }
+        for (int k = 0; k < n; k++) {
+            for (int c = 0; c < nrhs; c++) {
+                x[m_perm[k] * nrhs + c] = b[k * nrhs + c];
+            }
+        }
+    }
+
+    laplacian_template &laplacian_template::get(BodyScanCommon::SexType gender) {
+        static laplacian_template male;
+        static laplacian_template female;
+        return gender == BodyScanCommon::SexType::male ? male : female;
+    }
+
+    // Builds the cot weights W (per row in the order of the dense code, so every entry gets the same float sums),
+    // compacts it to the non zero columns and keeps L^T L and L^T (L V) for the solves.
+    void laplacian_template::build(const float (&verts)[BodyScanCommon::N_VERTS_INV][3], float bound,
+                                   const AHIBSModelPackView<int32_t> &rings_as_vector,
+                                   const AHIBSModelPackView<int32_t> &num_of_points_per_ring) {
+        const int N = BodyScanCommon::N_VERTS_INV;
+        std::vector<std::vector<std::pair<int, float>>> W_rows;
+        std::vector<float> row_values(N, 0.0f);
+        std::vector<int> row_cols;
+        int L_ring_total = 0;
+        for (int i = 0; i < N; i++) {
+            const int *ring = rings_as_vector.data + L_ring_total;
+            int Lring = num_of_points_per_ring[i] - 1;
+            L_ring_total = L_ring_total + num_of_points_per_ring[i];
+
+            bool row_valid = false;
+            row_cols.clear();
+            for (int ii = 0; ii < Lring; ii++) {
+                int j = ring[ii] - 1;
+                int k = ring[ii + 1] - 1;
+                if (verts[i][1] < bound || verts[j][1] < bound || verts[k][1] < bound) {
+                    continue;
+                }
+                row_valid = true;
+
+                float u[3], v[3], cross[3];
+                // u = vk-vi; v = vk-vj;
+                u[0] = verts[k][0] - verts[i][0];
+                u[1] = verts[k][1] - verts[i][1];
+                u[2] = verts[k][2] - verts[i][2];
+                v[0] = verts[k][0] - verts[j][0];
+                v[1] = verts[k][1] - verts[j][1];
+                v[2] = verts[k][2] - verts[j][2];
+                float dot = u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
+                cross[0] = u[1] * v[2] - u[2] * v[1];
+                cross[1] = u[2] * v[0] - u[0] * v[2];
+                cross[2] = u[0] * v[1] - u[1] * v[0];
+                float cot1 = dot / sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+                if (std::find(row_cols.begin(), row_cols.end(), j) == row_cols.end()) {
+                    row_cols.push_back(j);
+                }
+                row_values[j] = row_values[j] + cot1;
+                // u = vj-vi; v = vj-vk;
+                u[0] = verts[j][0] - verts[i][0];
+                u[1] = verts[j][1] - verts[i][1];
+                u[2] = verts[j][2] - verts[i][2];
+                v[0] = verts[j][0] - verts[k][0];
+                v[1] = verts[j][1] - verts[k][1];
+                v[2] = verts[j][2] - verts[k][2];
+                dot = u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
+                cross[0] = u[1] * v[2] - u[2] * v[1];
+                cross[1] = u[2] * v[0] - u[0] * v[2];
+                cross[2] = u[0] * v[1] - u[1] * v[0];
+                float cot2 = dot / sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+                if (std::find(row_cols.begin(), row_cols.end(), k) == row_cols.end()) {
+                    row_cols.push_back(k);
+                }
+                row_values[k] = row_values[k] + cot2;
+            }
+            if (row_valid) {
+                std::sort(row_cols.begin(), row_cols.end());
+                std::vector<std::pair<int, float>> row;
+                for (int col: row_cols) {
+                    row.emplace_back(col, row_values[col]);
+                    row_values[col] = 0.0f;
+                }
+                W_rows.push_back(row);
+            }
+        }
+        int N_rows = (int) W_rows.size();
+
+        // keep the non zero columns of W and the corresponding vertices
+        std::vector<float> W_cols_summed(N, 0.0f);
+        for (auto &row: W_rows) {
+            for (auto &entry: row) {
+                W_cols_summed[entry.first] += entry.second;
+            }
+        }
+        std::vector<int> compacted(N, -1);
+        m_V_idx.clear();
+        for (int col = 0; col < N; col++) {
+            if (W_cols_summed[col] != 0) {
+                compacted[col] = (int) m_V_idx.size();
+                m_V_idx.push_back(col);
+            }
+        }
+        int N_cols = (int) m_V_idx.size();
+
+        csr_matrix L;
+        L.rows = N_rows;
+        L.cols = N_cols;
+        L.row_ptr.assign(1, 0);
+        std::vector<float> dense_row;
+        for (int row = 0; row < N_rows; row++) {
+            std::vector<std::pair<int, float>> part;
+            float tmp_sum = 0.0f;
+            float W_row_summed = 0.0f;
+            for (auto &entry: W_rows[row]) {
+                W_row_summed += entry.second;
+                if (compacted[entry.first] >= 0) {
+                    part.emplace_back(compacted[entry.first], entry.second);
+                    tmp_sum = tmp_sum + entry.second;
+                }
+            }
+            tmp_sum = std::abs(tmp_sum);
+            if (tmp_sum > 10000) {
+                // as the dense code did: the first N_rows columns are rescaled from W's own (not compacted) columns
+                dense_row.assign(N_cols, 0.0f);
+                for (auto &entry: part) {
+                    dense_row[entry.first] = entry.second;
+                }
+                for (int col = 0; col < std::min(N_rows, N_cols); col++) {
+                    float W_row_col = 0.0f;
+                    for (auto &entry: W_rows[row]) {
+                        if (entry.first == col) {
+                            W_row_col = entry.second;
+                        }
+                    }
+                    dense_row[col] = W_row_col * 10000.0f / tmp_sum;
+                }
+                part.clear();
+                for (int col = 0; col < N_cols; col++) {
+                    if (dense_row[col] != 0 || col == row) {
+                        part.emplace_back(col, dense_row[col]);
+                    }
+                }
+            }
+            if (row < N_cols) {
+                auto iter = std::lower_bound(part.begin(), part.end(), std::make_pair(row, -INFINITY));
+                if (iter == part.end() || iter->first != row) {
+                    iter = part.insert(iter, std::make_pair(row, 0.0f));
+                }
+                iter->second = iter->second - W_row_summed;
+            }
+            for (auto &entry: part) {
+                L.col_idx.push_back(entry.first);
+                L.values.push_back(entry.second);
+            }
+            L.row_ptr.push_back((int) L.col_idx.size());
+        }
+
+        // delta = L V, then L^T delta
+        std::vector<double> delta((std::size_t) N_rows * 3, 0.0);
+        for (int row = 0; row < N_rows; row++) {
+            for (int p = L.row_ptr[row]; p < L.row_ptr[row + 1]; p++) {
+                const float *v = verts[m_V_idx[L.col_idx[p]]];
+                for (int c = 0; c < 3; c++) {
+                    delta[row * 3 + c] += L.values[p] * v[c];
+                }
+            }
+        }
+        m_Lt_delta.assign((std::size_t) N_cols * 3, 0.0);
+        for (int row = 0; row < N_rows; row++) {
+            for (int p = L.row_ptr[row]; p < L.row_ptr[row + 1]; p++) {
+                for (int c = 0; c < 3; c++) {
+                    m_Lt_delta[L.col_idx[p] * 3 + c] += L.values[p] * delta[row * 3 + c];
+                }
+            }
+        }
+
+        // L^T L, column by column through the transpose of L
+        std::vector<int> Lt_ptr(N_cols + 1, 0);
+        for (int col: L.col_idx) {
+            Lt_ptr[col + 1]++;
+        }
+        for (int col = 0; col < N_cols; col++) {
+            Lt_ptr[col + 1] += Lt_ptr[col];
+        }
+        std::vector<int> Lt_row(L.col_idx.size());
+        std::vector<double> Lt_val(L.col_idx.size());
+        std::vector<int> next(Lt_ptr.begin(), Lt_ptr.end() - 1);
+        for (int row = 0; row < N_rows; row++) {
+            for (int p = L.row_ptr[row]; p < L.row_ptr[row + 1]; p++) {
+                int q = next[L.col_idx[p]]++;
+                Lt_row[q] = row;
+                Lt_val[q] = L.values[p];
+            }
+        }
+        m_LtL = csr_matrix();
+        m_LtL.rows = N_cols;
+        m_LtL.cols = N_cols;
+        m_LtL.row_ptr.assign(1, 0);
+        std::vector<double> accumulator(N_cols, 0.0);
+        std::vector<int> marker(N_cols, -1);
+        std::vector<int> cols;
+        for (int a = 0; a < N_cols; a++) {
+            cols.clear();
+            // the diagonal is always kept, the anchors are added onto it
+            marker[a] = a;
+            cols.push_back(a);
+            for (int q = Lt_ptr[a]; q < Lt_ptr[a + 1]; q++) {
+                int row = Lt_row[q];
+                for (int p = L.row_ptr[row]; p < L.row_ptr[row + 1]; p++) {
+                    int b = L.col_idx[p];
+                    if (marker[b] != a) {
+                        marker[b] = a;
+                        cols.push_back(b);
+                    }
+                    accumulator[b] += Lt_val[q] * L.values[p];
+                }
+            }
+            std::sort(cols.begin(), cols.end());
+            for (int b: cols) {
+                m_LtL.col_idx.push_back(b);
+                m_LtL.values.push_back(accumulator[b]);
+                accumulator[b] = 0.0;
+            }
+            m_LtL.row_ptr.push_back((int) m_LtL.col_idx.size());
+        }
+
+        m_ldlt.analyze(m_LtL);
+        m_factorized_anchors.clear();
+    }
+
+    // Fallback when the normal matrix is not positive definite (some part of the mesh has no anchor).
+    bool laplacian_template::solve_dense(const std::vector<char> &anchors, std::vector<double> &rhs) const {
+        int n = m_LtL.rows;
+        cv::Mat A = cv::Mat::zeros(n, n, CV_64F);
+        for (int row = 0; row < n; row++) {
+            for (int p = m_LtL.row_ptr[row]; p < m_LtL.row_ptr[row + 1]; p++) {
+                A.at<double>(row, m_LtL.col_idx[p]) = m_LtL.values[p];
+            }
+            if (anchors[row]) {
+                A.at<double>(row, row) += 1.0;
+            }
+        }
+        cv::Mat b(n, 3, CV_64F, rhs.data());
+        cv::Mat x;
+        if (!cv::solve(A, b, x, cv::DECOMP_SVD)) {
+            return false;
+        }
+        std::copy(x.ptr<double>(), x.ptr<double>() + (std::size_t) n * 3, rhs.begin());
+        return true;
+    }
+
+    bool laplacian_template::solve(std::vector<float> &OutVertices, BodyScanCommon::SexType gender,
+                                   const AHIBSModelPackView<int32_t> &rings_as_vector,
+                                   const AHIBSModelPackView<int32_t> &num_of_points_per_ring, std::string &error_id) {
+        const common *c = common::getInstance();
+        AHIBSModelPackView<float> template_verts = c->getVertsInv(gender);
+        if (template_verts.size() < BodyScanCommon::N_VERTS_INV_3 ||
+            OutVertices.size() < BodyScanCommon::N_VERTS_INV_3 ||
+            num_of_points_per_ring.size() < BodyScanCommon::N_VERTS_INV) {
+            error_id = "Failed in Laplace: template or vertices size mismatch";
+            return false;
+        }
+        float bound = gender == BodyScanCommon::SexType::male ? 1.57 : 1.48;
+        float th = OutVertices[3 * 3552 + 1]; // over ear point
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_source != template_verts.data) {
+            const float (&verts)[BodyScanCommon::N_VERTS_INV][3] =
+                    *reinterpret_cast<const float (*)[BodyScanCommon::N_VERTS_INV][3]>(template_verts.data);
+            build(verts, bound, rings_as_vector, num_of_points_per_ring);
+            m_source = template_verts.data;
+        }
+        int n = (int) m_V_idx.size();
+        if (n == 0) {
+            error_id.clear();
+            return true;
+        }
+
+        // anchors: every vertex below the ear or in front keeps its position
+        std::vector<char> anchors(n, 0);
+        std::vector<double> rhs(m_Lt_delta);
+        for (int idx = 0; idx < n; idx++) {
+            int j = 3 * m_V_idx[idx];
+            if (OutVertices[j + 1] < th || OutVertices[j + 2] > 0) {
+                anchors[idx] = 1;
+                rhs[idx * 3] += OutVertices[j];
+                rhs[idx * 3 + 1] += OutVertices[j + 1];
+                rhs[idx * 3 + 2] += OutVertices[j + 2];
+            }
+        }
+
+        bool solved = false;
+        if (m_ldlt.is_analyzed()) {
+            if (!m_ldlt.is_factorized() || anchors != m_factorized_anchors) {
+                std::vector<double> shift(anchors.begin(), anchors.end());
+                m_factorized_anchors.clear();
+                if (m_ldlt.factorize(m_LtL, shift)) {
+                    m_factorized_anchors = anchors;
+                }
+            }
+            if (m_ldlt.is_factorized()) {
+                m_ldlt.solve(rhs, 3);
+                solved = true;
+            }
+        }
+        if (!solved && !solve_dense(anchors, rhs)) {
+            error_id = "Failed in Laplace: singular system";
+            return false;
+        }
+
+        for (int idx = 0; idx < n; idx++) {
+            int k = 3 * m_V_idx[idx];
+            OutVertices[k] = (float) rhs[idx * 3];
+            OutVertices[k + 1] = (float) rhs[idx * 3 + 1];
+            OutVertices[k + 2] = (float) rhs[idx * 3 + 2];
+        }
+        error_id.clear();
+        return true;
+    }
+}
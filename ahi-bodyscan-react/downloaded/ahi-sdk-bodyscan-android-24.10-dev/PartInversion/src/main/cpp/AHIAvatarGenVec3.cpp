@@ -6,6 +6,7 @@
 
 #include "AHIAvatarGenVec3.hpp"
 #include <algorithm>
+#include <cmath>
 
 namespace avatar_gen {
     AHIAvatarGenVec3::AHIAvatarGenVec3(float *src) : bFree(false) {
@@ -6,8 +6,51 @@
 
 #include "AvatarGenCommon.hpp"
 
+#include <mutex>
+
 namespace avatar_gen {
 
+    namespace {
+        template<typename T>
+        void set_view(AHIBSModelPackView<T> &view, const T *data, uint32_t rows, uint32_t cols) {
+            view.data = rows * cols == 0 ? nullptr : data;
+            view.rows = rows;
+            view.cols = cols;
+        }
+
+        // Views the blob in place when it is stored as the getters read it, converts it into the model's storage
+        // otherwise (float16 or float64 blobs).
+        bool view_packed(const AHIBSModelPack &pack, const AHIBSModelPackEntry &entry, common_model &model) {
+            if (entry.type == (uint32_t) AHIBSModelPackType::Int32) {
+                model.ints = pack.ints(entry.name);
+                return !model.ints.empty();
+            }
+            model.floats = pack.floats(entry.name);
+            if (!model.floats.empty()) {
+                return true;
+            }
+            if (!pack.copyFloats(entry.name, model.float_storage)) {
+                return false;
+            }
+            set_view(model.floats, model.float_storage.data(), entry.rows, entry.cols);
+            return true;
+        }
+
+        void store_decoded(char *bytes, std::size_t size, common_model &model) {
+            AHIModelCV cv = ahiDecodeCvFromBytes(bytes, size);
+            uint32_t rows = 0;
+            uint32_t cols = 0;
+            if (!ahiModelPackLayoutCv(cv, model.int_storage, model.float_storage, rows, cols)) {
+                return;
+            }
+            if (cv.type == 1) {
+                set_view(model.ints, model.int_storage.data(), rows, cols);
+            } else {
+                set_view(model.floats, model.float_storage.data(), rows, cols);
+            }
+        }
+    }
+
     // Class methods
     common::common(
             BodyScanCommon::SexType gender,
@@ -22,251 +65,185 @@ namespace avatar_gen {
             std::map<std::string, std::pair<char *, std::size_t>> &cvModelsMale,
             std::map<std::string, std::pair<char *, std::size_t>> &cvModelsFemale
     ) {
-        m_models = common_models();
+        m_models.male.clear();
+        m_models.female.clear();
+        m_models.pack.reset();
         for (auto &model : cvModelsMale) {
-            auto cv = ahiDecodeCvFromBytes(model.second.first, model.second.second);
-            m_models.male[model.first] = cv;
+            store_decoded(model.second.first, model.second.second, m_models.male[model.first]);
         }
         for (auto &model : cvModelsFemale) {
-            auto cv = ahiDecodeCvFromBytes(model.second.first, model.second.second);
-            m_models.female[model.first] = cv;
+            store_decoded(model.second.first, model.second.second, m_models.female[model.first]);
+        }
+    }
+
+    common *common::getInstance(BodyScanCommon::SexType gender, std::shared_ptr<const AHIBSModelPack> pack) {
+        static std::mutex mutex;
+        std::map<std::string, std::pair<char *, std::size_t>> cvModelsMale;
+        std::map<std::string, std::pair<char *, std::size_t>> cvModelsFemale;
+        common *instance = getInstance(gender, cvModelsMale, cvModelsFemale);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pack != nullptr && instance->m_models.male.empty() && instance->m_models.female.empty()) {
+            instance->setModels(std::move(pack));
+        }
+        return instance;
+    }
+
+    // The pack names the CV models as their resources: <name>_male, <name>_female, or <name> for both genders.
+    void common::setModels(std::shared_ptr<const AHIBSModelPack> pack) {
+        const std::string maleSuffix = "_male";
+        const std::string femaleSuffix = "_female";
+        auto endsWith = [](const std::string &name, const std::string &suffix) {
+            return name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+        };
+        m_models.male.clear();
+        m_models.female.clear();
+        m_models.pack = std::move(pack);
+        for (const AHIBSModelPackEntry *entry : m_models.pack->entries()) {
+            if (entry->model == 0) {
+                continue;
+            }
+            std::string name = entry->name;
+            if (endsWith(name, maleSuffix)) {
+                view_packed(*m_models.pack, *entry, m_models.male[name.substr(0, name.size() - maleSuffix.size())]);
+            } else if (endsWith(name, femaleSuffix)) {
+                view_packed(*m_models.pack, *entry,
+                            m_models.female[name.substr(0, name.size() - femaleSuffix.size())]);
+            } else {
+                view_packed(*m_models.pack, *entry, m_models.male[name]);
+                view_packed(*m_models.pack, *entry, m_models.female[name]);
+            }
+        }
+    }
+
+    const common_model &common::model(BodyScanCommon::SexType gender, const std::string &name) const {
+        if (gender == BodyScanCommon::SexType::male) {
+            return m_models.male.at(name);
+        } else {
+            return m_models.female.at(name);
         }
     }
 
-    std::vector<int> &common::getInvRightCalf() const {
-        return const_cast<std::vector<int> &>(m_models.male.at("InvRightCalf").vi);
+    AHIBSModelPackView<int32_t> common::getInvRightCalf() const {
+        return model(BodyScanCommon::SexType::male, "InvRightCalf").ints;
     }
 
-    std::vector<int> &common::getInvRightThigh() const {
-        return const_cast<std::vector<int> &>(m_models.male.at("InvRightThigh").vi);
+    AHIBSModelPackView<int32_t> common::getInvRightThigh() const {
+        return model(BodyScanCommon::SexType::male, "InvRightThigh").ints;
     }
 
-    std::vector<int> &common::getInvRightUpperArm() const {
-        return const_cast<std::vector<int> &>(m_models.male.at("InvRightUpperArm").vi);
+    AHIBSModelPackView<int32_t> common::getInvRightUpperArm() const {
+        return model(BodyScanCommon::SexType::male, "InvRightUpperArm").ints;
     }
 
-
-    std::vector<float> common::getMvnMu() const {
-        if (m_gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<float> &>(m_models.male.at("MvnMu").vf);
-        } else {
-            return const_cast<std::vector<float> &>(m_models.female.at("MvnMu").vf);
-        }
+    AHIBSModelPackView<float> common::getMvnMu() const {
+        return model(m_gender, "MvnMu").floats;
     }
 
-    std::vector<float> common::getMvnMu(BodyScanCommon::SexType gender) const {
-        if (gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<float> &>(m_models.male.at("MvnMu").vf);
-        } else {
-            return const_cast<std::vector<float> &>(m_models.female.at("MvnMu").vf);
-        }
+    AHIBSModelPackView<float> common::getMvnMu(BodyScanCommon::SexType gender) const {
+        return model(gender, "MvnMu").floats;
     }
 
-    std::vector<std::vector<float> > &common::getRanges() const {
-        if (m_gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.male.at("Ranges").vvf);
-        } else {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.female.at("Ranges").vvf);
-        }
+    AHIBSModelPackView<float> common::getRanges() const {
+        return model(m_gender, "Ranges").floats;
     }
 
-    std::vector<std::vector<float> > &common::getRanges(BodyScanCommon::SexType gender) const {
-        if (gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.male.at("Ranges").vvf);
-        } else {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.female.at("Ranges").vvf);
-        }
+    AHIBSModelPackView<float> common::getRanges(BodyScanCommon::SexType gender) const {
+        return model(gender, "Ranges").floats;
     }
 
-    std::vector<std::vector<float> > &common::getCov() const {
-        if (m_gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.male.at("Cov").vvf);
-        } else {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.female.at("Cov").vvf);
-        }
+    AHIBSModelPackView<float> common::getCov() const {
+        return model(m_gender, "Cov").floats;
     }
 
-    std::vector<std::vector<float> > &common::getCov(BodyScanCommon::SexType gender) const {
-        if (gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.male.at("Cov").vvf);
-        } else {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.female.at("Cov").vvf);
-        }
+    AHIBSModelPackView<float> common::getCov(BodyScanCommon::SexType gender) const {
+        return model(gender, "Cov").floats;
     }
 
-    std::vector<float> &common::getAvgVerts() const {
-        if (m_gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<float> &>(m_models.male.at("AvgVerts").vf);
-        } else {
-            return const_cast<std::vector<float> &>(m_models.female.at("AvgVerts").vf);
-        }
+    AHIBSModelPackView<float> common::getAvgVerts() const {
+        return model(m_gender, "AvgVerts").floats;
     }
 
-    std::vector<float> &common::getAvgVerts(BodyScanCommon::SexType gender) const {
-        if (gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<float> &>(m_models.male.at("AvgVerts").vf);
-        } else {
-            return const_cast<std::vector<float> &>(m_models.female.at("AvgVerts").vf);
-        }
+    AHIBSModelPackView<float> common::getAvgVerts(BodyScanCommon::SexType gender) const {
+        return model(gender, "AvgVerts").floats;
     }
 
-    std::vector<float> &common::getVertsInv() const {
-        if (m_gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<float> &>(m_models.male.at("VertsInv").vf);
-        } else {
-            return const_cast<std::vector<float> &>(m_models.female.at("VertsInv").vf);
-        }
+    AHIBSModelPackView<float> common::getVertsInv() const {
+        return model(m_gender, "VertsInv").floats;
     }
 
-    std::vector<float> &common::getVertsInv(BodyScanCommon::SexType gender) const {
-        if (gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<float> &>(m_models.male.at("VertsInv").vf);
-        } else {
-            return const_cast<std::vector<float> &>(m_models.female.at("VertsInv").vf);
-        }
+    AHIBSModelPackView<float> common::getVertsInv(BodyScanCommon::SexType gender) const {
+        return model(gender, "VertsInv").floats;
     }
 
-    std::vector<int> &common::getFaces() const {
-        if (m_gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<int> &>(m_models.male.at("Faces").vi);
-        } else {
-            return const_cast<std::vector<int> &>(m_models.female.at("Faces").vi);
-        }
+    AHIBSModelPackView<int32_t> common::getFaces() const {
+        return model(m_gender, "Faces").ints;
     }
 
-    std::vector<int> &common::getFaces(BodyScanCommon::SexType gender) const {
-        if (gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<int> &>(m_models.male.at("Faces").vi);
-        } else {
-            return const_cast<std::vector<int> &>(m_models.female.at("Faces").vi);
-        }
+    AHIBSModelPackView<int32_t> common::getFaces(BodyScanCommon::SexType gender) const {
+        return model(gender, "Faces").ints;
     }
 
-    std::vector<int> &common::getFacesInv() const {
-        if (m_gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<int> &>(m_models.male.at("FacesInv").vi);
-        } else {
-            return const_cast<std::vector<int> &>(m_models.female.at("FacesInv").vi);
-        }
+    AHIBSModelPackView<int32_t> common::getFacesInv() const {
+        return model(m_gender, "FacesInv").ints;
     }
 
-    std::vector<int> &common::getFacesInv(BodyScanCommon::SexType gender) const {
-        if (gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<int> &>(m_models.male.at("FacesInv").vi);
-        } else {
-            return const_cast<std::vector<int> &>(m_models.female.at("FacesInv").vi);
-        }
+    AHIBSModelPackView<int32_t> common::getFacesInv(BodyScanCommon::SexType gender) const {
+        return model(gender, "FacesInv").ints;
     }
 
-    std::vector<std::vector<float> > &common::getSv() const {
-        if (m_gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.male.at("Sv").vvf);
-        } else {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.female.at("Sv").vvf);
-        }
+    AHIBSModelPackView<float> common::getSv() const {
+        return model(m_gender, "Sv").floats;
     }
 
-    std::vector<std::vector<float> > &common::getSv(BodyScanCommon::SexType gender) const {
-        if (gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.male.at("Sv").vvf);
-        } else {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.female.at("Sv").vvf);
-        }
+    AHIBSModelPackView<float> common::getSv(BodyScanCommon::SexType gender) const {
+        return model(gender, "Sv").floats;
     }
 
-    std::vector<std::vector<float> > &common::getSvInv() const {
-        if (m_gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.male.at("SvInv").vvf);
-        } else {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.female.at("SvInv").vvf);
-        }
+    AHIBSModelPackView<float> common::getSvInv() const {
+        return model(m_gender, "SvInv").floats;
     }
 
-    std::vector<std::vector<float> > &common::getSvInv(BodyScanCommon::SexType gender) const {
-        if (gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.male.at("SvInv").vvf);
-        } else {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.female.at("SvInv").vvf);
-        }
+    AHIBSModelPackView<float> common::getSvInv(BodyScanCommon::SexType gender) const {
+        return model(gender, "SvInv").floats;
     }
 
-    std::vector<std::vector<float> > &common::getSkV() const {
-        if (m_gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.male.at("SkV").vvf);
-        } else {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.female.at("SkV").vvf);
-        }
+    AHIBSModelPackView<float> common::getSkV() const {
+        return model(m_gender, "SkV").floats;
     }
 
-    std::vector<std::vector<float> > &common::getSkV(BodyScanCommon::SexType gender) const {
-        if (gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.male.at("SkV").vvf);
-        } else {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.female.at("SkV").vvf);
-        }
+    AHIBSModelPackView<float> common::getSkV(BodyScanCommon::SexType gender) const {
+        return model(gender, "SkV").floats;
     }
 
-    std::vector<std::vector<float> > &common::getBonW() const {
-        if (m_gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.male.at("BonW").vvf);
-        } else {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.female.at("BonW").vvf);
-        }
+    AHIBSModelPackView<float> common::getBonW() const {
+        return model(m_gender, "BonW").floats;
     }
 
-    std::vector<std::vector<float> > &common::getBonW(BodyScanCommon::SexType gender) const {
-        if (gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.male.at("BonW").vvf);
-        } else {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.female.at("BonW").vvf);
-        }
+    AHIBSModelPackView<float> common::getBonW(BodyScanCommon::SexType gender) const {
+        return model(gender, "BonW").floats;
     }
 
-    std::vector<std::vector<float> > &common::getBonWInv() const {
-        if (m_gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.male.at("BonWInv").vvf);
-        } else {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.female.at("BonWInv").vvf);
-        }
+    AHIBSModelPackView<float> common::getBonWInv() const {
+        return model(m_gender, "BonWInv").floats;
     }
 
-    std::vector<std::vector<float> > &common::getBonWInv(BodyScanCommon::SexType gender) const {
-        if (gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.male.at("BonWInv").vvf);
-        } else {
-            return const_cast<std::vector<std::vector<float>> &>(m_models.female.at("BonWInv").vvf);
-        }
+    AHIBSModelPackView<float> common::getBonWInv(BodyScanCommon::SexType gender) const {
+        return model(gender, "BonWInv").floats;
     }
 
-    std::vector<int> &common::getLaplacianRings() const {
-        if (m_gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<int> &>(m_models.male.at("LaplacianRings").vi);
-        } else {
-            return const_cast<std::vector<int> &>(m_models.female.at("LaplacianRings").vi);
-        }
+    AHIBSModelPackView<int32_t> common::getLaplacianRings() const {
+        return model(m_gender, "LaplacianRings").ints;
     }
 
-    std::vector<int> &common::getLaplacianRings(BodyScanCommon::SexType gender) const {
-        if (gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<int> &>(m_models.male.at("LaplacianRings").vi);
-        } else {
-            return const_cast<std::vector<int> &>(m_models.female.at("LaplacianRings").vi);
-        }
+    AHIBSModelPackView<int32_t> common::getLaplacianRings(BodyScanCommon::SexType gender) const {
+        return model(gender, "LaplacianRings").ints;
     }
 
-    std::vector<int> &common::getLaplacianRingsAsVectors() const {
-        if (m_gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<int> &>(m_models.male.at("LaplacianRingsAsVectors").vi);
-        } else {
-            return const_cast<std::vector<int> &>(m_models.female.at("LaplacianRingsAsVectors").vi);
-        }
+    AHIBSModelPackView<int32_t> common::getLaplacianRingsAsVectors() const {
+        return model(m_gender, "LaplacianRingsAsVectors").ints;
     }
 
-    std::vector<int> &common::getLaplacianRingsAsVectors(BodyScanCommon::SexType gender) const {
-        if (gender == BodyScanCommon::SexType::male) {
-            return const_cast<std::vector<int> &>(m_models.male.at("LaplacianRingsAsVectors").vi);
-        } else {
-            return const_cast<std::vector<int> &>(m_models.female.at("LaplacianRingsAsVectors").vi);
-        }
+    AHIBSModelPackView<int32_t> common::getLaplacianRingsAsVectors(BodyScanCommon::SexType gender) const {
+        return model(gender, "LaplacianRingsAsVectors").ints;
     }
-}
\ No newline at end of file
+}
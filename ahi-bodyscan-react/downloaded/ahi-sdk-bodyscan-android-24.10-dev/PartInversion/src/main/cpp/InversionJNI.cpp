@@ -6,10 +6,23 @@
 
 #include <jni.h>
 #include <string>
+#include <fcntl.h>
+#include <unistd.h>
 #include <AHIAvatarGenInversion.hpp>
 #include <jnihelper/JNIHelper.hpp>
 #include "AvatarGenCommon.hpp"
 
+extern "C"
+JNIEXPORT jint JNICALL
+JNI_OnLoad(JavaVM *vm, void *reserved) {
+    JNIEnv *env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        return JNI_ERR;
+    }
+    JNIHelper::onLoad(env);
+    return JNI_VERSION_1_6;
+}
+
 extern "C"
 JNIEXPORT jstring JNICALL
 Java_com_advancedhumanimaging_sdk_bodyscan_partinversion_InversionJNI_invert(
@@ -30,14 +43,89 @@ Java_com_advancedhumanimaging_sdk_bodyscan_partinversion_InversionJNI_invert(
     auto cvModelsMapFemale = JNIHelper::javaModelsMapToCpp(env, cv_models_female);
     avatar_gen::inversion invert;
     std::string errorString;
-    std::vector<std::string> mesh = invert.invert(nativeSex, (float) height_cm, (float) weight_kg,
-                                                  (float) chest_cm, (float) waist_cm,
-                                                  (float) hip_cm, (float) inseam_cm,
-                                                  (float) fitness, errorString,
-                                                  cvModelsMapMale, cvModelsMapFemale, ' ');
-    std::ostringstream result;
-    for (const auto &a : mesh) {
-        result << a << '\n';
+    std::string mesh;
+    if (!invert.invert(nativeSex, (float) height_cm, (float) weight_kg, (float) chest_cm, (float) waist_cm,
+                       (float) hip_cm, (float) inseam_cm, (float) fitness, errorString, cvModelsMapMale->models,
+                       cvModelsMapFemale->models, avatar_gen::mesh_writer::format::obj, false,
+                       avatar_gen::mesh_writer::to_buffer(mesh))) {
+        mesh.clear();
+    }
+    return env->NewStringUTF(mesh.c_str());
+}
+
+// Writes the mesh straight to the file at path, OBJ or binary PLY with normals, without going through a Java string.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partinversion_InversionJNI_invertToFile(
+        JNIEnv *env,
+        jobject thiz,
+        jobject sex,
+        jdouble height_cm,
+        jdouble weight_kg,
+        jdouble chest_cm,
+        jdouble waist_cm,
+        jdouble hip_cm,
+        jdouble inseam_cm,
+        jdouble fitness,
+        jobject cv_models_male,
+        jobject cv_models_female,
+        jstring path,
+        jboolean binary) {
+    BodyScanCommon::SexType nativeSex = JNIHelper().getNativeSexType(env, sex);
+    auto cvModelsMapMale = JNIHelper::javaModelsMapToCpp(env, cv_models_male);
+    auto cvModelsMapFemale = JNIHelper::javaModelsMapToCpp(env, cv_models_female);
+    const char *nativePath = env->GetStringUTFChars(path, nullptr);
+    int fd = open(nativePath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    env->ReleaseStringUTFChars(path, nativePath);
+    if (fd < 0) {
+        return JNI_FALSE;
+    }
+    avatar_gen::inversion invert;
+    std::string errorString;
+    avatar_gen::mesh_writer::format format =
+            binary ? avatar_gen::mesh_writer::format::ply_binary : avatar_gen::mesh_writer::format::obj;
+    bool written = invert.invert(nativeSex, (float) height_cm, (float) weight_kg, (float) chest_cm,
+                                 (float) waist_cm, (float) hip_cm, (float) inseam_cm, (float) fitness, errorString,
+                                 cvModelsMapMale->models, cvModelsMapFemale->models, format, binary == JNI_TRUE,
+                                 avatar_gen::mesh_writer::to_fd(fd));
+    if (close(fd) != 0) {
+        written = false;
+    }
+    return written ? JNI_TRUE : JNI_FALSE;
+}
+// The avatar models are viewed in the pack from then on; the cereal maps invert is handed may be left empty.
+static jboolean useModelPack(std::shared_ptr<const AHIBSModelPack> pack) {
+    if (pack == nullptr) {
+        return JNI_FALSE;
+    }
+    avatar_gen::common::getInstance(BodyScanCommon::SexType::male, std::move(pack));
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partinversion_InversionJNI_openModelPack(
+        JNIEnv *env,
+        jobject thiz,
+        jstring path) {
+    const char *nativePath = env->GetStringUTFChars(path, nullptr);
+    std::string error;
+    std::shared_ptr<const AHIBSModelPack> pack = AHIBSModelPack::open(nativePath, true, error);
+    env->ReleaseStringUTFChars(path, nativePath);
+    return useModelPack(std::move(pack));
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_advancedhumanimaging_sdk_bodyscan_partinversion_InversionJNI_openModelPackFd(
+        JNIEnv *env,
+        jobject thiz,
+        jint fd,
+        jlong offset,
+        jlong length) {
+    if (fd < 0 || offset < 0 || length <= 0) {
+        return JNI_FALSE;
     }
-    return env->NewStringUTF(result.str().c_str());
-}
\ No newline at end of file
+    std::string error;
+    return useModelPack(AHIBSModelPack::open(fd, (uint64_t) offset, (uint64_t) length, true, error));
+}
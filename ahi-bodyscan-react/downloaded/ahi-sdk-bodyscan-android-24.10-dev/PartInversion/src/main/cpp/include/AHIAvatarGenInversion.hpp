@@ -10,6 +10,7 @@
 #include <opencv2/imgproc/imgproc.hpp>
 #include "AHIAvatarGenVec3.hpp"
 #include "AHIAvatarGenFace.hpp"
+#include "AHIAvatarGenMeshWriter.hpp"
 #include "Common.hpp"
 #include <map>
 
@@ -26,24 +27,23 @@ namespace avatar_gen {
                float Chest,
                float Waist, float Hip, float Inseam, float Fitness, std::string &errorString);
 
-        std::vector<std::string>
-        invert(BodyScanCommon::SexType Gender,
-               float H,
-               float W,
-               float Chest,
-               float Waist,
-               float Hip,
-               float Inseam,
-               float Fitness,
-               std::string &errorString,
+        // The mesh of invert() serialized into out as it is formatted, with the vertex normals if with_normals.
+        bool
+        invert(BodyScanCommon::SexType Gender, float H, float W, float Chest, float Waist, float Hip, float Inseam,
+               float Fitness, std::string &errorString,
                std::map<std::string, std::pair<char *, std::size_t>> &cvModelsMale,
                std::map<std::string, std::pair<char *, std::size_t>> &cvModelsFemale,
-               const char delim = '\n'
-        );
+               mesh_writer::format format, bool with_normals, const mesh_writer::sink &out);
+
+        void compute_part_laplacian_cot_weights(std::vector<float> &OutVertices,
+                                                BodyScanCommon::SexType gender,
+                                                const AHIBSModelPackView<int32_t> &rings_as_vector,
+                                                const AHIBSModelPackView<int32_t> &num_of_points_per_ring,
+                                                std::string &error_id);
 
         void wrap_vertices(std::vector<AHIAvatarGenVec3> &dest, std::vector<float> &src);
 
-        void wrap_faces(std::vector<AHIAvatarGenFace> &dest, std::vector<int> &src);
+        void wrap_faces(std::vector<AHIAvatarGenFace> &dest, const AHIBSModelPackView<int32_t> &src);
 
         void create_normals(std::vector<float> &Out, std::vector<AHIAvatarGenVec3> &Vertices,
                             std::vector<AHIAvatarGenFace> &Faces);
@@ -67,12 +67,6 @@ namespace avatar_gen {
         std::vector<float> ArcLength(const std::vector<float> &Vi, float theta_RA, float theta_RL,
                                      std::string &error_id);
 
-        void compute_part_laplacian_cot_weights(std::vector<float> &OutVertices,
-                                                BodyScanCommon::SexType gender,
-                                                const std::vector<int> &rings_as_vector,
-                                                const std::vector<int> &num_of_points_per_ring,
-                                                std::string &error_id);
-
         void gen_points_for_ransac(const std::vector<float> &ChestsIn,
                                    const std::vector<float> &WaistsIn,
                                    const std::vector<float> &HipsIn,
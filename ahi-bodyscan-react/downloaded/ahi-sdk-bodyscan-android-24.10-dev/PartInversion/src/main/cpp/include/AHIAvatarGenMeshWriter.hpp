@@ -0,0 +1,47 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef AHIAvatarGenMeshWriter_hpp
+#define AHIAvatarGenMeshWriter_hpp
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <AHIBSModelPack.hpp>
+
+namespace avatar_gen {
+
+    // Serializes a mesh straight from its vertex, normal and face arrays, formatted into one fixed chunk that is handed
+    // to a sink whenever it fills up, so no per line strings nor a copy of the whole file are made.
+    class mesh_writer {
+    public:
+        enum class format {
+            obj,       // "v x y z", "vn x y z" if there are normals, then "f a b c" (1-based, "f a//a ..." with normals)
+            ply_binary // little endian PLY: float32 positions and normals, uint16 indices (uint32 past 65535 vertices)
+        };
+
+        // Receives the serialized bytes in order, false to stop the write.
+        typedef std::function<bool(const char *data, std::size_t size)> sink;
+
+        // normals may be empty, or one per vertex. False if the sink failed.
+        static bool write(format f, const std::vector<float> &vertices, const std::vector<float> &normals,
+                          const AHIBSModelPackView<int32_t> &faces, const sink &out);
+
+        // Sink writing to a file descriptor the caller owns, retrying short and interrupted writes.
+        static sink to_fd(int fd);
+
+        // Sink appending to a caller buffer.
+        static sink to_buffer(std::string &buffer);
+
+        // Shortest text of value at 6 decimals ("-0.012", "1", "0"), the precision of the mesh coordinates in meters.
+        // Writes at most MAX_FLOAT_CHARS to text and returns the end of the written text.
+        static char *format_float(char *text, float value);
+
+        static constexpr int MAX_FLOAT_CHARS = 32;
+    };
+}
+
+#endif /* AHIAvatarGenMeshWriter_hpp */
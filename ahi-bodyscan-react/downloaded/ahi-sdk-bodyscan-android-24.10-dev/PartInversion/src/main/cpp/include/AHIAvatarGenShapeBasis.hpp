@@ -0,0 +1,64 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef AHIAvatarGenShapeBasis_hpp
+#define AHIAvatarGenShapeBasis_hpp
+
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <Common.hpp>
+
+// Threads the shape basis projection of a mesh is split over (1 keeps it on the calling thread).
+#ifndef AHI_SHAPE_BASIS_THREADS
+#define AHI_SHAPE_BASIS_THREADS 1
+#endif
+
+namespace avatar_gen {
+
+    // The shape basis (Sv or SvInv) of a gender packed for basis * coefficients: rows in panels of PANEL coordinates,
+    // each panel storing its N_COEFFS columns one after the other, so a column of a panel is one aligned run of floats
+    // the coefficient is broadcast over. Built once per gender and mesh from the model data, rebuilt if it is reloaded.
+    class shape_basis {
+    public:
+        static constexpr int N_COEFFS = 7;
+        static constexpr int PANEL = 8;
+
+        static shape_basis &get(BodyScanCommon::SexType gender, bool inversion_mesh);
+
+        // out[i] += basis[i] . coefficients over the size() coordinates of out. False if out is not the basis size.
+        bool add_to(const float (&coefficients)[N_COEFFS], std::vector<float> &out,
+                    int num_threads = AHI_SHAPE_BASIS_THREADS);
+
+        // Mean mesh plus basis * coefficients for num_meshes coefficient sets, coefficients[m * N_COEFFS + k] giving
+        // out[m * size + i]. The basis is read once per block of panels for all the meshes.
+        bool reconstruct_batch(const std::vector<float> &coefficients, int num_meshes, std::vector<float> &out,
+                               int num_threads = AHI_SHAPE_BASIS_THREADS);
+
+    private:
+        shape_basis(BodyScanCommon::SexType gender, bool inversion_mesh);
+
+        bool prepare();
+
+        void panel_range(const float *coefficients, const float *base, float *out, int first_panel,
+                         int last_panel) const;
+
+        // Runs work(first_panel, last_panel) over the panels split in num_threads ranges, the first on this thread.
+        void for_panels(int num_threads, const std::function<void(int, int)> &work) const;
+
+        BodyScanCommon::SexType m_gender;
+        bool m_inversion_mesh;
+        std::mutex m_mutex;
+        const void *m_source = nullptr; // basis the panels were built from
+        int m_size = 0;                 // coordinates, 3 per vertex
+        int m_num_panels = 0;
+        std::vector<float> m_storage;
+        float *m_panels = nullptr;      // m_storage aligned to a panel
+        const float *m_mean = nullptr;
+    };
+}
+
+#endif /* AHIAvatarGenShapeBasis_hpp */
@@ -0,0 +1,63 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef AHIAvatarGenSkinning_hpp
+#define AHIAvatarGenSkinning_hpp
+
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <Common.hpp>
+#include <AHIBSModelPack.hpp>
+
+namespace avatar_gen {
+
+    // Linear blend skinning of a gender's mean mesh over the 17 bones of its skeleton. The bone weights (BonW, or BonWInv
+    // for the inversion mesh) are kept sparse: the non zero (bone, weight) pairs of each vertex, most vertices having
+    // only a few. Built once per gender and mesh, rebuilt if the model data is reloaded.
+    class skinning {
+    public:
+        static constexpr int N_BONES = 17;
+
+        // Rows of [R | t] of a bone, taking p to R p + t.
+        struct bone_transform {
+            float m[12];
+        };
+
+        // Bone transforms of a pose, computed once and applied to every vertex: the feet rotated about y around their
+        // joints, then the arms and legs rotated about z around theirs.
+        struct pose {
+            bone_transform feet[N_BONES];
+            bone_transform limbs[N_BONES];
+        };
+
+        // thetas_pose: right arm, left arm, right leg, left leg. thetas_feet: right foot, left foot.
+        static bool make_pose(const AHIBSModelPackView<float> &skeleton, const std::vector<float> &thetas_pose,
+                              const std::vector<float> &thetas_feet, pose &out);
+
+        static skinning &get(BodyScanCommon::SexType gender, bool inversion_mesh);
+
+        // The mean mesh deformed by the pose into out, resized to it. False if the weights do not match the mesh.
+        bool deform(const pose &p, std::vector<float> &out);
+
+    private:
+        skinning(BodyScanCommon::SexType gender, bool inversion_mesh);
+
+        bool prepare();
+
+        BodyScanCommon::SexType m_gender;
+        bool m_inversion_mesh;
+        std::mutex m_mutex;
+        const void *m_source = nullptr; // weights the sparse lists were built from
+        const float *m_mean = nullptr;
+        int m_num_verts = 0;
+        std::vector<int> m_offsets;     // vertex v weights are [m_offsets[v], m_offsets[v + 1])
+        std::vector<std::uint8_t> m_bones;
+        std::vector<float> m_weights;
+    };
+}
+
+#endif /* AHIAvatarGenSkinning_hpp */
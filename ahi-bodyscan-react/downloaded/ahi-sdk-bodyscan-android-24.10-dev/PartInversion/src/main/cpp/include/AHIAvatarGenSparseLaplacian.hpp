@@ -0,0 +1,88 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef AHIAvatarGenSparseLaplacian_hpp
+#define AHIAvatarGenSparseLaplacian_hpp
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <Common.hpp>
+#include <AHIBSModelPack.hpp>
+
+namespace avatar_gen {
+
+    // Compressed sparse row matrix. A symmetric matrix stored with its full pattern is also its own CSC.
+    struct csr_matrix {
+        int rows = 0;
+        int cols = 0;
+        std::vector<int> row_ptr;
+        std::vector<int> col_idx;
+        std::vector<double> values;
+    };
+
+    // Sparse LDL^T of a symmetric positive definite matrix, under a reverse Cuthill-McKee ordering.
+    // analyze() only depends on the pattern, so it is done once and factorize() is rerun for new values.
+    class sparse_ldlt {
+    public:
+        bool analyze(const csr_matrix &A);
+
+        // Factorizes A + diag(diag_shift) (diag_shift may be empty). False if the matrix is not positive definite.
+        bool factorize(const csr_matrix &A, const std::vector<double> &diag_shift);
+
+        // Solves in place for nrhs right hand sides stored interleaved, x[i * nrhs + c].
+        void solve(std::vector<double> &x, int nrhs) const;
+
+        bool is_analyzed() const { return m_n > 0; }
+
+        bool is_factorized() const { return m_factorized; }
+
+    private:
+        void rcm_ordering(const csr_matrix &A);
+
+        int m_n = 0;
+        bool m_factorized = false;
+        std::vector<int> m_perm;      // new -> old
+        std::vector<int> m_perm_inv;  // old -> new
+        std::vector<int> m_parent;    // elimination tree
+        std::vector<int> m_Lp;
+        std::vector<int> m_Li;
+        std::vector<double> m_Lx;
+        std::vector<double> m_D;
+    };
+
+    // The part of the cot weights Laplacian solve of inversion that only depends on the gender template (vertices
+    // and rings), built once per gender: the compacted Laplacian L in CSR, L^T L, L^T delta and the symbolic
+    // factorization of L^T L. Per scan only the anchors change; the numeric factorization is kept for the last anchor set.
+    class laplacian_template {
+    public:
+        static laplacian_template &get(BodyScanCommon::SexType gender);
+
+        // Same output as the dense normal equations solve of compute_part_laplacian_cot_weights.
+        bool solve(std::vector<float> &OutVertices, BodyScanCommon::SexType gender,
+                   const AHIBSModelPackView<int32_t> &rings_as_vector,
+                   const AHIBSModelPackView<int32_t> &num_of_points_per_ring, std::string &error_id);
+
+    private:
+        laplacian_template() = default;
+
+        void build(const float (&verts)[BodyScanCommon::N_VERTS_INV][3], float bound,
+                   const AHIBSModelPackView<int32_t> &rings_as_vector,
+                   const AHIBSModelPackView<int32_t> &num_of_points_per_ring);
+
+        bool solve_dense(const std::vector<char> &anchors, std::vector<double> &rhs) const;
+
+        std::mutex m_mutex;
+        const void *m_source = nullptr; // template vertices the cache was built from
+        std::vector<int> m_V_idx;       // compacted column -> vertex
+        csr_matrix m_LtL;
+        std::vector<double> m_Lt_delta; // V_idx.size() x 3
+        sparse_ldlt m_ldlt;
+        std::vector<char> m_factorized_anchors;
+    };
+}
+
+#endif /* AHIAvatarGenSparseLaplacian_hpp */
@@ -10,14 +10,32 @@
 #include <stdio.h>
 #include <vector>
 #include <map>
+#include <memory>
 #include <AHIBSCereal.hpp>
+#include <AHIBSModelPack.hpp>
 #include "Common.hpp"
 
 namespace avatar_gen {
 
+    // A CV model as the getters hand it out: rows x cols values in row order (a vector is one column), viewed in place
+    // in the model pack it was opened from, or in the storage it was decoded to from its cereal resource.
+    struct common_model {
+        AHIBSModelPackView<float> floats;
+        AHIBSModelPackView<int32_t> ints;
+        std::vector<float> float_storage;
+        std::vector<int32_t> int_storage;
+
+        common_model() = default;
+
+        common_model(const common_model &) = delete;
+
+        common_model &operator=(const common_model &) = delete;
+    };
+
     struct common_models {
-        std::map<std::string, AHIModelCV> male;
-        std::map<std::string, AHIModelCV> female;
+        std::map<std::string, common_model> male;
+        std::map<std::string, common_model> female;
+        std::shared_ptr<const AHIBSModelPack> pack; // kept mapped while the views point into it
     };
 
     class common {
@@ -39,6 +57,11 @@ namespace avatar_gen {
                 std::map<std::string, std::pair<char *, std::size_t>> &cvModelsFemale
         );
 
+        void setModels(std::shared_ptr<const AHIBSModelPack> pack);
+
+        // Throws std::out_of_range if the model was not loaded.
+        const common_model &model(BodyScanCommon::SexType gender, const std::string &name) const;
+
     public:
         // Singleton methods
         static common *getInstance(
@@ -50,74 +73,78 @@ namespace avatar_gen {
             return &instance;
         }
 
+        // The instance viewing its CV models in the pack, which it keeps mapped. A pack is only taken while no models
+        // are loaded, the instance keeps the models it already has otherwise.
+        static common *getInstance(BodyScanCommon::SexType gender, std::shared_ptr<const AHIBSModelPack> pack);
+
         static common *getInstance() {
             std::map<std::string, std::pair<char *, std::size_t>> cvModelsMale;
             std::map<std::string, std::pair<char *, std::size_t>> cvModelsFemale;
             return getInstance(BodyScanCommon::SexType::male, cvModelsMale, cvModelsFemale);
         }
 
-        // Class methods
-        std::vector<int> &getInvRightCalf() const;
+        // Class methods. The views stay valid for the life of the instance.
+        AHIBSModelPackView<int32_t> getInvRightCalf() const;
 
-        std::vector<int> &getInvRightThigh() const;
+        AHIBSModelPackView<int32_t> getInvRightThigh() const;
 
-        std::vector<int> &getInvRightUpperArm() const;
+        AHIBSModelPackView<int32_t> getInvRightUpperArm() const;
 
-        std::vector<float> getMvnMu() const;
+        AHIBSModelPackView<float> getMvnMu() const;
 
-        std::vector<float> getMvnMu(BodyScanCommon::SexType gender) const;
+        AHIBSModelPackView<float> getMvnMu(BodyScanCommon::SexType gender) const;
 
-        std::vector<std::vector<float> > &getRanges() const;
+        AHIBSModelPackView<float> getRanges() const;
 
-        std::vector<std::vector<float> > &getRanges(BodyScanCommon::SexType gender) const;
+        AHIBSModelPackView<float> getRanges(BodyScanCommon::SexType gender) const;
 
-        std::vector<std::vector<float> > &getCov() const;
+        AHIBSModelPackView<float> getCov() const;
 
-        std::vector<std::vector<float> > &getCov(BodyScanCommon::SexType gender) const;
+        AHIBSModelPackView<float> getCov(BodyScanCommon::SexType gender) const;
 
-        std::vector<float> &getAvgVerts() const;
+        AHIBSModelPackView<float> getAvgVerts() const;
 
-        std::vector<float> &getAvgVerts(BodyScanCommon::SexType gender) const;
+        AHIBSModelPackView<float> getAvgVerts(BodyScanCommon::SexType gender) const;
 
-        std::vector<float> &getVertsInv() const;
+        AHIBSModelPackView<float> getVertsInv() const;
 
-        std::vector<float> &getVertsInv(BodyScanCommon::SexType gender) const;
+        AHIBSModelPackView<float> getVertsInv(BodyScanCommon::SexType gender) const;
 
-        std::vector<int> &getFaces() const;
+        AHIBSModelPackView<int32_t> getFaces() const;
 
-        std::vector<int> &getFaces(BodyScanCommon::SexType gender) const;
+        AHIBSModelPackView<int32_t> getFaces(BodyScanCommon::SexType gender) const;
 
-        std::vector<int> &getFacesInv() const;
+        AHIBSModelPackView<int32_t> getFacesInv() const;
 
-        std::vector<int> &getFacesInv(BodyScanCommon::SexType gender) const;
+        AHIBSModelPackView<int32_t> getFacesInv(BodyScanCommon::SexType gender) const;
 
-        std::vector<std::vector<float> > &getSv() const;
+        AHIBSModelPackView<float> getSv() const;
 
-        std::vector<std::vector<float> > &getSv(BodyScanCommon::SexType gender) const;
+        AHIBSModelPackView<float> getSv(BodyScanCommon::SexType gender) const;
 
-        std::vector<std::vector<float> > &getSvInv() const;
+        AHIBSModelPackView<float> getSvInv() const;
 
-        std::vector<std::vector<float> > &getSvInv(BodyScanCommon::SexType gender) const;
+        AHIBSModelPackView<float> getSvInv(BodyScanCommon::SexType gender) const;
 
-        std::vector<std::vector<float> > &getSkV() const;
+        AHIBSModelPackView<float> getSkV() const;
 
-        std::vector<std::vector<float> > &getSkV(BodyScanCommon::SexType gender) const;
+        AHIBSModelPackView<float> getSkV(BodyScanCommon::SexType gender) const;
 
-        std::vector<std::vector<float> > &getBonW() const;
+        AHIBSModelPackView<float> getBonW() const;
 
-        std::vector<std::vector<float> > &getBonW(BodyScanCommon::SexType gender) const;
+        AHIBSModelPackView<float> getBonW(BodyScanCommon::SexType gender) const;
 
-        std::vector<std::vector<float> > &getBonWInv() const;
+        AHIBSModelPackView<float> getBonWInv() const;
 
-        std::vector<std::vector<float> > &getBonWInv(BodyScanCommon::SexType gender) const;
+        AHIBSModelPackView<float> getBonWInv(BodyScanCommon::SexType gender) const;
 
-        std::vector<int> &getLaplacianRings() const;
+        AHIBSModelPackView<int32_t> getLaplacianRings() const;
 
-        std::vector<int> &getLaplacianRings(BodyScanCommon::SexType gender) const;
+        AHIBSModelPackView<int32_t> getLaplacianRings(BodyScanCommon::SexType gender) const;
 
-        std::vector<int> &getLaplacianRingsAsVectors() const;
+        AHIBSModelPackView<int32_t> getLaplacianRingsAsVectors() const;
 
-        std::vector<int> &getLaplacianRingsAsVectors(BodyScanCommon::SexType gender) const;
+        AHIBSModelPackView<int32_t> getLaplacianRingsAsVectors(BodyScanCommon::SexType gender) const;
 
     };
 
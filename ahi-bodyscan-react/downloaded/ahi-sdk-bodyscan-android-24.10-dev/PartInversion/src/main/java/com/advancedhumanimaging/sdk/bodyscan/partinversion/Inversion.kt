@@ -8,6 +8,7 @@ package com.advancedhumanimaging.sdk.bodyscan.partinversion
 
 import android.content.Context
 import android.net.Uri
+import com.advancedhumanimaging.sdk.bodyscan.common.AHIBSModelPack
 import com.advancedhumanimaging.sdk.bodyscan.common.BodyScanError
 import com.advancedhumanimaging.sdk.bodyscan.common.SexType
 import com.advancedhumanimaging.sdk.bodyscan.common.interfaces.AHIBSResourceType
@@ -19,7 +20,6 @@ import com.advancedhumanimaging.sdk.common.models.AHIResult
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.withContext
 import java.io.File
-import java.io.FileWriter
 
 class Inversion : IInversion {
 
@@ -49,6 +49,9 @@ class Inversion : IInversion {
     private val cvModelsMapMale = mutableMapOf<String, Pair<ByteArray, Int>>()
     private val cvModelsMapFemale = mutableMapOf<String, Pair<ByteArray, Int>>()
 
+    // Set once the native side reads the CV models from the model pack, the resources are not loaded then.
+    private var modelPackOpen = false
+
     private suspend fun getCvModelsMap(
         context: Context,
         resources: IResources,
@@ -107,24 +110,25 @@ class Inversion : IInversion {
                 AHILogging.log(AHILogLevel.ERROR, "Inversion failed due to invalid height or weight")
                 return@withContext AHIResult.failure(BodyScanError.BODY_SCAN_INVERSION_INVALID_HEIGHT_OR_WEIGHT)
             }
-            val cvModelsMapMale = getCvModelsMap(context, resources, SexType.male)
-            if (cvModelsMapMale.size != cvModelsAll.size) {
+            if (!modelPackOpen) {
+                modelPackOpen = AHIBSModelPack.open(context, InversionJNI::openModelPack, InversionJNI::openModelPackFd)
+            }
+            val cvModelsMapMale = if (modelPackOpen) mapOf() else getCvModelsMap(context, resources, SexType.male)
+            if (!modelPackOpen && cvModelsMapMale.size != cvModelsAll.size) {
                 AHILogging.log(AHILogLevel.ERROR, "Inversion failed due to some missing resources")
                 return@withContext AHIResult.failure(BodyScanError.BODY_SCAN_INVERSION_MISSING_CV_MODELS_MALE)
             }
-            val cvModelsMapFemale = getCvModelsMap(context, resources, SexType.female)
-            if (cvModelsMapFemale.size != cvModelsAll.size) {
+            val cvModelsMapFemale = if (modelPackOpen) mapOf() else getCvModelsMap(context, resources, SexType.female)
+            if (!modelPackOpen && cvModelsMapFemale.size != cvModelsAll.size) {
                 AHILogging.log(AHILogLevel.ERROR, "Inversion failed due to some missing resources")
                 return@withContext AHIResult.failure(BodyScanError.BODY_SCAN_INVERSION_MISSING_CV_MODELS_FEMALE)
             }
-            val meshData =
-                InversionJNI.invert(sex, heightCM, weightKG, chestCM, waistCM, hipCM, inseamCM, fitness, cvModelsMapMale, cvModelsMapFemale)
             val file = File(context.filesDir, "$name.obj")
-            val writer = FileWriter(file)
-            writer.append(meshData)
-            writer.flush()
-            writer.close()
-            if (meshData.isBlank()) {
+            val written = InversionJNI.invertToFile(
+                sex, heightCM, weightKG, chestCM, waistCM, hipCM, inseamCM, fitness, cvModelsMapMale, cvModelsMapFemale,
+                file.absolutePath, false
+            )
+            if (!written || file.length() == 0L) {
                 AHIResult.failure(BodyScanError.BODY_SCAN_INVERSION_FAILED_IN_INVERSION)
             } else {
                 AHIResult.success(Uri.fromFile(file))
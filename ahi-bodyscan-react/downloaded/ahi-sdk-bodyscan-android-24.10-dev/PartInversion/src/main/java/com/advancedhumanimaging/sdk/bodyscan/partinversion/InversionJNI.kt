@@ -26,4 +26,26 @@ internal object InversionJNI {
         cvModelsMale: Map<String, Pair<ByteArray, Int>>,
         cvModelsFemale: Map<String, Pair<ByteArray, Int>>
     ): String
+
+    // Writes the mesh to path natively, OBJ or binary PLY with normals. False if inversion or the write failed.
+    external fun invertToFile(
+        sex: SexType,
+        heightCM: Double,
+        weightKG: Double,
+        chestCM: Double,
+        waistCM: Double,
+        hipCM: Double,
+        inseamCM: Double,
+        fitness: Double,
+        cvModelsMale: Map<String, Pair<ByteArray, Int>>,
+        cvModelsFemale: Map<String, Pair<ByteArray, Int>>,
+        path: String,
+        binary: Boolean
+    ): Boolean
+
+    // Maps the model pack at path; the CV models are read from it from then on. False if it could not be opened.
+    external fun openModelPack(path: String): Boolean
+
+    // Same over the length bytes at offset of fd (an uncompressed asset). The descriptor may be closed afterwards.
+    external fun openModelPackFd(fd: Int, offset: Long, length: Long): Boolean
 }
\ No newline at end of file
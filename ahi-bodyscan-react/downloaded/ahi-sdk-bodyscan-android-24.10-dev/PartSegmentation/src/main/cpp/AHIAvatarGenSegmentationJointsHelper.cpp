@@ -53,11 +53,7 @@ namespace ahi_avatar_gen {
         cv::line(mask, cv::Point(mask.cols, mask.rows), cv::Point(0, mask.rows),
                  cv::Scalar(cv::GC_BGD),
                  30);
-        cv::Mat inp_image = orig_image.clone();
-        const cv::Mat *grabcut_image;
-        grabcut_image = &inp_image;
-        cv::Mat bgdModel, fgdModel;
-        cv::grabCut(*grabcut_image, mask, cv::Rect(), bgdModel, fgdModel, 3, cv::GC_INIT_WITH_MASK);
+        grabcut_with_mask(orig_image, mask, 3);
         mask = (mask == cv::GC_FGD) | (mask == cv::GC_PR_FGD);
         return mask;
     }
@@ -270,49 +266,26 @@ namespace ahi_avatar_gen {
                 // enforce BGD around knee joints
                 float Jx = (joints[9].x + joints[12].x) / 2;
                 float Jy = (joints[9].y + joints[12].y) / 2;
-                for (int x = 0; x < 2 * face_rect.width; x++) {
-                    for (int y = -(0.5 * face_rect.height); y < (0.5 * face_rect.height); y++) {
-                        cv::circle(mask, cv::Point(Jx + face_rect.width + x, Jy + y), radius,
-                                   cv::Scalar(cv::GC_BGD), thickness);
-                        cv::circle(mask, cv::Point(Jx - face_rect.width - x, Jy + y), radius,
-                                   cv::Scalar(cv::GC_BGD), thickness);
-                        cv::line(mask, cv::Point(0, mask.rows / 2),
-                                 cv::Point(Jx - face_rect.width - x, Jy + y),
-                                 cv::Scalar(cv::GC_BGD),
-                                 10);
-                        cv::line(mask, cv::Point(0, mask.rows),
-                                 cv::Point(Jx - face_rect.width - x, Jy + y),
-                                 cv::Scalar(cv::GC_BGD),
-                                 10);
-                        cv::line(mask, cv::Point(mask.cols, mask.rows / 2),
-                                 cv::Point(Jx + face_rect.width + x, Jy + y),
-                                 cv::Scalar(cv::GC_BGD),
-                                 10);
-                        cv::line(mask, cv::Point(mask.cols, mask.rows),
-                                 cv::Point(Jx + face_rect.width + x, Jy + y),
-                                 cv::Scalar(cv::GC_BGD),
-                                 10);
-                    }
-                }
+                paint_side_knee_background(mask, cv::Point(Jx, Jy), face_rect, radius);
             }
-            // around the face is a BKGD
-            for (int x = 0; x < mask.cols; x++) {
-                for (int y = 0; y < joints[1].y; y++) {
+            // around the face is a BKGD: the pixels marked here get a disc of radius around them, painted at once
+            // below with the ones under the feet (the rows past the image are under the border lines anyway)
+            cv::Mat bgd_centers = cv::Mat::zeros(mask.size(), CV_8UC1);
+            for (int y = 0; y < std::min(joints[1].y, mask.rows); y++) {
+                uchar *centers_row = bgd_centers.ptr<uchar>(y);
+                for (int x = 0; x < mask.cols; x++) {
                     if (y < 0.8 * joints[0].y) {
-                        cv::circle(mask, cv::Point(x, y), radius, cv::Scalar(cv::GC_BGD),
-                                   thickness);
+                        centers_row[x] = 255;
                     }
                     if (type == BodyScanCommon::Profile::front) {
                         if (x < face_rect.x - 0.8 * face_rect.width ||
                             x > face_rect.x + 1.8 * face_rect.width) {
-                            cv::circle(mask, cv::Point(x, y), radius, cv::Scalar(cv::GC_BGD),
-                                       thickness);
+                            centers_row[x] = 255;
                         }
                     } else {
                         if (x < (face_rect.x - 1.1 * face_rect.width) ||
                             x > (face_rect.x + 2.1 * face_rect.width)) {
-                            cv::circle(mask, cv::Point(x, y), radius, cv::Scalar(cv::GC_BGD),
-                                       thickness);
+                            centers_row[x] = 255;
                         }
                     }
                 }
@@ -325,24 +298,17 @@ namespace ahi_avatar_gen {
             cv::line(mask, cv::Point(mask.cols, mask.rows), cv::Point(0, mask.rows),
                      cv::Scalar(cv::GC_BGD), 20);
             // below feet and above head is BKGD
-            for (int x = 0; x < mask.cols; x++) {
-                for (int y = 0; y < mask.rows; y++) {
-                    if ((y > (std::max(joints[10].y, joints[13].y) + face_rect.height)) |
-                        (y < (joints[0].y - 30))) {
-                        cv::circle(mask, cv::Point(x, y), radius, cv::Scalar(cv::GC_BGD),
-                                   thickness);
-                    }
+            for (int y = 0; y < mask.rows; y++) {
+                if ((y > (std::max(joints[10].y, joints[13].y) + face_rect.height)) |
+                    (y < (joints[0].y - 30))) {
+                    bgd_centers.row(y).setTo(255);
                 }
             }
+            paint_label_discs(mask, bgd_centers, radius, cv::GC_BGD);
             mask.setTo(cv::GC_FGD, SkelBinMask > 0); // reinforce again
             // Actual start of feeding and calling grabcut
-            cv::Mat inp_image = orig_image.clone();
-            const cv::Mat *grabcut_image;
-            grabcut_image = &inp_image;
-            cv::Mat bgdModel, fgdModel;
             int N_iterations = 3;
-            cv::grabCut(*grabcut_image, mask, cv::Rect(), bgdModel, fgdModel, N_iterations,
-                        cv::GC_INIT_WITH_MASK);
+            grabcut_with_mask(orig_image, mask, N_iterations);
             mask = (mask == 1) | (mask == 3); // FG or probably FG
             return mask; // &  (JointsContBinMask);
         } catch (cv::Exception &e) {
@@ -541,49 +507,26 @@ namespace ahi_avatar_gen {
                 //enforce BGD around knee joints
                 float Jx = (joints[9].x + joints[12].x) / 2;
                 float Jy = (joints[9].y + joints[12].y) / 2;
-                for (int x = 0; x < 2 * face_rect.width; x++) {
-                    for (int y = -(0.5 * face_rect.height); y < (0.5 * face_rect.height); y++) {
-                        cv::circle(mask, cv::Point(Jx + face_rect.width + x, Jy + y), radius,
-                                   cv::Scalar(cv::GC_BGD), thickness);
-                        cv::circle(mask, cv::Point(Jx - face_rect.width - x, Jy + y), radius,
-                                   cv::Scalar(cv::GC_BGD), thickness);
-                        cv::line(mask, cv::Point(0, mask.rows / 2),
-                                 cv::Point(Jx - face_rect.width - x, Jy + y),
-                                 cv::Scalar(cv::GC_BGD),
-                                 10);
-                        cv::line(mask, cv::Point(0, mask.rows),
-                                 cv::Point(Jx - face_rect.width - x, Jy + y),
-                                 cv::Scalar(cv::GC_BGD),
-                                 10);
-                        cv::line(mask, cv::Point(mask.cols, mask.rows / 2),
-                                 cv::Point(Jx + face_rect.width + x, Jy + y),
-                                 cv::Scalar(cv::GC_BGD),
-                                 10);
-                        cv::line(mask, cv::Point(mask.cols, mask.rows),
-                                 cv::Point(Jx + face_rect.width + x, Jy + y),
-                                 cv::Scalar(cv::GC_BGD),
-                                 10);
-                    }
-                }
+                paint_side_knee_background(mask, cv::Point(Jx, Jy), face_rect, radius);
             }
-            // around the face is a BKGD
-            for (int x = 0; x < mask.cols; x++) {
-                for (int y = 0; y < joints[1].y; y++) {
+            // around the face is a BKGD: the pixels marked here get a disc of radius around them, painted at once
+            // below with the ones under the feet (the rows past the image are under the border lines anyway)
+            cv::Mat bgd_centers = cv::Mat::zeros(mask.size(), CV_8UC1);
+            for (int y = 0; y < std::min(joints[1].y, mask.rows); y++) {
+                uchar *centers_row = bgd_centers.ptr<uchar>(y);
+                for (int x = 0; x < mask.cols; x++) {
                     if (y < 0.8 * joints[0].y) {
-                        cv::circle(mask, cv::Point(x, y), radius, cv::Scalar(cv::GC_BGD),
-                                   thickness);
+                        centers_row[x] = 255;
                     }
                     if (type == BodyScanCommon::Profile::front) {
                         if (x < face_rect.x - 0.8 * face_rect.width ||
                             x > face_rect.x + 1.8 * face_rect.width) {
-                            cv::circle(mask, cv::Point(x, y), radius, cv::Scalar(cv::GC_BGD),
-                                       thickness);
+                            centers_row[x] = 255;
                         }
                     } else {
                         if (x < (face_rect.x - 1.1 * face_rect.width) ||
                             x > (face_rect.x + 2.1 * face_rect.width)) {
-                            cv::circle(mask, cv::Point(x, y), radius, cv::Scalar(cv::GC_BGD),
-                                       thickness);
+                            centers_row[x] = 255;
                         }
                     }
                 }
@@ -596,24 +539,17 @@ namespace ahi_avatar_gen {
             cv::line(mask, cv::Point(mask.cols, mask.rows), cv::Point(0, mask.rows),
                      cv::Scalar(cv::GC_BGD), 20);
             // below feet and above head is BKGD
-            for (int x = 0; x < mask.cols; x++) {
-                for (int y = 0; y < mask.rows; y++) {
-                    if ((y > (std::max(joints[10].y, joints[13].y) + face_rect.height)) |
-                        (y < (joints[0].y - 30))) {
-                        cv::circle(mask, cv::Point(x, y), radius, cv::Scalar(cv::GC_BGD),
-                                   thickness);
-                    }
+            for (int y = 0; y < mask.rows; y++) {
+                if ((y > (std::max(joints[10].y, joints[13].y) + face_rect.height)) |
+                    (y < (joints[0].y - 30))) {
+                    bgd_centers.row(y).setTo(255);
                 }
             }
+            paint_label_discs(mask, bgd_centers, radius, cv::GC_BGD);
             mask.setTo(cv::GC_FGD, SkelBinMask > 0); // reinforce again
             // Actual start of feeding and calling grabcut
-            cv::Mat inp_image = orig_image.clone();
-            const cv::Mat *grabcut_image;
-            grabcut_image = &inp_image;
-            cv::Mat bgdModel, fgdModel;
             int N_iterations = 3;
-            cv::grabCut(*grabcut_image, mask, cv::Rect(), bgdModel, fgdModel, N_iterations,
-                        cv::GC_INIT_WITH_MASK);
+            grabcut_with_mask(orig_image, mask, N_iterations);
             mask = (mask == 1) | (mask == 3); // FG or probably FG
             return mask; // &  (JointsContBinMask);
         } catch (cv::Exception &e) {
@@ -623,6 +559,99 @@ namespace ahi_avatar_gen {
     }
 
 // PRIVATE
+
+    void joints_helper::paint_label_discs(cv::Mat &mask, const cv::Mat &centers, int radius, int label) {
+        // stamping the disc cv::circle draws on every center is dilating the centers by that disc
+        cv::Mat disc = cv::Mat::zeros(2 * radius + 1, 2 * radius + 1, CV_8UC1);
+        cv::circle(disc, cv::Point(radius, radius), radius, cv::Scalar(255), -1);
+        cv::Mat covered;
+        cv::dilate(centers, covered, disc);
+        mask.setTo(cv::Scalar(label), covered);
+    }
+
+    void joints_helper::paint_label_fan(cv::Mat &mask, cv::Point apex, const cv::Rect &rect, int thickness, int label) {
+        // the lines from apex to every pixel of rect sweep the convex hull of apex and rect, and their thickness
+        // widens it as much as drawing its outline that thick does
+        std::vector<cv::Point> corners = {apex, rect.tl(), cv::Point(rect.x + rect.width - 1, rect.y),
+                                          rect.br() - cv::Point(1, 1), cv::Point(rect.x, rect.y + rect.height - 1)};
+        std::vector<cv::Point> hull;
+        cv::convexHull(corners, hull);
+        cv::fillConvexPoly(mask, hull, cv::Scalar(label));
+        cv::polylines(mask, hull, true, cv::Scalar(label), thickness);
+    }
+
+    void joints_helper::paint_side_knee_background(cv::Mat &mask, cv::Point knee, const cv::Rect &face_rect,
+                                                   int radius) {
+        // the pixels 1 to 3 face widths left and right of the knees, over a face height around them
+        int width = 2 * face_rect.width;
+        int y_first = -(0.5 * face_rect.height);
+        int y_last = (int) std::ceil(0.5 * face_rect.height) - 1;
+        if (width <= 0 || y_last < y_first) {
+            return;
+        }
+        cv::Rect right(knee.x + face_rect.width, knee.y + y_first, width, y_last - y_first + 1);
+        cv::Rect left(knee.x - face_rect.width - width + 1, knee.y + y_first, width, y_last - y_first + 1);
+        cv::Rect image(0, 0, mask.cols, mask.rows);
+        cv::Mat centers = cv::Mat::zeros(mask.size(), CV_8UC1);
+        centers(right & image).setTo(255);
+        centers(left & image).setTo(255);
+        paint_label_discs(mask, centers, radius, cv::GC_BGD);
+        // and the lines from the left and right borders to each of them
+        paint_label_fan(mask, cv::Point(0, mask.rows / 2), left, 10, cv::GC_BGD);
+        paint_label_fan(mask, cv::Point(0, mask.rows), left, 10, cv::GC_BGD);
+        paint_label_fan(mask, cv::Point(mask.cols, mask.rows / 2), right, 10, cv::GC_BGD);
+        paint_label_fan(mask, cv::Point(mask.cols, mask.rows), right, 10, cv::GC_BGD);
+    }
+
+    void joints_helper::grabcut_with_mask(const cv::Mat &image, cv::Mat &mask, int iterations) {
+        cv::Mat bgdModel, fgdModel;
+        int scale = 1 << std::max(0, grabcut_pyramid_level);
+        cv::Size coarse_size((image.cols + scale - 1) / scale, (image.rows + scale - 1) / scale);
+        if (scale == 1 || coarse_size.width < 32 || coarse_size.height < 32) {
+            cv::grabCut(image, mask, cv::Rect(), bgdModel, fgdModel, iterations, cv::GC_INIT_WITH_MASK);
+            return;
+        }
+        // all the iterations on the downscaled image, its labels picked from the full resolution ones
+        cv::Mat coarse_image, coarse_mask;
+        cv::resize(image, coarse_image, coarse_size, 0, 0, cv::INTER_AREA);
+        cv::resize(mask, coarse_mask, coarse_size, 0, 0, cv::INTER_NEAREST);
+        try {
+            cv::grabCut(coarse_image, coarse_mask, cv::Rect(), bgdModel, fgdModel, iterations,
+                        cv::GC_INIT_WITH_MASK);
+        } catch (cv::Exception &e) {
+            // the downsampling dropped all the samples of a label
+            bgdModel.release();
+            fgdModel.release();
+            cv::grabCut(image, mask, cv::Rect(), bgdModel, fgdModel, iterations, cv::GC_INIT_WITH_MASK);
+            return;
+        }
+        cv::Mat coarse_fg = (coarse_mask == cv::GC_FGD) | (coarse_mask == cv::GC_PR_FGD);
+        cv::Mat fg;
+        cv::resize(coarse_fg, fg, image.size(), 0, 0, cv::INTER_LINEAR);
+        fg = fg > 127;
+        // the probable pixels off the boundary take the coarse labels for good, the ones in the band along it get them
+        // as the guess of a full resolution pass with the coarse colour models
+        int band = std::max(1, grabcut_band_width);
+        cv::Mat band_element = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(2 * band + 1, 2 * band + 1));
+        cv::Mat inner, outer;
+        cv::erode(fg, inner, band_element);
+        cv::dilate(fg, outer, band_element);
+        cv::Mat uncertain = outer & ~inner;
+        cv::Mat probable = (mask == cv::GC_PR_BGD) | (mask == cv::GC_PR_FGD);
+        mask.setTo(cv::GC_FGD, probable & inner);
+        mask.setTo(cv::GC_BGD, probable & ~outer);
+        mask.setTo(cv::GC_PR_FGD, probable & uncertain & fg);
+        mask.setTo(cv::GC_PR_BGD, probable & uncertain & ~fg);
+        cv::Rect roi = cv::boundingRect(uncertain);
+        if (roi.area() == 0) {
+            return;
+        }
+        roi = cv::Rect(roi.x - band, roi.y - band, roi.width + 2 * band, roi.height + 2 * band) &
+              cv::Rect(0, 0, image.cols, image.rows);
+        cv::Mat roi_mask = mask(roi).clone();
+        cv::grabCut(image(roi), roi_mask, cv::Rect(), bgdModel, fgdModel, 1, cv::GC_EVAL_FREEZE_MODEL);
+        roi_mask.copyTo(mask(roi));
+    }
     cv::Mat joints_helper::Hist_and_Backproj(const cv::Mat &hsv, const cv::Mat &mask) {
         cv::Mat hist;
         int h_bins = 30;
@@ -924,11 +953,7 @@ namespace ahi_avatar_gen {
         cv::line(mask, cv::Point(mask.cols, mask.rows), cv::Point(0, mask.rows),
                  cv::Scalar(cv::GC_BGD),
                  30);
-        cv::Mat inp_image = orig_image.clone();
-        const cv::Mat *grabcut_image;
-        grabcut_image = &inp_image;
-        cv::Mat bgdModel, fgdModel;
-        cv::grabCut(*grabcut_image, mask, cv::Rect(), bgdModel, fgdModel, 3, cv::GC_INIT_WITH_MASK);
+        grabcut_with_mask(orig_image, mask, 3);
         mask = (mask == cv::GC_FGD) | (mask == cv::GC_PR_FGD);
         return mask;
     }
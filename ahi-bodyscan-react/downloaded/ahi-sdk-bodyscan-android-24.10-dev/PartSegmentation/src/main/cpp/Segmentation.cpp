@@ -6,16 +6,18 @@
 
 #include "Segmentation.hpp"
 
-#include "ahiCommon.hpp"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <thread>
+
 #include "ahiFactoryInspection.hpp"
 #include "ahiFactorySegment.hpp"
 #include "Common.hpp"
+#include "Logging.hpp"
 
-cv::Mat
-Segmentation::segment(const cv::Mat &capture, cv::Mat contourMask, BodyScanCommon::Profile profile,
-                      std::map<std::string, cv::Point2f> poseJoints, const char *modelBuffer,
-                      std::size_t modelBufferSize) {
-    std::string profileString = profile == BodyScanCommon::Profile::front ? "front" : "side";
+static ahiPoseInfo toPoseInfo(const std::map<std::string, cv::Point2f> &poseJoints) {
     ahiPoseInfo poseInfoPredictions;
     poseInfoPredictions.CentroidHeadTop = poseJoints.at("CentroidHeadTop");
     poseInfoPredictions.CentroidNeck = poseJoints.at("CentroidNeck");
@@ -31,18 +33,15 @@ Segmentation::segment(const cv::Mat &capture, cv::Mat contourMask, BodyScanCommo
     poseInfoPredictions.CentroidLeftElbow = poseJoints.at("CentroidLeftElbow");
     poseInfoPredictions.CentroidRightShoulder = poseJoints.at("CentroidRightShoulder");
     poseInfoPredictions.CentroidLeftShoulder = poseJoints.at("CentroidLeftShoulder");
-    ahiSegmentInfo segInfo = ahiSegmentInfo();
-    ahiCommon common = ahiCommon();
-    // load the tflite model first
-    common.loadTensorFlowModelFromBuffer(modelBuffer, modelBufferSize,
-                                         "segnet.tflite"); // could also use "segmentnet.tflite"
-
-    // load the image
-    common.feedInputBufferImageToCpp(capture.data, capture, "segnet.tflite");
-    common.segment(capture, contourMask, poseInfoPredictions, profileString, segInfo);
-    return segInfo.segmentMask;
+    return poseInfoPredictions;
 }
 
+cv::Mat
+Segmentation::segment(const cv::Mat &capture, cv::Mat contourMask, BodyScanCommon::Profile profile,
+                      std::map<std::string, cv::Point2f> poseJoints, const char *modelBuffer,
+                      std::size_t modelBufferSize) {
+    return segmentAll({capture}, {contourMask}, {profile}, {poseJoints}, modelBuffer, modelBufferSize)[0];
+}
 
 std::vector<cv::Mat> Segmentation::segmentAll(
         const std::vector<cv::Mat> &captures,
@@ -52,35 +51,62 @@ std::vector<cv::Mat> Segmentation::segmentAll(
         const char *modelBuffer,
         std::size_t modelBufferSize
 ) {
-    ahiCommon common = ahiCommon();
-    // load the tflite model first
-    common.loadTensorFlowModelFromBuffer(modelBuffer, modelBufferSize, "segnet.tflite"); // could also use "segmentnet.tflite"
-    std::vector<cv::Mat> silhouettes;
-    for (int index = 0; index < captures.size(); ++index) {
-        std::string profile = profiles[index] == BodyScanCommon::Profile::front ? "front" : "side";
-        auto joints = poseJoints[index];
-        auto contourMask = contourMasks[index];
-        auto capture = captures[index];
-        ahiPoseInfo poseInfoPredictions;
-        poseInfoPredictions.CentroidHeadTop = joints.at("CentroidHeadTop");
-        poseInfoPredictions.CentroidNeck = joints.at("CentroidNeck");
-        poseInfoPredictions.CentroidRightAnkle = joints.at("CentroidRightAnkle");
-        poseInfoPredictions.CentroidLeftAnkle = joints.at("CentroidLeftAnkle");
-        poseInfoPredictions.CentroidRightKnee = joints.at("CentroidRightKnee");
-        poseInfoPredictions.CentroidLeftKnee = joints.at("CentroidLeftKnee");
-        poseInfoPredictions.CentroidRightHip = joints.at("CentroidRightHip");
-        poseInfoPredictions.CentroidLeftHip = joints.at("CentroidLeftHip");
-        poseInfoPredictions.CentroidRightHand = joints.at("CentroidRightHand");
-        poseInfoPredictions.CentroidLeftHand = joints.at("CentroidLeftHand");
-        poseInfoPredictions.CentroidRightElbow = joints.at("CentroidRightElbow");
-        poseInfoPredictions.CentroidLeftElbow = joints.at("CentroidLeftElbow");
-        poseInfoPredictions.CentroidRightShoulder = joints.at("CentroidRightShoulder");
-        poseInfoPredictions.CentroidLeftShoulder = joints.at("CentroidLeftShoulder");
-        ahiSegmentInfo segInfo = ahiSegmentInfo();
-        // load the image
-        common.feedInputBufferImageToCpp(capture.data, capture, "segnet.tflite");
-        common.segment(capture, contourMask, poseInfoPredictions, profile, segInfo);
-        silhouettes.push_back(segInfo.segmentMask);
+    std::vector<cv::Mat> silhouettes(captures.size());
+    // load the tflite model once for the batch, every worker builds its own interpreter over it
+    std::shared_ptr<const tflite::FlatBufferModel> model;
+    if (modelBuffer != nullptr && modelBufferSize > 10) {
+        model = tflite::FlatBufferModel::BuildFromBuffer(modelBuffer, modelBufferSize);
+    }
+    if (model == nullptr) {
+        LOG_GUARD(std::cout << "Segmentation model could not be loaded" << std::endl)
+        return silhouettes;
+    }
+
+    // The captures are segmented concurrently, so the invoke of one view overlaps the grabCut refinement of the other.
+    std::size_t numWorkers = std::min<std::size_t>(captures.size(),
+                                                   std::max(1u, std::thread::hardware_concurrency()));
+    std::atomic<std::size_t> nextIndex(0);
+    auto worker = [&]() {
+        ahiFactorySegment segmenter;
+        segmenter.initSegment();
+        if (!segmenter.loadTensorFlowSegmentModelShared(model, "segnet.tflite")) {
+            return;
+        }
+        for (std::size_t index = nextIndex++; index < captures.size(); index = nextIndex++) {
+            const cv::Mat &capture = captures[index];
+            ahiPoseInfo poseInfoPredictions = toPoseInfo(poseJoints[index]);
+            std::string profile = profiles[index] == BodyScanCommon::Profile::front ? "front" : "side";
+            ahiSegmentInfo segInfo = ahiSegmentInfo();
+            segInfo.view = profile;
+            // load the image
+            segmenter.feedInputBufferImageToCppToSegment(capture.data, capture);
+            segmenter.getSegmentOutInfo(capture, contourMasks[index], poseInfoPredictions, profile, segInfo);
+            silhouettes[index] = segInfo.segmentMask;
+        }
+    };
+
+    std::vector<std::future<void>> workers;
+    for (std::size_t w = 1; w < numWorkers; ++w) {
+        workers.push_back(std::async(std::launch::async, worker));
+    }
+    std::exception_ptr failure;
+    try {
+        worker();
+    } catch (...) {
+        failure = std::current_exception();
+    }
+    // rethrow like the serial loop did, but only once every worker is done with the shared state
+    for (auto &pending: workers) {
+        try {
+            pending.get();
+        } catch (...) {
+            if (!failure) {
+                failure = std::current_exception();
+            }
+        }
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
     }
     return silhouettes;
-}
\ No newline at end of file
+}
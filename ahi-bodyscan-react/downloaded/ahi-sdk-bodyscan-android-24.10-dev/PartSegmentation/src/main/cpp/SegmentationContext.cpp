@@ -0,0 +1,264 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "SegmentationContext.hpp"
+
+#include <iostream>
+
+#include "Logging.hpp"
+
+static std::string to_lower(std::string str) {
+    std::for_each(str.begin(), str.end(), [](char &c) {
+        c = ::tolower(c);
+    });
+    return str;
+}
+
+bool SegmentationContext::registerModel(ahiModelRole role, const char *buffer, std::size_t bufferSize,
+                                        const std::string &modelName) {
+    if (buffer == nullptr || bufferSize <= 10) {
+        return false;
+    }
+    // BuildFromBuffer reads the caller's buffer in place, nothing is copied nor saved to a file
+    std::shared_ptr<const tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromBuffer(buffer,
+                                                                                                     bufferSize);
+    return registerModel(role, std::move(model), modelName);
+}
+
+bool SegmentationContext::registerModel(ahiModelRole role, std::shared_ptr<const tflite::FlatBufferModel> model,
+                                        const std::string &modelName) {
+    if (model == nullptr) {
+        return false;
+    }
+    switch (role) {
+        case ahiModelRole::face:
+            mFace.modelFileName = modelName;
+            return mFace.loadTensorFlowFaceModelShared(std::move(model), modelName);
+        case ahiModelRole::pose:
+            mPose.modelFileName = modelName;
+            return mPose.loadTensorFlowPoseModelShared(std::move(model), modelName);
+        case ahiModelRole::segment:
+            mSegment.modelFileName = modelName;
+            return mSegment.loadTensorFlowSegmentModelShared(std::move(model), modelName);
+    }
+    return false;
+}
+
+bool SegmentationContext::registerModelFile(ahiModelRole role, const std::string &modelName) {
+    std::string path = modelName;
+    if (!modelDirectory.empty() && modelName.find('/') == std::string::npos) {
+        path = modelDirectory + "/" + modelName;
+    }
+    std::shared_ptr<const tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(path.c_str());
+    if (model == nullptr) {
+        LOG_GUARD(std::cout << "Model " << path << " could not be loaded" << std::endl)
+        return false;
+    }
+    return registerModel(role, std::move(model), modelName);
+}
+
+void SegmentationContext::useOpenCvFace() {
+    mFace.initFace();
+    mFace.modelFileName = "openCV";
+}
+
+void SegmentationContext::feedMlKitFace(int faceX, int faceY, int faceHeight, int faceWidth,
+                                        int numOfDetectedFaces) {
+    mFace.initFace();
+    mFace.modelFileName = "mlkitFace";
+    mlKitFaceInfo &face = mFace.mlkitFaceDataInfo;
+    face.numOfDetectedFaces = numOfDetectedFaces;
+    face.faceX = faceX;
+    face.faceY = faceY;
+    face.faceWidth = faceWidth;
+    face.faceHeight = faceHeight;
+    face.faceRect = cv::Rect(faceX, faceY, faceHeight, faceWidth);
+    face.detectionMethodOrModel = "mlkitFace";
+}
+
+void SegmentationContext::feedMlKitPose(std::vector<float> mlkitPoseResults) {
+    mPose.initPose();
+    mPose.modelFileName = "mlkitPose";
+    mPose.mlkitPoseData = std::move(mlkitPoseResults);
+}
+
+void SegmentationContext::feedMlKitSegment(cv::Mat mlkitSegmentResults) {
+    mSegment.initSegment();
+    mSegment.modelFileName = "mlkitSeg";
+    mSegment.mlkitSegmentData = mlkitSegmentResults;
+}
+
+bool SegmentationContext::feedImage(ahiModelRole role, const cv::Mat &image) {
+    try {
+        mImageWidth = image.cols;
+        mImageHeight = image.rows;
+        switch (role) {
+            case ahiModelRole::face:
+                return mFace.feedInputBufferImageToCppToFace(image.data, image);
+            case ahiModelRole::pose:
+                return mPose.feedInputBufferImageToCppToPose(image.data, image);
+            case ahiModelRole::segment:
+                return mSegment.feedInputBufferImageToCppToSegment(image.data, image);
+        }
+    }
+    catch (std::exception &e) {
+        return false;
+    }
+    return false;
+}
+
+std::vector<cv::Point>
+SegmentationContext::calcScaledContourPoints(std::vector<cv::Point> originalContourPoints, float headTopY,
+                                             float ankleY, cv::Mat &scaledContourMat) {
+    float minContourX = 10000;
+    float maxContourX = -1;
+    float minContourY = 10000;
+    float maxContourY = -1;
+    int L = originalContourPoints.size();
+    for (int n = 0; n < L; n += 2) {
+        minContourX = MIN(minContourX, originalContourPoints[n].x);
+        maxContourX = MAX(maxContourX, originalContourPoints[n].x);
+        minContourY = MIN(minContourY, originalContourPoints[n].y);
+        maxContourY = MAX(maxContourY, originalContourPoints[n].y);
+    }
+    float contourAnkleY = 0.9f * maxContourY + 0.1f * minContourY;
+    float scale = 1.02 * (ankleY - headTopY) / (contourAnkleY - minContourY);
+    if (scale * (maxContourX - 720.0f / 2) + 720.0f / 2 > 720) {
+        scale = (720.0f / 2) / (maxContourX - 720.0f / 2);
+    }
+    std::vector<cv::Point> scaledContourPoints;
+    for (int n = 0; n < L; n++) {
+        float Px = scale * (originalContourPoints[n].x - scaledContourMat.cols / 2) +
+                   scaledContourMat.cols / 2;
+        float Py = scale * (originalContourPoints[n].y - minContourY) + 0.9f * headTopY;
+        scaledContourPoints.push_back(cv::Point(Px, Py));
+    }
+    std::vector<std::vector<cv::Point> > contours(1);
+    contours[0] = scaledContourPoints;
+    cv::drawContours(scaledContourMat, contours, 0, 255, 3);
+    return scaledContourPoints;
+}
+
+bool SegmentationContext::detectFace(cv::Mat image, ahiFaceInfo &faceInfo) {
+    mImageWidth = image.cols;
+    mImageHeight = image.rows;
+    faceInfo.detectedFaces.clear();
+    if (mFace.modelFileName.find("mlkit") != std::string::npos ||
+        faceInfo.detectionMethodOrModel.find("mlkit") != std::string::npos) {
+        faceInfo.numOfDetectedFaces = mFace.mlkitFaceDataInfo.numOfDetectedFaces;
+        faceInfo.detectedFaces.push_back(mFace.mlkitFaceDataInfo.faceRect);
+        faceInfo.detectionMethodOrModel = "mlkit";
+        return true;
+    }
+    if (to_lower(mFace.modelFileName).find("opencv") != std::string::npos ||
+        mFace.modelFileName.empty()) // opencv
+    {
+        std::vector<cv::Rect> outputFaces;
+        mFace.detectFaceCV(image, outputFaces);
+        faceInfo.detectedFaces = outputFaces;
+        faceInfo.numOfDetectedFaces = outputFaces.size();
+        faceInfo.detectionMethodOrModel = "openCV";
+        mFace.modelFileName = "openCV";
+        return true;
+    }
+    // below is for any additional face detection or landmarks models that we can run on C++
+    if (mFace.origImageMat.empty() || !image.empty()) {
+        mFace.feedInputBufferImageToCppToFace(nullptr, image);
+    }
+    faceInfo.detectionMethodOrModel = mFace.modelFileName;
+    return true;
+}
+
+bool SegmentationContext::detectPose(cv::Mat image, std::string genderStr, std::string viewStr,
+                                     ahiPoseInfo &poseInfoPredictions) {
+    if (!image.empty()) {
+        mImageWidth = image.cols;
+        mImageHeight = image.rows;
+    }
+    // init
+    poseInfoPredictions.GE = false;
+    poseInfoPredictions.numOfDetectedFaces = 0;
+    poseInfoPredictions.headFound = false;
+    poseInfoPredictions.RA = false;
+    poseInfoPredictions.LA = false;
+    poseInfoPredictions.RL = false;
+    poseInfoPredictions.LL = false;
+    poseInfoPredictions.UB = false;
+    poseInfoPredictions.LB = false;
+    poseInfoPredictions.view = to_lower(viewStr) == "front" ? "front" : "side";
+    poseInfoPredictions.gender = to_lower(genderStr) == "male" ? "male" : "female";
+    // face detection
+    if (poseInfoPredictions.Face.empty()) {
+        ahiFaceInfo faceInfo;
+        faceInfo.detectionMethodOrModel = mFace.modelFileName;
+        faceInfo.view = viewStr;
+        bool faceDetectSucess = detectFace(image, faceInfo);
+        const std::vector<cv::Rect> &facesFound = faceInfo.detectedFaces;
+        if (!faceDetectSucess || facesFound.empty()) {
+            LOG_GUARD(std::cout << "Face Not Found.." << std::endl)
+            poseInfoPredictions.numOfDetectedFaces = 0;
+            return true;
+        }
+        if (facesFound.size() > 1) {
+            LOG_GUARD(std::cout << "Face Not Found.." << std::endl)
+            poseInfoPredictions.numOfDetectedFaces = 2;
+            return true;
+        }
+        poseInfoPredictions.numOfDetectedFaces = 1;
+        poseInfoPredictions.Face = facesFound[0];
+        poseInfoPredictions.FaceConfidence = 1.0;
+    }
+    return mPose.getPoseInfoOutputs(image, poseInfoPredictions);
+}
+
+bool SegmentationContext::segment(cv::Mat image, cv::Mat contourMask, ahiPoseInfo poseInfoPredictions,
+                                  std::string viewStr, ahiSegmentInfo &segInfo) {
+    if (!image.empty()) {
+        mImageWidth = image.cols;
+        mImageHeight = image.rows;
+    }
+    segInfo.view = to_lower(viewStr) == "front" ? "front" : "side";
+    if (to_lower(mSegment.modelFileName).find("mlkit") != std::string::npos) {
+        segInfo.segUsed = "mlkit";
+    }
+    return mSegment.getSegmentOutInfo(image, contourMask, poseInfoPredictions, viewStr, segInfo);
+}
+
+bool SegmentationContext::inspect(ahiPoseInfo &poseInfoPredictions, cv::Mat contour, int yTopUp, int yTopLow,
+                                  int yBotUp, int yBotLow, bool doFullInspection) {
+    poseInfoPredictions.RA = false;
+    poseInfoPredictions.LA = false;
+    poseInfoPredictions.RL = false;
+    poseInfoPredictions.LL = false;
+    poseInfoPredictions.UB = false;
+    poseInfoPredictions.LB = false;
+    poseInfoPredictions.headInGreenZone = false;
+    poseInfoPredictions.anklesInGreenZone = false;
+    ahiFactoryInspection FI;
+    cv::Rect rectTop(0, yTopUp, mImageWidth, yTopLow - yTopUp);
+    cv::Rect rectBot(0, yBotUp, mImageWidth, yBotLow - yBotUp);
+    bool isHeadWithinGzoon = FI.isRectContainsPoint(rectTop, poseInfoPredictions.CentroidHeadTop);
+    bool isAnkleWithinGzoon =
+            FI.isRectContainsPoint(rectBot, poseInfoPredictions.CentroidRightAnkle) ||
+            FI.isRectContainsPoint(rectBot, poseInfoPredictions.CentroidLeftAnkle);
+    poseInfoPredictions.headInGreenZone = isHeadWithinGzoon;
+    poseInfoPredictions.anklesInGreenZone = isAnkleWithinGzoon;
+    // we shouldn't bother doing full inspection until head and ankles are within the green zones
+    if (!isHeadWithinGzoon || !isAnkleWithinGzoon || !doFullInspection) {
+        poseInfoPredictions.GE = false;
+        poseInfoPredictions.ErrorMsg = "";
+        return true;
+    }
+    bool fullInspectSucess = FI.inspectWithDetectedPosePlusContour(contour, poseInfoPredictions.Face,
+                                                                   poseInfoPredictions, yTopUp, yTopLow, yBotUp,
+                                                                   yBotLow);
+    if (!fullInspectSucess) {
+        poseInfoPredictions.GE = true;
+        poseInfoPredictions.ErrorMsg = "Inspection encountered issues";
+        return false;
+    }
+    return true;
+}
@@ -8,6 +8,8 @@
 #include "AHIAvatarGenHaarcascade_frontalface_alt2.hpp"
 #include "AHIAvatarGenHaarcascade_profileface.hpp"
 #include "CameraConstants.hpp"
+#include "Logging.hpp"
+#include <mutex>
 
 std::string ahiFactoryFace::to_lowerStr(std::string str) {
     std::for_each(str.begin(), str.end(), [](char &c) {
@@ -66,6 +68,60 @@ void ahiFactoryFace::detectFaceUsingOpencv(cv::Mat const &faceImage, cv::Cascade
     };
 }
 
+// The embedded cascades are parsed from XML once per process. detectMultiScale must not run concurrently on one
+// CascadeClassifier, so every thread reads its own classifiers from the already parsed storage (no XML parsing).
+static std::mutex gFaceCascadesMutex;
+
+static bool readFaceCascade(const char *xml, cv::FileStorage &storage, cv::CascadeClassifier &classifier) {
+    std::lock_guard<std::mutex> lock(gFaceCascadesMutex);
+    if (!storage.isOpened()) {
+        storage.open(xml, cv::FileStorage::READ | cv::FileStorage::FORMAT_XML | cv::FileStorage::MEMORY);
+    }
+    return storage.isOpened() && classifier.read(storage.getFirstTopLevelNode());
+}
+
+static cv::CascadeClassifier &frontFaceCascade() {
+    static cv::FileStorage storage;
+    thread_local cv::CascadeClassifier classifier;
+    if (classifier.empty() && !readFaceCascade(ahi_avatar_gen::front_face_features::data, storage, classifier)) {
+        LOG_GUARD(std::cout << "[ahiFactoryFace] unable to read the front face cascade" << std::endl)
+    }
+    return classifier;
+}
+
+static cv::CascadeClassifier &profileFaceCascade() {
+    static cv::FileStorage storage;
+    thread_local cv::CascadeClassifier classifier;
+    if (classifier.empty() && !readFaceCascade(ahi_avatar_gen::side_face_features::data, storage, classifier)) {
+        LOG_GUARD(std::cout << "[ahiFactoryFace] unable to read the profile face cascade" << std::endl)
+    }
+    return classifier;
+}
+
+// same detection as detectFaceUsingOpencv, on an already grayscale frame
+static bool detectTopFace(cv::Mat const &grayFrame, cv::CascadeClassifier &model, std::vector <cv::Rect> &outputFaces) {
+    if (model.empty() || grayFrame.empty()) {
+        return false;
+    }
+    std::vector <cv::Rect> faceRects;
+    cv::Size minFaceSize(30, 30);
+    cv::Size maxFaceSize(220, 220);
+    model.detectMultiScale(grayFrame, faceRects, 1.1, 3, 0, minFaceSize, maxFaceSize);
+    cv::Rect topRect;
+    int y = CAMERA_HEIGHT;
+    for (auto &faceRect:faceRects) {
+        if (faceRect.y < y) {
+            y = faceRect.y;
+            topRect = faceRect;
+        }
+    }
+    if (topRect.area() >= minFaceSize.area()) {
+        outputFaces.push_back(topRect);
+        return true;
+    }
+    return false;
+}
+
 // function for validating face with multiple face detector models
 void ahiFactoryFace::detectFaceCV(cv::Mat const &faceImage,
                                   std::vector <cv::Rect> &outputFaces) {
@@ -76,27 +132,36 @@ void ahiFactoryFace::detectFaceCV(cv::Mat const &faceImage,
     faceROI.y = 1;//30;
     faceROI.width = (faceImage.cols / 2); //400;
     faceROI.height = faceImage.rows / 3;//CAMERA_HEIGHT / 3;
-    cv::FileStorage fs;
-    cv::CascadeClassifier mFrontFaceCascadeDetector;
-    cv::CascadeClassifier mProfileFaceCascadeDetector;
-    fs.open(ahi_avatar_gen::front_face_features::data,
-            cv::FileStorage::READ | cv::FileStorage::FORMAT_XML | cv::FileStorage::MEMORY);
-    mFrontFaceCascadeDetector.read(fs.getFirstTopLevelNode()); //TODO: check result & handle.
-    fs.open(ahi_avatar_gen::side_face_features::data,
-            cv::FileStorage::READ | cv::FileStorage::FORMAT_XML | cv::FileStorage::MEMORY);
-    mProfileFaceCascadeDetector.read(fs.getFirstTopLevelNode()); //TODO: check result & handle.
+    cv::Mat roi = faceImage(faceROI);
+    // The grayscale frames detectMultiScale would otherwise convert on every pass are built once (and only when
+    // reached) and shared by the front, profile and flipped passes, which stop at the first detected face.
+    // The "RGB" retry of each pass is the same image with its red and blue swapped, i.e. an RGB2GRAY conversion.
+    cv::Mat grayBgr, grayRgb, grayFlipped;
+    auto gray = [&](cv::Mat &frame, int code) -> cv::Mat & {
+        if (frame.empty()) {
+            if (roi.channels() == 1) {
+                frame = roi;
+            } else {
+                cv::cvtColor(roi, frame, code);
+            }
+        }
+        return frame;
+    };
     if (outputFaces.empty()) {
-        detectFaceUsingOpencv(faceImage(faceROI), mFrontFaceCascadeDetector, false, false,
-                              outputFaces);
+        cv::CascadeClassifier &front = frontFaceCascade();
+        if (!detectTopFace(gray(grayBgr, cv::COLOR_BGR2GRAY), front, outputFaces)) {
+            detectTopFace(gray(grayRgb, cv::COLOR_RGB2GRAY), front, outputFaces);
+        }
     }
     //-- try opencv profile face detector
     if (outputFaces.empty()) {
-        detectFaceUsingOpencv(faceImage(faceROI), mProfileFaceCascadeDetector, false, false,
-                              outputFaces);
-    }
-    if (outputFaces.empty()) {
-        detectFaceUsingOpencv(faceImage(faceROI), mProfileFaceCascadeDetector, false, true,
-                              outputFaces);
+        cv::CascadeClassifier &profile = profileFaceCascade();
+        if (!detectTopFace(gray(grayBgr, cv::COLOR_BGR2GRAY), profile, outputFaces) &&
+            !detectTopFace(gray(grayRgb, cv::COLOR_RGB2GRAY), profile, outputFaces)) {
+            cv::flip(gray(grayBgr, cv::COLOR_BGR2GRAY), grayFlipped, 1);
+            // the retry of the flipped pass ran on the unflipped RGB image, already tried just above
+            detectTopFace(grayFlipped, profile, outputFaces);
+        }
     }
     if (!outputFaces.empty()) // below only if we feed 1280x720 and without Amar22 changes above
     {
@@ -239,6 +304,23 @@ ahiFactoryFace::loadTensorFlowFaceModelFromBufferOrFile(const char *buffer, std:
     return faceFT.mModel != nullptr;
 }
 
+bool ahiFactoryFace::loadTensorFlowFaceModelShared(std::shared_ptr<const tflite::FlatBufferModel> model,
+                                       std::string modelFileName) {
+    if (!isFaceInit) {
+        initFace();
+    }
+    faceFT.modelFileName = modelFileName;
+    faceFT.mSharedModel = std::move(model);
+    if (faceFT.mSharedModel == nullptr) {
+        return false;
+    }
+    if (!faceFT.buildOptimalInterpreter()) {
+        return false;
+    }
+    faceFT.GetModelInpOutNames();
+    return true;
+}
+
 bool ahiFactoryFace::feedInputBufferImageToCppToFace(const void *data, cv::Mat mat) {
     try {
         if (!isFaceInit) {
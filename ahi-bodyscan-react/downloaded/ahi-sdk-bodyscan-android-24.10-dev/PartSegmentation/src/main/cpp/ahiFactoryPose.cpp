@@ -6,6 +6,8 @@
 
 #include "ahiFactoryPose.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #include "ahiFactoryTensor.hpp"
@@ -111,278 +113,248 @@ bool ahiFactoryPose::mlkitPose(ahiPoseInfo &poseInfoPredictions) {
     return false;// TODO
 }
 
+// pose_light joints in heatmap channel order
+static const int POSE_LIGHT_JOINTS = 14;
+
+static cv::Point ahiPoseInfo::* const POSE_LIGHT_CENTROIDS[POSE_LIGHT_JOINTS] = {
+        &ahiPoseInfo::CentroidHeadTop, &ahiPoseInfo::CentroidNeck,
+        &ahiPoseInfo::CentroidRightShoulder, &ahiPoseInfo::CentroidRightElbow, &ahiPoseInfo::CentroidRightHand,
+        &ahiPoseInfo::CentroidLeftShoulder, &ahiPoseInfo::CentroidLeftElbow, &ahiPoseInfo::CentroidLeftHand,
+        &ahiPoseInfo::CentroidRightHip, &ahiPoseInfo::CentroidRightKnee, &ahiPoseInfo::CentroidRightAnkle,
+        &ahiPoseInfo::CentroidLeftHip, &ahiPoseInfo::CentroidLeftKnee, &ahiPoseInfo::CentroidLeftAnkle};
+
+static float ahiPoseInfo::* const POSE_LIGHT_CONFIDENCES[POSE_LIGHT_JOINTS] = {
+        &ahiPoseInfo::CentroidHeadTopConfidence, &ahiPoseInfo::CentroidNeckConfidence,
+        &ahiPoseInfo::CentroidRightShoulderConfidence, &ahiPoseInfo::CentroidRightElbowConfidence,
+        &ahiPoseInfo::CentroidRightHandConfidence,
+        &ahiPoseInfo::CentroidLeftShoulderConfidence, &ahiPoseInfo::CentroidLeftElbowConfidence,
+        &ahiPoseInfo::CentroidLeftHandConfidence,
+        &ahiPoseInfo::CentroidRightHipConfidence, &ahiPoseInfo::CentroidRightKneeConfidence,
+        &ahiPoseInfo::CentroidRightAnkleConfidence,
+        &ahiPoseInfo::CentroidLeftHipConfidence, &ahiPoseInfo::CentroidLeftKneeConfidence,
+        &ahiPoseInfo::CentroidLeftAnkleConfidence};
+
+// Heatmap value as the decoder reads it: at most 1, and 0 below the 0.1 noise floor (the iOS one).
+static inline float heatmapValue(float value) {
+    return value < 0.1f ? 0.f : std::min(value, 1.f);
+}
+
+struct ahiHeatmapPeak {
+    float max = 0;
+    int maxIndex = 0;
+    float sum = 0;
+    int support = 0; // pixels over the noise floor
+    float x = -1;    // heatmap coordinates, -1 when the channel is empty
+    float y = -1;
+};
+
+// Sub-pixel offset of a maximum at center from its two neighbours: the vertex of the parabola through their logs,
+// exact for a gaussian blob, or through the values themselves when a neighbour is under the noise floor.
+static float peakOffset(float before, float center, float after) {
+    if (before > 0 && after > 0) {
+        before = std::log(before);
+        center = std::log(center);
+        after = std::log(after);
+    }
+    float curvature = before - 2 * center + after;
+    if (curvature >= 0) { // flat, the maximum is saturated
+        return 0;
+    }
+    return std::max(-0.5f, std::min(0.5f, 0.5f * (before - after) / curvature));
+}
+
+// Peaks of the first POSE_LIGHT_JOINTS channels of rows x cols heatmaps interleaved by stride channels, in one pass
+// over the tensor, then refined to sub-pixel from the neighbours of each maximum.
+static void findHeatmapPeaks(const float *heatmaps, int rows, int cols, int stride,
+                             ahiHeatmapPeak (&peaks)[POSE_LIGHT_JOINTS]) {
+    for (int p = 0; p < rows * cols; p++) {
+        const float *pixel = heatmaps + (std::size_t) p * stride;
+        for (int c = 0; c < POSE_LIGHT_JOINTS; c++) {
+            float value = heatmapValue(pixel[c]);
+            if (value > 0) {
+                ahiHeatmapPeak &peak = peaks[c];
+                peak.sum += value;
+                peak.support++;
+                if (value > peak.max) {
+                    peak.max = value;
+                    peak.maxIndex = p;
+                }
+            }
+        }
+    }
+    auto at = [&](int i, int j, int c) {
+        if (i < 0 || i >= rows || j < 0 || j >= cols) {
+            return 0.f;
+        }
+        return heatmapValue(heatmaps[((std::size_t) i * cols + j) * stride + c]);
+    };
+    for (int c = 0; c < POSE_LIGHT_JOINTS; c++) {
+        ahiHeatmapPeak &peak = peaks[c];
+        if (peak.max <= 0) {
+            continue;
+        }
+        int i = peak.maxIndex / cols;
+        int j = peak.maxIndex % cols;
+        peak.x = j + peakOffset(at(i, j - 1, c), peak.max, at(i, j + 1, c));
+        peak.y = i + peakOffset(at(i - 1, j, c), peak.max, at(i + 1, j, c));
+    }
+}
+
 bool ahiFactoryPose::ahiPoseLight(ahiPoseInfo &poseInfoPredictions) {
-    // declare the constant for the heatmap
-    int const numChanel = 15;
-    int const numRow = 96; // we can get this from the model output as well
-    int const numCol = 96;
     // now we use ML to get the pose/joints, in this case this is a pose_light heatmap model
-    std::vector<std::string> OutputNames = poseFT.mOutputNames;
     ahiTensorOutputMap outputs;
     bool predPass = poseFT.invokeMIMO(poseFT.mInputs, outputs);
-    // iterate through the outputs
-    // in this case I'm use pose_light so one vector output is expected, but can be generalized
-    cv::Mat outputBlob;
-    for (auto outIter = outputs.begin(); outIter != outputs.end(); outIter++) {
-        std::string currModelOutNodeName = outIter->first;
-        std::cout << "Current output node name :" << currModelOutNodeName << "\n";
-        outputBlob = outIter->second._mat;
-        break;// index 0 is are the heatmaps
-    }
-    int paddingOffset = 0;
-    float xScale = 720.0 / 96.0;
-    float yScale = 1280.0 / 96.0;
+    if (!predPass || outputs.empty()) {
+        LOG_GUARD(std::cout << "predictFromHeatMapOpt() failed to run model" << std::endl)
+        return false;
+    }
+    // pose_light has one output, the heatmaps
+    const cv::Mat &outputBlob = outputs.begin()->second._mat;
+    return decodePoseLightHeatmaps(outputBlob, cv::Size(originalImageWidth, originalImageHeight),
+                                   poseInfoPredictions);
+}
+
+bool ahiFactoryPose::decodePoseLightHeatmaps(const cv::Mat &outputBlob, cv::Size captureSize,
+                                             ahiPoseInfo &poseInfoPredictions) {
+    if (outputBlob.type() != CV_32F || outputBlob.dims != 4 || !outputBlob.isContinuous() ||
+        outputBlob.size[3] < POSE_LIGHT_JOINTS || captureSize.width <= 0 || captureSize.height <= 0) {
+        return false;
+    }
+    const int numRow = outputBlob.size[1];
+    const int numCol = outputBlob.size[2];
+    // map the heatmaps onto the capture, or onto the square it was padded to for the model input
+    float xScale = (float) captureSize.width / numCol;
+    float yScale = (float) captureSize.height / numRow;
+    float xOffset = 0;
+    float yOffset = 0;
     if (isPaddedForResize) {
-        xScale = 1280.0 / 96.0;
-        paddingOffset = 280;
-    }
-    if (predPass) {
-        // perform the post processing of the heatMap
-        std::vector<float> heatMapEachSum(14, -1);
-        std::vector<float> heatMapEachRadius(14, -1);
-        for (int channel = 1; channel < numChanel; channel++) {
-            cv::Mat heatMapEach = cv::Mat::zeros(numRow, numCol, CV_32F);
-            for (int i = 0; i < numRow; i++) {
-                for (int j = 0; j < numCol; j++) {
-                    auto featureValue = (float) (outputBlob.at<cv::Vec4f>(0, i, j)[channel - 1]);
-                    if (featureValue > 1.0) { featureValue = 1.0; }
-                    if (featureValue < 0.1) // 0.1 was for iOS based
-                    { featureValue = 0.0; }
-                    heatMapEach.at<float>(cv::Point(j, i)) = featureValue;
-                }
-            }
-            cv::Point min_loc, max_loc;
-            double min_val, max_val;
-            cv::minMaxLoc(heatMapEach, &min_val, &max_val, &min_loc, &max_loc);
-            // refine the heatmap based on the contours
-            heatMapEach = 255. * heatMapEach / (max_val + 1.0e-10);
-            heatMapEachSum[channel - 1] = cv::sum(heatMapEach)[0];
-            // TODO: try to do moments as float and convert after.
-            heatMapEach.convertTo(heatMapEach, CV_8U);
-            cv::blur(heatMapEach, heatMapEach, cv::Size(3, 3)); // you may remove/keep but it helps
-            float cx = -1;
-            float cy = -1;
-            cv::Moments Mom;
-            float cx_mom = -1;
-            float cy_mom = -1;
-            float cxMinMax = -1;
-            float cyMinMax = -1;
-            heatMapEachRadius[channel - 1] = 0;
-            if (max_val > 0) {
-                std::vector<std::vector<cv::Point> > Blobcontours;
-                cv::findContours(heatMapEach.clone(), Blobcontours, cv::RETR_EXTERNAL,
-                                 cv::CHAIN_APPROX_SIMPLE);
-                std::vector<cv::Rect> boundRect(Blobcontours.size());
-                int biggest_blob_idx = 0;
-                float biggest_blob_area = -1;
-                for (size_t i = 0; i < Blobcontours.size(); i++) {
-                    boundRect[i] = boundingRect(Blobcontours[i]);
-                    float boundRect_area = boundRect[i].area();
-                    if (boundRect_area > biggest_blob_area) {
-                        biggest_blob_area = boundRect_area;
-                        biggest_blob_idx = i;
-                    }
-                }
-                // Head and ankle heatmaps is expected to have  the same or a wider width when cropped, but we can have
-                // a general method for all other joints if needed
-                float radius = 1;
-                cv::Point2f center;
-                // 4 or a small value means too close image anyway
-                if (Blobcontours[biggest_blob_idx].size() > 4) {
-                    cv::minEnclosingCircle(Blobcontours[biggest_blob_idx], center, radius);
-                    cx = center.x;
-                    cy = center.y;
-                } else {
-                    cxMinMax = max_loc.x;
-                    cyMinMax = max_loc.y;
-                    Mom = moments(heatMapEach, 0);
-                    cx_mom = Mom.m10 / (Mom.m00 + 1e-10);
-                    cy_mom = Mom.m01 / (Mom.m00 + 1e-10);
-                    cx = (cxMinMax + cx_mom) / 2;
-                    cy = (cyMinMax + cy_mom) / 2;
-                }
-                heatMapEachRadius[channel - 1] = radius;
-            }
-            // map jointCentroid to actual image size;
-            float cx_ = cx * xScale - paddingOffset;
-            float cy_ = cy * yScale;
-            cv::Point jointCentroid;
-            jointCentroid.x = (int) cx_;
-            jointCentroid.y = (int) cy_;
-            if (channel == 1) {
-                poseInfoPredictions.CentroidHeadTop = jointCentroid;
-                poseInfoPredictions.headFound = (jointCentroid.x > 0 && jointCentroid.y > 0) &&
-                                                (poseInfoPredictions.numOfDetectedFaces == 1);
-            }
-            if (channel == 2) { poseInfoPredictions.CentroidNeck = jointCentroid; }
-            if (channel == 3) { poseInfoPredictions.CentroidRightShoulder = jointCentroid; }
-            if (channel == 6) { poseInfoPredictions.CentroidLeftShoulder = jointCentroid; }
-            if (channel == 4) { poseInfoPredictions.CentroidRightElbow = jointCentroid; }
-            if (channel == 7) { poseInfoPredictions.CentroidLeftElbow = jointCentroid; }
-            if (channel == 5) {
-                poseInfoPredictions.CentroidRightHand = jointCentroid;
-                poseInfoPredictions.rightHandFound = (jointCentroid.x > 0 && jointCentroid.y > 0);
-            }
-            if (channel == 8) {
-                poseInfoPredictions.CentroidLeftHand = jointCentroid;
-                poseInfoPredictions.leftHandFound = (jointCentroid.x > 0 && jointCentroid.y > 0);
-            }
-            if (channel == 9) { poseInfoPredictions.CentroidRightHip = jointCentroid; }
-            if (channel == 12) { poseInfoPredictions.CentroidLeftHip = jointCentroid; }
-            if (channel == 10) { poseInfoPredictions.CentroidRightKnee = jointCentroid; }
-            if (channel == 13) { poseInfoPredictions.CentroidLeftKnee = jointCentroid; }
-            if (channel == 11) {
-                poseInfoPredictions.CentroidRightAnkle = jointCentroid;
-                poseInfoPredictions.rightLegFound = (jointCentroid.x > 0 && jointCentroid.y > 0);
-            }
-            if (channel == 14) {
-                poseInfoPredictions.CentroidLeftAnkle = jointCentroid;
-                poseInfoPredictions.leftLegFound = (jointCentroid.x > 0 && jointCentroid.y > 0);
-            }
+        int side = std::max(captureSize.width, captureSize.height);
+        xScale = (float) side / numCol;
+        yScale = (float) side / numRow;
+        xOffset = (side - captureSize.width) / 2.f;
+        yOffset = (side - captureSize.height) / 2.f;
+    }
+    ahiHeatmapPeak peaks[POSE_LIGHT_JOINTS];
+    findHeatmapPeaks((const float *) outputBlob.data, numRow, numCol, outputBlob.size[3], peaks);
+    // heatmap sums at the 0-255 scale of each channel, and the radius of each blob (the disc of its support, grown by
+    // the half pixel of its boundary)
+    float heatMapEachSum[POSE_LIGHT_JOINTS];
+    float heatMapEachRadius[POSE_LIGHT_JOINTS];
+    for (int j = 0; j < POSE_LIGHT_JOINTS; j++) {
+        const ahiHeatmapPeak &peak = peaks[j];
+        heatMapEachSum[j] = peak.max > 0 ? 255.f * peak.sum / peak.max : 0.f;
+        heatMapEachRadius[j] = peak.max > 0 ? std::max(1.f, std::sqrt(peak.support / (float) CV_PI) + 0.5f) : 0.f;
+        // map jointCentroid to actual image size
+        cv::Point jointCentroid(-1, -1);
+        if (peak.max > 0) {
+            jointCentroid = cv::Point(cvRound(peak.x * xScale - xOffset), cvRound(peak.y * yScale - yOffset));
         }
-        // Another fix attempt from the heatmap size itself. This is similar confidence scoring w.r.t others
-        // This seems working fine to adjust head, ankles and even wrists/hands
-        int counter = 0;
-        float heatmapAvg = 0;
-        float heatmapAvgRadious = 0;
-        for (int ch = 0; ch < 14; ch++) {
-            if (heatMapEachSum[ch] > 0) {
-                counter = counter + 1;
-                heatmapAvg = heatmapAvg + heatMapEachSum[ch];
-                heatmapAvgRadious = heatmapAvgRadious + heatMapEachRadius[ch];
-            }
+        poseInfoPredictions.*POSE_LIGHT_CENTROIDS[j] = jointCentroid;
+    }
+    auto found = [](const cv::Point &joint) { return joint.x > 0 && joint.y > 0; };
+    poseInfoPredictions.headFound =
+            found(poseInfoPredictions.CentroidHeadTop) && poseInfoPredictions.numOfDetectedFaces == 1;
+    poseInfoPredictions.rightHandFound = found(poseInfoPredictions.CentroidRightHand);
+    poseInfoPredictions.leftHandFound = found(poseInfoPredictions.CentroidLeftHand);
+    poseInfoPredictions.rightLegFound = found(poseInfoPredictions.CentroidRightAnkle);
+    poseInfoPredictions.leftLegFound = found(poseInfoPredictions.CentroidLeftAnkle);
+    // Another fix attempt from the heatmap size itself. This is similar confidence scoring w.r.t others
+    // This seems working fine to adjust head, ankles and even wrists/hands
+    int counter = 0;
+    float heatmapAvg = 0;
+    float heatmapAvgRadious = 0;
+    for (int ch = 0; ch < POSE_LIGHT_JOINTS; ch++) {
+        if (heatMapEachSum[ch] > 0) {
+            counter = counter + 1;
+            heatmapAvg = heatmapAvg + heatMapEachSum[ch];
+            heatmapAvgRadious = heatmapAvgRadious + heatMapEachRadius[ch];
         }
+    }
+    if (counter > 0) {
         heatmapAvg = heatmapAvg / counter;
         heatmapAvgRadious = xScale * heatmapAvgRadious / counter;
-        float ratioHead = std::min(1.0, heatMapEachSum[0] / (1.0e-10 + heatmapAvg));
-        float ratioRightAnkle = std::min(1.0, heatMapEachSum[10] / (1.0e-10 + heatmapAvg));
-        float ratioLeftAnkle = std::min(1.0, heatMapEachSum[13] / (1.0e-10 + heatmapAvg));
-        // if any of the above ratios is < 0.6, it simply means the joints is partly visible or not there at all
+    }
+    float ratioHead = std::min(1.0, heatMapEachSum[0] / (1.0e-10 + heatmapAvg));
+    float ratioRightAnkle = std::min(1.0, heatMapEachSum[10] / (1.0e-10 + heatmapAvg));
+    float ratioLeftAnkle = std::min(1.0, heatMapEachSum[13] / (1.0e-10 + heatmapAvg));
+    // if any of the above ratios is < 0.6, it simply means the joints is partly visible or not there at all
 
-        // Now headtop correction
-        if (ratioHead > 0 && poseInfoPredictions.CentroidHeadTop.y < 60) {
-            poseInfoPredictions.CentroidHeadTop.y = poseInfoPredictions.CentroidHeadTop.y -
-                                                    2.0 * (1. - ratioHead) * heatmapAvgRadious;
-        }
-        // Now RightAnkle correction
-        float ScaleRadiusAnkleX = 1.0;
-        if (poseInfoPredictions.view == "side") {
-            ScaleRadiusAnkleX = 0;
-        }
-        if (ratioRightAnkle > 0 && poseInfoPredictions.CentroidRightAnkle.y > (1280 - 60)) {
-            poseInfoPredictions.CentroidRightAnkle = poseInfoPredictions.CentroidRightAnkle +
-                                                     2.0 * (1. - ratioRightAnkle) * (cv::Point(
-                                                             -heatmapAvgRadious / 4 *
-                                                             ScaleRadiusAnkleX, heatmapAvgRadious));
-        }
-        // Now LeftAnkle correction
-        if (ratioLeftAnkle > 0 && poseInfoPredictions.CentroidLeftAnkle.y > (1280 - 60)) {
-            poseInfoPredictions.CentroidLeftAnkle = poseInfoPredictions.CentroidLeftAnkle +
-                                                    2.0 * (1. - ratioLeftAnkle) * (cv::Point(
-                                                            heatmapAvgRadious / 4 *
-                                                            ScaleRadiusAnkleX, heatmapAvgRadious));
-        }
-        // neck fix(up)
-        if (poseInfoPredictions.headFound) {
-            std::cout << "\n neck fix(up) using head" << "\n";
-            poseInfoPredictions.CentroidNeck.y = 0.85 * poseInfoPredictions.CentroidNeck.y +
-                                                 0.15 * poseInfoPredictions.CentroidHeadTop.y;
-        } else {
-            std::cout << "\n neck fix(up) using shoulders" << "\n";
-            poseInfoPredictions.CentroidNeck.y = 1.4 * poseInfoPredictions.CentroidNeck.y - 0.4 *
-                                                                                            (poseInfoPredictions.CentroidRightShoulder.y +
-                                                                                             poseInfoPredictions.CentroidLeftShoulder.y) /
-                                                                                            2.0;
-        }
-        // Approx confidence
-        float confidence_threshold = 0.7499;
-        for (int channel = 1; channel < 15; channel++) {
-            int j = channel - 1;
-            float confidence = std::min(1.0, heatMapEachSum[j] / (1.0e-10 + heatmapAvg));
-            float score = float(confidence < confidence_threshold);
-            if (channel == 1) {
-                poseInfoPredictions.CentroidHeadTopConfidence = confidence;
-            }
-            if (channel == 2) {
-                poseInfoPredictions.CentroidNeckConfidence = confidence;
-            }
-            if (channel == 3) {
-                poseInfoPredictions.CentroidRightShoulderConfidence = confidence;
-            }
-            if (channel == 6) {
-                poseInfoPredictions.CentroidLeftShoulderConfidence = confidence;
-            }
-            if (channel == 4) {
-                poseInfoPredictions.CentroidRightElbowConfidence = confidence;
-            }
-            if (channel == 7) {
-                poseInfoPredictions.CentroidLeftElbowConfidence = confidence;
-            }
-            if (channel == 5) {
-                poseInfoPredictions.CentroidRightHandConfidence = confidence;
-            }
-            if (channel == 8) {
-                poseInfoPredictions.CentroidLeftHandConfidence = confidence;
-            }
-            if (channel == 9) {
-                poseInfoPredictions.CentroidRightHipConfidence = confidence;
-            }
-            if (channel == 12) {
-                poseInfoPredictions.CentroidLeftHipConfidence = confidence;
-            }
-            if (channel == 10) {
-                poseInfoPredictions.CentroidRightKneeConfidence = confidence;
-            }
-            if (channel == 13) {
-                poseInfoPredictions.CentroidLeftKneeConfidence = confidence;
-            }
-            if (channel == 11) {
-                poseInfoPredictions.CentroidRightAnkleConfidence = confidence;
-            }
-            if (channel == 14) {
-                poseInfoPredictions.CentroidLeftAnkleConfidence = confidence;
-            }
-        }
-        // fix/check for people with face mask
-        if (poseInfoPredictions.CentroidHeadTopConfidence >= confidence_threshold) {
-            if (poseInfoPredictions.CentroidRightShoulderConfidence >= confidence_threshold &&
-                poseInfoPredictions.CentroidLeftShoulderConfidence >= confidence_threshold) {
-                cv::Point meanShoulder = (poseInfoPredictions.CentroidRightShoulder +
-                                          poseInfoPredictions.CentroidLeftShoulder) / 2;
-                cv::Point predNeckFromHeadShoulder =
-                        0.5 * poseInfoPredictions.CentroidHeadTop + 0.5 * meanShoulder;
-                if ((abs(poseInfoPredictions.CentroidNeck.x - predNeckFromHeadShoulder.x) +
-                     abs(poseInfoPredictions.CentroidNeck.y - predNeckFromHeadShoulder.y)) > 40) {
-                    poseInfoPredictions.CentroidNeck = predNeckFromHeadShoulder;
-                }
-                if (abs(poseInfoPredictions.CentroidNeck.x - meanShoulder.x) > 60) {
-                    poseInfoPredictions.CentroidNeck.x = meanShoulder.x;
-                }
-            } else if (
-                    poseInfoPredictions.CentroidRightShoulderConfidence >= confidence_threshold &&
-                    poseInfoPredictions.CentroidLeftShoulderConfidence < confidence_threshold) {
-                cv::Point predNeckFromHeadShoulder = (poseInfoPredictions.CentroidHeadTop +
-                                                      poseInfoPredictions.CentroidRightShoulder) /
-                                                     2;
-                if ((abs(poseInfoPredictions.CentroidNeck.x - predNeckFromHeadShoulder.x) +
-                     abs(poseInfoPredictions.CentroidNeck.y - predNeckFromHeadShoulder.y)) > 40) {
-                    poseInfoPredictions.CentroidNeck = predNeckFromHeadShoulder;
-                }
-            } else if (poseInfoPredictions.CentroidRightShoulderConfidence < confidence_threshold &&
-                       poseInfoPredictions.CentroidLeftShoulderConfidence >= confidence_threshold) {
-                cv::Point predNeckFromHeadShoulder = (poseInfoPredictions.CentroidHeadTop +
-                                                      poseInfoPredictions.CentroidLeftShoulder) / 2;
-                if ((abs(poseInfoPredictions.CentroidNeck.x - predNeckFromHeadShoulder.x) +
-                     abs(poseInfoPredictions.CentroidNeck.y - predNeckFromHeadShoulder.y)) > 40) {
-                    poseInfoPredictions.CentroidNeck = predNeckFromHeadShoulder;
-                }
+    // Now headtop correction
+    if (ratioHead > 0 && poseInfoPredictions.CentroidHeadTop.y < 60) {
+        poseInfoPredictions.CentroidHeadTop.y = poseInfoPredictions.CentroidHeadTop.y -
+                                                2.0 * (1. - ratioHead) * heatmapAvgRadious;
+    }
+    // Now RightAnkle correction
+    float ScaleRadiusAnkleX = 1.0;
+    if (poseInfoPredictions.view == "side") {
+        ScaleRadiusAnkleX = 0;
+    }
+    if (ratioRightAnkle > 0 && poseInfoPredictions.CentroidRightAnkle.y > (captureSize.height - 60)) {
+        poseInfoPredictions.CentroidRightAnkle = poseInfoPredictions.CentroidRightAnkle +
+                                                 2.0 * (1. - ratioRightAnkle) * (cv::Point(
+                                                         -heatmapAvgRadious / 4 *
+                                                         ScaleRadiusAnkleX, heatmapAvgRadious));
+    }
+    // Now LeftAnkle correction
+    if (ratioLeftAnkle > 0 && poseInfoPredictions.CentroidLeftAnkle.y > (captureSize.height - 60)) {
+        poseInfoPredictions.CentroidLeftAnkle = poseInfoPredictions.CentroidLeftAnkle +
+                                                2.0 * (1. - ratioLeftAnkle) * (cv::Point(
+                                                        heatmapAvgRadious / 4 *
+                                                        ScaleRadiusAnkleX, heatmapAvgRadious));
+    }
+    // neck fix(up)
+    if (poseInfoPredictions.headFound) {
+        // using head
+        poseInfoPredictions.CentroidNeck.y = 0.85 * poseInfoPredictions.CentroidNeck.y +
+                                             0.15 * poseInfoPredictions.CentroidHeadTop.y;
+    } else {
+        // using shoulders
+        poseInfoPredictions.CentroidNeck.y = 1.4 * poseInfoPredictions.CentroidNeck.y - 0.4 *
+                                                                                        (poseInfoPredictions.CentroidRightShoulder.y +
+                                                                                         poseInfoPredictions.CentroidLeftShoulder.y) /
+                                                                                        2.0;
+    }
+    // Approx confidence
+    float confidence_threshold = 0.7499;
+    for (int j = 0; j < POSE_LIGHT_JOINTS; j++) {
+        poseInfoPredictions.*POSE_LIGHT_CONFIDENCES[j] = std::min(1.0, heatMapEachSum[j] / (1.0e-10 + heatmapAvg));
+    }
+    // fix/check for people with face mask
+    if (poseInfoPredictions.CentroidHeadTopConfidence >= confidence_threshold) {
+        if (poseInfoPredictions.CentroidRightShoulderConfidence >= confidence_threshold &&
+            poseInfoPredictions.CentroidLeftShoulderConfidence >= confidence_threshold) {
+            cv::Point meanShoulder = (poseInfoPredictions.CentroidRightShoulder +
+                                      poseInfoPredictions.CentroidLeftShoulder) / 2;
+            cv::Point predNeckFromHeadShoulder =
+                    0.5 * poseInfoPredictions.CentroidHeadTop + 0.5 * meanShoulder;
+            if ((abs(poseInfoPredictions.CentroidNeck.x - predNeckFromHeadShoulder.x) +
+                 abs(poseInfoPredictions.CentroidNeck.y - predNeckFromHeadShoulder.y)) > 40) {
+                poseInfoPredictions.CentroidNeck = predNeckFromHeadShoulder;
+            }
+            if (abs(poseInfoPredictions.CentroidNeck.x - meanShoulder.x) > 60) {
+                poseInfoPredictions.CentroidNeck.x = meanShoulder.x;
+            }
+        } else if (
+                poseInfoPredictions.CentroidRightShoulderConfidence >= confidence_threshold &&
+                poseInfoPredictions.CentroidLeftShoulderConfidence < confidence_threshold) {
+            cv::Point predNeckFromHeadShoulder = (poseInfoPredictions.CentroidHeadTop +
+                                                  poseInfoPredictions.CentroidRightShoulder) /
+                                                 2;
+            if ((abs(poseInfoPredictions.CentroidNeck.x - predNeckFromHeadShoulder.x) +
+                 abs(poseInfoPredictions.CentroidNeck.y - predNeckFromHeadShoulder.y)) > 40) {
+                poseInfoPredictions.CentroidNeck = predNeckFromHeadShoulder;
+            }
+        } else if (poseInfoPredictions.CentroidRightShoulderConfidence < confidence_threshold &&
+                   poseInfoPredictions.CentroidLeftShoulderConfidence >= confidence_threshold) {
+            cv::Point predNeckFromHeadShoulder = (poseInfoPredictions.CentroidHeadTop +
+                                                  poseInfoPredictions.CentroidLeftShoulder) / 2;
+            if ((abs(poseInfoPredictions.CentroidNeck.x - predNeckFromHeadShoulder.x) +
+                 abs(poseInfoPredictions.CentroidNeck.y - predNeckFromHeadShoulder.y)) > 40) {
+                poseInfoPredictions.CentroidNeck = predNeckFromHeadShoulder;
             }
         }
-        return true;
-    } else {
-        LOG_GUARD(std::cout << "predictFromHeatMapOpt() failed to run model" << std::endl)
-        return false;
     }
+    return true;
 }
 
 bool ahiFactoryPose::ahiMoveNetPose(ahiPoseInfo &poseInfoPredictions) {
@@ -607,6 +579,23 @@ ahiFactoryPose::loadTensorFlowPoseModelFromBufferOrFile(const char *buffer, std:
     return poseFT.mModel != nullptr;
 }
 
+bool ahiFactoryPose::loadTensorFlowPoseModelShared(std::shared_ptr<const tflite::FlatBufferModel> model,
+                                       std::string modelFileName) {
+    if (!isPoseInit) {
+        initPose();
+    }
+    poseFT.modelFileName = modelFileName;
+    poseFT.mSharedModel = std::move(model);
+    if (poseFT.mSharedModel == nullptr) {
+        return false;
+    }
+    if (!poseFT.buildOptimalInterpreter()) {
+        return false;
+    }
+    poseFT.GetModelInpOutNames();
+    return true;
+}
+
 bool ahiFactoryPose::feedInputBufferImageToCppToPose(const void *data, cv::Mat mat) {
     try {
         if (!isPoseInit) {
@@ -669,7 +658,6 @@ bool ahiFactoryPose::feedInputBufferImageToCppToPose(const void *data, cv::Mat m
 
 bool ahiFactoryPose::getPoseInfoOutputs(cv::Mat image, ahiPoseInfo &poseInfoPredictions) {
     // lets do the pose now
-    ahiFactoryPose FP;
     bool ismlKitUsed =
             to_lowerStr(poseInfoPredictions.poseUsed).find("mlkit") != std::string::npos ||
             to_lowerStr(modelFileName).find("mlkit") != std::string::npos ||
@@ -680,9 +668,6 @@ bool ahiFactoryPose::getPoseInfoOutputs(cv::Mat image, ahiPoseInfo &poseInfoPred
         poseInfoPredictions.poseUsed = "mlkit";
         return poseSuccess;
     }
-    if (!FP.isPoseInit) {
-        FP.initPose();
-    }
     if(origImageMat.empty() || !image.empty()){
         feedInputBufferImageToCppToPose(nullptr, image);
     }
@@ -47,36 +47,84 @@ bool ahiFactorySegment::ahiDLSegment(ahiSegmentInfo &segInfo) {
         segInfo.segErrMsg = "Segmentation Invoke Failed";
         return false;
     }
-    int ix = 0; // we have one output here hence 0
-    auto outputName = segmentFT.mOutputNames[ix];
-    int pWidth = 256;
-    int pHeight = 256;
     cv::Mat OutResult;
     for (auto outIter = outputs.begin(); outIter != outputs.end(); outIter++) {
-        std::string currModelOutNodeName = outIter->first;
-        std::cout << "Current output node name :" << currModelOutNodeName << "\n";
         OutResult = outIter->second._mat;
     }
-    cv::Mat segMask(pHeight, pWidth, CV_32F);
-    int t = 0;
-    for (int y = 0; y < pHeight; ++y) {
-        for (int x = 0; x < pWidth; ++x) {
-            segMask.at<float>(cv::Point(x, y)) = (float) OutResult.at<cv::Vec4f>(0, y, x)[t];
-        }
+    if (OutResult.dims < 3) {
+        segInfo.segErrMsg = "Segmentation Output Unexpected";
+        return false;
     }
-    cv::Point min_loc, max_loc;
-    double min_val, max_val;
-    cv::minMaxLoc(segMask.clone(), &min_val, &max_val, &min_loc, &max_loc);// get peak location
-    segMask = 255. * segMask / (1.0e-10 + max_val);
-    segMask.convertTo(segMask, CV_8U);
-    int threshold = 0;
-    cv::threshold(segMask, segMask, threshold, 255, cv::THRESH_BINARY + cv::THRESH_OTSU);
+    // 1 x H x W x C output, the person is channel 0: it is the only one copied out of the tensor
+    int pHeight = OutResult.size[1];
+    int pWidth = OutResult.size[2];
+    int channels = OutResult.dims > 3 ? OutResult.size[3] : 1;
+    cv::Mat probabilities(pHeight, pWidth, CV_32FC(channels), OutResult.data);
+    cv::Mat segMask;
+    cv::extractChannel(probabilities, segMask, 0);
+    double max_val;
+    cv::minMaxLoc(segMask, nullptr, &max_val);
+    segMask.convertTo(segMask, CV_8U, 255. / (1.0e-10 + max_val));
+    // Otsu at the network resolution, only the mask is brought to the capture size
     cv::Size origSize(originalImageWidth, originalImageHeight);
-    cv::resize(segMask, segMask, origSize, CV_INTER_CUBIC);
-    segInfo.segmentDLMask = segMask;
+    if (softMaskUpscale) {
+        cv::Mat binary;
+        double threshold = cv::threshold(segMask, binary, 0, 255, cv::THRESH_BINARY + cv::THRESH_OTSU);
+        segInfo.segmentDLMask = upscaleThresholded(segMask, origSize, threshold);
+    } else {
+        cv::threshold(segMask, segMask, 0, 255, cv::THRESH_BINARY + cv::THRESH_OTSU);
+        cv::resize(segMask, segMask, origSize, 0, 0, cv::INTER_LINEAR);
+        segInfo.segmentDLMask = segMask;
+    }
     return true;
 }
 
+cv::Mat ahiFactorySegment::upscaleThresholded(const cv::Mat &soft, cv::Size size, double threshold) {
+    cv::Mat binary(size, CV_8UC1);
+    // source columns and weights of the bilinear interpolation, pixel centers aligned as in cv::resize
+    std::vector<int> x0(size.width), x1(size.width);
+    std::vector<float> wx(size.width);
+    double scaleX = (double) soft.cols / size.width;
+    for (int x = 0; x < size.width; x++) {
+        float fx = (float) ((x + 0.5) * scaleX - 0.5);
+        int ix = cvFloor(fx);
+        wx[x] = fx - ix;
+        if (ix < 0) {
+            ix = 0;
+            wx[x] = 0;
+        }
+        if (ix >= soft.cols - 1) {
+            ix = soft.cols - 1;
+            wx[x] = 0;
+        }
+        x0[x] = ix;
+        x1[x] = std::min(ix + 1, soft.cols - 1);
+    }
+    double scaleY = (double) soft.rows / size.height;
+    for (int y = 0; y < size.height; y++) {
+        float fy = (float) ((y + 0.5) * scaleY - 0.5);
+        int iy = cvFloor(fy);
+        float wy = fy - iy;
+        if (iy < 0) {
+            iy = 0;
+            wy = 0;
+        }
+        if (iy >= soft.rows - 1) {
+            iy = soft.rows - 1;
+            wy = 0;
+        }
+        const uchar *top = soft.ptr<uchar>(iy);
+        const uchar *bottom = soft.ptr<uchar>(std::min(iy + 1, soft.rows - 1));
+        uchar *out = binary.ptr<uchar>(y);
+        for (int x = 0; x < size.width; x++) {
+            float upper = top[x0[x]] + (top[x1[x]] - top[x0[x]]) * wx[x];
+            float lower = bottom[x0[x]] + (bottom[x1[x]] - bottom[x0[x]]) * wx[x];
+            out[x] = upper + (lower - upper) * wy > threshold ? 255 : 0;
+        }
+    }
+    return binary;
+}
+
 bool ahiFactorySegment::loadTensorFlowSegmentModelFromBufferOrFile(const char *buffer,
                                                                    std::size_t buffer_size,
                                                                    std::string modelFileName) {
@@ -91,8 +139,8 @@ bool ahiFactorySegment::loadTensorFlowSegmentModelFromBufferOrFile(const char *b
     }
     if (buffer_size > 10)  // model as buffer from Java or elsewhere
     {
+        // BuildFromBuffer maps the caller's buffer as is, there is no need to copy it to a file first
         segmentFT.mModel = tflite::FlatBufferModel::BuildFromBuffer(buffer, buffer_size);
-        bool saveSucess = segmentFT.saveModelBufferOnDevice(modelFileName, buffer, buffer_size);
     } else if (modelFileName.size() > 0 && buffer_size < 10) // full model name path is supplied
     {
         // here I can use the list of pose tflite models and load them. We need the full path of the model here
@@ -111,6 +159,24 @@ bool ahiFactorySegment::loadTensorFlowSegmentModelFromBufferOrFile(const char *b
     return segmentFT.mModel != nullptr;
 }
 
+bool ahiFactorySegment::loadTensorFlowSegmentModelShared(
+        std::shared_ptr<const tflite::FlatBufferModel> model, std::string modelFileName) {
+    if (!isSegmentInit) {
+        initSegment();
+    }
+    segmentFT.modelFileName = modelFileName;
+    segmentFT.mSharedModel = std::move(model);
+    if (segmentFT.mSharedModel == nullptr) {
+        return false;
+    }
+    // own interpreter (and delegate) over the shared read only model
+    if (!segmentFT.buildOptimalInterpreter()) {
+        return false;
+    }
+    segmentFT.GetModelInpOutNames();
+    return true;
+}
+
 bool ahiFactorySegment::feedInputBufferImageToCppToSegment(const void *data, cv::Mat mat) {
     try {
         if (!isSegmentInit) {
@@ -145,9 +211,14 @@ bool ahiFactorySegment::feedInputBufferImageToCppToSegment(const void *data, cv:
         cv::Mat preprocessed_image = segmentFT.processImageWorWoutPadding(mat, targetSize, top,
                                                                           bottom, left, right,
                                                                           toBGR, doPadding, toF32);
-        preprocessed_image = preprocessed_image / 255.0;
+        // scaled straight into the input tensor when it takes the preprocessed image as is
+        cv::Mat input = segmentFT.inputView(0);
+        if (input.size() != preprocessed_image.size() || input.channels() != preprocessed_image.channels()) {
+            input = cv::Mat();
+        }
+        preprocessed_image.convertTo(input, CV_32F, 1.0 / 255.0);
         segmentFT.addInput(InputNames[0],
-                           ahiTensorInput(preprocessed_image, true, false, targetSize, {1.0 / 255},
+                           ahiTensorInput(input, true, false, targetSize, {1.0 / 255},
                                           {0.}));
         return true;
     }
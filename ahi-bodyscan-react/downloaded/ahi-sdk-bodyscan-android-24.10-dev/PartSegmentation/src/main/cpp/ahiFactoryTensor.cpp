@@ -73,6 +73,7 @@ void ahiFactoryTensor::PrintModelInfo(const tflite::Interpreter *interpreter) {
 }
 
 void ahiFactoryTensor::GetModelInpOutNames() {
+    mSignature = ahiTensorSignature();
 // Below can be added to PrintModelInfo above
     const auto inputs = mInterpreter->inputs();
     mInputNames.clear();
@@ -101,12 +102,16 @@ bool ahiFactoryTensor::loadModel(const char *buffer, std::size_t buffer_size) {
     return mModel != nullptr;
 }
 
+bool ahiFactoryTensor::hasModel() const {
+    return mSharedModel != nullptr || mModel != nullptr;
+}
+
 void ahiFactoryTensor::resetInterpreter() {
     mInterpreter.reset();
 }
 
 bool ahiFactoryTensor::buildInterpreter() {
-    RETURN_FALSE_IF_TF_FAIL(tflite::InterpreterBuilder(*mModel, mResolver)(&mInterpreter))
+    RETURN_FALSE_IF_TF_FAIL(tflite::InterpreterBuilder(mSharedModel ? *mSharedModel : *mModel, mResolver)(&mInterpreter))
     mInterpreter->SetNumThreads(num_thread_);
 
     if (build_type_ == kNNAPI) {
@@ -127,7 +132,7 @@ bool ahiFactoryTensor::buildInterpreter() {
 }
 
 bool ahiFactoryTensor::buildOptimalInterpreter() {
-    RETURN_FALSE_IF_TF_FAIL(tflite::InterpreterBuilder(*mModel, mResolver)(&mInterpreter))
+    RETURN_FALSE_IF_TF_FAIL(tflite::InterpreterBuilder(mSharedModel ? *mSharedModel : *mModel, mResolver)(&mInterpreter))
     mInterpreter->SetNumThreads(num_thread_);
 
     TfLiteStatus Status;
@@ -817,81 +822,110 @@ bool ahiFactoryTensor::prepareInputsForImageBasedExtraMeas(cv::Mat front_silhoue
     }
 }
 
+bool ahiFactoryTensor::prepareSignature() {
+    if (mInterpreter == nullptr) {
+        return false;
+    }
+    if (mSignature.interpreter == mInterpreter.get()) {
+        return true;
+    }
+    static const bool typesMatched = (match_CV_TF_types(), true);
+    (void) typesMatched;
+    ahiTensorSignature signature;
+    signature.interpreter = mInterpreter.get();
+    for (int position = 0; position < (int) mInterpreter->inputs().size(); position++) {
+        signature.inputPositions[mInterpreter->GetInputName(position)] = position;
+        signature.inputDepths.push_back(openCV_TfLiteTypes[mInterpreter->input_tensor(position)->type]);
+    }
+    for (int position = 0; position < (int) mInterpreter->outputs().size(); position++) {
+        signature.outputDepths.push_back(openCV_TfLiteTypes[mInterpreter->output_tensor(position)->type]);
+    }
+    mSignature = signature;
+    return true;
+}
+
+cv::Mat ahiFactoryTensor::inputView(int position) {
+    if (!prepareSignature() || position < 0 || position >= (int) mSignature.inputDepths.size() ||
+        mSignature.inputDepths[position] < 0) {
+        return cv::Mat();
+    }
+    TfLiteTensor *tensor = mInterpreter->input_tensor(position);
+    int depth = mSignature.inputDepths[position];
+    if (tensor->dims->size == 4 && tensor->dims->data[0] == 1) {
+        return cv::Mat(tensor->dims->data[1], tensor->dims->data[2], CV_MAKETYPE(depth, tensor->dims->data[3]),
+                       tensor->data.raw);
+    }
+    if (tensor->dims->size == 0) {
+        return cv::Mat(1, 1, depth, tensor->data.raw);
+    }
+    return cv::Mat(tensor->dims->size, tensor->dims->data, depth, tensor->data.raw);
+}
+
 bool ahiFactoryTensor::invokeMIMO(ahiTensorInputMap &inputs, ahiTensorOutputMap &outputs) {
-    match_CV_TF_types();
-    //Stopwatch tfStopwatch(mModelName.c_str());
-    auto inputCount = inputs.size();
-    auto iter = inputs.begin();
-
-    while (iter != inputs.end()) {
-        // Get the iterator to the first named input - allows for unnamed input.
-        auto name = mInputNames.begin();
-        if (inputCount > 1) {
-            // If there's more than one input supplied -> search for input by name.
-            name = std::find(mInputNames.begin(), mInputNames.end(), iter->first);
-        }
-        if (name != mInputNames.end()) {
-            auto nameIx = std::distance(mInputNames.begin(), name);
-            const int inputIx = mInterpreter->inputs()[nameIx];
-            TfLiteTensor *tensor = mInterpreter->tensor(inputIx);
-            cv::Mat inputMat = iter->second._mat;
-            auto type = mInterpreter->input_tensor(nameIx)->type;
-
-            if (inputMat.rows > 1 && inputMat.cols > 1) {
-                int CV_type = openCV_TfLiteTypes[type];
-                if (CV_type < 0) {
-                    LOG_GUARD(std::cout << "TF input has unsupported CV type" << std::endl);
-                    return false;
-                }
-                inputMat.convertTo(inputMat, CV_type);
+    if (!prepareSignature()) {
+        return false;
+    }
+    for (auto iter = inputs.begin(); iter != inputs.end(); iter++) {
+        // a single input feeds the first tensor whatever its name, several are matched by name
+        int position = 0;
+        if (inputs.size() > 1) {
+            auto named = mSignature.inputPositions.find(iter->first);
+            if (named == mSignature.inputPositions.end()) {
+                continue;
             }
-            size_t cvSizeInBytes = inputMat.total() * inputMat.elemSize();
-            //LOG_GUARD(std::cout << "TensorModel::invoke cvSize:" << cvSizeInBytes << " Tensor bytes:" << tensor->bytes << std::endl)
-            if (cvSizeInBytes <= tensor->bytes) {
-                std::memcpy(mInterpreter->input_tensor(nameIx)->data.data, inputMat.data,
-                            cvSizeInBytes);
-            // original but not always good  memcpy(mInterpreter->typed_input_tensor<float>((int)nameIx), inputMat.data, cvSizeInBytes);
-            } else {
-                LOG_GUARD(std::cout << "[TensorModel::invoke]:" << mModelName << " error ("
-                                    << mInputNames[nameIx] << ") - invalid input mat size "
-                                    << cvSizeInBytes << " vs " << tensor->bytes << std::endl)
+            position = named->second;
+        }
+        TfLiteTensor *tensor = mInterpreter->input_tensor(position);
+        cv::Mat inputMat = iter->second._mat;
+        if (inputMat.data == reinterpret_cast<const uchar *>(tensor->data.raw)) {
+            continue; // preprocessed into inputView
+        }
+        if (!inputMat.isContinuous()) {
+            inputMat = inputMat.clone();
+        }
+        int depth = inputMat.depth();
+        if (inputMat.rows > 1 && inputMat.cols > 1 && depth != mSignature.inputDepths[position]) {
+            depth = mSignature.inputDepths[position];
+            if (depth < 0) {
+                LOG_GUARD(std::cout << "TF input has unsupported CV type" << std::endl);
                 return false;
             }
         }
-        iter++;
+        int type = CV_MAKETYPE(depth, inputMat.channels());
+        size_t cvSizeInBytes = inputMat.total() * CV_ELEM_SIZE(type);
+        if (cvSizeInBytes > tensor->bytes) {
+            LOG_GUARD(std::cout << "[TensorModel::invoke]:" << mModelName << " error (" << iter->first
+                                << ") - invalid input mat size " << cvSizeInBytes << " vs " << tensor->bytes << std::endl)
+            return false;
+        }
+        if (type != inputMat.type()) {
+            // converted straight into the tensor
+            cv::Mat tensorMat(inputMat.dims, inputMat.size.p, type, tensor->data.raw);
+            inputMat.convertTo(tensorMat, type);
+        } else {
+            std::memcpy(tensor->data.raw, inputMat.data, cvSizeInBytes);
+        }
     }
 
-    //TODO: check if all inputs succeeded.
-    //if (bAllInputsDone)
-    {
-        const TfLiteStatus status = mInterpreter->Invoke();
+    if (mInterpreter->Invoke() != kTfLiteOk) {
+        return false;
+    }
 
-        if (status != kTfLiteOk) {
+    for (int position = 0; position < (int) mInterpreter->outputs().size(); position++) {
+        const TfLiteTensor *tensor = mInterpreter->output_tensor(position);
+        int depth = mSignature.outputDepths[position];
+        if (depth < 0) {
             return false;
         }
-
-        auto ix = 0;
-        size_t nOutputs = mInterpreter->outputs().size();
-        //LOG_GUARD(std::cout << "[TensorModel::invoke]:" << mModelName << " nOutputs:" << nOutputs << std::endl)
-
-        while (ix < nOutputs) {
-            auto outputName = mOutputNames[ix];
-            const int outputIx = mInterpreter->outputs()[ix];
-            TfLiteTensor *tensor = mInterpreter->tensor(outputIx);
-            cv::Mat output(tensor->dims->size, tensor->dims->data, CV_32F);
-            size_t cvSizeInBytes = output.total() * output.elemSize();
-            //printTensor("Output", tensor);
-            //LOG_GUARD(std::cout << "[TensorModel::invoke]:" << mModelName << " cvSizeInBytes:" << cvSizeInBytes << std::endl)
-            memcpy(output.data, mInterpreter->typed_output_tensor<float>(ix), cvSizeInBytes);
-            ahiTensorOutput outputStruct;
-            outputStruct._mat = output;
-            outputs[outputName] = outputStruct;
-            ix++;
+        ahiTensorOutput outputStruct;
+        if (tensor->dims->size > 0) {
+            outputStruct._mat = cv::Mat(tensor->dims->size, tensor->dims->data, depth, tensor->data.raw);
+        } else {
+            outputStruct._mat = cv::Mat(1, 1, depth, tensor->data.raw);
         }
-
-        //LOG_GUARD(tfStopwatch.print())
-        return true;
+        outputs[mInterpreter->GetOutputName(position)] = outputStruct;
     }
+    return true;
 }
 
 FactoryTensorModelType ahiFactoryTensor::checkModel(const uint8_t *bytes) {
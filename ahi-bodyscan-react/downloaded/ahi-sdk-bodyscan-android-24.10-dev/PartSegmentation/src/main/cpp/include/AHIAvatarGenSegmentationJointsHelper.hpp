@@ -11,6 +11,15 @@
 
 #include "Common.hpp"
 
+// Coarse-to-fine grabCut: the pyramid level the labels are solved at first (0 runs every iteration at full resolution)
+// and the width, in full resolution pixels, of the band along the coarse boundary that is solved again at full resolution.
+#ifndef AHI_GRABCUT_PYRAMID_LEVEL
+#define AHI_GRABCUT_PYRAMID_LEVEL 0
+#endif
+#ifndef AHI_GRABCUT_BAND_WIDTH
+#define AHI_GRABCUT_BAND_WIDTH 8
+#endif
+
 namespace ahi_avatar_gen {
 
     class joints_helper {
@@ -39,9 +48,24 @@ namespace ahi_avatar_gen {
                                             const std::vector<cv::Point> &joints,
                                             cv::Mat contour_mask);
 
+        // Sets label under every disc of radius around the non-zero pixels of centers, as cv::circle per pixel would.
+        void paint_label_discs(cv::Mat &mask, const cv::Mat &centers, int radius, int label);
+
+        // Sets label under the lines of thickness from apex to every pixel of rect, as cv::line per pixel would.
+        void paint_label_fan(cv::Mat &mask, cv::Point apex, const cv::Rect &rect, int thickness, int label);
+
+        // The side view background around the knees, painted at once instead of discs and border lines per pixel.
+        void paint_side_knee_background(cv::Mat &mask, cv::Point knee, const cv::Rect &face_rect, int radius);
+
+        // grabCut initialized with the mask, coarse-to-fine when grabcut_pyramid_level > 0.
+        void grabcut_with_mask(const cv::Mat &image, cv::Mat &mask, int iterations);
+
     public:
         joints_helper(void);
 
+        int grabcut_pyramid_level = AHI_GRABCUT_PYRAMID_LEVEL;
+        int grabcut_band_width = AHI_GRABCUT_BAND_WIDTH;
+
         cv::Mat
         segment_using_net_joints_and_grabcut(const cv::Mat &orig_image, BodyScanCommon::Profile type,
                                              const cv::Mat &net_mask,
@@ -0,0 +1,89 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef BODYSCAN_SEGMENTATION_CONTEXT_HPP
+#define BODYSCAN_SEGMENTATION_CONTEXT_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+#include "ahiFactoryFace.hpp"
+#include "ahiFactoryPose.hpp"
+#include "ahiFactorySegment.hpp"
+
+// What a model registered with a SegmentationContext is run for.
+enum class ahiModelRole {
+    face,
+    pose,
+    segment
+};
+
+// The face detection, pose estimation and segmentation of one camera session or replay. A context owns its factories
+// and their interpreters, so contexts run on different threads at once; one context is used by one thread at a time.
+class SegmentationContext {
+public:
+    SegmentationContext() = default;
+
+    SegmentationContext(const SegmentationContext &) = delete;
+
+    SegmentationContext &operator=(const SegmentationContext &) = delete;
+
+    // Builds the interpreter of role over a tflite model in memory, which must outlive the context. modelName picks
+    // the variant within the role as the factories read it ("pose_light", "movenet", ...), it is not a path.
+    bool registerModel(ahiModelRole role, const char *buffer, std::size_t bufferSize, const std::string &modelName);
+
+    // Same over a model already loaded for another context, so it is not loaded once per context.
+    bool registerModel(ahiModelRole role, std::shared_ptr<const tflite::FlatBufferModel> model,
+                       const std::string &modelName);
+
+    // Builds the interpreter of role from modelName in modelDirectory (or modelName itself when it is a path).
+    bool registerModelFile(ahiModelRole role, const std::string &modelName);
+
+    // Faces found by the OpenCV cascades, with no model to register. Also what detectFace falls back to.
+    void useOpenCvFace();
+
+    // Role results ML Kit computed on the app side; the role then uses them instead of a model.
+    void feedMlKitFace(int faceX, int faceY, int faceHeight, int faceWidth, int numOfDetectedFaces);
+
+    void feedMlKitPose(std::vector<float> mlkitPoseResults);
+
+    void feedMlKitSegment(cv::Mat mlkitSegmentResults);
+
+    // Prepares the input of the role model from the capture.
+    bool feedImage(ahiModelRole role, const cv::Mat &image);
+
+    bool detectFace(cv::Mat image, ahiFaceInfo &faceInfo);
+
+    bool detectPose(cv::Mat image, std::string genderStr, std::string viewStr, ahiPoseInfo &poseInfoPredictions);
+
+    bool segment(cv::Mat image, cv::Mat contourMask, ahiPoseInfo poseInfoPredictions, std::string viewStr,
+                 ahiSegmentInfo &segInfo);
+
+    // Checks the head and ankles of poseInfoPredictions against the green zones [yTopUp, yTopLow] and
+    // [yBotUp, yBotLow], then the full pose against contour if doFullInspection. The results go to poseInfoPredictions.
+    bool inspect(ahiPoseInfo &poseInfoPredictions, cv::Mat contour, int yTopUp, int yTopLow, int yBotUp, int yBotLow,
+                 bool doFullInspection);
+
+    static std::vector<cv::Point> calcScaledContourPoints(std::vector<cv::Point> originalContourPoints, float headTopY,
+                                                          float ankleY, cv::Mat &scaledContourMat);
+
+    // Where registerModelFile looks for bare model names. Empty: they are opened as given.
+    std::string modelDirectory;
+
+private:
+    ahiFactoryFace mFace;
+    ahiFactoryPose mPose;
+    ahiFactorySegment mSegment;
+    mlKitFaceInfo mMlkitFace;
+    bool mUseMlkitFace = false;
+    int mImageWidth = 0;
+    int mImageHeight = 0;
+};
+
+#endif //BODYSCAN_SEGMENTATION_CONTEXT_HPP
@@ -42,7 +42,7 @@ public:
 
     void initFace();
 
-    bool isFaceInit;
+    bool isFaceInit = false;
 
     void getFactorTensorInstant();
 
@@ -53,6 +53,10 @@ public:
     bool loadTensorFlowFaceModelFromBufferOrFile(const char *buffer, std::size_t buffer_size,
                                                  std::string modelFileName);
 
+    // Builds this detector's own interpreter over a model loaded once for several of them.
+    bool loadTensorFlowFaceModelShared(std::shared_ptr<const tflite::FlatBufferModel> model,
+                                       std::string modelFileName);
+
     bool feedInputBufferImageToCppToFace(const void *data, cv::Mat mat);
 
     bool ahiDLFace(ahiFaceInfo &faceInfoPredictions);
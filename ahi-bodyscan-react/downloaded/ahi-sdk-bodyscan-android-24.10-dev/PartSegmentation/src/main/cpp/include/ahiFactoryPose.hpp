@@ -16,7 +16,7 @@ public:
 
     void initPose();
 
-    bool isPoseInit;
+    bool isPoseInit = false;
 
     void getFactorTensorInstant();
 
@@ -26,6 +26,10 @@ public:
 
     bool ahiPoseLight(ahiPoseInfo &jointsPrediction);
 
+    // Joints out of the pose_light heatmaps (1 x rows x cols x channels float, the first 14 channels are the joints)
+    // at the pixels of a captureSize capture, the post processing of ahiPoseLight. Allocates nothing.
+    bool decodePoseLightHeatmaps(const cv::Mat &outputBlob, cv::Size captureSize, ahiPoseInfo &jointsPrediction);
+
     std::vector<float> mlkitPoseData;
 
     bool mlkitPose(ahiPoseInfo &jointsPrediction);
@@ -33,6 +37,10 @@ public:
     bool loadTensorFlowPoseModelFromBufferOrFile(const char *buffer, std::size_t buffer_size,
                                                  std::string modelFileName);
 
+    // Builds this estimator's own interpreter over a model loaded once for several of them.
+    bool loadTensorFlowPoseModelShared(std::shared_ptr<const tflite::FlatBufferModel> model,
+                                       std::string modelFileName);
+
     bool feedInputBufferImageToCppToPose(const void *data, cv::Mat mat);
 
     bool getPoseInfoOutputs(cv::Mat image, ahiPoseInfo &poseInfoPredictions);
@@ -10,6 +10,12 @@
 #include "ahiFactoryInspection.hpp"
 #include "ahiFactoryTensor.hpp"
 
+// Brings the network mask to the capture size as the bilinear upscale of the soft mask thresholded on the fly, rather
+// than as the upscale of the thresholded mask.
+#ifndef AHI_SEGMENT_SOFT_MASK_UPSCALE
+#define AHI_SEGMENT_SOFT_MASK_UPSCALE 0
+#endif
+
 typedef struct {
     cv::Mat segmentMask;
     cv::Mat segmentDLMask;
@@ -25,7 +31,7 @@ public:
 
     void initSegment();
 
-    bool isSegmentInit;
+    bool isSegmentInit = false;
 
     void getFactorTensorInstant();
 
@@ -36,10 +42,20 @@ public:
     bool loadTensorFlowSegmentModelFromBufferOrFile(const char *buffer, std::size_t buffer_size,
                                                     std::string modelFileName);
 
+    // Builds this segmenter's interpreter from a model already loaded for another one, so concurrent segmenters
+    // each own an interpreter without loading the model again.
+    bool loadTensorFlowSegmentModelShared(std::shared_ptr<const tflite::FlatBufferModel> model,
+                                          std::string modelFileName);
+
     bool feedInputBufferImageToCppToSegment(const void *data, cv::Mat mat);
 
     bool ahiDLSegment(ahiSegmentInfo &segInfo);
 
+    bool softMaskUpscale = AHI_SEGMENT_SOFT_MASK_UPSCALE;
+
+    // Binary 0/255 mask of size, soft (CV_8U) upscaled bilinearly and thresholded in one pass.
+    static cv::Mat upscaleThresholded(const cv::Mat &soft, cv::Size size, double threshold);
+
     bool getSegmentOutInfo(cv::Mat image, cv::Mat contourMask, ahiPoseInfo poseInfoPredictions,
                            std::string viewStr, ahiSegmentInfo &segInfo);
 
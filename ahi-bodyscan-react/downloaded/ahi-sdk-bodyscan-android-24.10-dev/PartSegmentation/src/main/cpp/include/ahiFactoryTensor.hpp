@@ -7,6 +7,8 @@
 #ifndef ahiFactoryTensor_H_
 #define ahiFactoryTensor_H_
 
+#include <atomic>
+
 #include <opencv2/core/mat.hpp>
 #include <tensorflow/lite/delegates/gpu/delegate.h>
 #include <tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h>
@@ -74,6 +76,15 @@ typedef struct ahiTensorOutput {
 typedef std::unordered_map<std::string, ahiTensorInput> ahiTensorInputMap;
 typedef std::unordered_map<std::string, ahiTensorOutput> ahiTensorOutputMap;
 
+// Tensors of an interpreter resolved once: the input positions by name and the CV depth of every input and output
+// (< 0 when OpenCV has none matching the TFLite type).
+typedef struct ahiTensorSignature {
+    const tflite::Interpreter *interpreter = nullptr;
+    std::unordered_map<std::string, int> inputPositions;
+    std::vector<int> inputDepths;
+    std::vector<int> outputDepths;
+} ahiTensorSignature;
+
 typedef enum FactoryTensorModelType {
     ModelTypeUnknown,
     ModelTypeTF,
@@ -178,6 +189,8 @@ public:
 
     bool buildOptimalInterpreter();
 
+    bool hasModel() const;
+
     void resetInterpreter();
 
     void setNumThreads(int num);
@@ -213,6 +226,8 @@ public:
     // below are refactored FactoryTensor and TensorMap
     TfLiteDelegate *mDelegate;
     std::unique_ptr<tflite::FlatBufferModel> mModel;
+    // Used instead of mModel when several tensors build their own interpreter from one loaded model.
+    std::shared_ptr<const tflite::FlatBufferModel> mSharedModel;
     std::unique_ptr<tflite::Interpreter> mInterpreter;
     tflite::ops::builtin::BuiltinOpResolver mResolver;
     std::string mModelName;
@@ -227,8 +242,18 @@ public:
 
     int getInputDim(int, int);
 
+    // The outputs are headers over the output tensors, valid until the next invoke of the interpreter.
     bool invokeMIMO(ahiTensorInputMap &inputs, ahiTensorOutputMap &outputs);
 
+    // Resolves the signature of mInterpreter, once per interpreter.
+    bool prepareSignature();
+
+    // Header over the memory of input tensor position, an H x W x C image input as an H x W mat of C channels. An
+    // input preprocessed into it is not copied again by invokeMIMO.
+    cv::Mat inputView(int position);
+
+    ahiTensorSignature mSignature;
+
     std::vector<std::string> getModelFilesList(std::string gender, std::string measCatagory);
 
     std::string pickModelFromList(std::vector<std::string> mlModelsList, std::string keyword);
@@ -5,6 +5,8 @@
 #ifndef LOG_H_
 #define LOG_H_
 
+#include <android/log.h>
+
 #define ANDROID_LOG_TAG ""
 
 namespace ahi {
@@ -0,0 +1,137 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "bodyscan_bench.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+
+#include <opencv2/imgproc.hpp>
+
+namespace {
+    const int kImageWidth = 720;
+    const int kImageHeight = 1280;
+    const uint64_t kSeed = 20241017;
+
+    // ahiPoseInfo::tranformToCvJoints order, which is also the channel order of the pose_light heatmaps
+    const char *const kJointNames[14] = {
+            "CentroidHeadTop", "CentroidNeck",
+            "CentroidRightShoulder", "CentroidRightElbow", "CentroidRightHand",
+            "CentroidLeftShoulder", "CentroidLeftElbow", "CentroidLeftHand",
+            "CentroidRightHip", "CentroidRightKnee", "CentroidRightAnkle",
+            "CentroidLeftHip", "CentroidLeftKnee", "CentroidLeftAnkle"};
+
+    // A person standing in A pose, centred, head to ankles filling the frame like the capture guides ask for.
+    const cv::Point kFrontJoints[14] = {
+            {360, 95}, {360, 230},
+            {262, 268}, {205, 470}, {175, 650},
+            {458, 268}, {515, 470}, {545, 650},
+            {318, 640}, {312, 900}, {306, 1180},
+            {402, 640}, {408, 900}, {414, 1180}};
+
+    std::vector<cv::Point> profileJoints(BodyScanCommon::Profile profile) {
+        std::vector<cv::Point> joints(std::begin(kFrontJoints), std::end(kFrontJoints));
+        if (profile == BodyScanCommon::Profile::side) {
+            // seen from the side the limbs overlap the torso
+            for (auto &joint: joints) {
+                joint.x = kImageWidth / 2 + (int) std::lround(0.3 * (joint.x - kImageWidth / 2));
+            }
+        }
+        return joints;
+    }
+
+    cv::Mat drawFigure(const std::vector<cv::Point> &joints, BodyScanCommon::Profile profile) {
+        cv::Mat mask = cv::Mat::zeros(kImageHeight, kImageWidth, CV_8U);
+        const cv::Scalar on(255);
+        double widthScale = profile == BodyScanCommon::Profile::side ? 0.7 : 1.0;
+        int headRadius = (joints[1].y - joints[0].y) / 2;
+        cv::ellipse(mask, cv::Point(joints[0].x, joints[0].y + headRadius),
+                    cv::Size((int) (0.8 * headRadius * widthScale), headRadius), 0, 0, 360, on, cv::FILLED);
+        cv::line(mask, joints[0] + cv::Point(0, headRadius), joints[1], on, (int) (60 * widthScale));
+        std::vector<cv::Point> torso = {joints[2], joints[5], joints[11], joints[8]};
+        if (profile == BodyScanCommon::Profile::side) {
+            int halfDepth = 70;
+            torso = {cv::Point(joints[1].x - halfDepth, joints[2].y), cv::Point(joints[1].x + halfDepth, joints[2].y),
+                     cv::Point(joints[1].x + halfDepth, joints[8].y), cv::Point(joints[1].x - halfDepth, joints[8].y)};
+        }
+        cv::fillConvexPoly(mask, torso, on);
+        const int limbs[][2] = {{2, 3}, {3, 4}, {5, 6}, {6, 7}, {8, 9}, {9, 10}, {11, 12}, {12, 13}};
+        for (auto &limb: limbs) {
+            int thickness = limb[0] >= 8 ? 70 : 45;
+            cv::line(mask, joints[limb[0]], joints[limb[1]], on, (int) (thickness * widthScale));
+        }
+        return mask;
+    }
+
+    bodyscan_bench::SyntheticScan makeScan(BodyScanCommon::Profile profile) {
+        bodyscan_bench::SyntheticScan scan;
+        scan.joints = profileJoints(profile);
+        for (std::size_t i = 0; i < scan.joints.size(); i++) {
+            scan.namedJoints[kJointNames[i]] = cv::Point2f((float) scan.joints[i].x, (float) scan.joints[i].y);
+        }
+        scan.silhouette = drawFigure(scan.joints, profile);
+        cv::dilate(scan.silhouette, scan.contourMask,
+                   cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(51, 51)));
+
+        // a lit wall, the figure in darker clothes, and sensor noise on both
+        cv::RNG rng(kSeed + (uint64_t) profile);
+        scan.capture.create(kImageHeight, kImageWidth, CV_8UC3);
+        for (int y = 0; y < kImageHeight; y++) {
+            auto *row = scan.capture.ptr<cv::Vec3b>(y);
+            uchar wall = cv::saturate_cast<uchar>(200 - y / 16);
+            for (int x = 0; x < kImageWidth; x++) {
+                row[x] = cv::Vec3b(wall, wall, cv::saturate_cast<uchar>(wall - 10));
+            }
+        }
+        scan.capture.setTo(cv::Scalar(70, 60, 90), scan.silhouette);
+        cv::Mat noise(scan.capture.size(), CV_16SC3);
+        rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(8));
+        cv::Mat noisy;
+        scan.capture.convertTo(noisy, CV_16SC3);
+        noisy += noise;
+        noisy.convertTo(scan.capture, CV_8UC3);
+        return scan;
+    }
+}
+
+const bodyscan_bench::SyntheticScan &bodyscan_bench::syntheticScan(BodyScanCommon::Profile profile) {
+    static const SyntheticScan front = makeScan(BodyScanCommon::Profile::front);
+    static const SyntheticScan side = makeScan(BodyScanCommon::Profile::side);
+    return profile == BodyScanCommon::Profile::front ? front : side;
+}
+
+cv::Mat bodyscan_bench::syntheticHeatmaps(BodyScanCommon::Profile profile) {
+    const int size = 96;
+    const int channels = 14;
+    const int dims[] = {1, size, size, channels};
+    cv::Mat heatmaps(4, dims, CV_32F);
+    const std::vector<cv::Point> &joints = syntheticScan(profile).joints;
+    const double sigma = 2.0;
+    auto *data = (float *) heatmaps.data;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            for (int c = 0; c < channels; c++) {
+                double dx = x - joints[c].x * size / (double) kImageWidth;
+                double dy = y - joints[c].y * size / (double) kImageHeight;
+                data[(y * size + x) * channels + c] = (float) std::exp(-(dx * dx + dy * dy) / (2 * sigma * sigma));
+            }
+        }
+    }
+    return heatmaps;
+}
+
+bodyscan_cli::Resources *bodyscan_bench::resources() {
+    static std::unique_ptr<bodyscan_cli::Resources> loaded = []() {
+        std::unique_ptr<bodyscan_cli::Resources> resources(new bodyscan_cli::Resources());
+        const char *dir = std::getenv("BODYSCAN_RESOURCES");
+        if (dir == nullptr || !bodyscan_cli::loadResources(dir, *resources)) {
+            resources.reset();
+        }
+        return resources;
+    }();
+    return loaded.get();
+}
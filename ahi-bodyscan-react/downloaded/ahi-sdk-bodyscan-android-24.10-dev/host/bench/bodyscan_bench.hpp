@@ -0,0 +1,38 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef BODYSCAN_BENCH_HPP
+#define BODYSCAN_BENCH_HPP
+
+#include <benchmark/benchmark.h>
+
+#include "bodyscan_cli.hpp"
+
+// Fixed inputs of the stage benchmarks. The captures are drawn from a fixed seed so every run of every build measures
+// the same pixels; the stages that need models read them from the directory in $BODYSCAN_RESOURCES (laid out as for
+// bodyscan_cli) and are skipped without it.
+namespace bodyscan_bench {
+    const float kHeightCM = 180.0f;
+    const float kWeightKG = 80.0f;
+
+    struct SyntheticScan {
+        cv::Mat capture;                // 1280x720 RGB, as captures reach the native code
+        cv::Mat silhouette;             // CV_8U 0/255 mask of the figure
+        cv::Mat contourMask;            // CV_8U filled mask around the figure, as generateContourMask draws it
+        std::vector<cv::Point> joints;  // in the order of ahiPoseInfo::tranformToCvJoints
+        bodyscan_cli::Joints namedJoints;
+    };
+
+    const SyntheticScan &syntheticScan(BodyScanCommon::Profile profile);
+
+    // pose_light output for the joints of the scan, 1x96x96x14 gaussian heatmaps.
+    cv::Mat syntheticHeatmaps(BodyScanCommon::Profile profile);
+
+    // nullptr when $BODYSCAN_RESOURCES is not set or cannot be read.
+    bodyscan_cli::Resources *resources();
+}
+
+#endif //BODYSCAN_BENCH_HPP
@@ -0,0 +1,112 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "bodyscan_bench.hpp"
+
+#include "AHIAvatarGenClassificationHelper.hpp"
+#include "Classification.hpp"
+#include "ahiFactoryClassify.hpp"
+#include "ahiResultCache.hpp"
+#include "ahiSvrEngine.hpp"
+
+namespace {
+    void BM_extract_image_features(benchmark::State &state) {
+        const bodyscan_bench::SyntheticScan &front = bodyscan_bench::syntheticScan(BodyScanCommon::Profile::front);
+        const bodyscan_bench::SyntheticScan &side = bodyscan_bench::syntheticScan(BodyScanCommon::Profile::side);
+        ahi_avatar_gen::classification_helper helper;
+        for (auto _: state) {
+            std::vector<double> features = helper.extract_image_features(
+                    bodyscan_bench::kHeightCM, bodyscan_bench::kWeightKG, "M", front.silhouette, side.silhouette,
+                    front.namedJoints, side.namedJoints);
+            benchmark::DoNotOptimize(features.data());
+        }
+    }
+
+    BENCHMARK(BM_extract_image_features)->Unit(benchmark::kMillisecond);
+
+    // A bank shaped like the image features bank of classification_helper::classify: 19 SVRs over the 126 features,
+    // with range(0) support vectors each.
+    void BM_ahiSvrBank_predict(benchmark::State &state) {
+        const int numModels = 19;
+        const auto numVectors = (std::size_t) state.range(0);
+        cv::RNG rng(20241017);
+        std::vector<std::string> names;
+        std::map<std::string, AHIModelSVR> svrs;
+        for (int model = 0; model < numModels; model++) {
+            AHIModelSVR svr;
+            svr.name = "svr_" + std::to_string(model);
+            svr.vectors.assign(numVectors, std::vector<double>(N_FEATURES_svr_image_features));
+            for (auto &vector: svr.vectors) {
+                for (auto &value: vector) {
+                    value = rng.uniform(-1.0, 1.0);
+                }
+            }
+            svr.coefficients.resize(numVectors);
+            for (auto &coefficient: svr.coefficients) {
+                coefficient = rng.uniform(-1.0, 1.0);
+            }
+            svr.intercepts = {rng.uniform(-1.0, 1.0)};
+            names.push_back(svr.name);
+            svrs[svr.name] = svr;
+        }
+        ahiSvrKernel kernel;
+        kernel.type = KERNEL_TYPE;
+        kernel.gamma = KERNEL_GAMMA;
+        kernel.coef = KERNEL_COEF;
+        kernel.degree = KERNEL_DEGREE;
+        ahiSvrBank bank(names, svrs, N_FEATURES_svr_image_features, kernel);
+        std::vector<double> features(N_FEATURES_svr_image_features);
+        for (auto &feature: features) {
+            feature = rng.uniform(-1.0, 1.0);
+        }
+        for (auto _: state) {
+            std::vector<double> predicted = bank.predict(features);
+            benchmark::DoNotOptimize(predicted.data());
+        }
+        state.SetItemsProcessed((int64_t) (state.iterations() * numModels * numVectors));
+    }
+
+    BENCHMARK(BM_ahiSvrBank_predict)->Arg(250)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+    void BM_ahiDLClassification(benchmark::State &state) {
+        bodyscan_cli::Resources *resources = bodyscan_bench::resources();
+        if (resources != nullptr) {
+            bodyscan_cli::selectModels(*resources, Classification::getTfLiteModelNames(),
+                                       Classification::getSvrModelNames());
+        }
+        if (resources == nullptr || resources->tfModels.empty()) {
+            state.SkipWithError("ML models need BODYSCAN_RESOURCES");
+            return;
+        }
+        const bodyscan_bench::SyntheticScan &front = bodyscan_bench::syntheticScan(BodyScanCommon::Profile::front);
+        const bodyscan_bench::SyntheticScan &side = bodyscan_bench::syntheticScan(BodyScanCommon::Profile::side);
+        // silhouettes come back from Kotlin as RGBA bitmaps
+        cv::Mat frontSilhouette, sideSilhouette;
+        cv::cvtColor(front.silhouette, frontSilhouette, cv::COLOR_GRAY2RGBA);
+        cv::cvtColor(side.silhouette, sideSilhouette, cv::COLOR_GRAY2RGBA);
+        ahi_avatar_gen::classification_helper helper;
+        std::vector<double> features = helper.extract_image_features(
+                bodyscan_bench::kHeightCM, bodyscan_bench::kWeightKG, "M", front.silhouette, side.silhouette,
+                front.namedJoints, side.namedJoints);
+        ahiFactoryClassify classifier{};
+        classifier.classifyWorkers = (int) state.range(0);
+        classifier.hashTfModels(resources->tfModels);
+        for (auto _: state) {
+            // the models run on every iteration, not served from the previous one's outputs
+            state.PauseTiming();
+            ahiResultCache::getInstance()->clear();
+            state.ResumeTiming();
+            std::vector<std::pair<std::string, std::vector<float>>> classResultsRawPairs;
+            classifier.ahiDLClassification(bodyscan_bench::kHeightCM, bodyscan_bench::kWeightKG, "M",
+                                           frontSilhouette, sideSilhouette, features, "shape_and_comp",
+                                           resources->tfModels, classResultsRawPairs);
+            benchmark::DoNotOptimize(classResultsRawPairs.data());
+        }
+    }
+
+    // classification workers, 0 for the default count
+    BENCHMARK(BM_ahiDLClassification)->Arg(1)->Arg(2)->Arg(4)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime();
+}
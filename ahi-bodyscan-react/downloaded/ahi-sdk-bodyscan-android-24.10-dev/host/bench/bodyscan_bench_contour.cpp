@@ -0,0 +1,59 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "bodyscan_bench.hpp"
+
+#include "AvatarGenCommon.hpp"
+#include "AvatarGenContour.hpp"
+#include "AvatarGenSkinning.hpp"
+
+#include <cmath>
+
+namespace {
+    void BM_get_silhouttes_from_avatar(benchmark::State &state) {
+        auto profile = (BodyScanCommon::Profile) state.range(0);
+        bodyscan_cli::Resources *resources = bodyscan_bench::resources();
+        if (resources == nullptr || resources->cvModelsMale.empty()) {
+            state.SkipWithError("CV models need BODYSCAN_RESOURCES");
+            return;
+        }
+        avatar_gen::common::getInstance(BodyScanCommon::male, resources->cvModelsMale, resources->cvModelsFemale);
+        for (auto _: state) {
+            std::string error;
+            cv::Mat silhouette = avatar_gen::contour::get_silhouttes_from_avatar(
+                    1280, 720, bodyscan_bench::kHeightCM, bodyscan_bench::kWeightKG, BodyScanCommon::male, profile,
+                    error);
+            benchmark::DoNotOptimize(silhouette.data);
+        }
+    }
+
+    BENCHMARK(BM_get_silhouttes_from_avatar)->Arg(BodyScanCommon::Profile::front)
+            ->Arg(BodyScanCommon::Profile::side)->Unit(benchmark::kMillisecond);
+
+    // The front silhouette pose skinned onto the mean mesh, range(0) 1 for the inversion mesh.
+    void BM_skinning_deform(benchmark::State &state) {
+        bodyscan_cli::Resources *resources = bodyscan_bench::resources();
+        if (resources == nullptr || resources->cvModelsMale.empty()) {
+            state.SkipWithError("CV models need BODYSCAN_RESOURCES");
+            return;
+        }
+        const avatar_gen::common *c = avatar_gen::common::getInstance(BodyScanCommon::male, resources->cvModelsMale,
+                                                                      resources->cvModelsFemale);
+        std::vector<float> thetas_pose = {(float) M_PI / 10, (float) -M_PI / 10, (float) M_PI / 40,
+                                          (float) -M_PI / 40};
+        std::vector<float> thetas_feet(2, 0.0);
+        avatar_gen::skinning &skinning = avatar_gen::skinning::get(BodyScanCommon::male, state.range(0) != 0);
+        std::vector<float> vertices;
+        for (auto _: state) {
+            avatar_gen::skinning::pose pose;
+            avatar_gen::skinning::make_pose(c->getSkV(BodyScanCommon::male), thetas_pose, thetas_feet, pose);
+            skinning.deform(pose, vertices);
+            benchmark::DoNotOptimize(vertices.data());
+        }
+    }
+
+    BENCHMARK(BM_skinning_deform)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+}
@@ -0,0 +1,213 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "bodyscan_bench.hpp"
+
+#include "AHIAvatarGenInversion.hpp"
+#include "AHIAvatarGenMeshWriter.hpp"
+#include "AHIAvatarGenPredMesh.hpp"
+#include "AHIAvatarGenShapeBasis.hpp"
+#include "AHIBSModelPack.hpp"
+#include "AvatarGenCommon.hpp"
+
+namespace {
+    // Measurements of an average man of the synthetic height and weight, the fitness classification defaults to.
+    const std::vector<float> kParameters = {bodyscan_bench::kHeightCM, bodyscan_bench::kWeightKG, 100.0f, 88.0f, 101.0f,
+                                            81.0f, 0.8f};
+
+    const avatar_gen::common *loadCommon() {
+        bodyscan_cli::Resources *resources = bodyscan_bench::resources();
+        if (resources == nullptr || resources->cvModelsMale.empty()) {
+            return nullptr;
+        }
+        return avatar_gen::common::getInstance(BodyScanCommon::male, resources->cvModelsMale,
+                                               resources->cvModelsFemale);
+    }
+
+    bool runInv(std::vector<float> &vertices) {
+        avatar_gen::pred_mesh pm(BodyScanCommon::male);
+        std::vector<float> parameters = kParameters;
+        std::vector<float> thetas_pose(4, 0.0);
+        std::vector<float> thetas_feet(2, 0.0);
+        return pm.runInv(parameters, thetas_pose, thetas_feet, vertices) == "Passed";
+    }
+
+    void BM_runInv(benchmark::State &state) {
+        if (loadCommon() == nullptr) {
+            state.SkipWithError("CV models need BODYSCAN_RESOURCES");
+            return;
+        }
+        for (auto _: state) {
+            std::vector<float> vertices;
+            runInv(vertices);
+            benchmark::DoNotOptimize(vertices.data());
+        }
+    }
+
+    BENCHMARK(BM_runInv)->Unit(benchmark::kMillisecond);
+
+    // Height and weight known, the other measurements predicted from them, as a scan without classification does.
+    void BM_initialize_parameters(benchmark::State &state) {
+        if (loadCommon() == nullptr) {
+            state.SkipWithError("CV models need BODYSCAN_RESOURCES");
+            return;
+        }
+        avatar_gen::pred_mesh pm(BodyScanCommon::male);
+        std::vector<float> parameters = {bodyscan_bench::kHeightCM, bodyscan_bench::kWeightKG, -100.0f, -100.0f, -100.0f,
+                                         -100.0f, -100.0f};
+        for (auto _: state) {
+            std::vector<float> predicted = pm.initialize_parameters(parameters);
+            benchmark::DoNotOptimize(predicted.data());
+        }
+    }
+
+    BENCHMARK(BM_initialize_parameters)->Unit(benchmark::kMicrosecond);
+
+    // Shape basis of the inversion mesh added into the mean mesh, split over range(0) threads.
+    void BM_shape_basis_add_to(benchmark::State &state) {
+        const avatar_gen::common *c = loadCommon();
+        if (c == nullptr) {
+            state.SkipWithError("CV models need BODYSCAN_RESOURCES");
+            return;
+        }
+        avatar_gen::shape_basis &basis = avatar_gen::shape_basis::get(BodyScanCommon::male, true);
+        const float coefficients[avatar_gen::shape_basis::N_COEFFS] = {5.0f, 10.0f, 2.0f, -3.0f, 1.0f, -2.0f, 0.1f};
+        const AHIBSModelPackView<float> mean = c->getVertsInv(BodyScanCommon::male);
+        std::vector<float> vertices(mean.begin(), mean.end());
+        for (auto _: state) {
+            basis.add_to(coefficients, vertices, (int) state.range(0));
+            benchmark::DoNotOptimize(vertices.data());
+        }
+    }
+
+    BENCHMARK(BM_shape_basis_add_to)->Arg(1)->Arg(2)->Arg(4)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+    // range(0) inversion meshes reconstructed in one pass over the basis.
+    void BM_shape_basis_reconstruct_batch(benchmark::State &state) {
+        if (loadCommon() == nullptr) {
+            state.SkipWithError("CV models need BODYSCAN_RESOURCES");
+            return;
+        }
+        avatar_gen::shape_basis &basis = avatar_gen::shape_basis::get(BodyScanCommon::male, true);
+        int num_meshes = (int) state.range(0);
+        std::vector<float> coefficients((std::size_t) num_meshes * avatar_gen::shape_basis::N_COEFFS);
+        for (std::size_t i = 0; i < coefficients.size(); i++) {
+            coefficients[i] = (float) (i % 11) - 5.0f;
+        }
+        std::vector<float> meshes;
+        for (auto _: state) {
+            basis.reconstruct_batch(coefficients, num_meshes, meshes);
+            benchmark::DoNotOptimize(meshes.data());
+        }
+        state.SetItemsProcessed(state.iterations() * num_meshes);
+    }
+
+    BENCHMARK(BM_shape_basis_reconstruct_batch)->Arg(1)->Arg(8)->Arg(32)->Unit(benchmark::kMicrosecond);
+
+    void BM_compute_part_laplacian_cot_weights(benchmark::State &state) {
+        const avatar_gen::common *c = loadCommon();
+        std::vector<float> meshVertices;
+        if (c == nullptr || !runInv(meshVertices)) {
+            state.SkipWithError("CV models need BODYSCAN_RESOURCES");
+            return;
+        }
+        avatar_gen::inversion inv;
+        for (auto _: state) {
+            // the smoothing is in place, every iteration starts again from the predicted mesh
+            std::vector<float> vertices = meshVertices;
+            std::string error;
+            inv.compute_part_laplacian_cot_weights(vertices, BodyScanCommon::male,
+                                                   c->getLaplacianRingsAsVectors(BodyScanCommon::male),
+                                                   c->getLaplacianRings(BodyScanCommon::male), error);
+            benchmark::DoNotOptimize(vertices.data());
+        }
+    }
+
+    BENCHMARK(BM_compute_part_laplacian_cot_weights)->Unit(benchmark::kMillisecond);
+
+    // The mesh serialized by mesh_writer, range(0) 0 for OBJ and 1 for binary PLY.
+    void BM_mesh_writer(benchmark::State &state) {
+        const avatar_gen::common *c = loadCommon();
+        std::vector<float> vertices;
+        if (c == nullptr || !runInv(vertices)) {
+            state.SkipWithError("CV models need BODYSCAN_RESOURCES");
+            return;
+        }
+        AHIBSModelPackView<int32_t> faces = c->getFacesInv(BodyScanCommon::male);
+        avatar_gen::mesh_writer::format format = state.range(0) == 0 ? avatar_gen::mesh_writer::format::obj
+                                                                     : avatar_gen::mesh_writer::format::ply_binary;
+        std::string mesh;
+        for (auto _: state) {
+            mesh.clear();
+            avatar_gen::mesh_writer::write(format, vertices, {}, faces, avatar_gen::mesh_writer::to_buffer(mesh));
+            benchmark::DoNotOptimize(mesh.data());
+        }
+        state.SetBytesProcessed((int64_t) (state.iterations() * mesh.size()));
+    }
+
+    BENCHMARK(BM_mesh_writer)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+    // The CV models of both genders decoded from their cereal resources, as common::setModels does on first use.
+    void BM_load_models_cereal(benchmark::State &state) {
+        bodyscan_cli::Resources *resources = bodyscan_bench::resources();
+        if (resources == nullptr || resources->cvModelsMale.empty()) {
+            state.SkipWithError("CV models need BODYSCAN_RESOURCES");
+            return;
+        }
+        for (auto _: state) {
+            for (bodyscan_cli::ModelMap *models: {&resources->cvModelsMale, &resources->cvModelsFemale}) {
+                for (auto &model: *models) {
+                    AHIModelCV cv = ahiDecodeCvFromBytes(model.second.first, model.second.second);
+                    benchmark::DoNotOptimize(cv.type);
+                }
+            }
+        }
+    }
+
+    BENCHMARK(BM_load_models_cereal)->Unit(benchmark::kMillisecond);
+
+    // The same models from a float32 model pack: mapped, checked with range(0) 1, and viewed in place as common reads
+    // them.
+    void BM_load_models_pack(benchmark::State &state) {
+        bodyscan_cli::Resources *resources = bodyscan_bench::resources();
+        if (resources == nullptr || resources->cvModelsMale.empty()) {
+            state.SkipWithError("CV models need BODYSCAN_RESOURCES");
+            return;
+        }
+        AHIBSModelPackWriter writer;
+        std::string error;
+        for (auto &model: resources->cvModelsMale) {
+            AHIModelCV cv = ahiDecodeCvFromBytes(model.second.first, model.second.second);
+            ahiModelPackAddCv(writer, model.first + "_male", cv, AHIBSModelPackType::Float32, error);
+        }
+        for (auto &model: resources->cvModelsFemale) {
+            AHIModelCV cv = ahiDecodeCvFromBytes(model.second.first, model.second.second);
+            ahiModelPackAddCv(writer, model.first + "_female", cv, AHIBSModelPackType::Float32, error);
+        }
+        const std::string path = "bodyscan_bench_models.pak";
+        if (!writer.write(path, error)) {
+            state.SkipWithError(error.c_str());
+            return;
+        }
+        for (auto _: state) {
+            std::unique_ptr<AHIBSModelPack> pack = AHIBSModelPack::open(path, state.range(0) != 0, error);
+            if (!pack) {
+                state.SkipWithError(error.c_str());
+                break;
+            }
+            for (const AHIBSModelPackEntry *entry: pack->entries()) {
+                if (entry->type == (uint32_t) AHIBSModelPackType::Int32) {
+                    benchmark::DoNotOptimize(pack->ints(entry->name).data);
+                } else {
+                    benchmark::DoNotOptimize(pack->floats(entry->name).data);
+                }
+            }
+        }
+        std::remove(path.c_str());
+    }
+
+    BENCHMARK(BM_load_models_pack)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+}
@@ -0,0 +1,162 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "bodyscan_bench.hpp"
+
+#include "AHIAvatarGenSegmentationJointsHelper.hpp"
+#include "SegmentationContext.hpp"
+#include "ahiFactoryFace.hpp"
+#include "ahiFactoryPose.hpp"
+#include "ahiFactorySegment.hpp"
+
+namespace {
+    void BM_ahiDLSegment(benchmark::State &state) {
+        bodyscan_cli::Resources *resources = bodyscan_bench::resources();
+        if (resources == nullptr || resources->files.count("segnet") == 0) {
+            state.SkipWithError("segnet needs BODYSCAN_RESOURCES");
+            return;
+        }
+        std::vector<char> &segnet = resources->files["segnet"];
+        const bodyscan_bench::SyntheticScan &scan = bodyscan_bench::syntheticScan(BodyScanCommon::Profile::front);
+        ahiFactorySegment segmenter;
+        segmenter.initSegment();
+        if (!segmenter.loadTensorFlowSegmentModelFromBufferOrFile(segnet.data(), segnet.size(),
+                                                                  "segnet.tflite")) {
+            state.SkipWithError("segnet does not load");
+            return;
+        }
+        segmenter.feedInputBufferImageToCppToSegment(nullptr, scan.capture);
+        for (auto _: state) {
+            ahiSegmentInfo segInfo;
+            segmenter.ahiDLSegment(segInfo);
+            benchmark::DoNotOptimize(segInfo.segmentDLMask.data);
+        }
+    }
+
+    BENCHMARK(BM_ahiDLSegment)->Unit(benchmark::kMillisecond);
+
+    // One context per benchmark thread over one loaded segnet, as concurrent camera sessions run them.
+    void BM_SegmentationContext_segment(benchmark::State &state) {
+        bodyscan_cli::Resources *resources = bodyscan_bench::resources();
+        if (resources == nullptr || resources->files.count("segnet") == 0) {
+            state.SkipWithError("segnet needs BODYSCAN_RESOURCES");
+            return;
+        }
+        std::vector<char> &segnet = resources->files["segnet"];
+        static std::shared_ptr<const tflite::FlatBufferModel> model =
+                tflite::FlatBufferModel::BuildFromBuffer(segnet.data(), segnet.size());
+        const bodyscan_bench::SyntheticScan &scan = bodyscan_bench::syntheticScan(BodyScanCommon::Profile::front);
+        SegmentationContext context;
+        if (!context.registerModel(ahiModelRole::segment, model, "segnet.tflite")) {
+            state.SkipWithError("segnet does not load");
+            return;
+        }
+        for (auto _: state) {
+            context.feedImage(ahiModelRole::segment, scan.capture);
+            ahiSegmentInfo segInfo;
+            context.segment(scan.capture, scan.contourMask, ahiPoseInfo(), "front", segInfo);
+            benchmark::DoNotOptimize(segInfo.segmentMask.data);
+        }
+    }
+
+    BENCHMARK(BM_SegmentationContext_segment)->ThreadRange(1, 4)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+    // The network mask brought to the capture size: threshold then upscale (0), or the fused soft upscale (1).
+    void BM_upscaleThresholded(benchmark::State &state) {
+        const bodyscan_bench::SyntheticScan &scan = bodyscan_bench::syntheticScan(BodyScanCommon::Profile::front);
+        cv::Mat soft;
+        cv::resize(scan.silhouette, soft, cv::Size(256, 256), 0, 0, cv::INTER_AREA);
+        cv::GaussianBlur(soft, soft, cv::Size(9, 9), 0);
+        for (auto _: state) {
+            cv::Mat mask;
+            double threshold = cv::threshold(soft, mask, 0, 255, cv::THRESH_BINARY + cv::THRESH_OTSU);
+            if (state.range(0) == 0) {
+                cv::resize(mask, mask, scan.capture.size(), 0, 0, cv::INTER_LINEAR);
+            } else {
+                mask = ahiFactorySegment::upscaleThresholded(soft, scan.capture.size(), threshold);
+            }
+            benchmark::DoNotOptimize(mask.data);
+        }
+    }
+
+    BENCHMARK(BM_upscaleThresholded)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+    void BM_segment_using_net_joints_and_grabcut_and_contourmask(benchmark::State &state) {
+        auto profile = (BodyScanCommon::Profile) state.range(0);
+        const bodyscan_bench::SyntheticScan &scan = bodyscan_bench::syntheticScan(profile);
+        // the network mask is taken a little off the figure so grabCut has work to do
+        cv::Mat netMask;
+        cv::erode(scan.silhouette, netMask, cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(15, 15)));
+        ahi_avatar_gen::joints_helper jointsHelper;
+        for (auto _: state) {
+            cv::Mat silhouette = jointsHelper.segment_using_net_joints_and_grabcut_and_contourmask(
+                    scan.capture, profile, netMask, scan.joints, scan.contourMask);
+            benchmark::DoNotOptimize(silhouette.data);
+        }
+    }
+
+    BENCHMARK(BM_segment_using_net_joints_and_grabcut_and_contourmask)->Arg(BodyScanCommon::Profile::front)
+            ->Arg(BodyScanCommon::Profile::side)->Unit(benchmark::kMillisecond);
+
+    // Coarse-to-fine grabCut at pyramid level range(1) with a band of range(2) pixels. The iou and differing counters
+    // compare its silhouette with the one of the full resolution grabCut.
+    void BM_grabcut_coarse_to_fine(benchmark::State &state) {
+        auto profile = (BodyScanCommon::Profile) state.range(0);
+        const bodyscan_bench::SyntheticScan &scan = bodyscan_bench::syntheticScan(profile);
+        cv::Mat netMask;
+        cv::erode(scan.silhouette, netMask, cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(15, 15)));
+        ahi_avatar_gen::joints_helper jointsHelper;
+        jointsHelper.grabcut_pyramid_level = 0;
+        cv::Mat reference = jointsHelper.segment_using_net_joints_and_grabcut_and_contourmask(
+                scan.capture, profile, netMask, scan.joints, scan.contourMask);
+        jointsHelper.grabcut_pyramid_level = (int) state.range(1);
+        jointsHelper.grabcut_band_width = (int) state.range(2);
+        cv::Mat silhouette;
+        for (auto _: state) {
+            silhouette = jointsHelper.segment_using_net_joints_and_grabcut_and_contourmask(
+                    scan.capture, profile, netMask, scan.joints, scan.contourMask);
+            benchmark::DoNotOptimize(silhouette.data);
+        }
+        double both = cv::countNonZero(reference & silhouette);
+        double either = cv::countNonZero(reference | silhouette);
+        state.counters["iou"] = either > 0 ? both / either : 1.0;
+        state.counters["differing"] = either - both;
+    }
+
+    BENCHMARK(BM_grabcut_coarse_to_fine)->ArgsProduct({{BodyScanCommon::Profile::front, BodyScanCommon::Profile::side},
+                                                      {1, 2}, {4, 8, 16}})->Unit(benchmark::kMillisecond);
+
+    void BM_decodePoseLightHeatmaps(benchmark::State &state) {
+        auto profile = (BodyScanCommon::Profile) state.range(0);
+        cv::Mat heatmaps = bodyscan_bench::syntheticHeatmaps(profile);
+        cv::Size captureSize = bodyscan_bench::syntheticScan(profile).capture.size();
+        ahiFactoryPose pose;
+        pose.isPaddedForResize = false;
+        for (auto _: state) {
+            ahiPoseInfo poseInfo;
+            poseInfo.numOfDetectedFaces = 1;
+            poseInfo.view = profile == BodyScanCommon::Profile::front ? "front" : "side";
+            pose.decodePoseLightHeatmaps(heatmaps, captureSize, poseInfo);
+            benchmark::DoNotOptimize(poseInfo.CentroidHeadTop);
+        }
+    }
+
+    BENCHMARK(BM_decodePoseLightHeatmaps)->Arg(BodyScanCommon::Profile::front)->Arg(BodyScanCommon::Profile::side)
+            ->Unit(benchmark::kMicrosecond);
+
+    void BM_detectFaceCV(benchmark::State &state) {
+        const bodyscan_bench::SyntheticScan &scan = bodyscan_bench::syntheticScan(BodyScanCommon::Profile::front);
+        ahiFactoryFace face;
+        for (auto _: state) {
+            // there is no face to find, so every cascade pass runs
+            std::vector<cv::Rect> faces;
+            face.detectFaceCV(scan.capture, faces);
+            benchmark::DoNotOptimize(faces.data());
+        }
+    }
+
+    BENCHMARK(BM_detectFaceCV)->Unit(benchmark::kMillisecond);
+}
@@ -0,0 +1,208 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+// Runs a scan through the native pipeline on a Linux host: contour -> segmentation -> classification -> inversion,
+// the way the Kotlin layer chains the modules, and writes the classification JSON and the avatar OBJ (binary PLY
+// when the --obj file ends in .ply).
+//
+//   bodyscan_cli --front front.jpg --side side.jpg --front-joints front.txt --side-joints side.txt
+//                --height 180 --weight 80 --sex male --resources <dir> [--json out.json] [--obj out.obj] [--repeat n]
+//
+// <dir> holds the decrypted resources, one file per resource named after it (any extension): the ML and SVR
+// models of classification, "segnet", and the CV models as <name>_male / <name>_female or <name> when genderless.
+// Pose detection is ML Kit on Android, so the joints are inputs: one "<joint name> <x> <y>" line per joint.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "bodyscan_cli.hpp"
+
+namespace {
+    bool loadJoints(const std::string &path, bodyscan_cli::Joints &joints) {
+        std::ifstream file(path);
+        if (!file) {
+            return false;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            std::string name;
+            float x, y;
+            if (fields >> name >> x >> y) {
+                joints[name] = cv::Point2f(x, y);
+            }
+        }
+        return !joints.empty();
+    }
+
+    // Captures reach the native code as RGBA bitmaps converted to RGB.
+    cv::Mat loadCapture(const std::string &path) {
+        cv::Mat image = cv::imread(path, cv::IMREAD_COLOR);
+        if (!image.empty()) {
+            cv::cvtColor(image, image, cv::COLOR_BGR2RGB);
+        }
+        return image;
+    }
+
+    bool writeFile(const std::string &path, const std::string &content) {
+        std::ofstream file(path, std::ios::binary);
+        file << content;
+        return (bool) file;
+    }
+
+    int usage() {
+        std::cerr << "usage: bodyscan_cli --front <image> --side <image> --front-joints <file> --side-joints <file>\n"
+                     "                    --height <cm> --weight <kg> --sex <male|female> --resources <dir>\n"
+                     "                    [--json <file>] [--obj <file>] [--repeat <n>]\n";
+        return 2;
+    }
+
+    class StageTimer {
+    public:
+        void add(const std::string &stage, std::chrono::steady_clock::duration elapsed) {
+            mStages[stage] += std::chrono::duration<double, std::milli>(elapsed).count();
+        }
+
+        void print(int repeat) const {
+            for (auto &stage: mStages) {
+                std::cerr << stage.first << ": " << stage.second / repeat << " ms\n";
+            }
+        }
+
+    private:
+        std::map<std::string, double> mStages;
+    };
+}
+
+int main(int argc, char **argv) {
+    std::map<std::string, std::string> args;
+    for (int i = 1; i < argc; i += 2) {
+        std::string key = argv[i];
+        // a flag without its value is an error, not a flag to drop
+        if (key.compare(0, 2, "--") != 0 || i + 1 == argc) {
+            return usage();
+        }
+        args[key.substr(2)] = argv[i + 1];
+    }
+    for (auto &required: {"front", "side", "front-joints", "side-joints", "height", "weight", "sex", "resources"}) {
+        if (args.find(required) == args.end()) {
+            return usage();
+        }
+    }
+    float height = std::strtof(args["height"].c_str(), nullptr);
+    float weight = std::strtof(args["weight"].c_str(), nullptr);
+    BodyScanCommon::SexType sex;
+    if (args["sex"] == "female" || args["sex"] == "F") {
+        sex = BodyScanCommon::female;
+    } else if (args["sex"] == "male" || args["sex"] == "M") {
+        sex = BodyScanCommon::male;
+    } else {
+        std::cerr << "unknown sex " << args["sex"] << "\n";
+        return usage();
+    }
+    int repeat = args.count("repeat") ? std::max(1, std::atoi(args["repeat"].c_str())) : 1;
+
+    bodyscan_cli::Resources resources;
+    if (!bodyscan_cli::loadResources(args["resources"], resources)) {
+        std::cerr << "cannot read resources from " << args["resources"] << "\n";
+        return 1;
+    }
+    bodyscan_cli::selectModels(resources, bodyscan_cli::tfLiteModelNames(), bodyscan_cli::svrModelNames());
+    auto segnet = resources.files.find("segnet");
+    if (segnet == resources.files.end()) {
+        std::cerr << "segnet missing from the resources\n";
+        return 1;
+    }
+    std::vector<cv::Mat> captures = {loadCapture(args["front"]), loadCapture(args["side"])};
+    if (captures[0].empty() || captures[1].empty()) {
+        std::cerr << "cannot read the front or side image\n";
+        return 1;
+    }
+    std::vector<bodyscan_cli::Joints> joints(2);
+    if (!loadJoints(args["front-joints"], joints[0]) || !loadJoints(args["side-joints"], joints[1])) {
+        std::cerr << "cannot read the front or side joints\n";
+        return 1;
+    }
+    std::vector<BodyScanCommon::Profile> profiles = {BodyScanCommon::Profile::front, BodyScanCommon::Profile::side};
+
+    const std::string plySuffix = ".ply";
+    bool ply = args.count("obj") && args["obj"].size() >= plySuffix.size() &&
+               args["obj"].compare(args["obj"].size() - plySuffix.size(), plySuffix.size(), plySuffix) == 0;
+
+    StageTimer timer;
+    std::string json;
+    std::string obj;
+    std::string error;
+    for (int run = 0; run < repeat; run++) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<cv::Mat> contourMasks;
+        for (std::size_t index = 0; index < captures.size(); index++) {
+            contourMasks.push_back(bodyscan_cli::contourMask(sex, height, weight, captures[index].rows,
+                                                             captures[index].cols, profiles[index],
+                                                             resources.cvModelsMale, resources.cvModelsFemale));
+        }
+        auto contoured = std::chrono::steady_clock::now();
+        timer.add("contour", contoured - start);
+
+        std::vector<cv::Mat> silhouettes = bodyscan_cli::segment(captures, contourMasks, profiles, joints,
+                                                                 segnet->second);
+        auto segmented = std::chrono::steady_clock::now();
+        timer.add("segmentation", segmented - contoured);
+        if (silhouettes.size() != 2 || silhouettes[0].empty() || silhouettes[1].empty()) {
+            std::cerr << "segmentation failed\n";
+            return 1;
+        }
+        // classification gets the silhouettes back from Kotlin as RGBA bitmaps
+        for (auto &silhouette: silhouettes) {
+            cv::cvtColor(silhouette, silhouette, cv::COLOR_GRAY2RGBA);
+        }
+
+        std::map<std::string, float> results = bodyscan_cli::classify(height, weight, sex, silhouettes[0],
+                                                                      silhouettes[1], joints[0], joints[1],
+                                                                      resources.tfModels, resources.svrModels, json);
+        auto classified = std::chrono::steady_clock::now();
+        timer.add("classification", classified - segmented);
+        for (auto &key: {"cm_raw_chest", "cm_raw_waist", "cm_raw_hips", "cm_raw_inseam", "ml_gen_fitness"}) {
+            if (results.find(key) == results.end()) {
+                std::cerr << "classification did not return " << key << "\n";
+                return 1;
+            }
+        }
+
+        error.clear();
+        obj = bodyscan_cli::invert(sex, height, weight, results["cm_raw_chest"], results["cm_raw_waist"],
+                                   results["cm_raw_hips"], results["cm_raw_inseam"], results["ml_gen_fitness"],
+                                   resources.cvModelsMale, resources.cvModelsFemale, ply, error);
+        timer.add("inversion", std::chrono::steady_clock::now() - classified);
+        if (obj.empty()) {
+            std::cerr << "inversion failed " << error << "\n";
+            return 1;
+        }
+    }
+
+    int status = 0;
+    if (args.count("json")) {
+        if (!writeFile(args["json"], json)) {
+            std::cerr << "cannot write " << args["json"] << "\n";
+            status = 1;
+        }
+    } else {
+        std::cout << json;
+    }
+    if (args.count("obj") && !writeFile(args["obj"], obj)) {
+        std::cerr << "cannot write " << args["obj"] << "\n";
+        status = 1;
+    }
+    timer.print(repeat);
+    return status;
+}
@@ -0,0 +1,66 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#ifndef BODYSCAN_CLI_HPP
+#define BODYSCAN_CLI_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+#include "Common.hpp"
+
+// The stages of the scan pipeline as called by the Kotlin layer, one per module. Every stage is implemented in its own
+// translation unit, because the modules ship classes of the same name that must not meet in one translation unit.
+namespace bodyscan_cli {
+    using ModelMap = std::map<std::string, std::pair<char *, std::size_t>>;
+    using Joints = std::map<std::string, cv::Point2f>;
+
+    // Decrypted resources of a directory, one file per resource named after it (any extension). The model maps point
+    // into files: the CV models as <name>_male / <name>_female or <name> when genderless, and the classification
+    // models once selected by their names.
+    struct Resources {
+        std::map<std::string, std::vector<char>> files; // stem -> bytes
+        ModelMap cvModelsMale;
+        ModelMap cvModelsFemale;
+        ModelMap tfModels;
+        ModelMap svrModels;
+    };
+
+    bool loadResources(const std::string &dir, Resources &resources);
+
+    void selectModels(Resources &resources, const std::vector<std::string> &tfModelNames,
+                      const std::vector<std::string> &svrModelNames);
+
+    // PartContour: the ideal contour of the profile rasterized as the mask handed to segmentation.
+    cv::Mat contourMask(BodyScanCommon::SexType sex, float heightCM, float weightKG, int imageHeight, int imageWidth,
+                        BodyScanCommon::Profile profile, ModelMap &cvModelsMale, ModelMap &cvModelsFemale);
+
+    // PartSegmentation: one silhouette per capture.
+    std::vector<cv::Mat> segment(const std::vector<cv::Mat> &captures, const std::vector<cv::Mat> &contourMasks,
+                                 const std::vector<BodyScanCommon::Profile> &profiles,
+                                 const std::vector<Joints> &joints, const std::vector<char> &segmentationModel);
+
+    // PartClassification
+    std::vector<std::string> tfLiteModelNames();
+
+    std::vector<std::string> svrModelNames();
+
+    // Results map and its JSON, as returned to the Kotlin layer.
+    std::map<std::string, float> classify(double heightCM, double weightKG, BodyScanCommon::SexType sex,
+                                          const cv::Mat &frontSilhouette, const cv::Mat &sideSilhouette,
+                                          const Joints &frontJoints, const Joints &sideJoints,
+                                          ModelMap &tfModels, ModelMap &svrModels, std::string &json);
+
+    // PartInversion: the avatar as OBJ text, or as binary PLY with normals if ply.
+    std::string invert(BodyScanCommon::SexType sex, float heightCM, float weightKG, float chestCM, float waistCM,
+                       float hipCM, float inseamCM, float fitness, ModelMap &cvModelsMale, ModelMap &cvModelsFemale,
+                       bool ply, std::string &error);
+}
+
+#endif //BODYSCAN_CLI_HPP
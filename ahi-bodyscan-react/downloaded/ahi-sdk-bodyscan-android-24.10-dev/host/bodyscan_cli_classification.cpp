@@ -0,0 +1,28 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "bodyscan_cli.hpp"
+
+#include "Classification.hpp"
+
+std::vector<std::string> bodyscan_cli::tfLiteModelNames() {
+    return Classification::getTfLiteModelNames();
+}
+
+std::vector<std::string> bodyscan_cli::svrModelNames() {
+    return Classification::getSvrModelNames();
+}
+
+std::map<std::string, float> bodyscan_cli::classify(double heightCM, double weightKG, BodyScanCommon::SexType sex,
+                                                    const cv::Mat &frontSilhouette, const cv::Mat &sideSilhouette,
+                                                    const Joints &frontJoints, const Joints &sideJoints,
+                                                    ModelMap &tfModels, ModelMap &svrModels, std::string &json) {
+    std::string sexStr = sex == BodyScanCommon::male ? "M" : "F";
+    auto result = Classification::classify(heightCM, weightKG, sexStr, frontSilhouette, sideSilhouette, frontJoints,
+                                           sideJoints, "shape_and_comp", tfModels, svrModels, false);
+    json = result.currentClassResultsAsJson;
+    return result.classificationResultsCurrent;
+}
@@ -0,0 +1,18 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "bodyscan_cli.hpp"
+
+#include "ContourGenerator.hpp"
+
+cv::Mat bodyscan_cli::contourMask(BodyScanCommon::SexType sex, float heightCM, float weightKG, int imageHeight,
+                                  int imageWidth, BodyScanCommon::Profile profile, ModelMap &cvModelsMale,
+                                  ModelMap &cvModelsFemale) {
+    // captures are taken upright, so no alignment correction
+    auto contour = ContourGenerator::generateIdealContour(sex, heightCM, weightKG, imageHeight, imageWidth, 0.0f,
+                                                          profile, cvModelsMale, cvModelsFemale);
+    return ContourGenerator::generateContourMask(contour, imageHeight, imageWidth);
+}
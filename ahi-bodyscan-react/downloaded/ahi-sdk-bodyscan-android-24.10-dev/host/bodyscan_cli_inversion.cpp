@@ -0,0 +1,23 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "bodyscan_cli.hpp"
+
+#include "AHIAvatarGenInversion.hpp"
+
+std::string bodyscan_cli::invert(BodyScanCommon::SexType sex, float heightCM, float weightKG, float chestCM,
+                                 float waistCM, float hipCM, float inseamCM, float fitness, ModelMap &cvModelsMale,
+                                 ModelMap &cvModelsFemale, bool ply, std::string &error) {
+    avatar_gen::inversion invert;
+    std::string mesh;
+    avatar_gen::mesh_writer::format format =
+            ply ? avatar_gen::mesh_writer::format::ply_binary : avatar_gen::mesh_writer::format::obj;
+    if (!invert.invert(sex, heightCM, weightKG, chestCM, waistCM, hipCM, inseamCM, fitness, error, cvModelsMale,
+                       cvModelsFemale, format, ply, avatar_gen::mesh_writer::to_buffer(mesh))) {
+        mesh.clear();
+    }
+    return mesh;
+}
@@ -0,0 +1,74 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "bodyscan_cli.hpp"
+
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+
+namespace {
+    // The CV models the Kotlin layer hands to contour and inversion, as <name>_male / <name>_female resources
+    const char *const kCvModels[] = {"MvnMu", "AvgVerts", "VertsInv", "Ranges", "Cov", "SkV", "BonW", "BonWInv", "Sv",
+                                     "SvInv", "Faces", "FacesInv", "LaplacianRings", "LaplacianRingsAsVectors"};
+    // and as <name> resources
+    const char *const kCvModelsGenderless[] = {"InvRightCalf", "InvRightThigh", "InvRightUpperArm"};
+
+    bool readFile(const std::string &path, std::vector<char> &bytes) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+}
+
+bool bodyscan_cli::loadResources(const std::string &dir, Resources &resources) {
+    DIR *handle = opendir(dir.c_str());
+    if (handle == nullptr) {
+        return false;
+    }
+    for (dirent *entry = readdir(handle); entry != nullptr; entry = readdir(handle)) {
+        std::string fileName = entry->d_name;
+        if (fileName.empty() || fileName[0] == '.') {
+            continue;
+        }
+        std::string stem = fileName.substr(0, fileName.find('.'));
+        readFile(dir + "/" + fileName, resources.files[stem]);
+    }
+    closedir(handle);
+
+    auto select = [&resources](const std::string &resource, const std::string &name, ModelMap &models) {
+        auto iter = resources.files.find(resource);
+        if (iter != resources.files.end()) {
+            models[name] = std::make_pair(iter->second.data(), iter->second.size());
+        }
+    };
+    for (const std::string name: kCvModels) {
+        select(name + "_male", name, resources.cvModelsMale);
+        select(name + "_female", name, resources.cvModelsFemale);
+    }
+    for (const std::string name: kCvModelsGenderless) {
+        select(name, name, resources.cvModelsMale);
+        select(name, name, resources.cvModelsFemale);
+    }
+    return true;
+}
+
+void bodyscan_cli::selectModels(Resources &resources, const std::vector<std::string> &tfModelNames,
+                                const std::vector<std::string> &svrModelNames) {
+    auto select = [&resources](const std::vector<std::string> &names, ModelMap &models) {
+        for (auto &name: names) {
+            auto iter = resources.files.find(name);
+            if (iter != resources.files.end()) {
+                models[name] = std::make_pair(iter->second.data(), iter->second.size());
+            }
+        }
+    };
+    select(tfModelNames, resources.tfModels);
+    select(svrModelNames, resources.svrModels);
+}
@@ -0,0 +1,18 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+#include "bodyscan_cli.hpp"
+
+#include "Segmentation.hpp"
+
+std::vector<cv::Mat> bodyscan_cli::segment(const std::vector<cv::Mat> &captures,
+                                           const std::vector<cv::Mat> &contourMasks,
+                                           const std::vector<BodyScanCommon::Profile> &profiles,
+                                           const std::vector<Joints> &joints,
+                                           const std::vector<char> &segmentationModel) {
+    return Segmentation().segmentAll(captures, contourMasks, profiles, joints, segmentationModel.data(),
+                                     segmentationModel.size());
+}
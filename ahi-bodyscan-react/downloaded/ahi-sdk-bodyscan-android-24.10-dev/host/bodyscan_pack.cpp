@@ -0,0 +1,87 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+// Converts the decrypted cereal resources of a directory into one binary model pack (AHIBSModelPack.hpp): the CV
+// models under their resource names (<name>_male / <name>_female, <name> when genderless) and the SVR models of
+// classification as <name>.vectors / .coefficients / .intercepts.
+//
+//   bodyscan_pack --resources <dir> --out models.pak [--storage float32|float16]
+//
+// The float CV models are stored as --storage (float32 by default), the double ones and the SVR models as float64
+// unless float16 is asked for.
+
+#include <iostream>
+
+#include "AHIBSModelPack.hpp"
+#include "bodyscan_cli.hpp"
+
+namespace {
+    int usage() {
+        std::cerr << "usage: bodyscan_pack --resources <dir> --out <file> [--storage <float32|float16>]\n";
+        return 2;
+    }
+}
+
+int main(int argc, char **argv) {
+    std::map<std::string, std::string> args;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (key.compare(0, 2, "--") != 0) {
+            return usage();
+        }
+        args[key.substr(2)] = argv[i + 1];
+    }
+    if (!args.count("resources") || !args.count("out")) {
+        return usage();
+    }
+    AHIBSModelPackType storage = AHIBSModelPackType::Float32;
+    if (args.count("storage")) {
+        if (args["storage"] == "float16") {
+            storage = AHIBSModelPackType::Float16;
+        } else if (args["storage"] != "float32") {
+            return usage();
+        }
+    }
+
+    bodyscan_cli::Resources resources;
+    if (!bodyscan_cli::loadResources(args["resources"], resources)) {
+        std::cerr << "cannot read resources from " << args["resources"] << "\n";
+        return 1;
+    }
+    bodyscan_cli::selectModels(resources, {}, bodyscan_cli::svrModelNames());
+
+    AHIBSModelPackWriter writer;
+    std::string error;
+    auto addCvModels = [&](bodyscan_cli::ModelMap &models, const std::string &suffix) {
+        for (auto &model: models) {
+            // the genderless models are resources of their own name, handed out for both genders
+            std::string name = resources.files.count(model.first) ? model.first : model.first + suffix;
+            AHIModelCV cv = ahiDecodeCvFromBytes(model.second.first, model.second.second);
+            if (!ahiModelPackAddCv(writer, name, cv, storage, error)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    if (!addCvModels(resources.cvModelsMale, "_male") || !addCvModels(resources.cvModelsFemale, "_female")) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    AHIBSModelPackType svrStorage =
+            storage == AHIBSModelPackType::Float16 ? AHIBSModelPackType::Float16 : AHIBSModelPackType::Float64;
+    for (auto &model: resources.svrModels) {
+        AHIModelSVR svr = ahiDecodeSvrFromBytes(model.second.first, model.second.second);
+        if (!ahiModelPackAddSvr(writer, model.first, svr, svrStorage, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+    }
+    if (!writer.write(args["out"], error)) {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    return 0;
+}
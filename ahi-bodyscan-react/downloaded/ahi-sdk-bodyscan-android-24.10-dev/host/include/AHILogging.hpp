@@ -0,0 +1,16 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+// Host stand-in for the AHILogging.hpp of ahi-sdk-common-android, which is only shipped for Android.
+
+#ifndef BODYSCAN_HOST_AHILOGGING_HPP
+#define BODYSCAN_HOST_AHILOGGING_HPP
+
+#include <android/log.h>
+
+#define AHILog(priority, ...) ((void) __android_log_print(priority, "AHI", __VA_ARGS__))
+
+#endif // BODYSCAN_HOST_AHILOGGING_HPP
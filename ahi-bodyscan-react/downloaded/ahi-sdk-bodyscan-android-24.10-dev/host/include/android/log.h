@@ -0,0 +1,44 @@
+//
+//  AHI
+//
+//  Copyright (c) AHI. All rights reserved.
+//
+
+// Host stand-in for the NDK <android/log.h>, so the native sources log to stderr when built for Linux.
+
+#ifndef BODYSCAN_HOST_ANDROID_LOG_H
+#define BODYSCAN_HOST_ANDROID_LOG_H
+
+#include <cstdarg>
+#include <cstdio>
+
+typedef enum android_LogPriority {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT,
+} android_LogPriority;
+
+inline int __android_log_vprint(int prio, const char *tag, const char *fmt, va_list ap) {
+    static const char kPriorities[] = "??VDIWEFS";
+    char level = prio >= 0 && prio <= ANDROID_LOG_SILENT ? kPriorities[prio] : '?';
+    int written = std::fprintf(stderr, "%c/%s: ", level, tag != nullptr ? tag : "");
+    written += std::vfprintf(stderr, fmt, ap);
+    std::fputc('\n', stderr);
+    return written + 1;
+}
+
+inline int __android_log_print(int prio, const char *tag, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int written = __android_log_vprint(prio, tag, fmt, ap);
+    va_end(ap);
+    return written;
+}
+
+#endif // BODYSCAN_HOST_ANDROID_LOG_H